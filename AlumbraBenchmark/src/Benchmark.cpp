@@ -0,0 +1,404 @@
+#include "pch.h"
+#include "FreeCamera.h"
+#include "Window.h"
+#include "Scene.h"
+#include "Renderer.h"
+#include "Profiler.h"
+#include "CameraPath.h"
+#include "SceneGenerator.h"
+
+#include <algorithm>
+#include <cstdio>
+
+/*
+ * Offscreen benchmark for the renderer. Replays a camera path for a fixed number of frames
+ * in a hidden window and writes CPU/GPU frame time percentiles, draw counts and startup
+ * phase timings as JSON. Run from the AlumbraRenderer directory so shaders and resources
+ * resolve. Use --context egl on machines without a display server, e.g. under Mesa llvmpipe:
+ * it creates a surfaceless EGL context with no window at all. --context osmesa only asks GLFW
+ * for an OSMesa context, its hidden window still needs a display. Any of the --objects, --lights, ... options replace the default
+ * scene with a generated stress scene, for charting how the renderer scales.
+ */
+
+FreeCamera g_camera(glm::vec3(0.0f, 1.5f, 4.0f));
+
+struct BenchmarkOptions {
+    int width = 1920;
+    int height = 1080;
+    int frames = 600;
+    int warmupFrames = 60;
+    float pathDuration = 10.0f;
+    std::string pathFile;
+    std::string contextName = "native";
+    std::string outputFile = "benchmark.json";
+    std::string traceFile;
+    bool visibilityBuffer = false;
+    bool cpuCulling = true;
+    SoftwareOcclusionSettings softwareOcclusion;
+    bool gpuCulling = true;
+    bool occlusionCulling = true;
+    bool clusterCulling = true;
+    LodSettings lod;
+    ImpostorSettings impostors;
+    DynamicResolutionSettings dynamicRes;
+    TemporalAASettings taa;
+    CheckerboardSettings checkerboard;
+    bool stressScene = false;
+    StressSceneSettings stress;
+};
+
+struct Percentiles {
+    float mean = 0.0f, p50 = 0.0f, p95 = 0.0f, p99 = 0.0f, max = 0.0f;
+};
+
+static Percentiles percentiles(std::vector<float> samples)
+{
+    Percentiles result;
+    if (samples.empty())
+        return result;
+    std::sort(samples.begin(), samples.end());
+    auto at = [&samples](float p) {
+        return samples[std::min(samples.size() - 1, (size_t)(p / 100.0f * samples.size()))];
+    };
+    for (float sample : samples)
+        result.mean += sample;
+    result.mean /= samples.size();
+    result.p50 = at(50.0f);
+    result.p95 = at(95.0f);
+    result.p99 = at(99.0f);
+    result.max = samples.back();
+    return result;
+}
+
+/* Quotes a string as a JSON string literal, paths and GL renderer names may contain anything */
+static std::string jsonString(const std::string& value)
+{
+    std::string result = "\"";
+    for (char c : value) {
+        switch (c) {
+        case '"':  result += "\\\""; break;
+        case '\\': result += "\\\\"; break;
+        case '\n': result += "\\n"; break;
+        case '\r': result += "\\r"; break;
+        case '\t': result += "\\t"; break;
+        default:
+            if ((unsigned char)c < 0x20) {
+                char escaped[8];
+                std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                result += escaped;
+            }
+            else
+                result += c;
+        }
+    }
+    return result + "\"";
+}
+
+static void writeMeshStats(std::ofstream& file, const MeshStats& stats)
+{
+    file << "{\"vertices\":" << stats.vertices << ",\"triangles\":" << stats.triangles
+        << ",\"acmr\":" << stats.acmr << ",\"overdraw\":" << stats.overdraw << "}";
+}
+
+static void writePercentiles(std::ofstream& file, const Percentiles& p)
+{
+    file << "{\"mean\":" << p.mean << ",\"p50\":" << p.p50 << ",\"p95\":" << p.p95 << ",\"p99\":" << p.p99
+        << ",\"max\":" << p.max << "}";
+}
+
+static bool parseOptions(int argc, char** argv, BenchmarkOptions& options)
+{
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--width" && hasValue)
+            options.width = std::stoi(argv[++i]);
+        else if (arg == "--height" && hasValue)
+            options.height = std::stoi(argv[++i]);
+        else if (arg == "--frames" && hasValue)
+            options.frames = std::stoi(argv[++i]);
+        else if (arg == "--warmup" && hasValue)
+            options.warmupFrames = std::stoi(argv[++i]);
+        else if (arg == "--duration" && hasValue)
+            options.pathDuration = std::stof(argv[++i]);
+        else if (arg == "--path" && hasValue)
+            options.pathFile = argv[++i];
+        else if (arg == "--context" && hasValue)
+            options.contextName = argv[++i];
+        else if (arg == "--output" && hasValue)
+            options.outputFile = argv[++i];
+        else if (arg == "--trace" && hasValue)
+            options.traceFile = argv[++i];
+        else if (arg == "--visibility-buffer")
+            options.visibilityBuffer = true;
+        else if (arg == "--no-cpu-culling")
+            options.cpuCulling = false;
+        else if (arg == "--no-software-occlusion")
+            options.softwareOcclusion.enabled = false;
+        else if (arg == "--no-gpu-culling")
+            options.gpuCulling = false;
+        else if (arg == "--no-occlusion")
+            options.occlusionCulling = false;
+        else if (arg == "--no-clusters")
+            options.clusterCulling = false;
+        else if (arg == "--no-lod")
+            options.lod.enabled = false;
+        else if (arg == "--lod-pixel-error" && hasValue)
+            options.lod.pixelError = std::stof(argv[++i]);
+        else if (arg == "--no-impostors")
+            options.impostors.enabled = false;
+        else if (arg == "--impostor-pixels" && hasValue)
+            options.impostors.maxPixels = std::stof(argv[++i]);
+        else if (arg == "--taa")
+            options.taa.enabled = true;
+        else if (arg == "--checkerboard")
+            options.checkerboard.enabled = true;
+        else if (arg == "--dynamic-resolution" && hasValue) {
+            options.dynamicRes.targetMs = std::stof(argv[++i]);
+            options.dynamicRes.enabled = true;
+        }
+        else if (arg == "--objects" && hasValue) {
+            options.stress.objectCount = std::stoi(argv[++i]);
+            options.stressScene = true;
+        }
+        else if (arg == "--distribution" && hasValue) {
+            if (!SceneGenerator::parseDistribution(argv[++i], options.stress.distribution)) {
+                std::cout << "Unknown distribution " << argv[i] << std::endl;
+                return false;
+            }
+            options.stressScene = true;
+        }
+        else if (arg == "--extent" && hasValue) {
+            options.stress.extent = std::stof(argv[++i]);
+            options.stressScene = true;
+        }
+        else if (arg == "--instance-ratio" && hasValue) {
+            options.stress.instanceRatio = std::stof(argv[++i]);
+            options.stressScene = true;
+        }
+        else if (arg == "--lights" && hasValue) {
+            options.stress.lightCount = std::stoi(argv[++i]);
+            options.stressScene = true;
+        }
+        else if (arg == "--light-radius" && hasValue) {
+            options.stress.lightRadius = std::stof(argv[++i]);
+            options.stressScene = true;
+        }
+        else if (arg == "--materials" && hasValue) {
+            options.stress.materialCount = std::stoi(argv[++i]);
+            options.stressScene = true;
+        }
+        else if (arg == "--model" && hasValue) {
+            options.stress.modelPath = argv[++i];
+            options.stressScene = true;
+        }
+        else if (arg == "--seed" && hasValue) {
+            options.stress.seed = std::stoi(argv[++i]);
+            options.stressScene = true;
+        }
+        else {
+            std::cout << "Usage: AlumbraBenchmark [--width W] [--height H] [--frames N] [--warmup N]\n"
+                << "    [--path camera.path] [--duration seconds] [--context native|egl|osmesa]\n"
+                << "    [--output results.json] [--trace trace.json] [--visibility-buffer]\n"
+                << "    [--no-cpu-culling] [--no-software-occlusion] [--no-gpu-culling] [--no-occlusion]\n"
+                << "    [--no-clusters] [--no-lod] [--lod-pixel-error P] [--no-impostors]\n"
+                << "    [--impostor-pixels P] [--taa] [--checkerboard] [--dynamic-resolution target_ms]\n"
+                << "    [--objects N] [--distribution grid|uniform|clustered] [--extent E]\n"
+                << "    [--instance-ratio R] [--lights N] [--light-radius R] [--materials N]\n"
+                << "    [--model path] [--seed S]\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    BenchmarkOptions options;
+    if (!parseOptions(argc, argv, options))
+        return 1;
+
+    int contextAPI = GLFW_NATIVE_CONTEXT_API;
+    if (options.contextName == "egl")
+        contextAPI = Window::SURFACELESS_CONTEXT_API;
+    else if (options.contextName == "osmesa")
+        contextAPI = GLFW_OSMESA_CONTEXT_API;
+
+    Profiler::setThreadName("Main");
+    long long startupBegin = Profiler::now();
+    std::unique_ptr<Window> window;
+    {
+        PROFILE_SCOPE("Window Init");
+        window = std::make_unique<Window>("Alumbra Benchmark", options.width, options.height, false, contextAPI);
+    }
+    if (!window->valid())
+        return 1;
+    std::unique_ptr<Scene> scene;
+    {
+        PROFILE_SCOPE("Scene Load");
+        scene = std::make_unique<Scene>();
+        if (options.stressScene)
+            SceneGenerator::generate(*scene, options.stress);
+    }
+    std::unique_ptr<Renderer> renderer;
+    {
+        PROFILE_SCOPE("Renderer Init");
+        renderer = std::make_unique<Renderer>(scene.get());
+    }
+    float startupMs = (Profiler::now() - startupBegin) / 1e6f;
+    renderer->setGUIEnabled(false);
+    renderer->setVisibilityBuffer(options.visibilityBuffer);
+    renderer->setCpuCulling(options.cpuCulling);
+    renderer->setSoftwareOcclusion(options.softwareOcclusion);
+    renderer->setGpuCulling(options.gpuCulling, options.occlusionCulling);
+    renderer->setClusterCulling(options.clusterCulling);
+    renderer->setLod(options.lod);
+    renderer->setImpostors(options.impostors);
+    renderer->setDynamicResolution(options.dynamicRes);
+    renderer->setTemporalAA(options.taa);
+    renderer->setCheckerboard(options.checkerboard);
+
+    CameraPath path;
+    // Stress scenes are orbited from outside their extent
+    float orbitRadius = options.stressScene ? options.stress.extent * 1.5f : 4.0f;
+    float orbitHeight = options.stressScene ? options.stress.extent * 0.5f : 1.5f;
+    if (options.pathFile.empty() || !path.load(options.pathFile))
+        path = CameraPath::orbit(glm::vec3(0.0f), orbitRadius, orbitHeight, options.pathDuration);
+    float pathDuration = path.duration() > 0.0f ? path.duration() : options.pathDuration;
+
+    // Frames advance the path by a fixed step so every run renders the same views
+    int totalFrames = options.warmupFrames + options.frames;
+    std::vector<float> frameMs, submitMs, gpuFrameMs, renderScales;
+    std::map<std::string, std::vector<float>> gpuScopeMs;
+    unsigned long long lastGpuFrame = 0;
+    RenderStats stats;
+    for (int frame = 0; frame < totalFrames + GpuProfiler::FRAME_LATENCY; frame++) {
+        Profiler::beginFrame();
+        PROFILE_SCOPE("Frame");
+        long long frameStart = Profiler::now();
+
+        float t = std::min((float)frame / std::max(totalFrames - 1, 1), 1.0f) * pathDuration;
+        path.apply(t, g_camera);
+        window->clear();
+        renderer->beginDraw();
+        long long submitEnd = Profiler::now();
+        window->update();
+        long long frameEnd = Profiler::now();
+
+        // The trailing frames only drain the GPU profiler's latency
+        bool measured = frame >= options.warmupFrames && frame < totalFrames;
+        if (measured) {
+            frameMs.push_back((frameEnd - frameStart) / 1e6f);
+            submitMs.push_back((submitEnd - frameStart) / 1e6f);
+            renderScales.push_back(renderer->renderScale());
+            stats = renderer->stats();
+        }
+
+        const auto& gpu = renderer->gpuProfiler();
+        if (gpu.lastResolvedFrame() != lastGpuFrame) {
+            lastGpuFrame = gpu.lastResolvedFrame();
+            // GPU profiler frames count from 1
+            long long gpuFrame = (long long)lastGpuFrame - 1;
+            if (gpuFrame >= options.warmupFrames && gpuFrame < totalFrames) {
+                for (const auto& scope : gpu.lastResults()) {
+                    float ms = (scope.end - scope.start) / 1e6f;
+                    if (scope.depth == 0)
+                        gpuFrameMs.push_back(ms);
+                    else
+                        gpuScopeMs[scope.name].push_back(ms);
+                }
+            }
+        }
+    }
+
+    // Startup phases from the CPU profiler, summed by name since e.g. shaders compile many times
+    std::map<std::string, float> startupPhases;
+    for (const auto& event : Profiler::events(0, 0))
+        startupPhases[event.name] += (event.end - event.start) / 1e6f;
+
+    if (!options.traceFile.empty())
+        Profiler::exportTrace(options.traceFile, 0, Profiler::frame());
+
+    std::ofstream file(options.outputFile);
+    if (!file.is_open()) {
+        std::cout << "ERROR::BENCHMARK::Could not write " << options.outputFile << std::endl;
+        return 1;
+    }
+    file << "{\n";
+    file << "  \"config\": {\"width\":" << options.width << ",\"height\":" << options.height
+        << ",\"frames\":" << options.frames << ",\"warmup\":" << options.warmupFrames
+        << ",\"path\":" << jsonString(options.pathFile.empty() ? "orbit" : options.pathFile)
+        << ",\"context\":" << jsonString(options.contextName)
+        << ",\"visibility_buffer\":" << (options.visibilityBuffer ? "true" : "false")
+        << ",\"cpu_culling\":" << (options.cpuCulling ? "true" : "false")
+        << ",\"software_occlusion\":" << (options.softwareOcclusion.enabled ? "true" : "false")
+        << ",\"gpu_culling\":" << (options.gpuCulling ? (options.occlusionCulling ? "\"hiz\"" : "\"frustum\"") : "\"off\"")
+        << ",\"cluster_culling\":" << (options.clusterCulling ? "true" : "false")
+        << ",\"lod\":" << (options.lod.enabled ? "true" : "false")
+        << ",\"lod_pixel_error\":" << options.lod.pixelError
+        << ",\"impostors\":" << (options.impostors.enabled ? "true" : "false")
+        << ",\"impostor_pixels\":" << options.impostors.maxPixels
+        << ",\"taa\":" << (options.taa.enabled ? "true" : "false")
+        << ",\"checkerboard\":" << (options.checkerboard.enabled ? "true" : "false")
+        << ",\"dynamic_resolution\":" << (options.dynamicRes.enabled ? "true" : "false")
+        << ",\"target_ms\":" << options.dynamicRes.targetMs
+        << ",\"gl_renderer\":" << jsonString((const char*)glGetString(GL_RENDERER)) << "},\n";
+    file << "  \"scene\": {\"stress\":" << (options.stressScene ? "true" : "false")
+        << ",\"objects\":" << scene->objects().size() << ",\"models\":" << scene->models().size()
+        << ",\"materials\":" << scene->materials().size() << ",\"lights\":" << scene->pointLights().size();
+    if (options.stressScene) {
+        file << ",\"distribution\":" << jsonString(SceneGenerator::distributionName(options.stress.distribution))
+            << ",\"extent\":" << options.stress.extent << ",\"instance_ratio\":" << options.stress.instanceRatio
+            << ",\"light_radius\":" << options.stress.lightRadius << ",\"seed\":" << options.stress.seed;
+    }
+    file << "},\n";
+    // Vertex cache and overdraw of the loaded model files as imported and as uploaded
+    MeshOptimizeStats optimized = scene->optimizeStats();
+    file << "  \"mesh_optimize\": {\"before\":";
+    writeMeshStats(file, optimized.before);
+    file << ",\"after\":";
+    writeMeshStats(file, optimized.after);
+    file << "},\n";
+    // Tracked GPU memory at the end of the run, after the budget policy had its say
+    const char* categoryKeys[(int)ResourceCategory::Count] = { "environment", "render_targets", "textures",
+        "meshes", "shaders", "other" };
+    const ResourceManager& resources = ResourceManager::instance();
+    file << "  \"gpu_memory_mb\": {\"total\":" << resources.totalBytes() / (1024.0 * 1024.0);
+    for (int category = 0; category < (int)ResourceCategory::Count; category++) {
+        file << ",\"" << categoryKeys[category] << "\":"
+            << resources.stats((ResourceCategory)category).bytes / (1024.0 * 1024.0);
+    }
+    file << "},\n";
+    file << "  \"startup_ms\": {\"total\":" << startupMs;
+    for (const auto& phase : startupPhases)
+        file << "," << jsonString(phase.first) << ":" << phase.second;
+    file << "},\n";
+    file << "  \"cpu_frame_ms\": ";
+    writePercentiles(file, percentiles(frameMs));
+    file << ",\n  \"cpu_submit_ms\": ";
+    writePercentiles(file, percentiles(submitMs));
+    file << ",\n  \"gpu_frame_ms\": ";
+    writePercentiles(file, percentiles(gpuFrameMs));
+    file << ",\n  \"render_scale\": ";
+    writePercentiles(file, percentiles(renderScales));
+    file << ",\n  \"gpu_pass_ms\": {";
+    bool first = true;
+    for (const auto& scope : gpuScopeMs) {
+        file << (first ? "" : ",") << "\n    " << jsonString(scope.first) << ": ";
+        writePercentiles(file, percentiles(scope.second));
+        first = false;
+    }
+    file << "\n  },\n";
+    file << "  \"draws\": {\"draw_calls\":" << stats.drawCalls << ",\"dispatches\":" << stats.dispatches
+        << ",\"triangles\":" << stats.triangles << ",\"culled_objects\":" << stats.culledObjects
+        << ",\"occluded_objects\":" << stats.occludedObjects << ",\"impostors\":" << stats.impostors << "}\n";
+    file << "}\n";
+    std::cout << "Benchmark results written to " << options.outputFile << std::endl;
+
+    // Everything holding GL objects is gone while the context still is, what the manager
+    // still tracks afterwards leaked
+    renderer.reset();
+    scene.reset();
+    ResourceManager::instance().shutdown();
+    return 0;
+}
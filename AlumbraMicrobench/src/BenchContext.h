@@ -0,0 +1,5 @@
+#pragma once
+
+/* True when main created a hidden GL 4.5 context. Benchmarks that need GL call
+    state.skipWithError() otherwise, so the CPU only routines still run on headless machines */
+bool hasGLContext();
@@ -0,0 +1,176 @@
+#include "pch.h"
+#include "Microbench.h"
+#include "SceneBVH.h"
+#include "SoftwareOcclusion.h"
+#include "mesh/Shapes.h"
+
+#include <random>
+
+/* Unit sized boxes scattered uniformly through a cube of the given extent around the origin */
+static std::vector<AABB> makeObjectBounds(unsigned int count, float extent, unsigned int seed = 7)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> position(-extent, extent), size(0.25f, 1.0f);
+    std::vector<AABB> bounds(count);
+    for (auto& box : bounds) {
+        glm::vec3 center(position(rng), position(rng), position(rng));
+        glm::vec3 half(size(rng), size(rng), size(rng));
+        box.min = center - half;
+        box.max = center + half;
+    }
+    return bounds;
+}
+
+// Camera at the origin looking down -z, sees roughly a sixth of the scattered objects
+static Frustum makeFrustum()
+{
+    glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+    return Frustum::fromMatrix(projection);
+}
+
+/* Baseline the BVH has to beat, one plane test per object */
+static void BM_FrustumBruteForce(bench::State& state)
+{
+    auto bounds = makeObjectBounds((unsigned int)state.range(0), 100.0f);
+    Frustum frustum = makeFrustum();
+    std::vector<unsigned int> visible;
+    for (auto _ : state) {
+        visible.clear();
+        for (unsigned int i = 0; i < bounds.size(); i++) {
+            if (frustum.intersects(bounds[i]))
+                visible.push_back(i);
+        }
+        bench::doNotOptimize(visible.data());
+    }
+    state.setItemsProcessed(state.iterations() * bounds.size());
+}
+BENCHMARK(BM_FrustumBruteForce)->Range(1 << 10, 1 << 16);
+
+/* Second argument selects the AVX2 traversal */
+static void BM_BVHFrustumQuery(bench::State& state)
+{
+    bool simd = state.range(1) != 0;
+    if (simd && !SceneBVH::hasAVX2()) {
+        state.skipWithError("needs AVX2");
+        return;
+    }
+    auto bounds = makeObjectBounds((unsigned int)state.range(0), 100.0f);
+    SceneBVH bvh;
+    bvh.build(bounds);
+    Frustum frustum = makeFrustum();
+    std::vector<unsigned int> visible;
+    BVHQueryStats stats;
+    for (auto _ : state) {
+        visible.clear();
+        stats = simd ? bvh.queryAVX2(frustum, visible) : bvh.queryScalar(frustum, visible);
+        bench::doNotOptimize(visible.data());
+    }
+    state.setItemsProcessed(state.iterations() * bounds.size());
+    state.setLabel(std::to_string(stats.visible) + " visible, " + std::to_string(stats.nodesTested) + " nodes");
+}
+BENCHMARK(BM_BVHFrustumQuery)->Args({ 1 << 10, 0 })->Args({ 1 << 10, 1 })->Args({ 1 << 13, 0 })
+    ->Args({ 1 << 13, 1 })->Args({ 1 << 16, 0 })->Args({ 1 << 16, 1 });
+
+/* Moves a tenth of the objects every iteration, most stay inside their fat leaf bounds or are
+    refit in place */
+static void BM_BVHRefit(bench::State& state)
+{
+    auto bounds = makeObjectBounds((unsigned int)state.range(0), 100.0f);
+    SceneBVH bvh;
+    bvh.build(bounds);
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<float> step(-0.2f, 0.2f);
+    unsigned int moving = (unsigned int)bounds.size() / 10, first = 0;
+    for (auto _ : state) {
+        for (unsigned int i = 0; i < moving; i++) {
+            unsigned int object = (first + i) % bounds.size();
+            glm::vec3 offset(step(rng), step(rng), step(rng));
+            bounds[object].min += offset;
+            bounds[object].max += offset;
+            bvh.update(object, bounds[object]);
+        }
+        first += moving;
+    }
+    state.setItemsProcessed(state.iterations() * moving);
+}
+BENCHMARK(BM_BVHRefit)->Range(1 << 10, 1 << 16);
+
+static void BM_BVHBuild(bench::State& state)
+{
+    auto bounds = makeObjectBounds((unsigned int)state.range(0), 100.0f);
+    SceneBVH bvh;
+    for (auto _ : state) {
+        bvh.build(bounds);
+        bench::clobberMemory();
+    }
+    state.setItemsProcessed(state.iterations() * bounds.size());
+}
+BENCHMARK(BM_BVHBuild)->Range(1 << 10, 1 << 16);
+
+/* A wall of cube occluders in front of the camera with small objects scattered behind and in
+    front of it */
+struct OcclusionScene {
+    OccluderMesh cube;
+    std::vector<OccluderInstance> occluders;
+    std::vector<AABB> objectBounds;
+    glm::mat4 viewProjection;
+};
+
+static std::unique_ptr<OcclusionScene> makeOcclusionScene(unsigned int occluderCount, unsigned int objectCount)
+{
+    auto scene = std::make_unique<OcclusionScene>();
+    MeshData data = Cube::generate();
+    scene->cube.positions = data.positions;
+    for (unsigned int i = 0; i < data.positions.size(); i++)
+        scene->cube.indices.push_back(i);
+
+    unsigned int side = std::max(1u, (unsigned int)std::sqrt((double)occluderCount));
+    for (unsigned int i = 0; i < occluderCount; i++) {
+        glm::vec3 position(((float)(i % side) + 0.5f) / side - 0.5f, ((float)(i / side) + 0.5f) / side - 0.5f, 0.0f);
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), position * glm::vec3(40.0f, 24.0f, 1.0f) + glm::vec3(0.0f, 0.0f, -20.0f));
+        model = glm::scale(model, glm::vec3(40.0f / side, 24.0f / side, 1.0f));
+        scene->occluders.push_back({ &scene->cube, model });
+    }
+    scene->objectBounds = makeObjectBounds(objectCount, 15.0f);
+    for (auto& bounds : scene->objectBounds) {
+        bounds.min.z -= 30.0f;
+        bounds.max.z -= 30.0f;
+    }
+    scene->viewProjection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+    return scene;
+}
+
+static void BM_OcclusionRasterize(bench::State& state)
+{
+    auto scene = makeOcclusionScene((unsigned int)state.range(0), 0);
+    JobSystem jobs((int)state.range(1));
+    SoftwareOcclusion occlusion;
+    occlusion.setup(256, 128);
+    for (auto _ : state) {
+        occlusion.render(jobs, scene->viewProjection, scene->occluders);
+        bench::doNotOptimize(occlusion.depth().data());
+    }
+    state.setItemsProcessed(state.iterations() * occlusion.stats().triangles);
+    state.setLabel(std::to_string(jobs.threadCount()) + " threads");
+}
+BENCHMARK(BM_OcclusionRasterize)->Args({ 64, 0 })->Args({ 64, 7 })->Args({ 1024, 0 })->Args({ 1024, 7 });
+
+static void BM_OcclusionTest(bench::State& state)
+{
+    auto scene = makeOcclusionScene(256, (unsigned int)state.range(0));
+    JobSystem jobs((int)state.range(1));
+    SoftwareOcclusion occlusion;
+    occlusion.setup(256, 128);
+    occlusion.render(jobs, scene->viewProjection, scene->occluders);
+    std::vector<unsigned int> objects;
+    for (auto _ : state) {
+        objects.resize(scene->objectBounds.size());
+        for (unsigned int i = 0; i < objects.size(); i++)
+            objects[i] = i;
+        occlusion.filter(jobs, objects, scene->objectBounds);
+        bench::doNotOptimize(objects.data());
+    }
+    state.setItemsProcessed(state.iterations() * scene->objectBounds.size());
+    state.setLabel(std::to_string(occlusion.stats().rejected) + " rejected");
+}
+BENCHMARK(BM_OcclusionTest)->Args({ 1 << 12, 0 })->Args({ 1 << 12, 7 })->Args({ 1 << 16, 0 })->Args({ 1 << 16, 7 });
@@ -0,0 +1,89 @@
+#include "pch.h"
+#include "FreeCamera.h"
+#include "Microbench.h"
+#include "BenchContext.h"
+
+/*
+ * Microbenchmarks for isolated renderer routines (mesh extraction, shape generation, buffer
+ * packing, uniform lookups, HDR decode, ...). Most run without a GL context; the few that
+ * need one get a hidden window unless --no-gl is passed. Run from the AlumbraRenderer
+ * directory so shader files resolve.
+ */
+
+// Window.cpp is compiled in and expects the global camera
+FreeCamera g_camera;
+
+static bool s_hasGLContext = false;
+
+bool hasGLContext()
+{
+    return s_hasGLContext;
+}
+
+static GLFWwindow* createContext(int contextAPI)
+{
+    if (!glfwInit())
+        return nullptr;
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    glfwWindowHint(GLFW_CONTEXT_CREATION_API, contextAPI);
+    GLFWwindow* window = glfwCreateWindow(64, 64, "Alumbra Microbench", NULL, NULL);
+    if (window == NULL) {
+        std::cout << "Failed to create GL context, skipping GL benchmarks" << std::endl;
+        return nullptr;
+    }
+    glfwMakeContextCurrent(window);
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+        std::cout << "Failed to initialize GLAD, skipping GL benchmarks" << std::endl;
+        glfwDestroyWindow(window);
+        return nullptr;
+    }
+    return window;
+}
+
+int main(int argc, char** argv)
+{
+    // Pull out our own flags, everything else goes to the harness
+    bool useGL = true;
+    int contextAPI = GLFW_NATIVE_CONTEXT_API;
+    std::vector<char*> harnessArgs = { argv[0] };
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--no-gl")
+            useGL = false;
+        else if (arg == "--context" && i + 1 < argc) {
+            std::string name = argv[++i];
+            if (name == "egl")
+                contextAPI = GLFW_EGL_CONTEXT_API;
+            else if (name == "osmesa")
+                contextAPI = GLFW_OSMESA_CONTEXT_API;
+        }
+        else
+            harnessArgs.push_back(argv[i]);
+    }
+
+    bench::Options options;
+    if (!bench::parseOptions((int)harnessArgs.size(), harnessArgs.data(), options)) {
+        std::cout << "Usage: AlumbraMicrobench [--filter substring] [--min-time seconds]\n"
+            << "    [--repetitions N] [--json results.json] [--list] [--no-gl]\n"
+            << "    [--context native|egl|osmesa]\n";
+        return 1;
+    }
+
+    GLFWwindow* window = nullptr;
+    if (useGL && !options.list) {
+        window = createContext(contextAPI);
+        s_hasGLContext = window != nullptr;
+        if (s_hasGLContext)
+            std::cout << "GL renderer: " << (const char*)glGetString(GL_RENDERER) << "\n";
+    }
+
+    int result = bench::runAll(options);
+
+    if (window)
+        glfwDestroyWindow(window);
+    glfwTerminate();
+    return result;
+}
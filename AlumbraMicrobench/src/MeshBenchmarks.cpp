@@ -0,0 +1,258 @@
+#include "pch.h"
+#include "Microbench.h"
+#include "BenchContext.h"
+#include "Buffers.h"
+#include "mesh/MeshOptimizer.h"
+#include "mesh/MeshSimplifier.h"
+#include "mesh/Model.h"
+#include "mesh/Shapes.h"
+
+#include <algorithm>
+#include <random>
+
+/* Builds a triangulated side x side grid as ASSIMP would hand it to Model::processMesh, with
+    normals, tangent frames and one UV channel */
+static std::unique_ptr<aiMesh> makeGridMesh(unsigned int vertexCount)
+{
+    unsigned int side = std::max(2u, (unsigned int)std::sqrt((double)vertexCount));
+    auto mesh = std::make_unique<aiMesh>();
+    mesh->mPrimitiveTypes = aiPrimitiveType_TRIANGLE;
+    mesh->mNumVertices = side * side;
+    mesh->mVertices = new aiVector3D[mesh->mNumVertices];
+    mesh->mNormals = new aiVector3D[mesh->mNumVertices];
+    mesh->mTangents = new aiVector3D[mesh->mNumVertices];
+    mesh->mBitangents = new aiVector3D[mesh->mNumVertices];
+    mesh->mTextureCoords[0] = new aiVector3D[mesh->mNumVertices];
+    mesh->mNumUVComponents[0] = 2;
+    for (unsigned int y = 0; y < side; y++) {
+        for (unsigned int x = 0; x < side; x++) {
+            unsigned int i = y * side + x;
+            float u = (float)x / (side - 1), v = (float)y / (side - 1);
+            mesh->mVertices[i] = aiVector3D(u - 0.5f, 0.0f, v - 0.5f);
+            mesh->mNormals[i] = aiVector3D(0.0f, 1.0f, 0.0f);
+            mesh->mTangents[i] = aiVector3D(1.0f, 0.0f, 0.0f);
+            mesh->mBitangents[i] = aiVector3D(0.0f, 0.0f, 1.0f);
+            mesh->mTextureCoords[0][i] = aiVector3D(u, v, 0.0f);
+        }
+    }
+
+    mesh->mNumFaces = 2 * (side - 1) * (side - 1);
+    mesh->mFaces = new aiFace[mesh->mNumFaces];
+    unsigned int face = 0;
+    for (unsigned int y = 0; y + 1 < side; y++) {
+        for (unsigned int x = 0; x + 1 < side; x++) {
+            unsigned int i = y * side + x;
+            unsigned int quad[2][3] = { { i, i + side, i + 1 }, { i + 1, i + side, i + side + 1 } };
+            for (auto& triangle : quad) {
+                mesh->mFaces[face].mNumIndices = 3;
+                mesh->mFaces[face].mIndices = new unsigned int[3]{ triangle[0], triangle[1], triangle[2] };
+                face++;
+            }
+        }
+    }
+    return mesh;
+}
+
+static void BM_ExtractMeshData(bench::State& state)
+{
+    auto mesh = makeGridMesh((unsigned int)state.range(0));
+    for (auto _ : state) {
+        MeshData data = Model::extractMeshData(mesh.get());
+        bench::doNotOptimize(data.indices.data());
+    }
+    state.setItemsProcessed(state.iterations() * mesh->mNumVertices);
+}
+BENCHMARK(BM_ExtractMeshData)->Range(1 << 10, 1 << 20);
+
+/* Grid data the way a file without shared vertices arrives, every face has its own three
+    vertices and the faces are shuffled */
+static MeshData makeUnweldedGrid(unsigned int vertexCount)
+{
+    auto mesh = makeGridMesh(vertexCount);
+    MeshData grid = Model::extractMeshData(mesh.get());
+    std::vector<unsigned int> faces(grid.indices.size() / 3);
+    for (unsigned int i = 0; i < faces.size(); i++)
+        faces[i] = i;
+    std::shuffle(faces.begin(), faces.end(), std::mt19937(5));
+    MeshData data;
+    for (unsigned int face : faces) {
+        for (int k = 0; k < 3; k++) {
+            unsigned int v = grid.indices[face * 3 + k];
+            data.positions.push_back(grid.positions[v]);
+            data.normals.push_back(grid.normals[v]);
+            data.texCoords.push_back(grid.texCoords[v]);
+            data.tangents.push_back(grid.tangents[v]);
+            data.bitangents.push_back(grid.bitangents[v]);
+            data.indices.push_back((unsigned int)data.indices.size());
+        }
+    }
+    return data;
+}
+
+/* The whole import pipeline, the label compares the cache misses per triangle */
+static void BM_MeshOptimize(bench::State& state)
+{
+    MeshData source = makeUnweldedGrid((unsigned int)state.range(0));
+    MeshData data;
+    for (auto _ : state) {
+        data = source;
+        MeshOptimizer::optimize(data);
+        bench::doNotOptimize(data.indices.data());
+    }
+    state.setItemsProcessed(state.iterations() * (source.indices.size() / 3));
+    state.setLabel("ACMR " + std::to_string(MeshOptimizer::analyzeVertexCache(source.indices, (unsigned int)source.positions.size()))
+        + " -> " + std::to_string(MeshOptimizer::analyzeVertexCache(data.indices, (unsigned int)data.positions.size())));
+}
+BENCHMARK(BM_MeshOptimize)->Range(1 << 10, 1 << 18);
+
+static void BM_WeldVertices(bench::State& state)
+{
+    MeshData source = makeUnweldedGrid((unsigned int)state.range(0));
+    for (auto _ : state) {
+        MeshData data = source;
+        MeshOptimizer::weldVertices(data);
+        bench::doNotOptimize(data.positions.data());
+    }
+    state.setItemsProcessed(state.iterations() * source.positions.size());
+}
+BENCHMARK(BM_WeldVertices)->Range(1 << 10, 1 << 18);
+
+static void BM_OptimizeVertexCache(bench::State& state)
+{
+    MeshData source = makeUnweldedGrid((unsigned int)state.range(0));
+    MeshOptimizer::weldVertices(source);
+    for (auto _ : state) {
+        std::vector<unsigned int> indices = source.indices;
+        MeshOptimizer::optimizeVertexCache(indices, (unsigned int)source.positions.size());
+        bench::doNotOptimize(indices.data());
+    }
+    state.setItemsProcessed(state.iterations() * (source.indices.size() / 3));
+}
+BENCHMARK(BM_OptimizeVertexCache)->Range(1 << 10, 1 << 18);
+
+static void BM_SphereGenerate(bench::State& state)
+{
+    int sectors = (int)state.range(0), stacks = (int)state.range(1);
+    for (auto _ : state) {
+        MeshData data = Sphere::generate(sectors, stacks);
+        bench::doNotOptimize(data.positions.data());
+    }
+    state.setItemsProcessed(state.iterations() * (sectors + 1) * (stacks + 1));
+}
+BENCHMARK(BM_SphereGenerate)->Args({ 16, 8 })->Args({ 64, 32 })->Args({ 256, 128 })->Args({ 1024, 512 });
+
+/* Import cost of splitting a mesh into meshlets, the label shows how full they ended up */
+static void BM_MeshletBuild(bench::State& state)
+{
+    int sectors = (int)state.range(0), stacks = (int)state.range(1);
+    MeshData data = Sphere::generate(sectors, stacks);
+    std::vector<Meshlet> meshlets;
+    for (auto _ : state) {
+        std::vector<unsigned int> indices = data.indices;
+        meshlets = Meshlets::build(data.positions, indices);
+        bench::doNotOptimize(meshlets.data());
+    }
+    unsigned int triangles = (unsigned int)data.indices.size() / 3;
+    state.setItemsProcessed(state.iterations() * triangles);
+    state.setLabel(std::to_string(meshlets.size()) + " meshlets, "
+        + std::to_string(triangles / std::max<unsigned int>((unsigned int)meshlets.size(), 1)) + " triangles each");
+}
+BENCHMARK(BM_MeshletBuild)->Args({ 64, 32 })->Args({ 256, 128 })->Args({ 1024, 512 });
+
+/* One halving of a sphere with the quadric simplifier, the label shows the error reached */
+static void BM_Simplify(bench::State& state)
+{
+    int sectors = (int)state.range(0), stacks = (int)state.range(1);
+    MeshData data = Sphere::generate(sectors, stacks);
+    std::vector<unsigned int> simplified;
+    float error = 0.0f;
+    for (auto _ : state) {
+        simplified = MeshSimplifier::simplify(data.positions, data.normals, data.indices,
+            (unsigned int)data.indices.size() / 6 * 3, std::numeric_limits<float>::max(), &error);
+        bench::doNotOptimize(simplified.data());
+    }
+    unsigned int triangles = (unsigned int)data.indices.size() / 3;
+    state.setItemsProcessed(state.iterations() * triangles);
+    state.setLabel(std::to_string(triangles) + " -> " + std::to_string(simplified.size() / 3)
+        + " triangles, error " + std::to_string(error));
+}
+BENCHMARK(BM_Simplify)->Args({ 64, 32 })->Args({ 256, 128 });
+
+/* The whole import time LOD chain, simplification plus cache ordering of every level */
+static void BM_BuildLods(bench::State& state)
+{
+    int sectors = (int)state.range(0), stacks = (int)state.range(1);
+    MeshData source = Sphere::generate(sectors, stacks);
+    MeshData data;
+    for (auto _ : state) {
+        data.indices = source.indices;
+        data.positions = source.positions;
+        data.normals = source.normals;
+        MeshSimplifier::buildLods(data);
+        bench::doNotOptimize(data.indices.data());
+    }
+    state.setItemsProcessed(state.iterations() * (source.indices.size() / 3));
+    std::string label = std::to_string(data.lods.size()) + " levels:";
+    for (const auto& lod : data.lods)
+        label += " " + std::to_string(lod.indexCount / 3);
+    state.setLabel(label);
+}
+BENCHMARK(BM_BuildLods)->Args({ 64, 32 })->Args({ 256, 128 });
+
+static VertexStreams meshStreams(const MeshData& data)
+{
+    VertexStreams streams;
+    streams.positions = data.positions.data();
+    streams.normals = data.normals.data();
+    streams.texCoords = data.texCoords.data();
+    streams.tangents = data.tangents.data();
+    streams.bitangents = data.bitangents.data();
+    return streams;
+}
+
+/* Interleaves and quantizes the streams Mesh::setupMesh uploads, CPU only. Bytes processed are
+    the planar float streams read, the label compares them with the packed vertices written */
+static void BM_VertexPack(bench::State& state)
+{
+    auto mesh = makeGridMesh((unsigned int)state.range(0));
+    MeshData data = Model::extractMeshData(mesh.get());
+    size_t vertexCount = data.positions.size();
+    std::vector<unsigned char> packed(vertexCount * MeshVertexFormat::STRIDE);
+    VertexStreams streams = meshStreams(data);
+
+    for (auto _ : state) {
+        MeshVertexFormat::pack(streams, vertexCount, packed.data());
+        bench::doNotOptimize(packed.data());
+    }
+    size_t planar = (sizeof(glm::vec3) * 4 + sizeof(glm::vec2)) * vertexCount;
+    state.setBytesProcessed(state.iterations() * planar);
+    state.setLabel(std::to_string(planar / vertexCount) + " -> " + std::to_string(MeshVertexFormat::STRIDE)
+        + " bytes per vertex");
+}
+BENCHMARK(BM_VertexPack)->Range(1 << 10, 1 << 20);
+
+/* Full upload as Mesh::setupMesh does it, packing, narrowing indices, buffer and VAO creation */
+static void BM_VertexUpload(bench::State& state)
+{
+    if (!hasGLContext()) {
+        state.skipWithError("needs a GL context");
+        return;
+    }
+    auto mesh = makeGridMesh((unsigned int)state.range(0));
+    MeshData data = Model::extractMeshData(mesh.get());
+    VertexStreams streams = meshStreams(data);
+
+    size_t size = 0;
+    for (auto _ : state) {
+        VertexUpload upload = MeshVertexFormat::upload(streams, data.positions.size(), data.indices);
+        size = upload.size;
+        glDeleteVertexArrays(1, &upload.vertexArrayID);
+        glDeleteBuffers(1, &upload.bufferID);
+    }
+    glFinish();
+    size_t planar = sizeof(unsigned int) * data.indices.size()
+        + (sizeof(glm::vec3) * 4 + sizeof(glm::vec2)) * data.positions.size();
+    state.setBytesProcessed(state.iterations() * size);
+    state.setLabel(std::to_string(planar / 1024) + " -> " + std::to_string(size / 1024) + " KB");
+}
+BENCHMARK(BM_VertexUpload)->Range(1 << 10, 1 << 20);
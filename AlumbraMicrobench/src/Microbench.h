@@ -0,0 +1,385 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+/*
+ * Minimal header-only microbenchmark harness modelled on Google Benchmark. Benchmarks are free
+ * functions taking a bench::State and registered with BENCHMARK(fn), optionally parameterized
+ * with ->Arg(), ->Args() or ->Range(). Each run is calibrated until it lasts at least the
+ * minimum time, then timed over a number of repetitions:
+ *
+ *     static void BM_Thing(bench::State& state) {
+ *         auto input = makeInput(state.range(0));
+ *         for (auto _ : state)
+ *             bench::doNotOptimize(process(input));
+ *         state.setItemsProcessed(state.iterations() * state.range(0));
+ *     }
+ *     BENCHMARK(BM_Thing)->Range(64, 64 << 10);
+ */
+namespace bench {
+
+using Clock = std::chrono::steady_clock;
+
+/* Forces the compiler to materialize value without generating extra code around it */
+template <typename T>
+inline void doNotOptimize(T const& value)
+{
+#ifdef _MSC_VER
+    static char const volatile* volatile sink;
+    sink = &reinterpret_cast<char const volatile&>(value);
+    _ReadWriteBarrier();
+#else
+    asm volatile("" : : "r,m"(value) : "memory");
+#endif
+}
+
+/* Prevents the compiler from assuming memory is unchanged across the call, e.g. to keep
+    stores into a buffer that is never read back */
+inline void clobberMemory()
+{
+#ifdef _MSC_VER
+    _ReadWriteBarrier();
+#else
+    asm volatile("" : : : "memory");
+#endif
+}
+
+class State {
+public:
+    State(uint64_t maxIterations, const std::vector<int64_t>& args)
+        : m_maxIterations(maxIterations), m_args(args) {}
+
+    // What the range-for hands the loop body, marked so `for (auto _ : state)` does not warn
+    struct [[maybe_unused]] Value {};
+
+    struct Iterator {
+        State* state;
+        uint64_t remaining;
+
+        inline bool operator!=(const Iterator&) const
+        {
+            if (remaining != 0)
+                return true;
+            state->finishKeepRunning();
+            return false;
+        }
+        inline void operator++() { --remaining; }
+        inline Value operator*() const { return Value(); }
+    };
+
+    /* Range-for support, the loop body is the timed region */
+    inline Iterator begin()
+    {
+        startKeepRunning();
+        return Iterator{ this, m_skipped ? 0 : m_maxIterations };
+    }
+    inline Iterator end() { return Iterator{ this, 0 }; }
+
+    /* Excludes per-iteration setup from the measurement, expensive so use sparingly */
+    inline void pauseTiming() { m_elapsed += Clock::now() - m_start; }
+    inline void resumeTiming() { m_start = Clock::now(); }
+
+    inline void skipWithError(const std::string& message)
+    {
+        m_skipped = true;
+        m_error = message;
+    }
+
+    inline int64_t range(size_t index = 0) const { return index < m_args.size() ? m_args[index] : 0; }
+    inline uint64_t iterations() const { return m_maxIterations; }
+    inline void setItemsProcessed(int64_t items) { m_itemsProcessed = items; }
+    inline void setBytesProcessed(int64_t bytes) { m_bytesProcessed = bytes; }
+    inline void setLabel(const std::string& label) { m_label = label; }
+
+    inline double elapsedSeconds() const { return std::chrono::duration<double>(m_elapsed).count(); }
+    inline int64_t itemsProcessed() const { return m_itemsProcessed; }
+    inline int64_t bytesProcessed() const { return m_bytesProcessed; }
+    inline const std::string& label() const { return m_label; }
+    inline bool skipped() const { return m_skipped; }
+    inline const std::string& error() const { return m_error; }
+
+private:
+    uint64_t m_maxIterations;
+    std::vector<int64_t> m_args;
+    Clock::time_point m_start;
+    Clock::duration m_elapsed = Clock::duration::zero();
+    int64_t m_itemsProcessed = 0;
+    int64_t m_bytesProcessed = 0;
+    std::string m_label;
+    bool m_skipped = false;
+    std::string m_error;
+
+    inline void startKeepRunning() { m_start = Clock::now(); }
+    inline void finishKeepRunning() { m_elapsed += Clock::now() - m_start; }
+};
+
+using Function = void (*)(State&);
+
+class Benchmark {
+public:
+    Benchmark(const std::string& name, Function function) : m_name(name), m_function(function) {}
+
+    Benchmark* Arg(int64_t value)
+    {
+        m_argSets.push_back({ value });
+        return this;
+    }
+
+    Benchmark* Args(const std::vector<int64_t>& values)
+    {
+        m_argSets.push_back(values);
+        return this;
+    }
+
+    /* Adds lo, every power of the range multiplier in between, and hi */
+    Benchmark* Range(int64_t lo, int64_t hi)
+    {
+        for (int64_t value = lo; value < hi; value *= m_rangeMultiplier)
+            m_argSets.push_back({ value });
+        m_argSets.push_back({ hi });
+        return this;
+    }
+
+    Benchmark* RangeMultiplier(int multiplier)
+    {
+        m_rangeMultiplier = std::max(multiplier, 2);
+        return this;
+    }
+
+    inline const std::string& name() const { return m_name; }
+    inline Function function() const { return m_function; }
+    inline const std::vector<std::vector<int64_t>>& argSets() const { return m_argSets; }
+
+private:
+    std::string m_name;
+    Function m_function;
+    std::vector<std::vector<int64_t>> m_argSets;
+    int m_rangeMultiplier = 8;
+};
+
+inline std::vector<std::unique_ptr<Benchmark>>& registry()
+{
+    static std::vector<std::unique_ptr<Benchmark>> benchmarks;
+    return benchmarks;
+}
+
+inline Benchmark* registerBenchmark(const char* name, Function function)
+{
+    registry().push_back(std::make_unique<Benchmark>(name, function));
+    return registry().back().get();
+}
+
+struct Options {
+    double minTime = 0.5;
+    int repetitions = 1;
+    std::string filter;
+    std::string jsonFile;
+    bool list = false;
+};
+
+struct Result {
+    std::string name;
+    std::string label;
+    std::string error;
+    uint64_t iterations = 0;
+    double nsPerIteration = 0.0, stddev = 0.0;
+    double itemsPerSecond = 0.0, bytesPerSecond = 0.0;
+};
+
+inline std::string runName(const Benchmark& benchmark, const std::vector<int64_t>& args)
+{
+    std::string name = benchmark.name();
+    for (int64_t arg : args)
+        name += "/" + std::to_string(arg);
+    return name;
+}
+
+/* Grows the iteration count until a run lasts minTime, then times the requested repetitions
+    at that count */
+inline Result run(const Benchmark& benchmark, const std::vector<int64_t>& args, const Options& options)
+{
+    Result result;
+    result.name = runName(benchmark, args);
+
+    uint64_t iterations = 1;
+    for (;;) {
+        State state(iterations, args);
+        benchmark.function()(state);
+        if (state.skipped()) {
+            result.error = state.error();
+            return result;
+        }
+        double seconds = state.elapsedSeconds();
+        if (seconds >= options.minTime || iterations >= 1000000000ull)
+            break;
+        // Aim 40% past the minimum time, but never grow more than 10x per step
+        double multiplier = seconds > 0.0 ? options.minTime * 1.4 / seconds : 10.0;
+        iterations = (uint64_t)(iterations * std::min(std::max(multiplier, 1.5), 10.0)) + 1;
+    }
+
+    std::vector<double> samples;
+    double itemsPerSecond = 0.0, bytesPerSecond = 0.0;
+    for (int rep = 0; rep < std::max(options.repetitions, 1); rep++) {
+        State state(iterations, args);
+        benchmark.function()(state);
+        double seconds = std::max(state.elapsedSeconds(), 1e-12);
+        samples.push_back(seconds * 1e9 / iterations);
+        itemsPerSecond += state.itemsProcessed() / seconds;
+        bytesPerSecond += state.bytesProcessed() / seconds;
+        result.label = state.label();
+    }
+
+    double mean = 0.0;
+    for (double sample : samples)
+        mean += sample;
+    mean /= samples.size();
+    double variance = 0.0;
+    for (double sample : samples)
+        variance += (sample - mean) * (sample - mean);
+
+    result.iterations = iterations;
+    result.nsPerIteration = mean;
+    result.stddev = samples.size() > 1 ? std::sqrt(variance / (samples.size() - 1)) : 0.0;
+    result.itemsPerSecond = itemsPerSecond / samples.size();
+    result.bytesPerSecond = bytesPerSecond / samples.size();
+    return result;
+}
+
+inline std::string formatTime(double ns)
+{
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(2);
+    if (ns < 1e3)
+        out << ns << " ns";
+    else if (ns < 1e6)
+        out << ns / 1e3 << " us";
+    else
+        out << ns / 1e6 << " ms";
+    return out.str();
+}
+
+inline std::string formatRate(double perSecond, const char* unit)
+{
+    const char* prefixes[] = { "", "k", "M", "G", "T" };
+    int prefix = 0;
+    while (perSecond >= 1000.0 && prefix < 4) {
+        perSecond /= 1000.0;
+        prefix++;
+    }
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(2) << perSecond << " " << prefixes[prefix] << unit << "/s";
+    return out.str();
+}
+
+inline void writeJSON(const std::string& path, const std::vector<Result>& results)
+{
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        std::cout << "ERROR::MICROBENCH::Could not write " << path << std::endl;
+        return;
+    }
+    file << "{\n  \"benchmarks\": [";
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result& r = results[i];
+        file << (i == 0 ? "" : ",") << "\n    {\"name\":\"" << r.name << "\"";
+        if (!r.error.empty()) {
+            file << ",\"error\":\"" << r.error << "\"}";
+            continue;
+        }
+        file << ",\"iterations\":" << r.iterations << ",\"ns_per_iteration\":" << r.nsPerIteration
+            << ",\"stddev_ns\":" << r.stddev << ",\"items_per_second\":" << r.itemsPerSecond
+            << ",\"bytes_per_second\":" << r.bytesPerSecond << ",\"label\":\"" << r.label << "\"}";
+    }
+    file << "\n  ]\n}\n";
+}
+
+inline bool parseOptions(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--filter" && hasValue)
+            options.filter = argv[++i];
+        else if (arg == "--min-time" && hasValue)
+            options.minTime = std::stod(argv[++i]);
+        else if (arg == "--repetitions" && hasValue)
+            options.repetitions = std::stoi(argv[++i]);
+        else if (arg == "--json" && hasValue)
+            options.jsonFile = argv[++i];
+        else if (arg == "--list")
+            options.list = true;
+        else
+            return false;
+    }
+    return true;
+}
+
+/* Runs every registered benchmark whose name contains the filter and prints a result table */
+inline int runAll(const Options& options)
+{
+    std::vector<Result> results;
+    if (!options.list) {
+        std::cout << std::left << std::setw(48) << "Benchmark" << std::right << std::setw(14) << "Time"
+            << std::setw(14) << "StdDev" << std::setw(14) << "Iterations" << "  Throughput\n";
+        std::cout << std::string(110, '-') << "\n";
+    }
+
+    for (const auto& benchmark : registry()) {
+        auto argSets = benchmark->argSets();
+        if (argSets.empty())
+            argSets.push_back({});
+        for (const auto& args : argSets) {
+            std::string name = runName(*benchmark, args);
+            if (!options.filter.empty() && name.find(options.filter) == std::string::npos)
+                continue;
+            if (options.list) {
+                std::cout << name << "\n";
+                continue;
+            }
+
+            Result result = run(*benchmark, args, options);
+            std::cout << std::left << std::setw(48) << result.name << std::right;
+            if (!result.error.empty()) {
+                std::cout << "  SKIPPED: " << result.error << std::endl;
+            }
+            else {
+                std::cout << std::setw(14) << formatTime(result.nsPerIteration)
+                    << std::setw(14) << formatTime(result.stddev) << std::setw(14) << result.iterations;
+                if (result.itemsPerSecond > 0.0)
+                    std::cout << "  " << formatRate(result.itemsPerSecond, "items");
+                if (result.bytesPerSecond > 0.0)
+                    std::cout << "  " << formatRate(result.bytesPerSecond, "B");
+                if (!result.label.empty())
+                    std::cout << "  " << result.label;
+                std::cout << std::endl;
+            }
+            results.push_back(result);
+        }
+    }
+
+    if (!options.jsonFile.empty())
+        writeJSON(options.jsonFile, results);
+    return 0;
+}
+
+} // namespace bench
+
+#define BENCHMARK_CONCAT_IMPL(a, b) a##b
+#define BENCHMARK_CONCAT(a, b) BENCHMARK_CONCAT_IMPL(a, b)
+#define BENCHMARK(fn) \
+    static bench::Benchmark* BENCHMARK_CONCAT(s_benchmark_, __LINE__) = bench::registerBenchmark(#fn, fn)
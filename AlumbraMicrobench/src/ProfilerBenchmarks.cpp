@@ -0,0 +1,22 @@
+#include "pch.h"
+#include "Microbench.h"
+#include "Profiler.h"
+
+/* Overhead of an empty PROFILE_SCOPE, paid by every instrumented block */
+static void BM_ProfileScope(bench::State& state)
+{
+    for (auto _ : state) {
+        PROFILE_SCOPE("Microbench");
+        bench::clobberMemory();
+    }
+    state.setItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ProfileScope);
+
+static void BM_ProfilerNow(bench::State& state)
+{
+    for (auto _ : state)
+        bench::doNotOptimize(Profiler::now());
+    state.setItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ProfilerNow);
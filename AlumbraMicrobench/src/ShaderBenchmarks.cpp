@@ -0,0 +1,56 @@
+#include "pch.h"
+#include "Microbench.h"
+#include "BenchContext.h"
+#include "Shader.h"
+
+/* Compiles a small program and warms its uniform cache with cacheSize names. Unknown names
+    are cached too (as -1), so the cache can be grown past the program's real uniforms */
+static bool makeWarmShader(Shader& shader, int cacheSize, std::vector<std::string>& names)
+{
+    if (!hasGLContext())
+        return false;
+    shader.graphicsShaders({ "src/shaders/screen_quad.vert", "src/shaders/screen_quad.frag" });
+    // Long enough to defeat the small string optimization, like "material.texture_albedo"
+    for (int i = 0; i < cacheSize; i++)
+        names.push_back("pointLights[" + std::to_string(i) + "].position");
+    for (const auto& name : names)
+        shader.getUniformLocation(name);
+    return true;
+}
+
+/* Cache hit with a prebuilt std::string, the hash and compare cost only */
+static void BM_UniformLocationCached(bench::State& state)
+{
+    Shader shader;
+    std::vector<std::string> names;
+    if (!makeWarmShader(shader, (int)state.range(0), names)) {
+        state.skipWithError("needs a GL context");
+        return;
+    }
+    size_t i = 0;
+    for (auto _ : state) {
+        bench::doNotOptimize(shader.getUniformLocation(names[i]));
+        i = i + 1 == names.size() ? 0 : i + 1;
+    }
+    state.setItemsProcessed(state.iterations());
+    glDeleteProgram(shader.ID);
+}
+BENCHMARK(BM_UniformLocationCached)->Range(8, 512);
+
+/* Cache hit through a string literal as the set* helpers are called from the render passes,
+    which adds a std::string construction per call */
+static void BM_UniformLocationFromLiteral(bench::State& state)
+{
+    Shader shader;
+    std::vector<std::string> names;
+    if (!makeWarmShader(shader, (int)state.range(0), names)) {
+        state.skipWithError("needs a GL context");
+        return;
+    }
+    shader.getUniformLocation("material.texture_albedo");
+    for (auto _ : state)
+        bench::doNotOptimize(shader.getUniformLocation("material.texture_albedo"));
+    state.setItemsProcessed(state.iterations());
+    glDeleteProgram(shader.ID);
+}
+BENCHMARK(BM_UniformLocationFromLiteral)->Range(8, 512);
@@ -0,0 +1,73 @@
+#include "pch.h"
+#include "Microbench.h"
+
+#include <stb_image.h>
+
+/* Encodes a width x height gradient as a Radiance .hdr file in memory, using the run length
+    encoded scanlines that real environment maps ship with */
+static std::vector<unsigned char> makeRGBEImage(int width, int height)
+{
+    std::string header = "#?RADIANCE\nFORMAT=32-bit_rle_rgbe\n\n-Y " + std::to_string(height)
+        + " +X " + std::to_string(width) + "\n";
+    std::vector<unsigned char> image(header.begin(), header.end());
+
+    std::vector<unsigned char> scanline(width * 4);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            // Exponent 129 puts the mantissas in [0, 2), sky-like values
+            scanline[x * 4 + 0] = (unsigned char)(x * 255 / width);
+            scanline[x * 4 + 1] = (unsigned char)(y * 255 / height);
+            scanline[x * 4 + 2] = 128;
+            scanline[x * 4 + 3] = 129;
+        }
+        unsigned char start[4] = { 2, 2, (unsigned char)(width >> 8), (unsigned char)(width & 0xFF) };
+        image.insert(image.end(), start, start + 4);
+        // Each component is stored separately as runs, literal runs are up to 128 bytes
+        for (int c = 0; c < 4; c++) {
+            int x = 0;
+            while (x < width) {
+                int run = 1;
+                while (x + run < width && run < 127 && scanline[(x + run) * 4 + c] == scanline[x * 4 + c])
+                    run++;
+                if (run > 2) {
+                    image.push_back((unsigned char)(128 + run));
+                    image.push_back(scanline[x * 4 + c]);
+                    x += run;
+                    continue;
+                }
+                // Extend the literal up to the next run worth encoding
+                int literal = 1;
+                while (x + literal < width && literal < 128 && !(x + literal + 2 < width
+                    && scanline[(x + literal) * 4 + c] == scanline[(x + literal + 1) * 4 + c]
+                    && scanline[(x + literal) * 4 + c] == scanline[(x + literal + 2) * 4 + c]))
+                    literal++;
+                image.push_back((unsigned char)literal);
+                for (int i = 0; i < literal; i++)
+                    image.push_back(scanline[(x + i) * 4 + c]);
+                x += literal;
+            }
+        }
+    }
+    return image;
+}
+
+/* Decode of a 2:1 equirectangular map as done by Cubemap::loadHDRMap */
+static void BM_HDRDecode(bench::State& state)
+{
+    int width = (int)state.range(0), height = width / 2;
+    auto image = makeRGBEImage(width, height);
+    stbi_set_flip_vertically_on_load(true);
+    for (auto _ : state) {
+        int w, h, components;
+        float* data = stbi_loadf_from_memory(image.data(), (int)image.size(), &w, &h, &components, 0);
+        if (!data) {
+            state.skipWithError(stbi_failure_reason());
+            break;
+        }
+        bench::doNotOptimize(data[0]);
+        stbi_image_free(data);
+    }
+    state.setItemsProcessed(state.iterations() * width * height);
+    state.setBytesProcessed(state.iterations() * image.size());
+}
+BENCHMARK(BM_HDRDecode)->RangeMultiplier(2)->Range(256, 4096);
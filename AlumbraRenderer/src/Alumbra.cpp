@@ -3,11 +3,15 @@
 #include "Window.h"
 #include "Scene.h"
 #include "Renderer.h"
+#include "Profiler.h"
+#include "CameraPath.h"
 
 #include <stb_image.h>
 
 const int windowWidth = 1920;
 const int windowHeight = 1080;
+// Where camera paths recorded with R are saved, AlumbraBenchmark replays them with --path
+const std::string recordedPathFile = "recorded_camera.path";
 
 // timing
 float deltaTime = 0.0f;
@@ -17,11 +21,29 @@ FreeCamera g_camera(glm::vec3(0.0f, 1.5f, 4.0f));
 
 int main()
 {
+    Profiler::setThreadName("Main");
+    auto startup = std::make_unique<ProfileScope>("Startup");
     Window window("Alumbra", windowWidth, windowHeight);
-    Scene scene;
-    Renderer renderer(&scene);
+    std::unique_ptr<Scene> scene;
+    {
+        PROFILE_SCOPE("Scene Load");
+        scene = std::make_unique<Scene>();
+    }
+    std::unique_ptr<Renderer> renderer;
+    {
+        PROFILE_SCOPE("Renderer Init");
+        renderer = std::make_unique<Renderer>(scene.get());
+    }
+    startup.reset();
+
+    CameraPath recordedPath;
+    float recordStart = 0.0f;
+    bool wasRecording = false;
 
     while (!window.isClosed()) {
+        Profiler::beginFrame();
+        PROFILE_SCOPE("Frame");
+
         // per-frame time logic
         float currentFrame = glfwGetTime();
         deltaTime = currentFrame - lastFrame;
@@ -29,13 +51,33 @@ int main()
 
         window.processInput(deltaTime);
 
+        if (Window::recordingPath()) {
+            if (!wasRecording) {
+                recordedPath.clear();
+                recordStart = currentFrame;
+            }
+            recordedPath.addKeyframe(currentFrame - recordStart, g_camera);
+        }
+        else if (wasRecording) {
+            recordedPath.save(recordedPathFile);
+        }
+        wasRecording = Window::recordingPath();
+
         window.clear();
 
-        renderer.beginDraw();
+        renderer->beginDraw();
 
-        window.update();
+        {
+            PROFILE_SCOPE("Swap Buffers");
+            window.update();
+        }
     }
 
+    // Everything holding GL objects is gone while the context still is, what the manager
+    // still tracks afterwards leaked
+    renderer.reset();
+    scene.reset();
+    ResourceManager::instance().shutdown();
     return 0;
 }
 
@@ -0,0 +1,249 @@
+#include "pch.h"
+#include "AssetRegistry.h"
+#include "Profiler.h"
+
+#include <cstring>
+#include <filesystem>
+
+AssetRegistry& AssetRegistry::instance()
+{
+    static AssetRegistry registry;
+    return registry;
+}
+
+/* Filtering and wrapping are part of a texture, requests differing in them never share */
+static unsigned long long hashOptions(const TextureOptions& options)
+{
+    GLint values[5] = { options.minFilter, options.magFilter, options.wrapS, options.wrapT, options.wrapR };
+    return AssetRegistry::hashBytes(values, sizeof(values), 0x5bd1e995ull);
+}
+
+TextureHandle AssetRegistry::texture(const std::string& path, const TextureOptions& options)
+{
+    unsigned long long optionsHash = hashOptions(options);
+    std::string canonical = canonicalPath(path);
+    std::string key = canonical + "|" + std::to_string(optionsHash);
+    auto byPath = m_texturePaths.find(key);
+    if (byPath != m_texturePaths.end()) {
+        m_stats.textureReuses++;
+        return lockTexture(byPath->second);
+    }
+
+    std::vector<unsigned char> bytes;
+    if (!TextureLoader::readFile(path, bytes)) {
+        std::cout << "Texture failed to load at path: " << path << std::endl;
+        return nullptr;
+    }
+    // Another path to the same bytes, the path becomes one more key of the loaded texture
+    unsigned long long hash = hashBytes(bytes.data(), bytes.size(), optionsHash);
+    auto byHash = m_textureHashes.find(hash);
+    if (byHash != m_textureHashes.end()) {
+        m_stats.textureReuses++;
+        m_texturePaths[key] = byHash->second;
+        m_textures[byHash->second].paths.push_back(key);
+        return lockTexture(byHash->second);
+    }
+
+    PROFILE_SCOPE("Texture Load");
+    auto* texture = new TextureAsset();
+    texture->path = canonical;
+    texture->options = options;
+    texture->lastUsedFrame = ResourceManager::instance().frame();
+    uploadTexture(*texture, bytes, 0);
+    TextureHandle handle(texture, [this](TextureAsset* texture) { releaseTexture(texture); });
+    m_texturePaths[key] = texture;
+    m_textureHashes[hash] = texture;
+    m_textures[texture] = { handle, hash, { key } };
+    m_stats.textures++;
+    return handle;
+}
+
+MeshHandle AssetRegistry::mesh(MeshData data, const std::vector<MeshTexture>& textures,
+    const std::function<void(MeshData&)>& prepare, const std::string& path)
+{
+    unsigned long long hash = hashMesh(data, textures);
+    auto byHash = m_meshHashes.find(hash);
+    if (byHash != m_meshHashes.end()) {
+        m_stats.meshReuses++;
+        if (!path.empty() && m_meshPaths.emplace(path, byHash->second).second)
+            m_meshes[byHash->second].paths.push_back(path);
+        return lockMesh(byHash->second);
+    }
+
+    if (prepare)
+        prepare(data);
+    auto* mesh = new Mesh(data, textures);
+    MeshHandle handle(mesh, [this](Mesh* mesh) { releaseMesh(mesh); });
+    m_meshHashes[hash] = mesh;
+    m_meshes[mesh] = { handle, hash, {} };
+    if (!path.empty()) {
+        m_meshPaths[path] = mesh;
+        m_meshes[mesh].paths.push_back(path);
+    }
+    m_stats.meshes++;
+    return handle;
+}
+
+GLuint AssetRegistry::useTexture(TextureAsset& texture)
+{
+    texture.lastUsedFrame = ResourceManager::instance().frame();
+    if (texture.id == 0)
+        streamTexture(texture, texture.downscale);
+    return texture.id;
+}
+
+bool AssetRegistry::streamTexture(TextureAsset& texture, unsigned int downscale)
+{
+    PROFILE_SCOPE("Texture Stream");
+    std::vector<unsigned char> bytes;
+    if (!TextureLoader::readFile(texture.path, bytes)) {
+        std::cout << "Texture failed to stream from path: " << texture.path << std::endl;
+        return false;
+    }
+    uploadTexture(texture, bytes, downscale);
+    return true;
+}
+
+void AssetRegistry::evictTexture(TextureAsset& texture)
+{
+    texture.resource.reset();
+    texture.id = 0;
+}
+
+std::vector<TextureAsset*> AssetRegistry::textures() const
+{
+    std::vector<TextureAsset*> result;
+    result.reserve(m_textures.size());
+    for (const auto& entry : m_textures)
+        result.push_back(entry.first);
+    return result;
+}
+
+std::vector<Mesh*> AssetRegistry::meshes() const
+{
+    std::vector<Mesh*> result;
+    result.reserve(m_meshes.size());
+    for (const auto& entry : m_meshes)
+        result.push_back(entry.first);
+    return result;
+}
+
+MeshHandle AssetRegistry::findMesh(const std::string& path)
+{
+    auto byPath = m_meshPaths.find(path);
+    if (byPath == m_meshPaths.end())
+        return nullptr;
+    m_stats.meshReuses++;
+    return lockMesh(byPath->second);
+}
+
+std::string AssetRegistry::canonicalPath(const std::string& path)
+{
+    std::error_code error;
+    std::filesystem::path canonical = std::filesystem::weakly_canonical(path, error);
+    if (error)
+        canonical = std::filesystem::path(path).lexically_normal();
+    return canonical.generic_string();
+}
+
+/* MurmurHash64A */
+unsigned long long AssetRegistry::hashBytes(const void* data, size_t size, unsigned long long seed)
+{
+    const unsigned long long m = 0xc6a4a7935bd1e995ull;
+    const int r = 47;
+    unsigned long long h = seed ^ (size * m);
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    const unsigned char* end = bytes + (size & ~(size_t)7);
+    for (; bytes != end; bytes += 8) {
+        unsigned long long k;
+        std::memcpy(&k, bytes, 8);
+        k *= m;
+        k ^= k >> r;
+        k *= m;
+        h ^= k;
+        h *= m;
+    }
+    if (size & 7) {
+        unsigned long long tail = 0;
+        std::memcpy(&tail, bytes, size & 7);
+        h ^= tail;
+        h *= m;
+    }
+    h ^= h >> r;
+    h *= m;
+    h ^= h >> r;
+    return h;
+}
+
+unsigned long long AssetRegistry::hashMesh(const MeshData& data, const std::vector<MeshTexture>& textures)
+{
+    unsigned long long h = hashBytes(data.positions.data(), data.positions.size() * sizeof(glm::vec3));
+    h = hashBytes(data.normals.data(), data.normals.size() * sizeof(glm::vec3), h);
+    h = hashBytes(data.texCoords.data(), data.texCoords.size() * sizeof(glm::vec2), h);
+    h = hashBytes(data.tangents.data(), data.tangents.size() * sizeof(glm::vec3), h);
+    h = hashBytes(data.bitangents.data(), data.bitangents.size() * sizeof(glm::vec3), h);
+    h = hashBytes(data.indices.data(), data.indices.size() * sizeof(unsigned int), h);
+    h = hashBytes(data.lods.data(), data.lods.size() * sizeof(MeshLod), h);
+    for (const auto& texture : textures) {
+        // A registry texture's id changes when it is streamed or evicted, its file and options do not
+        if (texture.asset) {
+            h = hashBytes(texture.asset->path.data(), texture.asset->path.size(), h);
+            unsigned long long options = hashOptions(texture.asset->options);
+            h = hashBytes(&options, sizeof(options), h);
+        }
+        else {
+            h = hashBytes(&texture.id, sizeof(texture.id), h);
+        }
+        h = hashBytes(texture.type.data(), texture.type.size(), h);
+    }
+    return h;
+}
+
+TextureHandle AssetRegistry::lockTexture(TextureAsset* texture)
+{
+    return m_textures[texture].asset.lock();
+}
+
+MeshHandle AssetRegistry::lockMesh(Mesh* mesh)
+{
+    return m_meshes[mesh].asset.lock();
+}
+
+/* Replaces the texture's GL object with a new upload of the file's bytes, meshes pick the new
+    id up through useTexture */
+void AssetRegistry::uploadTexture(TextureAsset& texture, const std::vector<unsigned char>& bytes,
+    unsigned int downscale)
+{
+    TextureLoader loader;
+    loader.createNew(GL_TEXTURE_2D, texture.options);
+    GLuint id = loader.memoryTexture(bytes.data(), bytes.size(), texture.path, downscale);
+    ResourceManager& resources = ResourceManager::instance();
+    texture.resource = GpuResource(resources.adopt(ResourceType::Texture, ResourceCategory::Texture, id, 0,
+        texture.path));
+    resources.measureTexture(texture.resource.handle());
+    texture.id = id;
+    texture.downscale = downscale;
+}
+
+/* Deleter of the handles, runs when the last one is gone */
+void AssetRegistry::releaseTexture(TextureAsset* texture)
+{
+    auto entry = m_textures.find(texture);
+    for (const auto& path : entry->second.paths)
+        m_texturePaths.erase(path);
+    m_textureHashes.erase(entry->second.hash);
+    m_textures.erase(entry);
+    m_stats.textures--;
+    delete texture;
+}
+
+void AssetRegistry::releaseMesh(Mesh* mesh)
+{
+    auto entry = m_meshes.find(mesh);
+    for (const auto& path : entry->second.paths)
+        m_meshPaths.erase(path);
+    m_meshHashes.erase(entry->second.hash);
+    m_meshes.erase(entry);
+    m_stats.meshes--;
+    delete mesh;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "mesh/Mesh.h"
+#include "Texture.h"
+
+#include <functional>
+#include <unordered_map>
+
+using TextureHandle = std::shared_ptr<TextureAsset>;
+using MeshHandle = std::shared_ptr<Mesh>;
+
+struct AssetStats {
+    // Assets with at least one handle alive
+    unsigned int textures = 0;
+    unsigned int meshes = 0;
+    // Requests answered with an asset that was already loaded, by path or by content
+    unsigned int textureReuses = 0;
+    unsigned int meshReuses = 0;
+};
+
+/**
+ * Process wide registry deduplicating textures and meshes across every model of the scene.
+ * Assets are found in O(1) by canonical path and by a 64 bit hash of their content, so the
+ * same file reached through two relative paths, or two files with identical bytes, load once.
+ * Handles are reference counted, the registry only keeps weak references and an asset leaves
+ * it (a texture also frees its GL object) when the last model holding it is deleted. Loading
+ * is meant for the main thread, the registry takes no locks.
+ */
+class AssetRegistry {
+public:
+    static AssetRegistry& instance();
+
+    /* Loads an image once per canonical path and content, null when the file cannot be read */
+    TextureHandle texture(const std::string& path, const TextureOptions& options = TextureOptions());
+
+    /* Returns the live mesh built from the same data and textures, else runs prepare on the
+        data (the processing a shared mesh skips, like optimizing and building LODs), uploads it
+        and registers it. A non empty path is registered as another key for the result */
+    MeshHandle mesh(MeshData data, const std::vector<MeshTexture>& textures = {},
+        const std::function<void(MeshData&)>& prepare = nullptr, const std::string& path = "");
+    /* Mesh registered under a path key by an earlier mesh call, null when none is alive */
+    MeshHandle findMesh(const std::string& path);
+
+    /* Id to bind a registry texture with. Marks it used this frame and streams it back in,
+        at the resolution it was last downscaled to, when it was evicted */
+    GLuint useTexture(TextureAsset& texture);
+    /* Reloads a texture from its file with its resolution halved downscale times. The previous
+        GL texture is released to the ResourceManager and deleted once no frame uses it */
+    bool streamTexture(TextureAsset& texture, unsigned int downscale);
+    /* Frees the GL texture until the next useTexture */
+    void evictTexture(TextureAsset& texture);
+
+    /* Live assets, for MemoryBudget to pick from */
+    std::vector<TextureAsset*> textures() const;
+    std::vector<Mesh*> meshes() const;
+
+    inline const AssetStats& stats() const { return m_stats; }
+
+    static std::string canonicalPath(const std::string& path);
+    static unsigned long long hashBytes(const void* data, size_t size, unsigned long long seed = 0);
+    /* Content hash over every vertex stream, the index buffer and the textures, registry textures
+        by file and options and others by GL name */
+    static unsigned long long hashMesh(const MeshData& data, const std::vector<MeshTexture>& textures);
+
+private:
+    template<typename T>
+    struct Entry {
+        std::weak_ptr<T> asset;
+        unsigned long long hash;
+        std::vector<std::string> paths;
+    };
+
+    std::unordered_map<std::string, TextureAsset*> m_texturePaths;
+    std::unordered_map<unsigned long long, TextureAsset*> m_textureHashes;
+    std::unordered_map<TextureAsset*, Entry<TextureAsset>> m_textures;
+    std::unordered_map<std::string, Mesh*> m_meshPaths;
+    std::unordered_map<unsigned long long, Mesh*> m_meshHashes;
+    std::unordered_map<Mesh*, Entry<Mesh>> m_meshes;
+    AssetStats m_stats;
+
+    AssetRegistry() = default;
+    TextureHandle lockTexture(TextureAsset* texture);
+    MeshHandle lockMesh(Mesh* mesh);
+    void releaseTexture(TextureAsset* texture);
+    void releaseMesh(Mesh* mesh);
+    void uploadTexture(TextureAsset& texture, const std::vector<unsigned char>& bytes, unsigned int downscale);
+};
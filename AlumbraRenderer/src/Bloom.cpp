@@ -0,0 +1,111 @@
+#include "pch.h"
+#include "Bloom.h"
+
+Bloom::Bloom()
+{
+    glCreateFramebuffers(1, &m_framebufferID);
+    glCreateSamplers(1, &m_sampler);
+    glSamplerParameteri(m_sampler, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glSamplerParameteri(m_sampler, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glSamplerParameteri(m_sampler, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glSamplerParameteri(m_sampler, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+}
+
+Bloom::~Bloom() {}
+
+/* Allocates the mip chain starting at half of the source resolution */
+void Bloom::setup(int width, int height, GLenum format)
+{
+    m_mips.clear();
+
+    ResourceManager& resources = ResourceManager::instance();
+    m_sourceSize = glm::ivec2(width, height);
+    glm::ivec2 size = m_sourceSize;
+    for (int i = 0; i < MAX_MIPS && (size.x > 1 || size.y > 1); i++) {
+        size = glm::max(size / 2, glm::ivec2(1));
+        BloomMip mip;
+        mip.size = size;
+        mip.texture = GpuResource(resources.createTexture(ResourceCategory::RenderTarget, GL_TEXTURE_2D,
+            "Bloom Mip " + std::to_string(i)));
+        GLuint texture = mip.texture.id();
+        glTextureStorage2D(texture, 1, format, size.x, size.y);
+        glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTextureParameteri(texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTextureParameteri(texture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        resources.measureTexture(mip.texture.handle());
+        m_mips.push_back(std::move(mip));
+    }
+}
+
+/* Runs the downsample and upsample chains and returns the half resolution bloom texture.
+    Only the sourceRegion corner of the source is read, and each mip only fills the matching
+    corner, so a dynamic render scale does not need the chain to be reallocated.
+    Expects a screen quad VAO to be bound, leaves the bloom framebuffer bound */
+GLuint Bloom::render(const Shader& downsampleShader, const Shader& upsampleShader, GLuint source,
+    glm::ivec2 sourceRegion, const BloomSettings& settings) const
+{
+    int mipCount = std::min(std::max(settings.quality, 1), (int)m_mips.size());
+    glBindFramebuffer(GL_FRAMEBUFFER, m_framebufferID);
+    glBindSampler(0, m_sampler);
+
+    // Downsample, the first pass also applies the bright-pass threshold
+    downsampleShader.use();
+    downsampleShader.setFloat("threshold", settings.threshold);
+    GLuint currentTexture = source;
+    glm::ivec2 currentSize = m_sourceSize;
+    glm::ivec2 currentRegion = glm::min(sourceRegion, m_sourceSize);
+    for (int i = 0; i < mipCount; i++) {
+        const auto& mip = m_mips[i];
+        glm::ivec2 region = mipRegion(sourceRegion, i);
+        glNamedFramebufferTexture(m_framebufferID, GL_COLOR_ATTACHMENT0, mip.texture.id(), 0);
+        glViewport(0, 0, region.x, region.y);
+        downsampleShader.setVec2("srcTexelSize", 1.0f / glm::vec2(currentSize));
+        downsampleShader.setVec2("srcUVScale", glm::vec2(currentRegion) / glm::vec2(currentSize));
+        downsampleShader.setVec2("srcUVMax", (glm::vec2(currentRegion) - 0.5f) / glm::vec2(currentSize));
+        downsampleShader.setBool("prefilter", i == 0);
+        glBindTextureUnit(0, currentTexture);
+        glDrawArrays(GL_TRIANGLES, 0, 6);
+        currentTexture = mip.texture.id();
+        currentSize = mip.size;
+        currentRegion = region;
+    }
+
+    // Upsample, each smaller mip is blurred and added on top of the next larger one
+    upsampleShader.use();
+    upsampleShader.setFloat("radius", settings.radius);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE);
+    glBlendEquation(GL_FUNC_ADD);
+    for (int i = mipCount - 1; i > 0; i--) {
+        const auto& mip = m_mips[i];
+        const auto& target = m_mips[i - 1];
+        glm::ivec2 region = mipRegion(sourceRegion, i);
+        glm::ivec2 targetRegion = mipRegion(sourceRegion, i - 1);
+        glNamedFramebufferTexture(m_framebufferID, GL_COLOR_ATTACHMENT0, target.texture.id(), 0);
+        glViewport(0, 0, targetRegion.x, targetRegion.y);
+        upsampleShader.setVec2("srcTexelSize", 1.0f / glm::vec2(mip.size));
+        upsampleShader.setVec2("srcUVScale", glm::vec2(region) / glm::vec2(mip.size));
+        upsampleShader.setVec2("srcUVMax", (glm::vec2(region) - 0.5f) / glm::vec2(mip.size));
+        glBindTextureUnit(0, mip.texture.id());
+        glDrawArrays(GL_TRIANGLES, 0, 6);
+    }
+    glDisable(GL_BLEND);
+    glBindSampler(0, 0);
+
+    return m_mips[0].texture.id();
+}
+
+/* Fraction of the first mip covered when the source was rendered into sourceRegion, used to
+    remap screen UVs when sampling the returned texture */
+glm::vec2 Bloom::uvScale(glm::ivec2 sourceRegion) const
+{
+    if (m_mips.empty())
+        return glm::vec2(1.0f);
+    return glm::vec2(mipRegion(sourceRegion, 0)) / glm::vec2(m_mips[0].size);
+}
+
+glm::ivec2 Bloom::mipRegion(glm::ivec2 sourceRegion, int level)
+{
+    return glm::max(sourceRegion >> (level + 1), glm::ivec2(1));
+}
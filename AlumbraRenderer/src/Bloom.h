@@ -0,0 +1,48 @@
+#pragma once
+
+#include "Shader.h"
+
+struct BloomSettings {
+    // Luminance above which pixels start to bloom
+    float threshold = 1.0f;
+    // Tent filter radius in source texels, widens the glow without adding passes
+    float radius = 1.0f;
+    // Number of mips in the chain, each one halves the resolution
+    int quality = 6;
+    float intensity = 0.3f;
+};
+
+/**
+ * Progressive bloom over a chain of half resolution mips. The source is thresholded and
+ * downsampled with a 13 tap filter, then upsampled back with a tent filter and additively
+ * blended into each larger mip, so the whole chain costs less than one full resolution pass.
+ */
+class Bloom {
+public:
+    static constexpr int MAX_MIPS = 8;
+
+    Bloom();
+    ~Bloom();
+
+    void setup(int width, int height, GLenum format = GL_RGBA16F);
+    GLuint render(const Shader& downsampleShader, const Shader& upsampleShader, GLuint source,
+        glm::ivec2 sourceRegion, const BloomSettings& settings) const;
+    glm::vec2 uvScale(glm::ivec2 sourceRegion) const;
+
+    inline int mipCount() const { return m_mips.size(); }
+
+private:
+    struct BloomMip {
+        GpuResource texture;
+        glm::ivec2 size;
+    };
+
+    GLuint m_framebufferID;
+    // Bilinear clamped sampler for every read, the 13 tap and tent filters rely on hardware
+    // filtering whatever the filter of the source texture is
+    GLuint m_sampler;
+    glm::ivec2 m_sourceSize = glm::ivec2(0);
+    std::vector<BloomMip> m_mips;
+
+    static glm::ivec2 mipRegion(glm::ivec2 sourceRegion, int level);
+};
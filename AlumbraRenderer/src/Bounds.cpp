@@ -0,0 +1,62 @@
+#include "pch.h"
+#include "Bounds.h"
+
+/* Transforms the center and extents instead of all eight corners (Arvo) */
+AABB AABB::transformed(const glm::mat4& matrix) const
+{
+    if (empty())
+        return *this;
+    glm::vec3 center = glm::vec3(matrix * glm::vec4(this->center(), 1.0f));
+    glm::vec3 extents = this->extents();
+    glm::mat3 absolute = glm::mat3(glm::abs(matrix[0].xyz()), glm::abs(matrix[1].xyz()), glm::abs(matrix[2].xyz()));
+    glm::vec3 newExtents = absolute * extents;
+    AABB box;
+    box.min = center - newExtents;
+    box.max = center + newExtents;
+    return box;
+}
+
+AABB AABB::merge(const AABB& a, const AABB& b)
+{
+    AABB box = a;
+    box.expand(b);
+    return box;
+}
+
+AABB AABB::fromPoints(const std::vector<glm::vec3>& points)
+{
+    AABB box;
+    for (const auto& point : points)
+        box.expand(point);
+    return box;
+}
+
+/* Gribb-Hartmann plane extraction, the rows of the matrix are combined so that each plane
+    corresponds to one of -w <= x, y, z <= w */
+Frustum Frustum::fromMatrix(const glm::mat4& viewProjection)
+{
+    glm::mat4 m = glm::transpose(viewProjection);
+    Frustum frustum;
+    frustum.planes[0] = m[3] + m[0]; // Left
+    frustum.planes[1] = m[3] - m[0]; // Right
+    frustum.planes[2] = m[3] + m[1]; // Bottom
+    frustum.planes[3] = m[3] - m[1]; // Top
+    frustum.planes[4] = m[3] + m[2]; // Near
+    frustum.planes[5] = m[3] - m[2]; // Far
+    for (auto& plane : frustum.planes)
+        plane /= glm::length(glm::vec3(plane));
+    return frustum;
+}
+
+/* A box is outside when its corner furthest along the plane normal is behind it */
+bool Frustum::intersects(const AABB& box) const
+{
+    for (const auto& plane : planes) {
+        glm::vec3 positive = glm::vec3(plane.x >= 0.0f ? box.max.x : box.min.x,
+            plane.y >= 0.0f ? box.max.y : box.min.y,
+            plane.z >= 0.0f ? box.max.z : box.min.z);
+        if (glm::dot(glm::vec3(plane), positive) + plane.w < 0.0f)
+            return false;
+    }
+    return true;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <limits>
+
+/* Axis aligned bounding box, starts out empty (min > max) so expanding it with the first
+    point or box makes it exactly that */
+struct AABB {
+    glm::vec3 min = glm::vec3(std::numeric_limits<float>::max());
+    glm::vec3 max = glm::vec3(-std::numeric_limits<float>::max());
+
+    inline bool empty() const { return min.x > max.x; }
+    inline glm::vec3 center() const { return 0.5f * (min + max); }
+    inline glm::vec3 extents() const { return 0.5f * (max - min); }
+
+    inline void expand(const glm::vec3& point)
+    {
+        min = glm::min(min, point);
+        max = glm::max(max, point);
+    }
+    inline void expand(const AABB& box)
+    {
+        min = glm::min(min, box.min);
+        max = glm::max(max, box.max);
+    }
+    inline bool contains(const AABB& box) const
+    {
+        return glm::all(glm::lessThanEqual(min, box.min)) && glm::all(glm::greaterThanEqual(max, box.max));
+    }
+    inline float surfaceArea() const
+    {
+        glm::vec3 d = max - min;
+        return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+    }
+
+    /* Smallest box around this one after transforming it, the box is never empty */
+    AABB transformed(const glm::mat4& matrix) const;
+
+    static AABB merge(const AABB& a, const AABB& b);
+    static AABB fromPoints(const std::vector<glm::vec3>& points);
+};
+
+/* Six inward facing planes of a view frustum, xyz is the normalized plane normal and w the
+    distance so a point is inside when dot(plane.xyz, p) + plane.w >= 0 */
+struct Frustum {
+    glm::vec4 planes[6];
+
+    /* Extracts the planes from a (view) projection matrix with GL clip space conventions */
+    static Frustum fromMatrix(const glm::mat4& viewProjection);
+
+    /* Conservative test, boxes near frustum corners may be accepted */
+    bool intersects(const AABB& box) const;
+};
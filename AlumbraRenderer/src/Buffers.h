@@ -1,34 +1,244 @@
 #pragma once
 
-class DataBuffer {
-public:
-    DataBuffer(int bufferSize, int vertexCount, int numComponents, int indexCount = 0);
-    ~DataBuffer();
-    void addIndices(const unsigned int* idcs);
-    void addVec3s(const glm::vec3* data);
-    void addVec2s(const glm::vec2* data);
-
-    //inline unsigned int bufferSize() const { return m_bufferSize; }
-    inline int numComponents() const { return m_numComponents; }
-    inline int vertexCount() const { return m_vertexCount; }
-    inline unsigned int dataBufferID() const { return m_bufferID; }
-    inline int indexEnd() const { return m_indexEnd; }
-
-private:
-    unsigned int m_bufferID;
-    int m_numComponents, m_vertexCount, m_indexCount;
-    long long m_indexEnd = 0ll;
-    long long m_dataOffset = 0ll;
-};
-
-class VertexArray {
+#include <glm/gtc/packing.hpp>
+#include <cstring>
+
+/* Pointers into the CPU side streams a vertex format packs from, a null stream encodes a
+    default value so a format can be packed from meshes missing some of its attributes */
+struct VertexStreams {
+    const glm::vec3* positions = nullptr;
+    const glm::vec3* normals = nullptr;
+    const glm::vec2* texCoords = nullptr;
+    const glm::vec3* tangents = nullptr;
+    const glm::vec3* bitangents = nullptr;
+};
+
+/* Quantizers used by the attribute encodings, each one is the inverse of what the fixed
+    function vertex fetch or shaders/octahedral.glsl does to the stored value */
+namespace quantize {
+    // Octahedral mapping of a unit vector onto the [-1, 1] square, matches octEncode in the shaders
+    inline glm::vec2 octEncode(glm::vec3 n)
+    {
+        n /= std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+        if (n.z < 0.0f) {
+            return (1.0f - glm::abs(glm::vec2(n.y, n.x)))
+                * glm::vec2(n.x >= 0.0f ? 1.0f : -1.0f, n.y >= 0.0f ? 1.0f : -1.0f);
+        }
+        return glm::vec2(n.x, n.y);
+    }
+
+    // Inverse of octEncode, for reading quantized normals back on the CPU
+    inline glm::vec3 octDecode(glm::vec2 e)
+    {
+        glm::vec3 n(e.x, e.y, 1.0f - std::abs(e.x) - std::abs(e.y));
+        if (n.z < 0.0f) {
+            glm::vec2 folded = (1.0f - glm::abs(glm::vec2(n.y, n.x)))
+                * glm::vec2(n.x >= 0.0f ? 1.0f : -1.0f, n.y >= 0.0f ? 1.0f : -1.0f);
+            n.x = folded.x;
+            n.y = folded.y;
+        }
+        return glm::normalize(n);
+    }
+
+    inline GLshort snorm16(float v)
+    {
+        return (GLshort)std::round(glm::clamp(v, -1.0f, 1.0f) * 32767.0f);
+    }
+
+    // Any unit vector perpendicular to n, for vertices without a tangent
+    inline glm::vec3 perpendicular(const glm::vec3& n)
+    {
+        glm::vec3 axis = std::abs(n.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+        return glm::normalize(glm::cross(n, axis));
+    }
+}
+
+/* Attribute encodings. Each one knows the GL format the vertex fetch reads, its size in the
+    interleaved vertex and how to write one vertex of it from the streams */
+
+// 3 floats, used for positions where quantizing would move vertices off shared edges
+struct PositionFloat3 {
+    static constexpr GLint COMPONENTS = 3;
+    static constexpr GLenum TYPE = GL_FLOAT;
+    static constexpr GLboolean NORMALIZED = GL_FALSE;
+    static constexpr GLuint SIZE = 12;
+    static void encode(unsigned char* out, const VertexStreams& streams, size_t i)
+    {
+        glm::vec3 position = streams.positions ? streams.positions[i] : glm::vec3(0.0f);
+        std::memcpy(out, &position, SIZE);
+    }
+};
+
+// Octahedral normal in two snorm16, the shader reads the [-1, 1] square and calls octDecode.
+// Worst case error is under 0.05 degrees
+struct NormalOctSnorm16 {
+    static constexpr GLint COMPONENTS = 2;
+    static constexpr GLenum TYPE = GL_SHORT;
+    static constexpr GLboolean NORMALIZED = GL_TRUE;
+    static constexpr GLuint SIZE = 4;
+    static void encode(unsigned char* out, const VertexStreams& streams, size_t i)
+    {
+        glm::vec3 normal = streams.normals ? streams.normals[i] : glm::vec3(0.0f, 0.0f, 1.0f);
+        glm::vec2 oct = glm::dot(normal, normal) > 0.0f ? quantize::octEncode(normal) : glm::vec2(0.0f);
+        GLshort packed[2] = { quantize::snorm16(oct.x), quantize::snorm16(oct.y) };
+        std::memcpy(out, packed, SIZE);
+    }
+};
+
+// Tangent in 10:10:10 snorm with the bitangent's handedness in the 2 bit w, the shader
+// rebuilds the bitangent as cross(N, T) * w
+struct TangentSnorm10Sign {
+    static constexpr GLint COMPONENTS = 4;
+    static constexpr GLenum TYPE = GL_INT_2_10_10_10_REV;
+    static constexpr GLboolean NORMALIZED = GL_TRUE;
+    static constexpr GLuint SIZE = 4;
+    static void encode(unsigned char* out, const VertexStreams& streams, size_t i)
+    {
+        glm::vec3 normal = streams.normals ? streams.normals[i] : glm::vec3(0.0f, 0.0f, 1.0f);
+        glm::vec3 tangent = streams.tangents ? streams.tangents[i] : glm::vec3(0.0f);
+        float sign = 1.0f;
+        if (glm::dot(tangent, tangent) > 1e-12f) {
+            tangent = glm::normalize(tangent);
+            if (streams.bitangents && glm::dot(glm::cross(normal, tangent), streams.bitangents[i]) < 0.0f)
+                sign = -1.0f;
+        }
+        else {
+            tangent = glm::dot(normal, normal) > 0.0f ? quantize::perpendicular(glm::normalize(normal))
+                : glm::vec3(1.0f, 0.0f, 0.0f);
+        }
+        GLuint packed = glm::packSnorm3x10_1x2(glm::vec4(tangent, sign));
+        std::memcpy(out, &packed, SIZE);
+    }
+};
+
+// Two half floats, exact to 1/2048 over [0, 1) and coarser on tiled UVs further out
+struct TexCoordHalf2 {
+    static constexpr GLint COMPONENTS = 2;
+    static constexpr GLenum TYPE = GL_HALF_FLOAT;
+    static constexpr GLboolean NORMALIZED = GL_FALSE;
+    static constexpr GLuint SIZE = 4;
+    static void encode(unsigned char* out, const VertexStreams& streams, size_t i)
+    {
+        GLuint packed = glm::packHalf2x16(streams.texCoords ? streams.texCoords[i] : glm::vec2(0.0f));
+        std::memcpy(out, &packed, SIZE);
+    }
+};
+
+// 2 floats, for screen space quads whose texels have to line up exactly
+struct TexCoordFloat2 {
+    static constexpr GLint COMPONENTS = 2;
+    static constexpr GLenum TYPE = GL_FLOAT;
+    static constexpr GLboolean NORMALIZED = GL_FALSE;
+    static constexpr GLuint SIZE = 8;
+    static void encode(unsigned char* out, const VertexStreams& streams, size_t i)
+    {
+        glm::vec2 texCoord = streams.texCoords ? streams.texCoords[i] : glm::vec2(0.0f);
+        std::memcpy(out, &texCoord, SIZE);
+    }
+};
+
+/* An encoding bound to a shader attribute location */
+template<GLuint Location, typename Encoding>
+struct VertexAttribute : Encoding {
+    static constexpr GLuint LOCATION = Location;
+};
+
+/* Narrowest index type able to address a vertex count */
+struct IndexFormat {
+    GLenum type = GL_UNSIGNED_INT;
+    GLuint size = sizeof(GLuint);
+
+    static IndexFormat forVertexCount(size_t vertexCount)
+    {
+        if (vertexCount <= 0x10000)
+            return { GL_UNSIGNED_SHORT, sizeof(GLushort) };
+        return {};
+    }
+};
+
+/* GL objects of an uploaded mesh, the buffer holds the indices followed by the vertices */
+struct VertexUpload {
+    GLuint vertexArrayID = 0;
+    GLuint bufferID = 0;
+    IndexFormat indexFormat;
+    // Bytes of the buffer, indices and vertices together
+    size_t size = 0;
+    // Where the vertices start, after the indices
+    size_t vertexOffset = 0;
+};
+
+/* Writes indices in the given format, out must hold indexCount * format.size bytes */
+void packIndices(const unsigned int* indices, size_t indexCount, IndexFormat format, unsigned char* out);
+
+/**
+ * Interleaved vertex layout described by its attributes at compile time. Offsets and stride are
+ * constants, so packing unrolls into one pass writing every attribute of a vertex next to each
+ * other and the VAO setup is a fixed list of format calls. Every attribute is read through a
+ * single binding, a vertex is one fetch instead of one per planar stream.
+ */
+template<typename... Attributes>
+class VertexFormat {
 public:
-    VertexArray();
-    ~VertexArray();
-    void loadBuffer(const DataBuffer& buffer, int texIndex);
-    void bind();
-    inline unsigned int vertexArrayID() const { return m_vertexArrayID; }
+    static constexpr GLuint STRIDE = (Attributes::SIZE + ... + 0);
+    static_assert(STRIDE % 4 == 0, "vertex attributes have to stay 4 byte aligned");
+
+    /* Packs vertexCount vertices, out must hold vertexCount * STRIDE bytes */
+    static void pack(const VertexStreams& streams, size_t vertexCount, unsigned char* out)
+    {
+        for (size_t i = 0; i < vertexCount; i++, out += STRIDE) {
+            GLuint offset = 0;
+            ((Attributes::encode(out + offset, streams, i), offset += Attributes::SIZE), ...);
+        }
+    }
 
-private:
-    unsigned int m_vertexArrayID;
+    /* Points every attribute of the VAO at binding 0, reading vertices from offset in buffer */
+    static void setupVertexArray(GLuint vertexArrayID, GLuint bufferID, GLintptr offset)
+    {
+        glVertexArrayVertexBuffer(vertexArrayID, 0, bufferID, offset, STRIDE);
+        GLuint relativeOffset = 0;
+        ((glEnableVertexArrayAttrib(vertexArrayID, Attributes::LOCATION),
+            glVertexArrayAttribFormat(vertexArrayID, Attributes::LOCATION, Attributes::COMPONENTS,
+                Attributes::TYPE, Attributes::NORMALIZED, relativeOffset),
+            glVertexArrayAttribBinding(vertexArrayID, Attributes::LOCATION, 0),
+            relativeOffset += Attributes::SIZE), ...);
+    }
+
+    /* Uploads the indices, narrowed when the vertex count allows, and the packed vertices
+        into one immutable buffer and creates a VAO reading both */
+    static VertexUpload upload(const VertexStreams& streams, size_t vertexCount,
+        const std::vector<unsigned int>& indices = {})
+    {
+        VertexUpload result;
+        result.indexFormat = IndexFormat::forVertexCount(vertexCount);
+        size_t indexBytes = indices.size() * result.indexFormat.size;
+        // Vertex buffer offsets must be a multiple of 4, 16 bit indices may leave 2 bytes over
+        result.vertexOffset = (indexBytes + 3) & ~(size_t)3;
+        result.size = result.vertexOffset + vertexCount * STRIDE;
+
+        std::vector<unsigned char> data(result.size);
+        packIndices(indices.data(), indices.size(), result.indexFormat, data.data());
+        pack(streams, vertexCount, data.data() + result.vertexOffset);
+
+        glCreateBuffers(1, &result.bufferID);
+        glNamedBufferStorage(result.bufferID, result.size, data.data(), 0);
+        glCreateVertexArrays(1, &result.vertexArrayID);
+        if (!indices.empty())
+            glVertexArrayElementBuffer(result.vertexArrayID, result.bufferID);
+        setupVertexArray(result.vertexArrayID, result.bufferID, result.vertexOffset);
+        return result;
+    }
 };
+
+// Imported and generated meshes, 24 bytes a vertex where the planar float streams took 56
+using MeshVertexFormat = VertexFormat<
+    VertexAttribute<0, PositionFloat3>,
+    VertexAttribute<1, NormalOctSnorm16>,
+    VertexAttribute<2, TexCoordHalf2>,
+    VertexAttribute<3, TangentSnorm10Sign>>;
+// Full screen quads
+using ScreenQuadVertexFormat = VertexFormat<
+    VertexAttribute<0, PositionFloat3>,
+    VertexAttribute<1, TexCoordFloat2>>;
+// Skybox and cubemap capture cubes
+using PositionVertexFormat = VertexFormat<
+    VertexAttribute<0, PositionFloat3>>;
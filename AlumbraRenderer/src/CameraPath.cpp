@@ -0,0 +1,92 @@
+#include "pch.h"
+#include "CameraPath.h"
+
+#include <algorithm>
+#include <glm/gtc/constants.hpp>
+
+CameraPath::CameraPath() {}
+
+CameraPath::~CameraPath() {}
+
+void CameraPath::clear()
+{
+    m_keyframes.clear();
+}
+
+/* Keyframes are expected in increasing time order */
+void CameraPath::addKeyframe(float time, const FreeCamera& camera)
+{
+    m_keyframes.push_back({ time, camera.position(), camera.yaw(), camera.pitch() });
+}
+
+/* Moves the camera to the interpolated pose at the given time, clamped to the path's ends */
+void CameraPath::apply(float time, FreeCamera& camera) const
+{
+    if (m_keyframes.empty())
+        return;
+    auto next = std::lower_bound(m_keyframes.begin(), m_keyframes.end(), time,
+        [](const CameraKeyframe& keyframe, float t) { return keyframe.time < t; });
+    if (next == m_keyframes.begin()) {
+        camera.setPose(next->position, next->yaw, next->pitch);
+        return;
+    }
+    if (next == m_keyframes.end()) {
+        const auto& last = m_keyframes.back();
+        camera.setPose(last.position, last.yaw, last.pitch);
+        return;
+    }
+    auto prev = next - 1;
+    float span = next->time - prev->time;
+    float t = span > 0.0f ? (time - prev->time) / span : 1.0f;
+    camera.setPose(glm::mix(prev->position, next->position, t),
+        glm::mix(prev->yaw, next->yaw, t), glm::mix(prev->pitch, next->pitch, t));
+}
+
+/* Reads a path saved by save, one "time x y z yaw pitch" keyframe per line */
+bool CameraPath::load(const std::string& path)
+{
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cout << "ERROR::CAMERA_PATH::Could not read " << path << std::endl;
+        return false;
+    }
+    m_keyframes.clear();
+    CameraKeyframe keyframe;
+    while (file >> keyframe.time >> keyframe.position.x >> keyframe.position.y >> keyframe.position.z
+        >> keyframe.yaw >> keyframe.pitch) {
+        m_keyframes.push_back(keyframe);
+    }
+    return !m_keyframes.empty();
+}
+
+bool CameraPath::save(const std::string& path) const
+{
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        std::cout << "ERROR::CAMERA_PATH::Could not write " << path << std::endl;
+        return false;
+    }
+    for (const auto& keyframe : m_keyframes) {
+        file << keyframe.time << " " << keyframe.position.x << " " << keyframe.position.y << " "
+            << keyframe.position.z << " " << keyframe.yaw << " " << keyframe.pitch << "\n";
+    }
+    std::cout << "Camera path with " << m_keyframes.size() << " keyframes written to " << path << std::endl;
+    return true;
+}
+
+/* A full circle around center that always looks at it, the default benchmark path */
+CameraPath CameraPath::orbit(const glm::vec3& center, float radius, float height, float duration,
+    int keyframeCount)
+{
+    CameraPath path;
+    float pitch = -glm::degrees(std::atan2(height, radius));
+    for (int i = 0; i <= keyframeCount; i++) {
+        float t = (float)i / keyframeCount;
+        float angle = t * glm::two_pi<float>();
+        glm::vec3 position = center + glm::vec3(std::cos(angle) * radius, height, std::sin(angle) * radius);
+        // Looking back at the center means facing the opposite direction of the offset
+        float yaw = glm::degrees(angle) + 180.0f;
+        path.m_keyframes.push_back({ t * duration, position, yaw, pitch });
+    }
+    return path;
+}
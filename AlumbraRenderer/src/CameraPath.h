@@ -0,0 +1,38 @@
+#pragma once
+
+#include "FreeCamera.h"
+
+struct CameraKeyframe {
+    float time;
+    glm::vec3 position;
+    float yaw;
+    float pitch;
+};
+
+/**
+ * A timed list of camera poses that can be recorded from the interactive camera, saved to a
+ * text file and replayed by interpolating between keyframes, so benchmark runs always see the
+ * same views.
+ */
+class CameraPath {
+public:
+    CameraPath();
+    ~CameraPath();
+
+    void clear();
+    void addKeyframe(float time, const FreeCamera& camera);
+    void apply(float time, FreeCamera& camera) const;
+
+    bool load(const std::string& path);
+    bool save(const std::string& path) const;
+
+    static CameraPath orbit(const glm::vec3& center, float radius, float height, float duration,
+        int keyframeCount = 64);
+
+    inline bool empty() const { return m_keyframes.empty(); }
+    inline size_t keyframeCount() const { return m_keyframes.size(); }
+    inline float duration() const { return m_keyframes.empty() ? 0.0f : m_keyframes.back().time; }
+
+private:
+    std::vector<CameraKeyframe> m_keyframes;
+};
@@ -0,0 +1,69 @@
+#include "pch.h"
+#include "CheckerboardShading.h"
+
+CheckerboardShading::CheckerboardShading()
+{
+    glCreateFramebuffers(1, &m_framebufferID);
+}
+
+CheckerboardShading::~CheckerboardShading() {}
+
+/* Allocates the half width lighting target for a full size of width x height */
+void CheckerboardShading::setup(int width, int height, GLenum format)
+{
+    ResourceManager& resources = ResourceManager::instance();
+    m_checkerTexture = GpuResource(resources.createTexture(ResourceCategory::RenderTarget, GL_TEXTURE_2D,
+        "Checkerboard Lighting"));
+    GLuint texture = m_checkerTexture.id();
+    glTextureStorage2D(texture, 1, format, (width + 1) / 2, height);
+    glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTextureParameteri(texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTextureParameteri(texture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    resources.measureTexture(m_checkerTexture.handle());
+    glNamedFramebufferTexture(m_framebufferID, GL_COLOR_ATTACHMENT0, texture, 0);
+    m_historyValid = false;
+}
+
+void CheckerboardShading::begin(int renderWidth, int renderHeight)
+{
+    m_renderWidth = renderWidth;
+    m_renderHeight = renderHeight;
+    m_frame ^= 1;
+    glBindFramebuffer(GL_FRAMEBUFFER, m_framebufferID);
+    glViewport(0, 0, (renderWidth + 1) / 2, renderHeight);
+}
+
+void CheckerboardShading::setUniforms(const Shader& shader) const
+{
+    shader.setInt("checkerFrame", m_frame);
+    shader.setVec2("renderSize", glm::vec2(m_renderWidth, m_renderHeight));
+}
+
+/* Fills the full render size from the half width lighting. Expects the output framebuffer
+    to be bound with a render size viewport, a screen quad VAO, and the shader's samplers set to
+    units 0-4 as the checker texture followed by the arguments in order. The history is the
+    output of the previous reconstruct */
+void CheckerboardShading::reconstruct(const Shader& reconstructShader, GLuint depthTexture, GLuint normalTexture,
+    GLuint velocityTexture, GLuint historyTexture, glm::vec2 historyUVScale, glm::vec2 historyUVMax,
+    glm::vec2 jitterDelta, float zNear, float zFar, const CheckerboardSettings& settings)
+{
+    reconstructShader.use();
+    reconstructShader.setVec2("historyUVScale", historyUVScale);
+    reconstructShader.setVec2("historyUVMax", historyUVMax);
+    reconstructShader.setVec2("jitterDelta", jitterDelta);
+    reconstructShader.setInt("checkerFrame", m_frame);
+    reconstructShader.setVec2("renderSize", glm::vec2(m_renderWidth, m_renderHeight));
+    reconstructShader.setFloat("zNear", zNear);
+    reconstructShader.setFloat("zFar", zFar);
+    reconstructShader.setFloat("depthSensitivity", settings.depthSensitivity);
+    reconstructShader.setFloat("normalPower", settings.normalPower);
+    reconstructShader.setFloat("historyWeight", m_historyValid ? settings.historyWeight : 0.0f);
+    glBindTextureUnit(0, m_checkerTexture.id());
+    glBindTextureUnit(1, depthTexture);
+    glBindTextureUnit(2, normalTexture);
+    glBindTextureUnit(3, velocityTexture);
+    glBindTextureUnit(4, historyTexture);
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+    m_historyValid = true;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "Shader.h"
+
+struct CheckerboardSettings {
+    bool enabled = false;
+    // How quickly neighbor weights fall off with relative view depth difference
+    float depthSensitivity = 50.0f;
+    // Exponent on the normal similarity of neighbors, higher keeps creases sharper
+    float normalPower = 8.0f;
+    // Share of the reprojected last frame in each reconstructed pixel
+    float historyWeight = 0.5f;
+};
+
+/**
+ * Shades half of the pixels every frame in a checkerboard pattern into a half width target,
+ * swapping the pattern each frame. The reconstruct pass writes the shaded pixels as is and
+ * fills the others from their depth and normal weighted neighbors, blended with the last
+ * frame's result reprojected through the G-buffer velocity.
+ */
+class CheckerboardShading {
+public:
+    CheckerboardShading();
+    ~CheckerboardShading();
+
+    void setup(int width, int height, GLenum format = GL_RGBA16F);
+    /* Binds the half width target for the lighting pass and flips the pattern */
+    void begin(int renderWidth, int renderHeight);
+    /* Lighting shader uniforms for pbr_shading.frag, the shader must be in use */
+    void setUniforms(const Shader& shader) const;
+    void reconstruct(const Shader& reconstructShader, GLuint depthTexture, GLuint normalTexture,
+        GLuint velocityTexture, GLuint historyTexture, glm::vec2 historyUVScale, glm::vec2 historyUVMax,
+        glm::vec2 jitterDelta, float zNear, float zFar, const CheckerboardSettings& settings);
+
+    inline void invalidateHistory() { m_historyValid = false; }
+
+private:
+    GLuint m_framebufferID;
+    GpuResource m_checkerTexture;
+    int m_renderWidth = 0, m_renderHeight = 0;
+    int m_frame = 0;
+    bool m_historyValid = false;
+};
@@ -1,5 +1,6 @@
 #include "pch.h"
 #include "Cubemap.h"
+#include "Profiler.h"
 
 Cubemap::Cubemap() {}
 
@@ -7,19 +8,36 @@ Cubemap::~Cubemap() {}
 
 void Cubemap::loadHDRMap(const std::string& hdrImage)
 {
-    DataBuffer buffer(sizeof(cubemapVertices[0]) * cubemapVertices.size(), 36, 1);
-    buffer.addVec3s(cubemapVertices.data());
+    PROFILE_SCOPE("Cubemap::loadHDRMap");
+    uploadCube();
+    m_sourcePath = hdrImage;
+    loadSource();
+}
 
-    VertexArray vao;
-    vao.loadBuffer(buffer, -1);
-    m_vao = vao.vertexArrayID();
+/* Only the capture reads the equirectangular map, MemoryBudget drops it once the environment
+    is baked and the next capture streams it back in */
+void Cubemap::releaseSource()
+{
+    if (!m_sourcePath.empty() && m_environment) {
+        m_cubemap.reset();
+        m_cubemapID = 0;
+    }
+}
 
+void Cubemap::loadSource()
+{
+    const std::string& hdrImage = m_sourcePath;
     stbi_set_flip_vertically_on_load(true);
     int width, height, nrComponents;
-    float* data = stbi_loadf(hdrImage.c_str(), &width, &height, &nrComponents, 0);
+    float* data;
+    {
+        PROFILE_SCOPE("HDR Decode");
+        data = stbi_loadf(hdrImage.c_str(), &width, &height, &nrComponents, 0);
+    }
     if (data) {
         glCreateTextures(GL_TEXTURE_2D, 1, &m_cubemapID);
         glTextureStorage2D(m_cubemapID, 1, GL_RGB16F, width, height);
+        ownTexture(m_cubemap, m_cubemapID, "Equirectangular Map");
         glTextureSubImage2D(m_cubemapID, 0, 0, 0, width, height, GL_RGB, GL_FLOAT, data);
 
         glTextureParameteri(m_cubemapID, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
@@ -36,12 +54,15 @@ void Cubemap::loadHDRMap(const std::string& hdrImage)
 
 void Cubemap::captureEnvironment(const Framebuffer& captureBuffer, const Shader& captureShader)
 {
+    PROFILE_FUNCTION();
+    if (!m_cubemap && !m_sourcePath.empty())
+        loadSource();
     m_texOps.minFilter = GL_LINEAR_MIPMAP_LINEAR;
     m_texOps.magFilter = GL_LINEAR;
     m_texOps.wrapS = GL_CLAMP_TO_EDGE;
     m_texOps.wrapT = GL_CLAMP_TO_EDGE;
     m_texLoader.createNew(GL_TEXTURE_CUBE_MAP, m_texOps);
-    m_environmentMap = m_texLoader.emptyTexture(GL_RGB16F, 2048, 2048);
+    m_environmentMap = ownTexture(m_environment, m_texLoader.emptyTexture(GL_RGB16F, 2048, 2048), "Environment Map");
 
     captureShader.use();
     captureShader.setSampler("equirectangularMap", 0);
@@ -62,9 +83,10 @@ void Cubemap::captureEnvironment(const Framebuffer& captureBuffer, const Shader&
 
 void Cubemap::irradianceConvolution(const Framebuffer& captureBuffer, const Shader& convolveShader)
 {
+    PROFILE_FUNCTION();
     m_texOps.minFilter = GL_LINEAR;
     m_texLoader.createNew(GL_TEXTURE_CUBE_MAP, m_texOps);
-    m_irradianceMap = m_texLoader.emptyTexture(GL_RGB16F, 32, 32);
+    m_irradianceMap = ownTexture(m_irradiance, m_texLoader.emptyTexture(GL_RGB16F, 32, 32), "Irradiance Map");
     captureBuffer.resizeRB(32, 32);
 
     convolveShader.use();
@@ -83,10 +105,12 @@ void Cubemap::irradianceConvolution(const Framebuffer& captureBuffer, const Shad
 }
 void Cubemap::specularPrefilter(const Framebuffer& captureBuffer, const Shader& prefilterShader)
 {
+    PROFILE_FUNCTION();
     unsigned maxMipLevels = 10;
     m_texOps.minFilter = GL_LINEAR_MIPMAP_LINEAR;
     m_texLoader.createNew(GL_TEXTURE_CUBE_MAP, m_texOps);
-    m_prefilterMap = m_texLoader.emptyTexture(GL_RGB16F, 1024, 1024, maxMipLevels);
+    m_prefilterMap = ownTexture(m_prefilter, m_texLoader.emptyTexture(GL_RGB16F, 1024, 1024, maxMipLevels),
+        "Prefilter Map");
     glGenerateTextureMipmap(m_prefilterMap);
 
     prefilterShader.use();
@@ -126,12 +150,7 @@ void Cubemap::loadMap(const std::vector<std::string>& faces)
     glTextureParameteri(m_cubemapID, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     glTextureParameteri(m_cubemapID, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
 
-    DataBuffer buffer(sizeof(cubemapVertices[0]) * cubemapVertices.size(), 36, 1);
-    buffer.addVec3s(cubemapVertices.data());
-
-    VertexArray vao;
-    vao.loadBuffer(buffer, -1);
-    m_vao = vao.vertexArrayID();
+    uploadCube();
     int width, height, nrChannels;
     // Need to load first face in order to get width/height for the storage function
     unsigned char* data = stbi_load(faces[0].c_str(), &width, &height, &nrChannels, 0);
@@ -147,6 +166,7 @@ void Cubemap::loadMap(const std::vector<std::string>& faces)
     }
     if (data) {
         glTextureStorage2D(m_cubemapID, 1, internalFormat, width, height);
+        ownTexture(m_cubemap, m_cubemapID, "Skybox");
         glTextureSubImage3D(m_cubemapID, 0, 0, 0, 0, width, height, 1, format, GL_UNSIGNED_BYTE, data);
         stbi_image_free(data);
     }
@@ -169,6 +189,29 @@ void Cubemap::loadMap(const std::vector<std::string>& faces)
     }
 }
 
+/* Hands a texture to the ResourceManager, releasing the one the owner held before */
+GLuint Cubemap::ownTexture(GpuResource& owner, GLuint texture, const char* name)
+{
+    ResourceManager& resources = ResourceManager::instance();
+    owner = GpuResource(resources.adopt(ResourceType::Texture, ResourceCategory::Environment, texture, 0,
+        name));
+    resources.measureTexture(owner.handle());
+    return texture;
+}
+
+void Cubemap::uploadCube()
+{
+    VertexStreams streams;
+    streams.positions = cubemapVertices.data();
+    VertexUpload upload = PositionVertexFormat::upload(streams, cubemapVertices.size());
+    ResourceManager& resources = ResourceManager::instance();
+    m_cubeVertexArray = GpuResource(resources.adopt(ResourceType::VertexArray, ResourceCategory::Environment,
+        upload.vertexArrayID, 0, "Cubemap Cube"));
+    m_cubeBuffer = GpuResource(resources.adopt(ResourceType::Buffer, ResourceCategory::Environment,
+        upload.bufferID, upload.size, "Cubemap Cube"));
+    m_vao = upload.vertexArrayID;
+}
+
 void Cubemap::draw(const Shader& shader)
 {
     glDepthFunc(GL_LEQUAL);
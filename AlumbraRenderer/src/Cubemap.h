@@ -18,18 +18,29 @@ public:
 
     void loadMap(const std::vector<std::string>& faces);
     void draw(const Shader& shader);
+    void releaseSource();
 
     inline GLuint cubemapID() const { return m_cubemapID; }
     inline GLuint environmentMap() const { return m_environmentMap; }
     inline GLuint irradianceMap() const { return m_irradianceMap; }
     inline GLuint prefilterMap() const { return m_prefilterMap; }
     inline GLuint vao() const { return m_vao; }
+    // Whether the equirectangular map an HDR environment was captured from is still loaded
+    inline bool sourceResident() const { return (bool)m_cubemap; }
 private:
     GLuint m_cubemapID;
     GLuint m_environmentMap;
     GLuint m_irradianceMap;
     GLuint m_prefilterMap;
     GLuint m_vao;
+    // Loading another environment releases the maps of the previous one
+    GpuResource m_cubemap, m_environment, m_irradiance, m_prefilter, m_cubeVertexArray, m_cubeBuffer;
+
+    std::string m_sourcePath;
+
+    GLuint ownTexture(GpuResource& owner, GLuint texture, const char* name);
+    void loadSource();
+    void uploadCube();
 
     TextureLoader m_texLoader;
     TextureOptions m_texOps;
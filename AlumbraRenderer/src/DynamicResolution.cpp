@@ -0,0 +1,43 @@
+#include "pch.h"
+#include "DynamicResolution.h"
+
+DynamicResolution::DynamicResolution()
+{
+    for (auto& scale : m_frameScales)
+        scale = 1.0f;
+}
+
+DynamicResolution::~DynamicResolution() {}
+
+float DynamicResolution::update(const GpuProfiler& profiler, const DynamicResolutionSettings& settings)
+{
+    float minScale = glm::clamp(settings.minScale, 0.1f, 1.0f);
+    float maxScale = glm::clamp(settings.maxScale, minScale, 1.0f);
+
+    unsigned long long resolved = profiler.lastResolvedFrame();
+    if (!settings.enabled) {
+        m_scale = maxScale;
+    }
+    else if (resolved != m_lastFrame && !profiler.lastResults().empty()) {
+        // The root scope spans the whole frame
+        const auto& frame = profiler.lastResults().front();
+        m_lastGpuMs = (frame.end - frame.start) / 1e6f;
+        float frameScale = m_frameScales[resolved % SCALE_HISTORY];
+
+        // Scale that would have hit the budget, assuming cost is proportional to area
+        float budget = settings.targetMs * settings.headroom;
+        float ideal = frameScale * std::sqrt(budget / std::max(m_lastGpuMs, 0.01f));
+        ideal = glm::clamp(ideal, minScale, maxScale);
+        float rate = ideal < m_scale ? 0.5f : 0.05f;
+        float next = m_scale + (ideal - m_scale) * rate;
+        // Ignore tiny changes so the render size does not jitter every frame
+        if (std::abs(next - m_scale) > 0.005f || ideal == minScale || ideal == maxScale)
+            m_scale = next;
+    }
+    m_scale = glm::clamp(m_scale, minScale, maxScale);
+    m_lastFrame = resolved;
+
+    // GpuProfiler::beginFrame already advanced to this frame's number
+    m_frameScales[profiler.frameNumber() % SCALE_HISTORY] = m_scale;
+    return m_scale;
+}
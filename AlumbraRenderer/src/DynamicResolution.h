@@ -0,0 +1,40 @@
+#pragma once
+
+#include "GpuProfiler.h"
+
+struct DynamicResolutionSettings {
+    bool enabled = false;
+    // GPU frame budget in milliseconds, 16.6 for 60 Hz
+    float targetMs = 16.6f;
+    float minScale = 0.5f;
+    float maxScale = 1.0f;
+    // Fraction of the budget aimed for, leaves room for spikes between measurements
+    float headroom = 0.9f;
+};
+
+/**
+ * Picks a per-axis render scale every frame from GPU profiler feedback. GPU results arrive
+ * FRAME_LATENCY frames late, so each measurement is related to the scale that frame was
+ * actually rendered at. Cost is assumed to grow with pixel count, the scale drops quickly
+ * when over budget and recovers slowly so it does not oscillate.
+ */
+class DynamicResolution {
+public:
+    DynamicResolution();
+    ~DynamicResolution();
+
+    /* Call after GpuProfiler::beginFrame, returns the scale to render this frame at */
+    float update(const GpuProfiler& profiler, const DynamicResolutionSettings& settings);
+
+    inline float scale() const { return m_scale; }
+    inline float lastGpuMs() const { return m_lastGpuMs; }
+
+private:
+    static constexpr int SCALE_HISTORY = 2 * GpuProfiler::FRAME_LATENCY;
+
+    float m_scale = 1.0f;
+    float m_lastGpuMs = 0.0f;
+    unsigned long long m_lastFrame = 0;
+    // Scale used by recent GPU frames, indexed by frame number
+    float m_frameScales[SCALE_HISTORY];
+};
@@ -5,7 +5,8 @@
 
 Framebuffer::Framebuffer()
 {
-    glCreateFramebuffers(1, &m_framebufferID);
+    m_framebuffer = GpuResource(ResourceManager::instance().createFramebuffer(ResourceCategory::RenderTarget, "Framebuffer"));
+    m_framebufferID = m_framebuffer.id();
 }
 
 Framebuffer::~Framebuffer() {}
@@ -26,13 +27,36 @@ void Framebuffer::attachColorBuffers(std::vector<GLuint>&& buffers)
 }
 
 void Framebuffer::attachRenderbuffer(int width, int height) {
-    glCreateRenderbuffers(1, &m_renderbufferID);
-    glNamedRenderbufferStorage(m_renderbufferID, GL_DEPTH_COMPONENT24,
-        width, height);
+    m_renderbuffer = GpuResource(ResourceManager::instance().createRenderbuffer(ResourceCategory::RenderTarget, "Framebuffer Depth"));
+    m_renderbufferID = m_renderbuffer.id();
+    resizeRB(width, height);
     glNamedFramebufferRenderbuffer(m_framebufferID, GL_DEPTH_ATTACHMENT,
         GL_RENDERBUFFER, m_renderbufferID);
 }
 
+/* Depth attachment that can also be sampled, used when later passes need to read scene depth */
+void Framebuffer::attachDepthTexture(int width, int height)
+{
+    ResourceManager& resources = ResourceManager::instance();
+    m_depthTexture = GpuResource(resources.createTexture(ResourceCategory::RenderTarget, GL_TEXTURE_2D, "Framebuffer Depth"));
+    m_depthTextureID = m_depthTexture.id();
+    glTextureStorage2D(m_depthTextureID, 1, GL_DEPTH_COMPONENT24, width, height);
+    resources.measureTexture(m_depthTexture.handle());
+    glTextureParameteri(m_depthTextureID, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTextureParameteri(m_depthTextureID, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTextureParameteri(m_depthTextureID, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTextureParameteri(m_depthTextureID, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glNamedFramebufferTexture(m_framebufferID, GL_DEPTH_ATTACHMENT, m_depthTextureID, 0);
+}
+
+/* Shares a depth texture owned by another framebuffer, so passes can write the same depth */
+void Framebuffer::attachDepthTexture(GLuint texture)
+{
+    m_depthTexture.reset();
+    m_depthTextureID = texture;
+    glNamedFramebufferTexture(m_framebufferID, GL_DEPTH_ATTACHMENT, m_depthTextureID, 0);
+}
+
 void Framebuffer::bindAs(GLenum fbType) const
 {
     glBindFramebuffer(fbType, m_framebufferID);
@@ -65,6 +89,8 @@ void Framebuffer::clear() const
 void Framebuffer::resizeRB(int width, int height) const
 {
     glNamedRenderbufferStorage(m_renderbufferID, GL_DEPTH_COMPONENT24, width, height);
+    ResourceManager::instance().setBytes(m_renderbuffer.handle(),
+        (size_t)width * height * ResourceManager::texelBytes(GL_DEPTH_COMPONENT24));
 }
 
 void Framebuffer::bindTexture(unsigned int index)
@@ -1,11 +1,15 @@
 #pragma once
 
+#include "ResourceManager.h"
+
 class Framebuffer {
 public:
     Framebuffer();
     ~Framebuffer();
     void attachColorBuffers(std::vector<GLuint>&& buffers);
     void attachRenderbuffer(int width, int height);
+    void attachDepthTexture(int width, int height);
+    void attachDepthTexture(GLuint texture);
     void bindAs(GLenum fbType) const;
     void unbind() const;
     bool isComplete();
@@ -17,10 +21,15 @@ public:
     inline GLuint id() const { return m_framebufferID; }
     inline const std::vector<GLuint>& colorBuffers() const { return m_colorBuffers; }
     inline GLuint colorBuffer(unsigned int index) const { return m_colorBuffers[index]; }
+    inline GLuint depthTexture() const { return m_depthTextureID; }
 private:
     GLuint m_framebufferID;
     std::vector<GLuint> m_colorBuffers;
-    GLuint m_renderbufferID;
+    GLuint m_renderbufferID = 0;
+    GLuint m_depthTextureID = 0;
+    // The framebuffer and the attachments it created itself, shared depth textures stay with
+    // their owner
+    GpuResource m_framebuffer, m_renderbuffer, m_depthTexture;
     int m_width, m_height;
 };
 
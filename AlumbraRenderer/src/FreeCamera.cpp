@@ -94,6 +94,15 @@ void FreeCamera::processMouseScroll(float yoffset)
         m_zoom = 45.0f;
 }
 
+// Places the camera directly, used to replay recorded or scripted camera paths
+void FreeCamera::setPose(const glm::vec3& position, float yaw, float pitch)
+{
+    m_position = position;
+    m_yaw = yaw;
+    m_pitch = pitch;
+    updateCameraVectors();
+}
+
 // Calculates the front vector from the Camera's (updated) Euler Angles
 void FreeCamera::updateCameraVectors()
 {
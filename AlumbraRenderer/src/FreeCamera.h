@@ -36,11 +36,14 @@ public:
     void processKeyboard(Camera_Movement direction, float deltaTime);
     void processMouseMovement(float xoffset, float yoffset, GLboolean constrainPitch = true);
     void processMouseScroll(float yoffset);
+    void setPose(const glm::vec3& position, float yaw, float pitch);
 
     inline float zoom() const { return m_zoom; }
     inline float fov() const { return m_fov; }
     inline glm::vec3 position() const { return m_position; }
     inline glm::vec3 front() const { return m_front; }
+    inline float yaw() const { return m_yaw; }
+    inline float pitch() const { return m_pitch; }
 
 private:
     void updateCameraVectors();
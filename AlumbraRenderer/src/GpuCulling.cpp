@@ -0,0 +1,171 @@
+#include "pch.h"
+#include "GpuCulling.h"
+#include "Window.h"
+#include <cstring>
+
+// GL_PARAMETER_BUFFER from GL 4.6 / ARB_indirect_parameters, the loader only covers 4.5
+static constexpr GLenum PARAMETER_BUFFER = 0x80EE;
+
+struct DrawElementsIndirectCommand {
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+
+static bool hasExtension(const char* name)
+{
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; i++) {
+        if (std::strcmp((const char*)glGetStringi(GL_EXTENSIONS, i), name) == 0)
+            return true;
+    }
+    return false;
+}
+
+GpuCulling::GpuCulling()
+{
+    GLint major = 0, minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    if (major > 4 || (major == 4 && minor >= 6))
+        m_multiDrawCount = (MultiDrawElementsIndirectCountProc)Window::procAddress("glMultiDrawElementsIndirectCount");
+    if (m_multiDrawCount == nullptr && hasExtension("GL_ARB_indirect_parameters"))
+        m_multiDrawCount = (MultiDrawElementsIndirectCountProc)Window::procAddress("glMultiDrawElementsIndirectCountARB");
+    if (m_multiDrawCount == nullptr)
+        std::cout << "GPU culling: glMultiDrawElementsIndirectCount unavailable, submitting every draw slot" << std::endl;
+
+    // Command counts of both phases followed by their triangle counts
+    m_countBuffer = GpuResource(ResourceManager::instance().createBuffer(ResourceCategory::Other,
+        sizeof(GLuint) * CULL_PHASE_COUNT * 2, nullptr, GL_DYNAMIC_STORAGE_BIT, "GPU Culling Counts"));
+}
+
+GpuCulling::~GpuCulling() {}
+
+/* Allocates the depth pyramid, its base is the largest power of two that fits in width x height
+    so every level halves exactly */
+void GpuCulling::setup(int width, int height)
+{
+    auto floorPow2 = [](int value) {
+        int result = 1;
+        while (result * 2 <= value)
+            result *= 2;
+        return result;
+    };
+    m_hiZSize = glm::ivec2(floorPow2(width), floorPow2(height));
+    m_hiZLevels = 1;
+    while ((m_hiZSize.x >> m_hiZLevels) > 0 || (m_hiZSize.y >> m_hiZLevels) > 0)
+        m_hiZLevels++;
+
+    ResourceManager& resources = ResourceManager::instance();
+    m_hiZTexture = GpuResource(resources.createTexture(ResourceCategory::RenderTarget, GL_TEXTURE_2D, "Hi-Z Pyramid"));
+    GLuint texture = m_hiZTexture.id();
+    glTextureStorage2D(texture, m_hiZLevels, GL_R32F, m_hiZSize.x, m_hiZSize.y);
+    glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTextureParameteri(texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTextureParameteri(texture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    resources.measureTexture(m_hiZTexture.handle());
+}
+
+void GpuCulling::reset(unsigned int itemCount)
+{
+    m_itemCount = itemCount;
+    if (itemCount > m_itemCapacity || !m_commandBuffer) {
+        ResourceManager& resources = ResourceManager::instance();
+        m_itemCapacity = std::max(itemCount, 1u);
+        // One command list per phase
+        m_commandBuffer = GpuResource(resources.createBuffer(ResourceCategory::Other,
+            sizeof(DrawElementsIndirectCommand) * m_itemCapacity * CULL_PHASE_COUNT, nullptr, 0,
+            "GPU Culling Commands"));
+        m_visibilitySSBO = GpuResource(resources.createBuffer(ResourceCategory::Other,
+            sizeof(GLuint) * m_itemCapacity, nullptr, 0, "GPU Culling Visibility"));
+    }
+    // Everything counts as visible last frame, the first frame then draws it all early
+    GLuint visible = 1;
+    glClearNamedBufferData(m_visibilitySSBO.id(), GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &visible);
+}
+
+/* Writes the phase's draw commands and count, expects the mesh pool to be bound. The camera
+    position is only used by the cluster culling shader's cone test */
+void GpuCulling::cull(const Shader& cullShader, const glm::mat4& viewProjection, const glm::vec3& cameraPosition,
+    CullPhase phase, bool occlusion) const
+{
+    if (m_itemCount == 0)
+        return;
+    if (phase == CULL_EARLY) {
+        GLuint zero = 0;
+        glClearNamedBufferData(m_countBuffer.id(), GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+    }
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 14, m_commandBuffer.id());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 15, m_countBuffer.id());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 16, m_visibilitySSBO.id());
+
+    cullShader.use();
+    cullShader.setMat4("viewProjection", viewProjection);
+    cullShader.setVec3("cameraPosition", cameraPosition);
+    cullShader.setInt("phase", phase);
+    cullShader.setBool("occlusion", occlusion);
+    cullShader.setBool("compact", hasDrawCount());
+    cullShader.setInt("itemCount", m_itemCount);
+    cullShader.setInt("commandStride", m_itemCapacity);
+    cullShader.setVec2("hiZSize", glm::vec2(m_hiZSize));
+    cullShader.setInt("hiZLevels", m_hiZLevels);
+    glBindTextureUnit(0, m_hiZTexture.id());
+
+    glDispatchCompute((m_itemCount + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+/* Max-reduces the renderSize corner of the depth texture into the pyramid, one dispatch per level */
+void GpuCulling::buildHiZ(const Shader& hiZShader, GLuint depthTexture, glm::ivec2 renderSize) const
+{
+    hiZShader.use();
+    glm::ivec2 srcSize = renderSize;
+    for (int level = 0; level < m_hiZLevels; level++) {
+        glm::ivec2 dstSize = glm::max(m_hiZSize >> level, glm::ivec2(1));
+        glBindTextureUnit(0, level == 0 ? depthTexture : m_hiZTexture.id());
+        glBindImageTexture(0, m_hiZTexture.id(), level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+        hiZShader.setInt("srcLevel", level == 0 ? 0 : level - 1);
+        hiZShader.setVec2("srcSize", glm::vec2(srcSize));
+        hiZShader.setVec2("dstSize", glm::vec2(dstSize));
+        glDispatchCompute((dstSize.x + HIZ_GROUP_SIZE - 1) / HIZ_GROUP_SIZE,
+            (dstSize.y + HIZ_GROUP_SIZE - 1) / HIZ_GROUP_SIZE, 1);
+        glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+        srcSize = dstSize;
+    }
+}
+
+void GpuCulling::draw(const MeshPool& pool, CullPhase phase) const
+{
+    if (m_itemCount == 0)
+        return;
+    glBindVertexArray(pool.vertexArray());
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandBuffer.id());
+    const void* commands = (const void*)(sizeof(DrawElementsIndirectCommand) * m_itemCapacity * phase);
+    if (hasDrawCount()) {
+        glBindBuffer(PARAMETER_BUFFER, m_countBuffer.id());
+        m_multiDrawCount(GL_TRIANGLES, GL_UNSIGNED_INT, commands, sizeof(GLuint) * phase, m_itemCount, 0);
+        glBindBuffer(PARAMETER_BUFFER, 0);
+    }
+    else {
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, commands, m_itemCount, 0);
+    }
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+unsigned int GpuCulling::drawnCount(CullPhase phase) const
+{
+    GLuint count = 0;
+    glGetNamedBufferSubData(m_countBuffer.id(), sizeof(GLuint) * phase, sizeof(GLuint), &count);
+    return count;
+}
+
+unsigned int GpuCulling::drawnTriangles(CullPhase phase) const
+{
+    GLuint count = 0;
+    glGetNamedBufferSubData(m_countBuffer.id(), sizeof(GLuint) * (CULL_PHASE_COUNT + phase), sizeof(GLuint), &count);
+    return count;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "Shader.h"
+#include "mesh/MeshPool.h"
+
+enum CullPhase {
+    // Draws visible last frame, tested against the frustum only
+    CULL_EARLY = 0,
+    // Everything else, tested against the frustum and the Hi-Z pyramid of the early draws
+    CULL_LATE,
+    CULL_PHASE_COUNT
+};
+
+/**
+ * GPU driven culling of the mesh pool draws. A compute pass tests each draw's bounding box
+ * against the frustum and a hierarchical depth pyramid and writes compacted indirect draw
+ * commands, drawn with glMultiDrawElementsIndirectCount. Culling runs in two phases: draws
+ * visible last frame are drawn first, the depth pyramid is built from them and the late
+ * phase draws whatever has become visible since, so nothing pops in a frame late. The same
+ * buffers serve the cluster culling pass, which culls every meshlet of every draw on its own
+ * and also rejects clusters facing away from the camera.
+ */
+class GpuCulling {
+public:
+    // Must match local_size_x in shaders/draw_cull.comp and shaders/cluster_cull.comp and the
+    // group size in shaders/hiz_build.comp
+    static constexpr int CULL_GROUP_SIZE = 64;
+    static constexpr int HIZ_GROUP_SIZE = 8;
+
+    GpuCulling();
+    ~GpuCulling();
+
+    void setup(int width, int height);
+    /* Sizes the per-item buffers and marks every item visible, call after the pool was built and
+        when switching between culling draws and clusters */
+    void reset(unsigned int itemCount);
+    void cull(const Shader& cullShader, const glm::mat4& viewProjection, const glm::vec3& cameraPosition,
+        CullPhase phase, bool occlusion) const;
+    void buildHiZ(const Shader& hiZShader, GLuint depthTexture, glm::ivec2 renderSize) const;
+    void draw(const MeshPool& pool, CullPhase phase) const;
+    /* Read back how many commands and triangles each phase emitted, stall until the GPU caught up */
+    unsigned int drawnCount(CullPhase phase) const;
+    unsigned int drawnTriangles(CullPhase phase) const;
+
+    // False when the driver lacks glMultiDrawElementsIndirectCount, culled commands are then
+    // written in place with zero instances and every slot is submitted
+    inline bool hasDrawCount() const { return m_multiDrawCount != nullptr; }
+    // Draws or clusters, whatever the pool was last reset for
+    inline unsigned int itemCount() const { return m_itemCount; }
+    inline int hiZLevels() const { return m_hiZLevels; }
+
+private:
+    typedef void (APIENTRY* MultiDrawElementsIndirectCountProc)(GLenum mode, GLenum type,
+        const void* indirect, GLintptr drawcount, GLsizei maxdrawcount, GLsizei stride);
+
+    MultiDrawElementsIndirectCountProc m_multiDrawCount = nullptr;
+    GpuResource m_commandBuffer;
+    GpuResource m_countBuffer;
+    GpuResource m_visibilitySSBO;
+    unsigned int m_itemCount = 0;
+    unsigned int m_itemCapacity = 0;
+
+    GpuResource m_hiZTexture;
+    glm::ivec2 m_hiZSize = glm::ivec2(0);
+    int m_hiZLevels = 0;
+};
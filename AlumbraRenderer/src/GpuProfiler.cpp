@@ -0,0 +1,181 @@
+#include "pch.h"
+#include "GpuProfiler.h"
+#include "Profiler.h"
+#include "vendor/imgui/imgui.h"
+
+#include <algorithm>
+#include <cfloat>
+
+/* Value at the given percentile (0-100) of the samples */
+static float percentile(std::vector<float> samples, float p)
+{
+    if (samples.empty())
+        return 0.0f;
+    size_t index = std::min(samples.size() - 1, (size_t)(p / 100.0f * samples.size()));
+    std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+    return samples[index];
+}
+
+GpuProfiler::GpuProfiler()
+{
+    for (auto& slot : m_slots) {
+        glCreateQueries(GL_TIMESTAMP, MAX_SCOPES * 2, slot.queries);
+        slot.scopes.reserve(MAX_SCOPES);
+    }
+    m_historyFrames.resize(HISTORY_SIZE, 0);
+}
+
+GpuProfiler::~GpuProfiler() {}
+
+/* Reads back the slot recorded FRAME_LATENCY frames ago and starts recording into it.
+    If the GPU is so far behind that its results are still not available, this frame is not
+    timed rather than waiting on the queries */
+void GpuProfiler::beginFrame()
+{
+    FrameSlot& slot = m_slots[m_frameNumber % FRAME_LATENCY];
+    m_frameNumber++;
+    m_current = nullptr;
+    m_openScopes.clear();
+
+    if (slot.pending && !resolve(slot)) {
+        m_droppedFrames++;
+        return;
+    }
+    slot.scopes.clear();
+    slot.frameNumber = m_frameNumber;
+    slot.profilerFrame = Profiler::frame();
+    // Calibrate the GPU clock against the CPU profiler clock every frame to follow any drift
+    GLint64 gpuNow = 0;
+    glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+    slot.cpuOffset = Profiler::now() - gpuNow;
+    m_current = &slot;
+    pushScope("Frame");
+}
+
+void GpuProfiler::endFrame()
+{
+    if (m_current == nullptr)
+        return;
+    while (!m_openScopes.empty())
+        popScope();
+    m_current->pending = true;
+    m_current = nullptr;
+}
+
+void GpuProfiler::pushScope(const char* name)
+{
+    glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, name);
+    if (m_current == nullptr || m_current->scopes.size() == MAX_SCOPES) {
+        m_openScopes.push_back(-1);
+        return;
+    }
+    int index = m_current->scopes.size();
+    ScopeQuery scope;
+    scope.name = name;
+    scope.depth = m_openScopes.size();
+    scope.startQuery = m_current->queries[index * 2];
+    scope.endQuery = m_current->queries[index * 2 + 1];
+    glQueryCounter(scope.startQuery, GL_TIMESTAMP);
+    m_current->scopes.push_back(scope);
+    m_openScopes.push_back(index);
+}
+
+void GpuProfiler::popScope()
+{
+    if (m_openScopes.empty())
+        return;
+    int index = m_openScopes.back();
+    m_openScopes.pop_back();
+    if (index >= 0 && m_current != nullptr)
+        glQueryCounter(m_current->scopes[index].endQuery, GL_TIMESTAMP);
+    glPopDebugGroup();
+}
+
+/* Copies a finished slot into the history, returns false if the GPU has not reached it yet */
+bool GpuProfiler::resolve(FrameSlot& slot)
+{
+    // The frame scope ends last and queries complete in order, so once it is ready all of them are
+    GLint available = 0;
+    glGetQueryObjectiv(slot.scopes.front().endQuery, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available)
+        return false;
+
+    int writeIndex = (m_historyOffset + m_historyCount) % HISTORY_SIZE;
+    if (m_historyCount < HISTORY_SIZE)
+        m_historyCount++;
+    else
+        m_historyOffset = (m_historyOffset + 1) % HISTORY_SIZE;
+    m_historyFrames[writeIndex] = slot.frameNumber;
+    // Scopes missing from this frame, e.g. a disabled pass, read as zero
+    for (auto& scopeHistory : m_history)
+        scopeHistory.samples[writeIndex] = 0.0f;
+
+    m_lastResults.clear();
+    m_lastResolvedFrame = slot.frameNumber;
+    for (const auto& scope : slot.scopes) {
+        GLuint64 start = 0, end = 0;
+        glGetQueryObjectui64v(scope.startQuery, GL_QUERY_RESULT, &start);
+        glGetQueryObjectui64v(scope.endQuery, GL_QUERY_RESULT, &end);
+        m_lastResults.push_back({ scope.name, scope.depth, start, end });
+        Profiler::recordGpu(scope.name, (long long)start + slot.cpuOffset, (long long)end + slot.cpuOffset,
+            slot.profilerFrame);
+        history(scope.name, scope.depth).samples[writeIndex] += (end - start) / 1e6f;
+    }
+    slot.pending = false;
+    return true;
+}
+
+GpuProfiler::ScopeHistory& GpuProfiler::history(const char* name, int depth)
+{
+    for (auto& scopeHistory : m_history) {
+        if (scopeHistory.name == name)
+            return scopeHistory;
+    }
+    m_history.push_back({ name, depth, std::vector<float>(HISTORY_SIZE, 0.0f) });
+    return m_history.back();
+}
+
+void GpuProfiler::drawGUI()
+{
+    ImGui::Begin("GPU Profiler");
+    ImGui::Text("%d frame latency, %u frames dropped", FRAME_LATENCY, m_droppedFrames);
+    ImGui::Text("%-20s %8s %8s %8s", "Scope (ms)", "p50", "p95", "p99");
+    for (const auto& scopeHistory : m_history) {
+        std::vector<float> samples;
+        samples.reserve(m_historyCount);
+        for (int i = 0; i < m_historyCount; i++)
+            samples.push_back(scopeHistory.samples[(m_historyOffset + i) % HISTORY_SIZE]);
+
+        std::string label = std::string(scopeHistory.depth * 2, ' ') + scopeHistory.name;
+        ImGui::Text("%-20s %8.3f %8.3f %8.3f", label.c_str(), percentile(samples, 50.0f),
+            percentile(samples, 95.0f), percentile(samples, 99.0f));
+        ImGui::PlotLines(("##" + scopeHistory.name).c_str(), samples.data(), samples.size(), 0,
+            nullptr, 0.0f, FLT_MAX, ImVec2(0.0f, 30.0f));
+    }
+    if (ImGui::Button("Export CSV"))
+        exportCSV("gpu_profile.csv");
+    ImGui::End();
+}
+
+/* Writes one row per resolved frame in the history and one column per scope, in ms */
+bool GpuProfiler::exportCSV(const std::string& path) const
+{
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        std::cout << "ERROR::GPU_PROFILER::Could not write " << path << std::endl;
+        return false;
+    }
+    file << "frame";
+    for (const auto& scopeHistory : m_history)
+        file << "," << scopeHistory.name;
+    file << "\n";
+    for (int i = 0; i < m_historyCount; i++) {
+        int index = (m_historyOffset + i) % HISTORY_SIZE;
+        file << m_historyFrames[index];
+        for (const auto& scopeHistory : m_history)
+            file << "," << scopeHistory.samples[index];
+        file << "\n";
+    }
+    std::cout << "GPU profile written to " << path << std::endl;
+    return true;
+}
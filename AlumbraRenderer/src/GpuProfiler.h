@@ -0,0 +1,82 @@
+#pragma once
+
+/**
+ * Times nested GPU scopes with GL_TIMESTAMP queries. Each frame records into its own slot
+ * of a small query pool and is only read back FRAME_LATENCY frames later, so reading the
+ * results never stalls the pipeline. Scopes are mirrored as debug groups for tools like
+ * RenderDoc or Nsight, and the per-scope history can be shown in ImGui or saved to CSV.
+ * Resolved scopes are also forwarded to the CPU Profiler for its trace export.
+ */
+class GpuProfiler {
+public:
+    static constexpr int FRAME_LATENCY = 4;
+    static constexpr int MAX_SCOPES = 32;
+    static constexpr int HISTORY_SIZE = 256;
+
+    // A scope from a resolved frame, times are raw GPU timestamps in nanoseconds
+    struct ScopeResult {
+        const char* name;
+        int depth;
+        GLuint64 start;
+        GLuint64 end;
+    };
+
+    GpuProfiler();
+    ~GpuProfiler();
+
+    void beginFrame();
+    void endFrame();
+    void pushScope(const char* name);
+    void popScope();
+
+    void drawGUI();
+    bool exportCSV(const std::string& path) const;
+
+    inline const std::vector<ScopeResult>& lastResults() const { return m_lastResults; }
+    // Number of the frame currently being recorded
+    inline unsigned long long frameNumber() const { return m_frameNumber; }
+    // Frame number of lastResults, counting beginFrame calls from 1
+    inline unsigned long long lastResolvedFrame() const { return m_lastResolvedFrame; }
+    inline unsigned int droppedFrames() const { return m_droppedFrames; }
+
+private:
+    struct ScopeQuery {
+        const char* name;
+        int depth;
+        GLuint startQuery;
+        GLuint endQuery;
+    };
+
+    struct FrameSlot {
+        GLuint queries[MAX_SCOPES * 2];
+        std::vector<ScopeQuery> scopes;
+        unsigned long long frameNumber = 0;
+        // CPU profiler frame and clock offset, so results can be put on the CPU timeline
+        unsigned long long profilerFrame = 0;
+        long long cpuOffset = 0;
+        bool pending = false;
+    };
+
+    // Rolling per-scope times in ms, all histories are aligned by resolved frame
+    struct ScopeHistory {
+        std::string name;
+        int depth;
+        std::vector<float> samples;
+    };
+
+    FrameSlot m_slots[FRAME_LATENCY];
+    FrameSlot* m_current = nullptr;
+    std::vector<int> m_openScopes;
+    unsigned long long m_frameNumber = 0;
+    unsigned int m_droppedFrames = 0;
+
+    std::vector<ScopeHistory> m_history;
+    std::vector<unsigned long long> m_historyFrames;
+    int m_historyOffset = 0;
+    int m_historyCount = 0;
+    std::vector<ScopeResult> m_lastResults;
+    unsigned long long m_lastResolvedFrame = 0;
+
+    bool resolve(FrameSlot& slot);
+    ScopeHistory& history(const char* name, int depth);
+};
@@ -0,0 +1,142 @@
+#include "pch.h"
+#include "Impostors.h"
+#include "Profiler.h"
+
+Impostors::Impostors()
+{
+    glCreateFramebuffers(1, &m_framebufferID);
+    GLenum attachments[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+    glNamedFramebufferDrawBuffers(m_framebufferID, 2, attachments);
+    // Quads are generated from gl_VertexID, the core profile still wants a VAO bound
+    glCreateVertexArrays(1, &m_quadVAO);
+}
+
+Impostors::~Impostors() {}
+
+/* Every layer is rendered by the G-buffer shader into the same attachments the G-buffer pass
+    writes, normal to 0 and albedo to 1, the metal/rough and velocity outputs have no attachment
+    and are dropped */
+void Impostors::bake(const Shader& gBufferShader, const std::vector<Model*>& models,
+    const std::vector<unsigned int>& bakedModels)
+{
+    PROFILE_FUNCTION();
+    releaseAtlases();
+    m_modelLayers.assign(models.size(), -1);
+    m_layerCount = bakedModels.size();
+    if (m_layerCount == 0)
+        return;
+
+    ResourceManager& resources = ResourceManager::instance();
+    auto createAtlas = [&](GLenum format, GLenum filter, const std::string& name) {
+        GpuResource atlas(resources.createTexture(ResourceCategory::RenderTarget, GL_TEXTURE_2D_ARRAY, name));
+        GLuint texture = atlas.id();
+        glTextureStorage3D(texture, 1, format, ATLAS_SIZE, ATLAS_SIZE, m_layerCount);
+        glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, filter);
+        glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, filter);
+        glTextureParameteri(texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTextureParameteri(texture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        resources.measureTexture(atlas.handle());
+        return atlas;
+    };
+    // Same formats as the G-buffer targets, so baked texels read back exactly as written
+    m_albedoAtlas = createAtlas(GL_SRGB8_ALPHA8, GL_LINEAR, "Impostor Albedo Atlas");
+    m_normalAtlas = createAtlas(GL_RG16, GL_LINEAR, "Impostor Normal Atlas");
+    m_depthAtlas = createAtlas(GL_DEPTH_COMPONENT24, GL_NEAREST, "Impostor Depth Atlas");
+
+    gBufferShader.use();
+    gBufferShader.setMat4("model", glm::mat4(1.0f));
+    gBufferShader.setMat4("prevModel", glm::mat4(1.0f));
+    gBufferShader.setMat4("currViewProjection", glm::mat4(1.0f));
+    gBufferShader.setMat4("prevViewProjection", glm::mat4(1.0f));
+    gBufferShader.setVec3("albedo", glm::vec3(1.0f));
+    gBufferShader.setFloat("metallic", 0.0f);
+    gBufferShader.setFloat("roughness", 1.0f);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_framebufferID);
+    glEnable(GL_DEPTH_TEST);
+
+    const float clearColor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    const float clearDepth = 1.0f;
+    for (unsigned int layer = 0; layer < m_layerCount; layer++) {
+        Model& model = *models[bakedModels[layer]];
+        m_modelLayers[bakedModels[layer]] = layer;
+        glNamedFramebufferTextureLayer(m_framebufferID, GL_COLOR_ATTACHMENT0, m_normalAtlas.id(), 0, layer);
+        glNamedFramebufferTextureLayer(m_framebufferID, GL_COLOR_ATTACHMENT1, m_albedoAtlas.id(), 0, layer);
+        glNamedFramebufferTextureLayer(m_framebufferID, GL_DEPTH_ATTACHMENT, m_depthAtlas.id(), 0, layer);
+        glClearNamedFramebufferfv(m_framebufferID, GL_COLOR, 0, clearColor);
+        glClearNamedFramebufferfv(m_framebufferID, GL_COLOR, 1, clearColor);
+        glClearNamedFramebufferfv(m_framebufferID, GL_DEPTH, 0, &clearDepth);
+
+        // Orthographic views of the bounding sphere from twice its radius away, depth then maps
+        // linearly from the sphere's front to its back
+        glm::vec4 sphere = boundingSphere(model.bounds());
+        glm::vec3 center(sphere);
+        float radius = sphere.w;
+        gBufferShader.setMat4("projection", glm::ortho(-radius, radius, -radius, radius, radius, 3.0f * radius));
+        for (int y = 0; y < GRID; y++) {
+            for (int x = 0; x < GRID; x++) {
+                glm::vec3 direction = viewDirection(x, y);
+                glm::vec3 up = std::abs(direction.y) > 0.999f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+                gBufferShader.setMat4("view", glm::lookAt(center + direction * 2.0f * radius, center, up));
+                glViewport(x * VIEW_SIZE, y * VIEW_SIZE, VIEW_SIZE, VIEW_SIZE);
+                model.draw(gBufferShader);
+            }
+        }
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+/* One instanced draw of a quad per instance, the instances are read from binding 19 */
+void Impostors::draw(const Shader& impostorShader, const std::vector<ImpostorInstance>& instances)
+{
+    if (instances.empty() || m_layerCount == 0)
+        return;
+    if (instances.size() > m_instanceCapacity) {
+        m_instanceCapacity = std::max((unsigned int)instances.size(), m_instanceCapacity * 2);
+        m_instanceSSBO = GpuResource(ResourceManager::instance().createBuffer(ResourceCategory::Other,
+            m_instanceCapacity * sizeof(ImpostorInstance), nullptr, GL_DYNAMIC_STORAGE_BIT, "Impostor Instances"));
+    }
+    glNamedBufferSubData(m_instanceSSBO.id(), 0, instances.size() * sizeof(ImpostorInstance), instances.data());
+
+    impostorShader.use();
+    impostorShader.setSampler("albedoAtlas", 0);
+    impostorShader.setSampler("normalAtlas", 1);
+    impostorShader.setSampler("depthAtlas", 2);
+    glBindTextureUnit(0, m_albedoAtlas.id());
+    glBindTextureUnit(1, m_normalAtlas.id());
+    glBindTextureUnit(2, m_depthAtlas.id());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 19, m_instanceSSBO.id());
+    glBindVertexArray(m_quadVAO);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, instances.size());
+}
+
+void Impostors::clear()
+{
+    releaseAtlases();
+    m_modelLayers.clear();
+    m_layerCount = 0;
+}
+
+glm::vec3 Impostors::viewDirection(int x, int y)
+{
+    return hemiOctDecode(glm::vec2(x, y) / float(GRID - 1) * 2.0f - 1.0f);
+}
+
+/* Matches hemiOctDecode in shaders/octahedral.glsl, the square's edge is the horizon */
+glm::vec3 Impostors::hemiOctDecode(glm::vec2 f)
+{
+    glm::vec2 p = glm::vec2(f.x + f.y, f.x - f.y) * 0.5f;
+    return glm::normalize(glm::vec3(p.x, 1.0f - std::abs(p.x) - std::abs(p.y), p.y));
+}
+
+glm::vec4 Impostors::boundingSphere(const AABB& bounds)
+{
+    glm::vec3 center = (bounds.min + bounds.max) * 0.5f;
+    float radius = std::max(glm::length(bounds.max - bounds.min) * 0.5f, 1e-4f);
+    return glm::vec4(center, radius);
+}
+
+void Impostors::releaseAtlases()
+{
+    for (GpuResource* texture : { &m_albedoAtlas, &m_normalAtlas, &m_depthAtlas })
+        texture->reset();
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "Scene.h"
+
+struct ImpostorSettings {
+    bool enabled = true;
+    // Objects whose bounding sphere spans fewer pixels than this on screen draw as impostors
+    float maxPixels = 48.0f;
+    // Most instanced models baked first, each one costs a layer of every atlas
+    unsigned int maxModels = 16;
+};
+
+// std430 layout, must match shaders/impostor.vert
+struct ImpostorInstance {
+    glm::mat4 model;
+    glm::mat4 prevModel;
+    // Object space bounding sphere of the model, center in xyz and radius in w
+    glm::vec4 sphere;
+    glm::vec3 albedo;
+    float metallic;
+    float roughness;
+    GLuint layer;
+    GLuint padding[2];
+};
+
+/**
+ * Octahedral impostors for distant instances. Each baked model is rendered with the G-buffer
+ * shader from GRID x GRID directions laid out hemi-octahedrally over the upper hemisphere,
+ * orthographic views of its bounding sphere side by side in one layer of an albedo, normal and
+ * depth atlas. Normals are baked in object space and albedo with a white material, so every
+ * instance keeps its own transform and material. Instances are drawn as camera facing quads
+ * in one instanced draw, each blending the four baked views nearest to its view direction and
+ * writing the G-buffer like any other geometry, so far away fields of objects cost about the
+ * same no matter what the models are made of.
+ */
+class Impostors {
+public:
+    static constexpr int GRID = 8;
+    // Pixels per side of every baked view
+    static constexpr int VIEW_SIZE = 64;
+    static constexpr int ATLAS_SIZE = GRID * VIEW_SIZE;
+
+    Impostors();
+    ~Impostors();
+
+    /* Bakes the given models, replacing every earlier bake, expects the G-buffer shader */
+    void bake(const Shader& gBufferShader, const std::vector<Model*>& models,
+        const std::vector<unsigned int>& bakedModels);
+    /* Draws the instances into the bound G-buffer, instances are uploaded on every call */
+    void draw(const Shader& impostorShader, const std::vector<ImpostorInstance>& instances);
+    void clear();
+
+    // Atlas layer of a model, -1 when it was not baked
+    inline int layer(unsigned int model) const { return model < m_modelLayers.size() ? m_modelLayers[model] : -1; }
+    inline unsigned int layerCount() const { return m_layerCount; }
+
+    /* Object space direction of the baked view at a grid cell */
+    static glm::vec3 viewDirection(int x, int y);
+    static glm::vec3 hemiOctDecode(glm::vec2 f);
+    static glm::vec4 boundingSphere(const AABB& bounds);
+
+private:
+    GLuint m_framebufferID;
+    GpuResource m_albedoAtlas;
+    GpuResource m_normalAtlas;
+    GpuResource m_depthAtlas;
+    GpuResource m_instanceSSBO;
+    unsigned int m_instanceCapacity = 0;
+    GLuint m_quadVAO;
+    unsigned int m_layerCount = 0;
+    std::vector<int> m_modelLayers;
+
+    void releaseAtlases();
+};
@@ -0,0 +1,93 @@
+#include "pch.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+
+JobSystem::JobSystem(int workerCount)
+{
+    if (workerCount < 0) {
+        int hardwareThreads = (int)std::thread::hardware_concurrency();
+        workerCount = std::max(hardwareThreads - 1, 0);
+    }
+    for (int i = 0; i < workerCount; i++)
+        m_workers.emplace_back(&JobSystem::workerLoop, this, i);
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_quit = true;
+    }
+    m_wake.notify_all();
+    for (auto& worker : m_workers)
+        worker.join();
+}
+
+void JobSystem::parallelFor(unsigned int count, const std::function<void(unsigned int)>& job)
+{
+    if (count == 0)
+        return;
+    if (m_workers.empty() || count == 1) {
+        for (unsigned int i = 0; i < count; i++)
+            job(i);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_job = &job;
+        m_jobCount = count;
+        m_nextJob.store(0, std::memory_order_relaxed);
+        m_finishedJobs = 0;
+        m_generation++;
+    }
+    m_wake.notify_all();
+
+    unsigned int ran = runJobs(job, count);
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_finishedJobs += ran;
+    m_done.wait(lock, [this] { return m_finishedJobs == m_jobCount && m_activeWorkers == 0; });
+    m_job = nullptr;
+}
+
+void JobSystem::workerLoop(unsigned int index)
+{
+    Profiler::setThreadName(("Worker " + std::to_string(index)).c_str());
+    unsigned long long seenGeneration = 0;
+    while (true) {
+        const std::function<void(unsigned int)>* job;
+        unsigned int count;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [&] { return m_quit || (m_generation != seenGeneration && m_job != nullptr); });
+            if (m_quit)
+                return;
+            seenGeneration = m_generation;
+            job = m_job;
+            count = m_jobCount;
+            m_activeWorkers++;
+        }
+
+        unsigned int ran = runJobs(*job, count);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_finishedJobs += ran;
+            m_activeWorkers--;
+            if (m_finishedJobs == m_jobCount && m_activeWorkers == 0)
+                m_done.notify_one();
+        }
+    }
+}
+
+unsigned int JobSystem::runJobs(const std::function<void(unsigned int)>& job, unsigned int count)
+{
+    unsigned int ran = 0;
+    while (true) {
+        unsigned int index = m_nextJob.fetch_add(1, std::memory_order_relaxed);
+        if (index >= count)
+            break;
+        job(index);
+        ran++;
+    }
+    return ran;
+}
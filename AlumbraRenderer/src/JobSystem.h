@@ -0,0 +1,44 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+/**
+ * Fixed pool of worker threads for data parallel frame work. parallelFor hands out job indices
+ * from a shared counter to the workers and the calling thread, and returns once every job has
+ * finished, so callers can treat it like a loop. Only one parallelFor runs at a time.
+ */
+class JobSystem {
+public:
+    /* Negative picks one worker less than the hardware threads, the caller makes up the
+        difference. Zero workers runs every job on the calling thread */
+    JobSystem(int workerCount = -1);
+    ~JobSystem();
+
+    /* Runs job(0) ... job(count - 1) across all threads and waits for them */
+    void parallelFor(unsigned int count, const std::function<void(unsigned int)>& job);
+
+    // Workers plus the calling thread
+    inline unsigned int threadCount() const { return (unsigned int)m_workers.size() + 1; }
+
+private:
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_wake, m_done;
+    const std::function<void(unsigned int)>* m_job = nullptr;
+    unsigned int m_jobCount = 0;
+    std::atomic<unsigned int> m_nextJob{ 0 };
+    unsigned int m_finishedJobs = 0;
+    // Workers that joined the current batch, it is only over once they have all left it
+    unsigned int m_activeWorkers = 0;
+    // Bumped for every parallelFor so sleeping workers can tell a new batch from a spurious wakeup
+    unsigned long long m_generation = 0;
+    bool m_quit = false;
+
+    void workerLoop(unsigned int index);
+    /* Runs jobs until the counter is exhausted, returns how many this thread ran */
+    unsigned int runJobs(const std::function<void(unsigned int)>& job, unsigned int count);
+};
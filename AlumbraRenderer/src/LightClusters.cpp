@@ -0,0 +1,77 @@
+#include "pch.h"
+#include "LightClusters.h"
+
+LightClusters::LightClusters()
+{
+    ResourceManager& resources = ResourceManager::instance();
+    m_lightIndicesSSBO = GpuResource(resources.createBuffer(ResourceCategory::Other,
+        sizeof(GLuint) * CLUSTER_COUNT * AVERAGE_LIGHTS_PER_CLUSTER, nullptr, 0, "Cluster Light Indices"));
+
+    // One (offset, count) pair per cluster
+    m_lightGridSSBO = GpuResource(resources.createBuffer(ResourceCategory::Other,
+        sizeof(GLuint) * 2 * CLUSTER_COUNT, nullptr, 0, "Cluster Light Grid"));
+
+    m_indexCounterSSBO = GpuResource(resources.createBuffer(ResourceCategory::Other, sizeof(GLuint), nullptr,
+        GL_DYNAMIC_STORAGE_BIT, "Cluster Index Counter"));
+
+    updateLights({});
+}
+
+LightClusters::~LightClusters() {}
+
+/* Uploads the scene's point lights, growing the light buffer when needed so lights can
+    be added or moved every frame */
+void LightClusters::updateLights(const std::vector<PointLight>& lights)
+{
+    m_lightCount = lights.size();
+    if (m_lightCount > m_lightCapacity || !m_lightsSSBO) {
+        m_lightCapacity = std::max(m_lightCount, std::max(m_lightCapacity * 2, 16u));
+        m_lightsSSBO = GpuResource(ResourceManager::instance().createBuffer(ResourceCategory::Other,
+            m_lightCapacity * sizeof(struct PointLight), nullptr, GL_DYNAMIC_STORAGE_BIT, "Point Lights"));
+    }
+    if (m_lightCount != 0)
+        glNamedBufferSubData(m_lightsSSBO.id(), 0, m_lightCount * sizeof(struct PointLight), lights.data());
+}
+
+/* Builds the per-cluster light lists for the given camera */
+void LightClusters::cull(const Shader& cullShader, const glm::mat4& projection, const glm::mat4& view,
+    float zNear, float zFar, int width, int height)
+{
+    // Exponential depth slicing: slice = log(z) * scale + bias
+    float logRatio = std::log(zFar / zNear);
+    m_zScale = CLUSTER_Z / logRatio;
+    m_zBias = -(CLUSTER_Z * std::log(zNear)) / logRatio;
+    m_tileSize = glm::vec2(std::ceil((float)width / CLUSTER_X), std::ceil((float)height / CLUSTER_Y));
+
+    GLuint zero = 0;
+    glNamedBufferSubData(m_indexCounterSSBO.id(), 0, sizeof(GLuint), &zero);
+
+    bind();
+    cullShader.use();
+    cullShader.setMat4("invProjection", glm::inverse(projection));
+    cullShader.setMat4("view", view);
+    cullShader.setFloat("zNear", zNear);
+    cullShader.setFloat("zFar", zFar);
+    cullShader.setVec2("screenSize", glm::vec2(width, height));
+    cullShader.setInt("numPointLights", m_lightCount);
+    setUniforms(cullShader);
+
+    glDispatchCompute(CLUSTER_X, CLUSTER_Y, CLUSTER_Z);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+/* Sets the cluster lookup uniforms used by clusters.glsl, the shader must be in use */
+void LightClusters::setUniforms(const Shader& shader) const
+{
+    shader.setVec2("clusterTileSize", m_tileSize);
+    shader.setFloat("clusterZScale", m_zScale);
+    shader.setFloat("clusterZBias", m_zBias);
+}
+
+void LightClusters::bind() const
+{
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, m_lightsSSBO.id());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, m_lightIndicesSSBO.id());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, m_lightGridSSBO.id());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 6, m_indexCounterSSBO.id());
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "Scene.h"
+#include "Shader.h"
+
+/**
+ * Bins point lights into view space froxel clusters with a compute pass. The resulting
+ * per-cluster light lists are stored in SSBOs so any shader including clusters.glsl can
+ * shade only the lights that affect its cluster.
+ */
+class LightClusters {
+public:
+    // Must match the defines in shaders/clusters.glsl
+    static constexpr unsigned int CLUSTER_X = 16, CLUSTER_Y = 9, CLUSTER_Z = 24;
+    static constexpr unsigned int CLUSTER_COUNT = CLUSTER_X * CLUSTER_Y * CLUSTER_Z;
+    static constexpr unsigned int AVERAGE_LIGHTS_PER_CLUSTER = 128;
+
+    LightClusters();
+    ~LightClusters();
+
+    void updateLights(const std::vector<PointLight>& lights);
+    void cull(const Shader& cullShader, const glm::mat4& projection, const glm::mat4& view,
+        float zNear, float zFar, int width, int height);
+    void setUniforms(const Shader& shader) const;
+    void bind() const;
+
+    inline unsigned int lightCount() const { return m_lightCount; }
+
+private:
+    GpuResource m_lightsSSBO;
+    GpuResource m_lightIndicesSSBO;
+    GpuResource m_lightGridSSBO;
+    GpuResource m_indexCounterSSBO;
+    unsigned int m_lightCapacity = 0;
+    unsigned int m_lightCount = 0;
+
+    // Lookup parameters shared between the cull pass and shading passes
+    glm::vec2 m_tileSize = glm::vec2(1.0f);
+    float m_zScale = 0.0f;
+    float m_zBias = 0.0f;
+};
@@ -0,0 +1,62 @@
+#include "pch.h"
+#include "LodSelector.h"
+#include "Profiler.h"
+
+/* Objects are matched to last frame's levels by position in the list, the levels restart at
+    full detail whenever the number of meshes changes */
+void LodSelector::select(const std::vector<Model*>& models, const std::vector<SceneObject>& objects,
+    const std::vector<glm::mat4>& objectMatrices, const std::vector<AABB>& worldBounds,
+    const glm::vec3& viewPosition, float projectionScale, int viewportHeight, const LodSettings& settings)
+{
+    PROFILE_FUNCTION();
+    m_objectOffsets.resize(objects.size());
+    unsigned int meshCount = 0;
+    for (unsigned int i = 0; i < objects.size(); i++) {
+        m_objectOffsets[i] = meshCount;
+        meshCount += models[objects[i].model]->meshes().size();
+    }
+    if (m_lods.size() != meshCount || !settings.enabled)
+        m_lods.assign(meshCount, 0);
+    m_pixelsPerUnit.resize(objects.size());
+
+    float pixelsPerDistance = projectionScale * viewportHeight * 0.5f;
+    for (unsigned int i = 0; i < objects.size(); i++) {
+        const glm::mat3 basis(objectMatrices[i]);
+        float scale = std::max(std::max(glm::length(basis[0]), glm::length(basis[1])), glm::length(basis[2]));
+        const AABB& bounds = worldBounds[i];
+        glm::vec3 closest = glm::clamp(viewPosition, bounds.min, bounds.max);
+        float distance = glm::length(closest - viewPosition);
+        // Inside the bounds any error can cover the screen
+        float pixelsPerUnit = distance > 0.0f ? scale * pixelsPerDistance / distance
+            : std::numeric_limits<float>::max();
+        m_pixelsPerUnit[i] = pixelsPerUnit;
+        if (!settings.enabled)
+            continue;
+
+        const auto& meshes = models[objects[i].model]->meshes();
+        unsigned int* lods = m_lods.data() + m_objectOffsets[i];
+        for (unsigned int m = 0; m < meshes.size(); m++)
+            lods[m] = selectLevel(*meshes[m], lods[m], pixelsPerUnit, settings);
+    }
+}
+
+void LodSelector::clear()
+{
+    m_lods.clear();
+    m_objectOffsets.clear();
+    m_pixelsPerUnit.clear();
+}
+
+unsigned int LodSelector::selectLevel(const Mesh& mesh, unsigned int previous, float pixelsPerUnit,
+    const LodSettings& settings)
+{
+    unsigned int lod = std::min(previous, mesh.lodCount() - 1);
+    // Refine while the current level shows too much error, coarsen while the next one would
+    // stay clearly below the threshold
+    while (lod > 0 && mesh.m_lods[lod].error * pixelsPerUnit > settings.pixelError)
+        lod--;
+    float coarsenError = settings.pixelError * (1.0f - settings.hysteresis);
+    while (lod + 1 < mesh.lodCount() && mesh.m_lods[lod + 1].error * pixelsPerUnit <= coarsenError)
+        lod++;
+    return lod;
+}
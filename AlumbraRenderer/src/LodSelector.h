@@ -0,0 +1,45 @@
+#pragma once
+
+#include "Scene.h"
+
+struct LodSettings {
+    bool enabled = true;
+    // Largest error in pixels a level may show on screen
+    float pixelError = 1.0f;
+    // A level is only dropped once its error is this fraction below the threshold, so objects
+    // sitting at a switching distance do not pop back and forth
+    float hysteresis = 0.25f;
+};
+
+/**
+ * Picks the level of detail of every mesh of every object for one view from the screen space
+ * size of its simplification error. The error of a level is scaled by the object's largest axis
+ * and projected at the distance to the object's world bounds, which never underestimates it.
+ * Each view keeps its own selector since the levels of the last frame are the starting point of
+ * the next one's hysteresis.
+ */
+class LodSelector {
+public:
+    /* projectionScale is the projection's [1][1] entry, viewportHeight is in pixels */
+    void select(const std::vector<Model*>& models, const std::vector<SceneObject>& objects,
+        const std::vector<glm::mat4>& objectMatrices, const std::vector<AABB>& worldBounds,
+        const glm::vec3& viewPosition, float projectionScale, int viewportHeight, const LodSettings& settings);
+    void clear();
+
+    // One level per mesh of every object, in the order MeshPool lists its draws
+    inline const std::vector<unsigned int>& lods() const { return m_lods; }
+    // Levels of an object's meshes
+    inline const unsigned int* objectLods(unsigned int object) const { return m_lods.data() + m_objectOffsets[object]; }
+    // Screen pixels covered by one object space unit of an object at its closest, also kept
+    // up to date while levels of detail are disabled
+    inline float pixelsPerUnit(unsigned int object) const { return m_pixelsPerUnit[object]; }
+
+    /* Level of one mesh with previous as the last frame's, pixelsPerUnit at its distance */
+    static unsigned int selectLevel(const Mesh& mesh, unsigned int previous, float pixelsPerUnit,
+        const LodSettings& settings);
+
+private:
+    std::vector<unsigned int> m_lods;
+    std::vector<unsigned int> m_objectOffsets;
+    std::vector<float> m_pixelsPerUnit;
+};
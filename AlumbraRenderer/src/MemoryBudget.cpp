@@ -0,0 +1,125 @@
+#include "pch.h"
+#include "MemoryBudget.h"
+#include "AssetRegistry.h"
+#include "Cubemap.h"
+#include "Profiler.h"
+
+#include <algorithm>
+
+static size_t megabytes(float mb)
+{
+    return (size_t)(mb * 1024.0f * 1024.0f);
+}
+
+void MemoryBudget::update(Cubemap& environment, const MemoryBudgetSettings& settings)
+{
+    PROFILE_FUNCTION();
+    m_stats.meshCpuBytes = 0;
+    for (Mesh* mesh : AssetRegistry::instance().meshes())
+        m_stats.meshCpuBytes += mesh->cpuSize();
+    if (!settings.enabled)
+        return;
+
+    if (settings.meshCpuMB > 0.0f && m_stats.meshCpuBytes > megabytes(settings.meshCpuMB))
+        releaseMeshCopies(megabytes(settings.meshCpuMB));
+    if (overBudget(ResourceCategory::Environment, settings) && environment.sourceResident()) {
+        environment.releaseSource();
+        if (!environment.sourceResident())
+            m_stats.sourcesReleased++;
+    }
+    if (overBudget(ResourceCategory::Texture, settings) || overBudget(ResourceCategory::Count, settings))
+        shrinkTextures(settings);
+    else
+        restoreTextures(settings);
+}
+
+bool MemoryBudget::overBudget(ResourceCategory category, const MemoryBudgetSettings& settings)
+{
+    const ResourceManager& resources = ResourceManager::instance();
+    if (category == ResourceCategory::Count)
+        return settings.totalMB > 0.0f && resources.totalBytes() > megabytes(settings.totalMB);
+    float budget = settings.categoryMB[(int)category];
+    return budget > 0.0f && resources.stats(category).bytes > megabytes(budget);
+}
+
+/* Largest copies first, so the fewest meshes need a readback when the scene is rebuilt */
+void MemoryBudget::releaseMeshCopies(size_t budget)
+{
+    std::vector<Mesh*> resident;
+    for (Mesh* mesh : AssetRegistry::instance().meshes()) {
+        if (mesh->cpuResident())
+            resident.push_back(mesh);
+    }
+    std::sort(resident.begin(), resident.end(),
+        [](const Mesh* a, const Mesh* b) { return a->cpuSize() > b->cpuSize(); });
+    for (Mesh* mesh : resident) {
+        if (m_stats.meshCpuBytes <= budget)
+            break;
+        m_stats.meshCpuBytes -= mesh->cpuSize();
+        mesh->releaseCpuData();
+        m_stats.meshesReleased++;
+    }
+}
+
+/* Least recently drawn first, a texture loses half its resolution per step until it reaches
+    maxDownscale and is evicted on the next one */
+void MemoryBudget::shrinkTextures(const MemoryBudgetSettings& settings)
+{
+    AssetRegistry& registry = AssetRegistry::instance();
+    unsigned long long frame = ResourceManager::instance().frame();
+    std::vector<TextureAsset*> idle;
+    for (TextureAsset* texture : registry.textures()) {
+        if (texture->id != 0 && frame - texture->lastUsedFrame >= settings.idleFrames)
+            idle.push_back(texture);
+    }
+    std::sort(idle.begin(), idle.end(),
+        [](const TextureAsset* a, const TextureAsset* b) { return a->lastUsedFrame < b->lastUsedFrame; });
+    for (size_t i = 0; i < std::min<size_t>(idle.size(), settings.texturesPerFrame); i++) {
+        TextureAsset& texture = *idle[i];
+        if (texture.downscale < settings.maxDownscale) {
+            if (registry.streamTexture(texture, texture.downscale + 1))
+                m_stats.texturesDownscaled++;
+        }
+        else {
+            registry.evictTexture(texture);
+            m_stats.texturesEvicted++;
+        }
+    }
+}
+
+/* Most recently drawn first, one step back up at a time while the budgets have room for it */
+void MemoryBudget::restoreTextures(const MemoryBudgetSettings& settings)
+{
+    AssetRegistry& registry = AssetRegistry::instance();
+    ResourceManager& resources = ResourceManager::instance();
+    unsigned long long frame = resources.frame();
+    std::vector<TextureAsset*> drawn;
+    for (TextureAsset* texture : registry.textures()) {
+        if (texture->id != 0 && texture->downscale > 0 && frame - texture->lastUsedFrame < settings.idleFrames)
+            drawn.push_back(texture);
+    }
+    if (drawn.empty())
+        return;
+    std::sort(drawn.begin(), drawn.end(),
+        [](const TextureAsset* a, const TextureAsset* b) { return a->lastUsedFrame > b->lastUsedFrame; });
+
+    float textureBudget = settings.categoryMB[(int)ResourceCategory::Texture];
+    size_t textureBytes = resources.stats(ResourceCategory::Texture).bytes;
+    size_t totalBytes = resources.totalBytes();
+    unsigned int restored = 0;
+    for (TextureAsset* texture : drawn) {
+        if (restored == settings.texturesPerFrame)
+            break;
+        // Doubling both sides quadruples the texture
+        size_t growth = resources.bytes(texture->resource.handle()) * 3;
+        if ((textureBudget > 0.0f && textureBytes + growth > megabytes(textureBudget))
+            || (settings.totalMB > 0.0f && totalBytes + growth > megabytes(settings.totalMB)))
+            continue;
+        if (registry.streamTexture(*texture, texture->downscale - 1)) {
+            textureBytes += growth;
+            totalBytes += growth;
+            m_stats.texturesRestored++;
+            restored++;
+        }
+    }
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "ResourceManager.h"
+
+class Cubemap;
+
+struct MemoryBudgetSettings {
+    bool enabled = true;
+    // GPU budget of each ResourceCategory and of all of them together in MB, 0 is unbounded
+    float categoryMB[(int)ResourceCategory::Count] = { 384.0f, 0.0f, 1024.0f, 0.0f, 0.0f, 0.0f };
+    float totalMB = 0.0f;
+    // CPU copies of mesh streams kept after upload, in MB
+    float meshCpuMB = 512.0f;
+    // Textures not drawn for this many frames may be downscaled and then evicted
+    unsigned int idleFrames = 300;
+    // Halvings of its resolution a texture goes through before it is evicted
+    unsigned int maxDownscale = 2;
+    // Textures streamed per frame, each is a synchronous decode on the main thread
+    unsigned int texturesPerFrame = 2;
+};
+
+struct MemoryBudgetStats {
+    size_t meshCpuBytes = 0;
+    unsigned int meshesReleased = 0;
+    unsigned int texturesDownscaled = 0;
+    unsigned int texturesEvicted = 0;
+    unsigned int texturesRestored = 0;
+    unsigned int sourcesReleased = 0;
+};
+
+/**
+ * Keeps the renderer inside its memory budgets by acting on what the ResourceManager and the
+ * AssetRegistry track, once per frame after the frame was submitted:
+ * - meshes over the CPU budget drop their stream copies, largest first, and read them back
+ *   from their GPU buffer when a pool or occluder build needs them again
+ * - an environment over budget drops the equirectangular map it was captured from
+ * - textures over budget that were not drawn for a while are streamed again at half their
+ *   resolution, least recently used first, and evicted once at the lowest allowed resolution.
+ *   Evicted textures stream back in when a mesh binds them, downscaled ones are raised again
+ *   once they are being drawn and the budget has room for them
+ * Render targets, meshes and shaders have no policy, their budgets only flag the panel.
+ */
+class MemoryBudget {
+public:
+    void update(Cubemap& environment, const MemoryBudgetSettings& settings);
+
+    /* Whether a category is over its budget, Count stands for the total */
+    static bool overBudget(ResourceCategory category, const MemoryBudgetSettings& settings);
+    inline const MemoryBudgetStats& stats() const { return m_stats; }
+
+private:
+    MemoryBudgetStats m_stats;
+
+    void releaseMeshCopies(size_t budget);
+    void shrinkTextures(const MemoryBudgetSettings& settings);
+    void restoreTextures(const MemoryBudgetSettings& settings);
+};
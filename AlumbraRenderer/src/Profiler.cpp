@@ -0,0 +1,154 @@
+#include "pch.h"
+#include "Profiler.h"
+
+#include <chrono>
+#include <mutex>
+
+struct Profiler::ThreadBuffer {
+    std::vector<ProfileEvent> events;
+    // Only the owning thread writes, exporters read up to the published count
+    std::atomic<size_t> count{ 0 };
+    unsigned int threadID;
+    std::string threadName;
+};
+
+std::atomic<unsigned long long> Profiler::s_frame{ 0 };
+unsigned long long Profiler::s_captureFirst = 0, Profiler::s_captureLast = 0;
+std::string Profiler::s_capturePath;
+
+// Buffers are owned here so events survive the thread that recorded them
+static std::mutex s_registryMutex;
+static std::vector<std::unique_ptr<Profiler::ThreadBuffer>> s_threadBuffers;
+static const auto s_epoch = std::chrono::steady_clock::now();
+
+/* Nanoseconds since the profiler was loaded */
+long long Profiler::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - s_epoch).count();
+}
+
+/* Marks the start of a new frame and finishes a pending frame capture once its range is done */
+void Profiler::beginFrame()
+{
+    unsigned long long frame = s_frame.fetch_add(1, std::memory_order_relaxed) + 1;
+    if (s_captureLast != 0 && frame > s_captureLast + CAPTURE_DELAY_FRAMES) {
+        exportTrace(s_capturePath, s_captureFirst, s_captureLast);
+        s_captureFirst = s_captureLast = 0;
+    }
+}
+
+void Profiler::record(const char* name, long long start, long long end)
+{
+    ThreadBuffer& buffer = threadBuffer();
+    size_t index = buffer.count.load(std::memory_order_relaxed);
+    buffer.events[index % EVENTS_PER_THREAD] = { name, start, end, frame() };
+    buffer.count.store(index + 1, std::memory_order_release);
+}
+
+/* GPU scopes arrive a few frames late, so they carry the frame they were recorded in.
+    Only the render thread reports them */
+void Profiler::recordGpu(const char* name, long long start, long long end, unsigned long long frame)
+{
+    ThreadBuffer& buffer = gpuBuffer();
+    size_t index = buffer.count.load(std::memory_order_relaxed);
+    buffer.events[index % EVENTS_PER_THREAD] = { name, start, end, frame };
+    buffer.count.store(index + 1, std::memory_order_release);
+}
+
+void Profiler::setThreadName(const char* name)
+{
+    threadBuffer().threadName = name;
+}
+
+Profiler::ThreadBuffer& Profiler::threadBuffer()
+{
+    static thread_local ThreadBuffer* t_buffer = nullptr;
+    if (t_buffer == nullptr) {
+        std::lock_guard<std::mutex> lock(s_registryMutex);
+        auto buffer = std::make_unique<ThreadBuffer>();
+        buffer->events.resize(EVENTS_PER_THREAD);
+        buffer->threadID = s_threadBuffers.size() + 1;
+        buffer->threadName = "Thread " + std::to_string(buffer->threadID);
+        t_buffer = buffer.get();
+        s_threadBuffers.push_back(std::move(buffer));
+    }
+    return *t_buffer;
+}
+
+Profiler::ThreadBuffer& Profiler::gpuBuffer()
+{
+    static ThreadBuffer* s_gpuBuffer = nullptr;
+    if (s_gpuBuffer == nullptr) {
+        std::lock_guard<std::mutex> lock(s_registryMutex);
+        auto buffer = std::make_unique<ThreadBuffer>();
+        buffer->events.resize(EVENTS_PER_THREAD);
+        buffer->threadID = 0;
+        buffer->threadName = "GPU";
+        s_gpuBuffer = buffer.get();
+        s_threadBuffers.push_back(std::move(buffer));
+    }
+    return *s_gpuBuffer;
+}
+
+/* CPU events of every thread whose frame lies in [firstFrame, lastFrame] */
+std::vector<ProfileEvent> Profiler::events(unsigned long long firstFrame, unsigned long long lastFrame)
+{
+    std::lock_guard<std::mutex> lock(s_registryMutex);
+    std::vector<ProfileEvent> result;
+    for (const auto& buffer : s_threadBuffers) {
+        if (buffer->threadID == 0)
+            continue;
+        size_t count = buffer->count.load(std::memory_order_acquire);
+        size_t begin = count > EVENTS_PER_THREAD ? count - EVENTS_PER_THREAD : 0;
+        for (size_t i = begin; i < count; i++) {
+            const ProfileEvent& event = buffer->events[i % EVENTS_PER_THREAD];
+            if (event.frame >= firstFrame && event.frame <= lastFrame)
+                result.push_back(event);
+        }
+    }
+    return result;
+}
+
+/* Writes every event whose frame lies in [firstFrame, lastFrame] as Chrome trace_event JSON.
+    Pass 0, 0 for startup. Only the newest EVENTS_PER_THREAD events of each thread are kept */
+bool Profiler::exportTrace(const std::string& path, unsigned long long firstFrame, unsigned long long lastFrame)
+{
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        std::cout << "ERROR::PROFILER::Could not write " << path << std::endl;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(s_registryMutex);
+    file << "{\"traceEvents\":[\n";
+    bool first = true;
+    for (const auto& buffer : s_threadBuffers) {
+        file << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+            << buffer->threadID << ",\"args\":{\"name\":\"" << buffer->threadName << "\"}}";
+        first = false;
+
+        size_t count = buffer->count.load(std::memory_order_acquire);
+        size_t begin = count > EVENTS_PER_THREAD ? count - EVENTS_PER_THREAD : 0;
+        for (size_t i = begin; i < count; i++) {
+            const ProfileEvent& event = buffer->events[i % EVENTS_PER_THREAD];
+            if (event.frame < firstFrame || event.frame > lastFrame)
+                continue;
+            // Trace timestamps are in microseconds
+            file << ",\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->threadID
+                << ",\"ts\":" << event.start / 1000.0 << ",\"dur\":" << (event.end - event.start) / 1000.0
+                << ",\"args\":{\"frame\":" << event.frame << "}}";
+        }
+    }
+    file << "\n]}\n";
+    std::cout << "Trace written to " << path << std::endl;
+    return true;
+}
+
+/* Exports the next frameCount frames to path once the last of them and its GPU work has finished */
+void Profiler::captureFrames(int frameCount, const std::string& path)
+{
+    s_captureFirst = frame() + 1;
+    s_captureLast = frame() + std::max(frameCount, 1);
+    s_capturePath = path;
+}
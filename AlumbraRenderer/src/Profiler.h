@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+// Times the enclosing block, name must outlive the profiler (a string literal)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__FUNCTION__)
+
+struct ProfileEvent {
+    const char* name;
+    long long start;
+    long long end;
+    unsigned long long frame;
+};
+
+/**
+ * Low overhead CPU profiler. Every thread records into its own fixed size ring buffer, so
+ * recording an event is two clock reads and a store with no locks. Frame 0 is startup,
+ * everything before the first beginFrame. Events can be dumped as Chrome trace_event JSON
+ * (chrome://tracing or ui.perfetto.dev) for startup or a range of frames, together with
+ * GPU scope timings mapped onto the CPU clock.
+ */
+class Profiler {
+public:
+    static constexpr size_t EVENTS_PER_THREAD = 1 << 16;
+    // Frame captures are written this many frames late so GPU results for them have arrived
+    static constexpr int CAPTURE_DELAY_FRAMES = 8;
+
+    // Per thread event ring, defined in Profiler.cpp
+    struct ThreadBuffer;
+
+    static long long now();
+    static void beginFrame();
+    static inline unsigned long long frame() { return s_frame.load(std::memory_order_relaxed); }
+
+    static void record(const char* name, long long start, long long end);
+    static void recordGpu(const char* name, long long start, long long end, unsigned long long frame);
+    static void setThreadName(const char* name);
+
+    static std::vector<ProfileEvent> events(unsigned long long firstFrame, unsigned long long lastFrame);
+    static bool exportTrace(const std::string& path, unsigned long long firstFrame, unsigned long long lastFrame);
+    static void captureFrames(int frameCount, const std::string& path);
+    static inline bool capturing() { return s_captureLast != 0; }
+
+private:
+    static std::atomic<unsigned long long> s_frame;
+    static unsigned long long s_captureFirst, s_captureLast;
+    static std::string s_capturePath;
+
+    static ThreadBuffer& threadBuffer();
+    static ThreadBuffer& gpuBuffer();
+};
+
+/* Records the lifetime of the object as an event, use through PROFILE_SCOPE */
+class ProfileScope {
+public:
+    ProfileScope(const char* name) : m_name(name), m_start(Profiler::now()) {}
+    ~ProfileScope() { Profiler::record(m_name, m_start, Profiler::now()); }
+
+private:
+    const char* m_name;
+    long long m_start;
+};
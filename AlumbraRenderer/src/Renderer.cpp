@@ -6,8 +6,8 @@
 
 Renderer::Renderer(Scene* scene)
     : m_scene(scene)
-    , m_pointDepthFBOs(scene->pointLights().size(), 0)
-    , m_pointDepthMaps(scene->pointLights().size(), 0)
+    , m_pointDepthFBOs(std::min(scene->pointLights().size(), MAX_SHADOWED_POINT_LIGHTS), 0)
+    , m_pointDepthMaps(std::min(scene->pointLights().size(), MAX_SHADOWED_POINT_LIGHTS), 0)
 {
     glDepthFunc(GL_LESS);
     glEnable(GL_CULL_FACE);
@@ -24,23 +24,133 @@ Renderer::Renderer(Scene* scene)
 #endif // _DEBUG
 
     // Setting up a screen quad to render to
-    auto size = sizeof(fbQuadPos[0]) * fbQuadPos.size() + sizeof(fbQuadTex[0]) * fbQuadTex.size();
-    DataBuffer vbo(size, 6, 2);
-    vbo.addVec3s(fbQuadPos.data());
-    vbo.addVec2s(fbQuadTex.data());
-    VertexArray vao;
-    vao.loadBuffer(vbo, 1);
-    m_screenQuadVAO = vao.vertexArrayID();
+    VertexStreams quadStreams;
+    quadStreams.positions = fbQuadPos.data();
+    quadStreams.texCoords = fbQuadTex.data();
+    m_screenQuadVAO = ScreenQuadVertexFormat::upload(quadStreams, fbQuadPos.size()).vertexArrayID;
 
     setupShaders();
     setupFramebuffers();
     setupUniforms();
+    m_meshPool.build(m_scene->models(), m_scene->objects());
+    resetGpuCulling();
+    buildSceneBVH();
+    buildOccluders();
+    bakeImpostors();
 }
 
 Renderer::~Renderer() {}
 
+/* Rebuilds scene dependent GPU data, call after models or objects were added or removed */
+void Renderer::sceneChanged()
+{
+    PROFILE_FUNCTION();
+    m_meshPool.build(m_scene->models(), m_scene->objects());
+    resetGpuCulling();
+    buildSceneBVH();
+    buildOccluders();
+    bakeImpostors();
+    m_lodSelector.clear();
+    m_temporalAA.invalidateHistory();
+    m_checkerboard.invalidateHistory();
+}
+
+/* Inserts the world bounds of every object into the culling BVH */
+void Renderer::buildSceneBVH()
+{
+    const auto& models = m_scene->models();
+    const auto& objects = m_scene->objects();
+    m_objectBounds.clear();
+    m_objectBounds.reserve(objects.size());
+    for (const auto& object : objects)
+        m_objectBounds.push_back(models[object.model]->bounds().transformed(object.transform.matrix()));
+    m_sceneBVH.build(m_objectBounds);
+}
+
+/* Refits the objects whose matrix changed since last frame, call after the object matrices
+    were computed */
+void Renderer::updateSceneBVH()
+{
+    PROFILE_FUNCTION();
+    const auto& models = m_scene->models();
+    const auto& objects = m_scene->objects();
+    if (m_sceneBVH.objectCount() != objects.size()) {
+        buildSceneBVH();
+        return;
+    }
+    for (unsigned int i = 0; i < objects.size(); i++) {
+        if (m_objectMatrices[i] != m_prevObjectMatrices[i]) {
+            m_objectBounds[i] = models[objects[i].model]->bounds().transformed(m_objectMatrices[i]);
+            m_sceneBVH.update(i, m_objectBounds[i]);
+        }
+    }
+}
+
+void Renderer::setSoftwareOcclusion(const SoftwareOcclusionSettings& settings)
+{
+    bool resize = settings.width != m_softwareOcclusionSettings.width || settings.height != m_softwareOcclusionSettings.height;
+    bool rebuild = settings.triangleBudget != m_softwareOcclusionSettings.triangleBudget;
+    m_softwareOcclusionSettings = settings;
+    if (resize)
+        m_softwareOcclusion.setup(settings.width, settings.height);
+    if (rebuild)
+        buildOccluders();
+}
+
+void Renderer::setImpostors(const ImpostorSettings& settings)
+{
+    bool rebake = settings.maxModels != m_impostorSettings.maxModels;
+    m_impostorSettings = settings;
+    if (rebake)
+        bakeImpostors();
+}
+
+/* Sizes the GPU culling buffers for the pool's clusters or draws, whichever the visibility
+    pass culls, and marks them all visible */
+void Renderer::resetGpuCulling()
+{
+    m_cullingClusters = m_useClusterCulling && m_meshPool.clusterCount() > 0;
+    m_gpuCulling.reset(m_cullingClusters ? m_meshPool.clusterCount() : m_meshPool.drawCount());
+}
+
+/* Builds the simplified geometry of every model used by an occluder object */
+void Renderer::buildOccluders()
+{
+    PROFILE_FUNCTION();
+    const auto& models = m_scene->models();
+    m_occluderMeshes.clear();
+    m_occluderMeshes.resize(models.size());
+    for (const auto& object : m_scene->objects()) {
+        if (object.occluder && m_occluderMeshes[object.model].indices.empty()) {
+            m_occluderMeshes[object.model] = SoftwareOcclusion::buildOccluder(*models[object.model],
+                m_softwareOcclusionSettings.triangleBudget);
+        }
+    }
+}
+
+/* Bakes impostors of the models with the most instances, a model used once gains little from
+    one */
+void Renderer::bakeImpostors()
+{
+    PROFILE_FUNCTION();
+    const auto& models = m_scene->models();
+    std::vector<unsigned int> instances(models.size(), 0);
+    for (const auto& object : m_scene->objects())
+        instances[object.model]++;
+    std::vector<unsigned int> baked;
+    for (unsigned int i = 0; i < models.size(); i++) {
+        if (instances[i] > 1)
+            baked.push_back(i);
+    }
+    std::stable_sort(baked.begin(), baked.end(), [&](unsigned int a, unsigned int b) { return instances[a] > instances[b]; });
+    if (baked.size() > m_impostorSettings.maxModels)
+        baked.resize(m_impostorSettings.maxModels);
+    m_impostors.bake(m_gBufferShader, models, baked);
+}
+
 void Renderer::setupShaders()
 {
+    PROFILE_FUNCTION();
     m_pbrLightingShader.graphicsShaders({ "src/shaders/pbr_shading.vert", "src/shaders/pbr_shading.frag" });
     m_gBufferShader.graphicsShaders({ "src/shaders/pbr_geometry.vert", "src/shaders/pbr_geometry.frag" });
     m_skyboxShader.graphicsShaders({ "src/shaders/skybox.vert", "src/shaders/skybox.frag" });
@@ -54,72 +164,113 @@ void Renderer::setupShaders()
         "src/shaders/point_depth_map.vert",
         "src/shaders/point_depth_map.geom",
         "src/shaders/point_depth_map.frag" });
-    m_blurShader.graphicsShaders({ "src/shaders/gaussian_blur.vert", "src/shaders/gaussian_blur.frag" });
+    m_bloomDownsampleShader.graphicsShaders({ "src/shaders/screen_quad.vert", "src/shaders/bloom_downsample.frag" });
+    m_bloomUpsampleShader.graphicsShaders({ "src/shaders/screen_quad.vert", "src/shaders/bloom_upsample.frag" });
+    m_lightCullShader.computeShader("src/shaders/cluster_light_cull.comp");
+    m_tileClassifyShader.computeShader("src/shaders/tile_classify.comp");
+    m_simpleTileShader.graphicsShaders({ "src/shaders/pbr_tile.vert", "src/shaders/pbr_shading.frag" },
+        { "TILE_SIMPLE" });
+    m_complexTileShader.graphicsShaders({ "src/shaders/pbr_tile.vert", "src/shaders/pbr_shading.frag" });
+    m_visibilityShader.graphicsShaders({ "src/shaders/visibility.vert", "src/shaders/visibility.frag" });
+    m_visibilityResolveShader.graphicsShaders({ "src/shaders/screen_quad.vert",
+        "src/shaders/visibility_resolve.frag" });
+    m_taaResolveShader.graphicsShaders({ "src/shaders/screen_quad.vert", "src/shaders/taa_resolve.frag" });
+    m_checkerReconstructShader.graphicsShaders({ "src/shaders/screen_quad.vert",
+        "src/shaders/checkerboard_reconstruct.frag" });
+    m_drawCullShader.computeShader("src/shaders/draw_cull.comp");
+    m_clusterCullShader.computeShader("src/shaders/cluster_cull.comp");
+    m_hiZBuildShader.computeShader("src/shaders/hiz_build.comp");
+    m_impostorShader.graphicsShaders({ "src/shaders/impostor.vert", "src/shaders/impostor.frag" });
 }
 
 void Renderer::setupFramebuffers()
 {
+    PROFILE_FUNCTION();
     TextureLoader texLoader;
     TextureOptions texOps;
+    // The scene color is bilinear filtered, the bloom taps and the upscale rely on it
+    texOps.minFilter = GL_LINEAR;
+    texOps.magFilter = GL_LINEAR;
+
+    for (auto& sceneColor : m_sceneColors) {
+        texLoader.createNew(GL_TEXTURE_2D, texOps);
+        sceneColor = trackRenderTarget(texLoader.emptyTexture(HDR_FORMAT, Window::width(), Window::height()),
+            "Scene Color");
+    }
     texOps.minFilter = GL_NEAREST;
     texOps.magFilter = GL_NEAREST;
-
-    texLoader.createNew(GL_TEXTURE_2D, texOps);
-    GLuint sceneBuffer = texLoader.emptyTexture(GL_RGBA16F, Window::width(), Window::height());
-    texLoader.createNew(GL_TEXTURE_2D, texOps);
-    GLuint blurBuffer = texLoader.emptyTexture(GL_RGBA16F, Window::width(), Window::height());
-    m_mainBuffer.attachColorBuffers({ sceneBuffer, blurBuffer });
+    m_mainBuffer.attachColorBuffers({ m_sceneColors[m_sceneColorIndex] });
     m_mainBuffer.attachRenderbuffer(Window::width(), Window::height());
+    m_tileClassifier.setup(Window::width(), Window::height());
     
     // Setup GBuffer
+    // Position is reconstructed from the depth texture, so per pixel we only store
+    // octahedral normal (RG16), albedo (RGBA8) and metal/rough/AO (RGBA8): 16 bytes with depth
     texOps.wrapS = GL_REPEAT;
     texOps.wrapT = GL_REPEAT;
     texLoader.createNew(GL_TEXTURE_2D, texOps);
-    GLuint gPosition = texLoader.emptyTexture(GL_RGB16F, Window::width(), Window::height());
+    GLuint gNormal = trackRenderTarget(texLoader.emptyTexture(GL_RG16, Window::width(), Window::height()),
+        "GBuffer Normal");
     texLoader.createNew(GL_TEXTURE_2D, texOps);
-    GLuint gNormal = texLoader.emptyTexture(GL_RGB16F, Window::width(), Window::height());
+    GLuint gAlbedo = trackRenderTarget(texLoader.emptyTexture(GL_SRGB8_ALPHA8, Window::width(), Window::height()),
+        "GBuffer Albedo");
     texLoader.createNew(GL_TEXTURE_2D, texOps);
-    GLuint gAlbedo = texLoader.emptyTexture(GL_SRGB8_ALPHA8, Window::width(), Window::height());
+    GLuint gMetalRoughAO = trackRenderTarget(texLoader.emptyTexture(GL_RGBA8, Window::width(), Window::height()),
+        "GBuffer Metal Rough AO");
+    // Screen space motion for the temporal resolve, not read by the lighting passes
     texLoader.createNew(GL_TEXTURE_2D, texOps);
-    GLuint gMetalRoughAO = texLoader.emptyTexture(GL_RGB16F, Window::width(), Window::height());
-    m_gBuffer.attachColorBuffers({ gPosition, gNormal, gAlbedo, gMetalRoughAO });
-    m_gBuffer.attachRenderbuffer(Window::width(), Window::height());
-    
-    // Setup IBL environment map
-    m_captureBuffer.attachRenderbuffer(2048, 2048);
-    auto& sceneCubemap = m_scene->cubemap();
-    sceneCubemap.captureEnvironment(m_captureBuffer, m_cubemapCaptureShader);
-    sceneCubemap.irradianceConvolution(m_captureBuffer, m_cubemapConvolveShader);
-    sceneCubemap.specularPrefilter(m_captureBuffer, m_cubemapPrefilterShader);
+    GLuint gVelocity = trackRenderTarget(texLoader.emptyTexture(GL_RG16F, Window::width(), Window::height()),
+        "GBuffer Velocity");
+    m_gBuffer.attachColorBuffers({ gNormal, gAlbedo, gMetalRoughAO, gVelocity });
+    m_gBuffer.attachDepthTexture(Window::width(), Window::height());
 
-    // Precompute BRDF Integral
-    texOps.minFilter = GL_LINEAR;
-    texOps.magFilter = GL_LINEAR;
-    texOps.wrapS = GL_CLAMP_TO_EDGE;
-    texOps.wrapT = GL_CLAMP_TO_EDGE;
+    // Setup visibility buffer, only a 32 bit triangle ID per pixel. It shares the GBuffer's depth
+    // so the resolve only has to fill the color targets for the lighting passes
     texLoader.createNew(GL_TEXTURE_2D, texOps);
-    m_brdfLUT = texLoader.emptyTexture(GL_RG16F, 512, 512);
-    m_captureBuffer.attachColorBuffers({ m_brdfLUT });
-    m_captureBuffer.resizeRB(512, 512);
-    m_captureBuffer.bindAs(GL_FRAMEBUFFER);
-    glViewport(0, 0, 512, 512);
-    m_brdfPrecomputeShader.use();
-    m_captureBuffer.clear();
-    glBindVertexArray(m_screenQuadVAO);
-    glDrawArrays(GL_TRIANGLES, 0, 6);
+    GLuint visibilityID = trackRenderTarget(texLoader.emptyTexture(GL_R32UI, Window::width(), Window::height()),
+        "Visibility Buffer");
+    m_visibilityBuffer.attachColorBuffers({ visibilityID });
+    m_visibilityBuffer.attachDepthTexture(m_gBuffer.depthTexture());
+    
+    // Setup IBL environment map
+    {
+        PROFILE_SCOPE("IBL Bake");
+        m_captureBuffer.attachRenderbuffer(2048, 2048);
+        auto& sceneCubemap = m_scene->cubemap();
+        sceneCubemap.captureEnvironment(m_captureBuffer, m_cubemapCaptureShader);
+        sceneCubemap.irradianceConvolution(m_captureBuffer, m_cubemapConvolveShader);
+        sceneCubemap.specularPrefilter(m_captureBuffer, m_cubemapPrefilterShader);
 
-    // Setup Ping Pong Framebuffers
-    texLoader.createNew(GL_TEXTURE_2D, texOps);
-    GLuint pingTexture = texLoader.emptyTexture(GL_RGBA16F, Window::width(), Window::height());
-    m_pingBuffer.attachColorBuffers({ pingTexture });
+        // Precompute BRDF Integral
+        texOps.minFilter = GL_LINEAR;
+        texOps.magFilter = GL_LINEAR;
+        texOps.wrapS = GL_CLAMP_TO_EDGE;
+        texOps.wrapT = GL_CLAMP_TO_EDGE;
+        texLoader.createNew(GL_TEXTURE_2D, texOps);
+        m_brdfLUT = trackRenderTarget(texLoader.emptyTexture(GL_RG16F, 512, 512), "BRDF LUT");
+        m_captureBuffer.attachColorBuffers({ m_brdfLUT });
+        m_captureBuffer.resizeRB(512, 512);
+        m_captureBuffer.bindAs(GL_FRAMEBUFFER);
+        glViewport(0, 0, 512, 512);
+        m_brdfPrecomputeShader.use();
+        m_captureBuffer.clear();
+        glBindVertexArray(m_screenQuadVAO);
+        glDrawArrays(GL_TRIANGLES, 0, 6);
+        // Wait for the bake so its GPU cost shows up in the startup trace instead of the first frame
+        glFinish();
+    }
 
-    texLoader.createNew(GL_TEXTURE_2D, texOps);
-    GLuint pongTexture = texLoader.emptyTexture(GL_RGBA16F, Window::width(), Window::height());;
-    m_pongBuffer.attachColorBuffers({ pongTexture });
+    // Setup bloom mip chain
+    m_bloom.setup(Window::width(), Window::height(), HDR_FORMAT);
+    m_temporalAA.setup(Window::width(), Window::height(), HDR_FORMAT);
+    m_checkerboard.setup(Window::width(), Window::height(), HDR_FORMAT);
+    m_gpuCulling.setup(Window::width(), Window::height());
+    m_softwareOcclusion.setup(m_softwareOcclusionSettings.width, m_softwareOcclusionSettings.height);
 
     // Setup Directional Depth Framebuffer
     glCreateTextures(GL_TEXTURE_2D, 1, &m_directionalDepthMap);
     glTextureStorage2D(m_directionalDepthMap, 1, GL_DEPTH_COMPONENT24, SHADOW_WIDTH, SHADOW_HEIGHT);
+    trackRenderTarget(m_directionalDepthMap, "Directional Shadow Map");
     glTextureParameteri(m_directionalDepthMap, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTextureParameteri(m_directionalDepthMap, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
     glTextureParameteri(m_directionalDepthMap, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
@@ -140,6 +291,7 @@ void Renderer::setupFramebuffers()
     glCreateTextures(GL_TEXTURE_CUBE_MAP, m_pointDepthMaps.size(), m_pointDepthMaps.data());
     for (int i = 0; i < m_pointDepthMaps.size(); i++) {
         glTextureStorage2D(m_pointDepthMaps[i], 1, GL_DEPTH_COMPONENT24, SHADOW_WIDTH, SHADOW_HEIGHT);
+        trackRenderTarget(m_pointDepthMaps[i], "Point Shadow Map " + std::to_string(i));
         glTextureParameteri(m_pointDepthMaps[i], GL_TEXTURE_MAG_FILTER, GL_NEAREST);
         glTextureParameteri(m_pointDepthMaps[i], GL_TEXTURE_MIN_FILTER, GL_NEAREST);
         glTextureParameteri(m_pointDepthMaps[i], GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
@@ -160,39 +312,59 @@ void Renderer::setupFramebuffers()
 
 void Renderer::setupUniforms()
 {
-    m_pbrLightingShader.use();
-    m_pbrLightingShader.setSampler("gPosition",           0);
-    m_pbrLightingShader.setSampler("gNormal",             1);
-    m_pbrLightingShader.setSampler("gAlbedo",             2);
-    m_pbrLightingShader.setSampler("gMetalRoughAO",       3);
-    m_pbrLightingShader.setSampler("directionalDepthMap", 4);
-    for (int i = 0; i < m_pointDepthMaps.size(); i++) {
-        m_pbrLightingShader.setSampler("pointDepthMaps[" + std::to_string(i) + "]", 5 + i);
+    for (const Shader* lightingShader : { &m_pbrLightingShader, &m_simpleTileShader, &m_complexTileShader }) {
+        lightingShader->setSampler("gDepth",              0);
+        lightingShader->setSampler("gNormal",             1);
+        lightingShader->setSampler("gAlbedo",             2);
+        lightingShader->setSampler("gMetalRoughAO",       3);
+        lightingShader->setSampler("directionalDepthMap", 4);
+        for (int i = 0; i < m_pointDepthMaps.size(); i++) {
+            lightingShader->setSampler("pointDepthMaps[" + std::to_string(i) + "]", 5 + i);
+        }
+        lightingShader->setSampler("irradianceMap",   5 + m_pointDepthMaps.size());
+        lightingShader->setSampler("prefilterMap",    5 + m_pointDepthMaps.size() + 1);
+        lightingShader->setSampler("brdfLUT",         5 + m_pointDepthMaps.size() + 2);
     }
-    m_pbrLightingShader.setSampler("irradianceMap",   5 + m_pointDepthMaps.size());
-    m_pbrLightingShader.setSampler("prefilterMap",    5 + m_pointDepthMaps.size() + 1);
-    m_pbrLightingShader.setSampler("brdfLUT",         5 + m_pointDepthMaps.size() + 2);
 
-    m_blurShader.use();
-    m_blurShader.setSampler("image", 0);
+    m_bloomDownsampleShader.setSampler("srcTexture", 0);
+    m_bloomUpsampleShader.setSampler("srcTexture", 0);
+
+    m_visibilityResolveShader.setSampler("visibilityBuffer", 0);
+
+    m_taaResolveShader.setSampler("sceneTexture", 0);
+    m_taaResolveShader.setSampler("velocityTexture", 1);
+    m_taaResolveShader.setSampler("depthTexture", 2);
+    m_taaResolveShader.setSampler("historyTexture", 3);
+
+    m_checkerReconstructShader.setSampler("checkerTexture", 0);
+    m_checkerReconstructShader.setSampler("gDepth", 1);
+    m_checkerReconstructShader.setSampler("gNormal", 2);
+    m_checkerReconstructShader.setSampler("velocityTexture", 3);
+    m_checkerReconstructShader.setSampler("historyTexture", 4);
+
+    m_drawCullShader.setSampler("hiZ", 0);
+    m_clusterCullShader.setSampler("hiZ", 0);
+    m_hiZBuildShader.setSampler("srcDepth", 0);
 
     m_postProcessShader.use();
     m_postProcessShader.setSampler("sceneTexture", 0);
     m_postProcessShader.setSampler("bloomTexture", 1);
-
-    // Setting up lights UBO
-    auto& lights = m_scene->pointLights();
-    if (lights.size() != 0) {
-        GLuint lightsUBO;
-        glCreateBuffers(1, &lightsUBO);
-        glNamedBufferStorage(lightsUBO, lights.size() * sizeof(struct PointLight), nullptr, GL_DYNAMIC_STORAGE_BIT);
-        glBindBufferBase(GL_UNIFORM_BUFFER, 2, lightsUBO);
-        glNamedBufferSubData(lightsUBO, 0, lights.size() * sizeof(struct PointLight), lights.data());
-    }
 }
 
 void Renderer::beginDraw()
 {
+    PROFILE_FUNCTION();
+    m_stats = RenderStats();
+    m_gpuProfiler.beginFrame();
+
+    // Screen sized targets keep their full allocation, a lower render scale only shrinks the
+    // region drawn into. The temporal resolve or the post pass upscales it back to the window
+    float renderScale = m_dynamicRes.update(m_gpuProfiler, m_dynamicResSettings);
+    m_renderWidth = std::max((int)std::round(Window::width() * renderScale), 1);
+    m_renderHeight = std::max((int)std::round(Window::height() * renderScale), 1);
+    m_tileClassifier.setRenderSize(m_renderWidth, m_renderHeight);
+
+    m_gpuProfiler.pushScope("Shadow");
     glEnable(GL_DEPTH_TEST);
     glDisable(GL_FRAMEBUFFER_SRGB);
     //glCullFace(GL_FRONT);
@@ -221,7 +393,7 @@ void Renderer::beginDraw()
     float spacing = 2.5;
 
     const auto& models = m_scene->models();
-    const auto& transforms = m_scene->transforms();
+    const auto& objects = m_scene->objects();
     /*
     for (int i = 0; i < models.size(); i++) {
         glm::mat4 model = glm::mat4(1.0f);
@@ -237,11 +409,8 @@ void Renderer::beginDraw()
                 models[i]->draw(m_directDepthShader);
             }
         }
-        //glm::mat4 modelM = glm::mat4(1.0f);
-        //modelM = glm::scale(modelM, transforms[i].scale);
-        //modelM = glm::translate(modelM, transforms[i].translate);
-        //m_directDepthShader.setMat4("model", modelM);
-        //models[i]->draw(m_directDepthShader);
+        //m_directDepthShader.setMat4("model", objects[i].transform.matrix());
+        //models[objects[i].model]->draw(m_directDepthShader);
     } */
     
     // Point lights depth pass
@@ -287,55 +456,74 @@ void Renderer::beginDraw()
                     models[i]->draw(m_pointDepthShader);
                 }
             }
-            //glm::mat4 modelM = glm::mat4(1.0f);
-            //modelM = glm::scale(modelM, transforms[i].scale);
-            //modelM = glm::translate(modelM, transforms[i].translate);
-            //m_pointDepthShader.setMat4("model", modelM);
-            //models[i]->draw(m_pointDepthShader);
+            //m_pointDepthShader.setMat4("model", objects[i].transform.matrix());
+            //models[objects[i].model]->draw(m_pointDepthShader);
         }
     } */
+    m_gpuProfiler.popScope();
 
-    // Geometry Pass
-    m_gBuffer.bindAs(GL_FRAMEBUFFER);
-    glClearColor(0.0, 0.0, 0.0, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    glEnable(GL_DEPTH_TEST);
-    glViewport(0, 0, Window::width(), Window::height());
-    m_gBufferShader.use();
-
-    glm::mat4 projectionM = glm::perspective(glm::radians(g_camera.zoom()),
-        (float)Window::width() / (float)Window::height(), 0.1f, 100.0f);
+    glm::mat4 unjitteredProjection = glm::perspective(glm::radians(g_camera.zoom()),
+        (float)Window::width() / (float)Window::height(), NEAR_PLANE, FAR_PLANE);
     glm::mat4 viewM = g_camera.getViewMatrix();
-    m_gBufferShader.setMat4("projection", projectionM);
-    m_gBufferShader.setMat4("view", viewM);
+    m_currViewProjection = unjitteredProjection * viewM;
+    glm::mat4 skyViewProjection = unjitteredProjection * glm::mat4(glm::mat3(viewM));
 
-    m_gBufferShader.setVec3("albedo", m_albedo);
+    // Sub-pixel offset in render pixels, every pass up to the temporal resolve uses the
+    // jittered projection so the reconstructed positions match the rasterized depth
+    if (!m_taaSettings.enabled)
+        m_temporalAA.invalidateHistory();
+    glm::vec2 jitter = m_temporalAA.nextJitter(m_taaSettings);
+    glm::mat4 projectionM = unjitteredProjection;
+    projectionM[2][0] += jitter.x * 2.0f / m_renderWidth;
+    projectionM[2][1] += jitter.y * 2.0f / m_renderHeight;
 
-    for (auto i = 0; i < models.size(); i++) {
-        glm::mat4 model = glm::mat4(1.0f);
-        m_gBufferShader.setFloat("roughness", m_roughness);
-        m_gBufferShader.setFloat("metallic", m_metallic);
-        m_gBufferShader.setMat4("model", model);
-        models[i]->draw(m_gBufferShader);
-    }
+    m_objectMatrices.clear();
+    for (const auto& object : objects)
+        m_objectMatrices.push_back(object.transform.matrix());
+    if (m_prevObjectMatrices.size() != m_objectMatrices.size())
+        m_prevObjectMatrices = m_objectMatrices;
+    updateSceneBVH();
+    m_lodSelector.select(m_scene->models(), objects, m_objectMatrices, m_objectBounds, g_camera.position(),
+        unjitteredProjection[1][1], m_renderHeight, m_lodSettings);
+
+    m_gpuProfiler.pushScope("Geometry");
+    if (m_useVisibilityBuffer)
+        visibilityPass(viewM, projectionM);
+    else
+        geometryPass(viewM, projectionM);
+    m_gpuProfiler.popScope();
+
+    m_gpuProfiler.pushScope("Lighting");
+    m_gpuProfiler.pushScope("Light Culling");
+    // Bin point lights into clusters, lights are re-uploaded every frame so they can move
+    m_lightClusters.updateLights(lights);
+    m_lightClusters.cull(m_lightCullShader, projectionM, viewM, NEAR_PLANE, FAR_PLANE,
+        m_renderWidth, m_renderHeight);
+    m_stats.dispatches++;
+    m_gpuProfiler.popScope();
 
     // Deferred shading pass
+    if (!m_checkerboardSettings.enabled)
+        m_checkerboard.invalidateHistory();
+    GLuint lastSceneColor = m_sceneColors[m_sceneColorIndex];
+    m_sceneColorIndex = 1 - m_sceneColorIndex;
+    m_mainBuffer.attachColorBuffers({ m_sceneColors[m_sceneColorIndex] });
     m_mainBuffer.bindAs(GL_FRAMEBUFFER);
     m_mainBuffer.clear();
 
     // Lighting
-    m_pbrLightingShader.use();
-    m_pbrLightingShader.setVec3("directLight.direction", directLight.direction);
-    m_pbrLightingShader.setVec3("directLight.color", directLight.color);
-    m_pbrLightingShader.setFloat("directLight.intensity", directLight.intensity);
-    m_pbrLightingShader.setInt("numPointLights", lights.size());
-    
-    m_pbrLightingShader.setVec3("viewPos", g_camera.position());
-    m_pbrLightingShader.setMat4("lightSpaceMatrix", lightSpaceMatrix);
-    m_pbrLightingShader.setFloat("farPlane", far);
+    if (m_useTileClassification) {
+        m_gpuProfiler.pushScope("Tile Classification");
+        m_tileClassifier.classify(m_tileClassifyShader, m_gBuffer.depthTexture(), NEAR_PLANE, FAR_PLANE);
+        m_stats.dispatches++;
+        m_gpuProfiler.popScope();
+    }
 
-    for (auto i = 0; i < m_gBuffer.colorBuffers().size(); i++) {
-        glBindTextureUnit(i, m_gBuffer.colorBuffer(i));
+    // Textures shared by every lighting shader variant
+    // Normal, albedo and metal/rough/AO, the velocity target is only read by the temporal resolve
+    glBindTextureUnit(0, m_gBuffer.depthTexture());
+    for (auto i = 0; i < 3; i++) {
+        glBindTextureUnit(i + 1, m_gBuffer.colorBuffer(i));
     }
     glBindTextureUnit(4, m_directionalDepthMap);
     for (auto i = 0; i < m_pointDepthMaps.size(); i++) {
@@ -345,14 +533,48 @@ void Renderer::beginDraw()
     glBindTextureUnit(5 + m_pointDepthMaps.size(), sceneCubemap.irradianceMap());
     glBindTextureUnit(5 + m_pointDepthMaps.size() + 1, sceneCubemap.prefilterMap());
     glBindTextureUnit(5 + m_pointDepthMaps.size() + 2, m_brdfLUT);
+    m_lightClusters.bind();
 
+    // Checkerboard shading lights half the pixels into its own target, the reconstruct pass
+    // below then fills the main buffer
+    if (m_checkerboardSettings.enabled)
+        m_checkerboard.begin(m_renderWidth, m_renderHeight);
     glBindVertexArray(m_screenQuadVAO);
-    glDrawArrays(GL_TRIANGLES, 0, 6);
+    if (m_useTileClassification) {
+        // Sky tiles are skipped entirely since the skybox covers them
+        setLightingUniforms(m_simpleTileShader, viewM, projectionM, lightSpaceMatrix, far);
+        m_simpleTileShader.setVec3("tileClassColor", glm::vec3(0.0f, 1.0f, 0.0f));
+        m_tileClassifier.drawTiles(TILE_SIMPLE, m_simpleTileShader);
 
+        setLightingUniforms(m_complexTileShader, viewM, projectionM, lightSpaceMatrix, far);
+        m_complexTileShader.setVec3("tileClassColor", glm::vec3(1.0f, 0.0f, 0.0f));
+        m_tileClassifier.drawTiles(TILE_COMPLEX, m_complexTileShader);
+        m_stats.drawCalls += 2;
+    }
+    else {
+        setLightingUniforms(m_pbrLightingShader, viewM, projectionM, lightSpaceMatrix, far);
+        glDrawArrays(GL_TRIANGLES, 0, 6);
+        m_stats.drawCalls++;
+    }
+    if (m_checkerboardSettings.enabled) {
+        m_gpuProfiler.pushScope("Checkerboard Reconstruct");
+        m_mainBuffer.bindAs(GL_FRAMEBUFFER);
+        glViewport(0, 0, m_renderWidth, m_renderHeight);
+        glm::vec2 fullSize(Window::width(), Window::height());
+        m_checkerboard.reconstruct(m_checkerReconstructShader, m_gBuffer.depthTexture(), m_gBuffer.colorBuffer(0),
+            m_gBuffer.colorBuffer(3), lastSceneColor, glm::vec2(m_prevRenderSize) / fullSize,
+            (glm::vec2(m_prevRenderSize) - 0.5f) / fullSize, m_prevJitter - jitter, NEAR_PLANE, FAR_PLANE,
+            m_checkerboardSettings);
+        m_stats.drawCalls++;
+        m_gpuProfiler.popScope();
+    }
+    m_gpuProfiler.popScope();
+
+    m_gpuProfiler.pushScope("Skybox");
     m_gBuffer.bindAs(GL_READ_FRAMEBUFFER);
     m_mainBuffer.bindAs(GL_DRAW_FRAMEBUFFER);
-    glBlitFramebuffer(0, 0, Window::width(), Window::height(),
-        0, 0, Window::width(), Window::height(), GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+    glBlitFramebuffer(0, 0, m_renderWidth, m_renderHeight,
+        0, 0, m_renderWidth, m_renderHeight, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
     m_mainBuffer.bindAs(GL_FRAMEBUFFER);
     // Draw cubemap
     glm::mat4 cmView = glm::mat4(glm::mat3(viewM));
@@ -362,45 +584,249 @@ void Renderer::beginDraw()
     m_skyboxShader.setSampler("skybox", 0);
     glBindTextureUnit(0, sceneCubemap.environmentMap());
     m_scene->cubemap().draw(m_skyboxShader);
+    m_stats.drawCalls++;
+    m_gpuProfiler.popScope();
 
     glDisable(GL_DEPTH_TEST);
-    bool horizontal = true;
-    int amount = 10;
-    GLuint currentBuffer = m_mainBuffer.colorBuffer(1);
-    m_pongBuffer.bindAs(GL_FRAMEBUFFER);
-    m_blurShader.use();
-    for (auto i = 0; i < amount; i++) {
-        m_blurShader.setBool("horizontal", horizontal);
-        glBindTextureUnit(0, currentBuffer);
-        glBindVertexArray(m_screenQuadVAO);
-        glDrawArrays(GL_TRIANGLES, 0, 6);
-        horizontal = !horizontal;
-        if (horizontal) {
-            m_pongBuffer.bindAs(GL_FRAMEBUFFER);
-            currentBuffer = m_pingBuffer.colorBuffer(0);
-        }
-        else {
-            m_pingBuffer.bindAs(GL_FRAMEBUFFER);
-            currentBuffer = m_pongBuffer.colorBuffer(0);
-        }
+    glBindVertexArray(m_screenQuadVAO);
+    GLuint bloomTexture = 0;
+    if (m_useBloom) {
+        m_gpuProfiler.pushScope("Bloom");
+        bloomTexture = m_bloom.render(m_bloomDownsampleShader, m_bloomUpsampleShader,
+            m_mainBuffer.colorBuffer(0), glm::ivec2(m_renderWidth, m_renderHeight), m_bloomSettings);
+        int bloomMips = std::min(std::max(m_bloomSettings.quality, 1), m_bloom.mipCount());
+        m_stats.drawCalls += bloomMips * 2 - 1;
+        m_gpuProfiler.popScope();
+    }
+
+    // The temporal resolve reconstructs the full resolution scene, so the post pass then
+    // reads it without any upscaling
+    GLuint sceneTexture = m_mainBuffer.colorBuffer(0);
+    glm::ivec2 renderSize(m_renderWidth, m_renderHeight);
+    glm::vec2 sceneUVScale = glm::vec2(renderSize) / glm::vec2(Window::width(), Window::height());
+    if (m_taaSettings.enabled) {
+        m_gpuProfiler.pushScope("Temporal AA");
+        glm::mat4 skyReprojection = m_prevSkyViewProjection * glm::inverse(skyViewProjection);
+        sceneTexture = m_temporalAA.resolve(m_taaResolveShader, sceneTexture, m_gBuffer.colorBuffer(3),
+            m_gBuffer.depthTexture(), renderSize, jitter, skyReprojection, m_taaSettings);
+        sceneUVScale = glm::vec2(1.0f);
+        m_stats.drawCalls++;
+        m_gpuProfiler.popScope();
     }
+    m_prevViewProjection = m_currViewProjection;
+    m_prevSkyViewProjection = skyViewProjection;
+    m_prevJitter = jitter;
+    m_prevRenderSize = renderSize;
+    std::swap(m_prevObjectMatrices, m_objectMatrices);
 
     // Now rendering to default buffer with post processing
+    m_gpuProfiler.pushScope("Post");
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, Window::width(), Window::height());
     glEnable(GL_FRAMEBUFFER_SRGB);
     glClear(GL_COLOR_BUFFER_BIT);
     m_postProcessShader.use();
-    glBindVertexArray(m_screenQuadVAO);
-    glBindTextureUnit(0, m_mainBuffer.colorBuffer(0));
-    if (horizontal)
-        glBindTextureUnit(1, m_pingBuffer.colorBuffer(0));
-    else
-        glBindTextureUnit(1, m_pongBuffer.colorBuffer(0));
+    glBindTextureUnit(0, sceneTexture);
+    glBindTextureUnit(1, bloomTexture);
     m_postProcessShader.setFloat("exposure", m_exposure);
-    m_postProcessShader.setBool("bloom", true);
+    m_postProcessShader.setBool("bloom", m_useBloom);
+    m_postProcessShader.setFloat("bloomIntensity", m_bloomSettings.intensity);
+    m_postProcessShader.setFloat("bloomRadius", m_bloomSettings.radius);
+    m_postProcessShader.setVec2("sceneUVScale", sceneUVScale);
+    m_postProcessShader.setVec2("bloomUVScale", m_bloom.uvScale(renderSize));
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+    m_stats.drawCalls++;
+    m_gpuProfiler.popScope();
+
+    if (m_guiEnabled) {
+        m_gpuProfiler.pushScope("GUI");
+        PROFILE_SCOPE("GUI");
+        drawGUI();
+        m_gpuProfiler.popScope();
+    }
+    m_gpuProfiler.endFrame();
+    ResourceManager::instance().endFrame();
+    m_memoryBudget.update(m_scene->cubemap(), m_memoryBudgetSettings);
+}
+
+/* Hands a target created with its storage to the ResourceManager, the renderer keeps it for
+    its whole lifetime */
+GLuint Renderer::trackRenderTarget(GLuint texture, const std::string& name)
+{
+    ResourceManager& resources = ResourceManager::instance();
+    m_renderTargets.emplace_back(resources.adopt(ResourceType::Texture, ResourceCategory::RenderTarget, texture, 0,
+        name));
+    resources.measureTexture(m_renderTargets.back().handle());
+    return texture;
+}
+
+/* Rasterizes every object inside the view frustum into the GBuffer with its full vertex attributes */
+void Renderer::geometryPass(const glm::mat4& viewM, const glm::mat4& projectionM)
+{
+    PROFILE_FUNCTION();
+    m_gBuffer.bindAs(GL_FRAMEBUFFER);
+    glClearColor(0.0, 0.0, 0.0, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glEnable(GL_DEPTH_TEST);
+    glViewport(0, 0, m_renderWidth, m_renderHeight);
+    m_gBufferShader.use();
+    m_gBufferShader.setMat4("projection", projectionM);
+    m_gBufferShader.setMat4("view", viewM);
+    m_gBufferShader.setMat4("currViewProjection", m_currViewProjection);
+    m_gBufferShader.setMat4("prevViewProjection", m_prevViewProjection);
+
+    const auto& models = m_scene->models();
+    const auto& materials = m_scene->materials();
+    const auto& objects = m_scene->objects();
+    m_visibleObjects.clear();
+    if (m_useCpuCulling) {
+        PROFILE_SCOPE("Frustum Culling");
+        m_cullStats = m_sceneBVH.query(Frustum::fromMatrix(projectionM * viewM), m_visibleObjects);
+    }
+    else {
+        for (unsigned int i = 0; i < objects.size(); i++)
+            m_visibleObjects.push_back(i);
+    }
+    m_stats.culledObjects = (unsigned int)(objects.size() - m_visibleObjects.size());
+
+    // Occluders inside the frustum hide the remaining objects before anything is submitted
+    if (m_softwareOcclusionSettings.enabled) {
+        PROFILE_SCOPE("Software Occlusion");
+        m_occluderInstances.clear();
+        for (unsigned int i : m_visibleObjects) {
+            const auto& mesh = m_occluderMeshes[objects[i].model];
+            if (objects[i].occluder && !mesh.indices.empty())
+                m_occluderInstances.push_back({ &mesh, m_objectMatrices[i], i });
+        }
+        m_softwareOcclusion.render(m_jobs, projectionM * viewM, m_occluderInstances);
+        m_softwareOcclusion.filter(m_jobs, m_visibleObjects, m_objectBounds);
+        m_stats.occludedObjects = m_softwareOcclusion.stats().rejected;
+    }
+
+    // Objects small enough on screen are gathered into one instanced impostor draw
+    m_impostorInstances.clear();
+    for (unsigned int i : m_visibleObjects) {
+        const auto& object = objects[i];
+        const auto& material = materials[object.material];
+        int layer = m_impostorSettings.enabled ? m_impostors.layer(object.model) : -1;
+        if (layer >= 0) {
+            glm::vec4 sphere = Impostors::boundingSphere(models[object.model]->bounds());
+            if (2.0f * sphere.w * m_lodSelector.pixelsPerUnit(i) < m_impostorSettings.maxPixels) {
+                m_impostorInstances.push_back({ m_objectMatrices[i], m_prevObjectMatrices[i], sphere,
+                    material.albedo, material.metallic, material.roughness, (GLuint)layer, { 0, 0 } });
+                continue;
+            }
+        }
+        m_gBufferShader.setVec3("albedo", material.albedo);
+        m_gBufferShader.setFloat("roughness", material.roughness);
+        m_gBufferShader.setFloat("metallic", material.metallic);
+        m_gBufferShader.setMat4("model", m_objectMatrices[i]);
+        m_gBufferShader.setMat4("prevModel", m_prevObjectMatrices[i]);
+        const unsigned int* lods = m_lodSelector.objectLods(i);
+        models[object.model]->draw(m_gBufferShader, lods);
+        m_stats.drawCalls += models[object.model]->meshes().size();
+        m_stats.triangles += models[object.model]->triangleCount(lods);
+    }
+
+    if (!m_impostorInstances.empty()) {
+        m_impostorShader.use();
+        m_impostorShader.setMat4("projection", projectionM);
+        m_impostorShader.setMat4("view", viewM);
+        m_impostorShader.setMat4("currViewProjection", m_currViewProjection);
+        m_impostorShader.setMat4("prevViewProjection", m_prevViewProjection);
+        m_impostorShader.setVec3("cameraPosition", g_camera.position());
+        m_impostors.draw(m_impostorShader, m_impostorInstances);
+        m_stats.impostors = (unsigned int)m_impostorInstances.size();
+        m_stats.drawCalls++;
+        m_stats.triangles += m_impostorInstances.size() * 2;
+    }
+}
+
+/* Rasterizes only triangle IDs and depth, then resolves them into the same GBuffer targets by
+    fetching and interpolating the triangle's vertices from the mesh pool once per pixel */
+void Renderer::visibilityPass(const glm::mat4& viewM, const glm::mat4& projectionM)
+{
+    PROFILE_FUNCTION();
+    glm::mat4 viewProjection = projectionM * viewM;
+    m_meshPool.setLods(m_lodSelector.lods());
+    m_meshPool.updateTransforms(m_objectMatrices);
+    m_meshPool.updateMaterials(m_scene->materials());
+
+    GLuint clearID = 0;
+    float clearDepth = 1.0f;
+    glClearNamedFramebufferuiv(m_visibilityBuffer.id(), GL_COLOR, 0, &clearID);
+    glClearNamedFramebufferfv(m_visibilityBuffer.id(), GL_DEPTH, 0, &clearDepth);
+    m_visibilityBuffer.bindAs(GL_FRAMEBUFFER);
+    glEnable(GL_DEPTH_TEST);
+    glViewport(0, 0, m_renderWidth, m_renderHeight);
+    m_visibilityShader.use();
+    m_visibilityShader.setMat4("viewProjection", viewProjection);
+    m_visibilityShader.setBool("clusters", false);
+    if (m_useGpuCulling) {
+        if (m_cullingClusters != (m_useClusterCulling && m_meshPool.clusterCount() > 0))
+            resetGpuCulling();
+        const Shader& cullShader = m_cullingClusters ? m_clusterCullShader : m_drawCullShader;
+        m_visibilityShader.setBool("clusters", m_cullingClusters);
+        // Items visible last frame go first, the late phase re-tests the rest against their depth
+        m_meshPool.bind();
+        m_gpuCulling.cull(cullShader, viewProjection, g_camera.position(), CULL_EARLY, m_useOcclusionCulling);
+        m_visibilityShader.use();
+        m_gpuCulling.draw(m_meshPool, CULL_EARLY);
+        if (m_useOcclusionCulling) {
+            m_gpuCulling.buildHiZ(m_hiZBuildShader, m_gBuffer.depthTexture(),
+                glm::ivec2(m_renderWidth, m_renderHeight));
+            m_stats.dispatches += m_gpuCulling.hiZLevels();
+        }
+        m_gpuCulling.cull(cullShader, viewProjection, g_camera.position(), CULL_LATE, m_useOcclusionCulling);
+        m_visibilityShader.use();
+        m_gpuCulling.draw(m_meshPool, CULL_LATE);
+        m_stats.drawCalls += 2;
+        m_stats.dispatches += 2;
+    }
+    else {
+        m_meshPool.draw();
+        m_stats.drawCalls += m_meshPool.drawCount();
+    }
+    m_stats.triangles += m_meshPool.lodTriangleCount();
+
+    // Resolve, background pixels are discarded so their stale GBuffer colors are never read
+    // since every later pass tests depth first
+    m_gBuffer.bindAs(GL_FRAMEBUFFER);
+    glDisable(GL_DEPTH_TEST);
+    m_visibilityResolveShader.use();
+    m_visibilityResolveShader.setMat4("viewProjection", viewProjection);
+    m_visibilityResolveShader.setMat4("currViewProjection", m_currViewProjection);
+    m_visibilityResolveShader.setMat4("prevViewProjection", m_prevViewProjection);
+    m_visibilityResolveShader.setVec2("screenSize", glm::vec2(m_renderWidth, m_renderHeight));
+    glBindTextureUnit(0, m_visibilityBuffer.colorBuffer(0));
+    m_meshPool.bind();
+    glBindVertexArray(m_screenQuadVAO);
     glDrawArrays(GL_TRIANGLES, 0, 6);
+    m_stats.drawCalls++;
+    glEnable(GL_DEPTH_TEST);
+}
 
-    drawGUI();
+/* Per-frame uniforms shared by the fullscreen lighting shader and its tile variants */
+void Renderer::setLightingUniforms(const Shader& shader, const glm::mat4& viewM, const glm::mat4& projectionM,
+    const glm::mat4& lightSpaceMatrix, float farPlane)
+{
+    const auto& directLight = m_scene->directionalLight();
+    shader.use();
+    shader.setVec3("directLight.direction", directLight.direction);
+    shader.setVec3("directLight.color", directLight.color);
+    shader.setFloat("directLight.intensity", directLight.intensity);
+    m_lightClusters.setUniforms(shader);
+    shader.setBool("showLightHeatmap", m_showLightHeatmap);
+    shader.setBool("showTileClasses", m_showTileClasses);
+    shader.setBool("checkerboard", m_checkerboardSettings.enabled);
+    if (m_checkerboardSettings.enabled)
+        m_checkerboard.setUniforms(shader);
+
+    shader.setVec3("viewPos", g_camera.position());
+    shader.setMat4("view", viewM);
+    shader.setMat4("invViewProjection", glm::inverse(projectionM * viewM));
+    shader.setMat4("lightSpaceMatrix", lightSpaceMatrix);
+    shader.setFloat("farPlane", farPlane);
 }
 
 void Renderer::drawGUI()
@@ -414,36 +840,202 @@ void Renderer::drawGUI()
         ImGui::Begin("Info");
         ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate,
             ImGui::GetIO().Framerate);
+        ImGui::Text("%u draw calls, %u dispatches, %llu triangles", m_stats.drawCalls, m_stats.dispatches,
+            m_stats.triangles);
         ImGui::Text("Keyboard Controls:");
         ImGui::Text("W/A/S/D - Forward/Left/Back/Right");
         ImGui::Text("C/SPACE - Down/Up");
         ImGui::Text("P - Show/Hide Mouse Pointer");
+        ImGui::Text("R - Start/Stop Camera Path Recording%s", Window::recordingPath() ? " (recording)" : "");
         ImGui::Text("ESC - Exit Program");
 
         ImGui::SliderFloat("- Exposure", &m_exposure, 0.01f, 5.0f);
-        ImGui::Text("Material");
-        ImGui::SliderFloat("- Metallic", &m_metallic, 0.0f, 1.0f);
-        ImGui::SliderFloat("- Roughness", &m_roughness, 0.0f, 1.0f);
-        static int matOption = 0;
-        if (ImGui::RadioButton("Gold", &matOption, 0))
-            m_albedo = glm::vec3(1.0f, 0.782f, 0.344f);
+        ImGui::Checkbox("Bloom", &m_useBloom);
+        ImGui::SliderFloat("- Threshold", &m_bloomSettings.threshold, 0.0f, 5.0f);
+        ImGui::SliderFloat("- Radius", &m_bloomSettings.radius, 0.5f, 4.0f);
+        ImGui::SliderInt("- Quality", &m_bloomSettings.quality, 1, m_bloom.mipCount());
+        ImGui::SliderFloat("- Intensity", &m_bloomSettings.intensity, 0.0f, 1.0f);
+        // The first scene material is editable, it is the default scene's sphere
+        auto& materials = m_scene->materials();
+        if (!materials.empty()) {
+            auto& material = materials[0];
+            ImGui::Text("Material");
+            ImGui::SliderFloat("- Metallic", &material.metallic, 0.0f, 1.0f);
+            ImGui::SliderFloat("- Roughness", &material.roughness, 0.0f, 1.0f);
+            static int matOption = 0;
+            if (ImGui::RadioButton("Gold", &matOption, 0))
+                material.albedo = glm::vec3(1.0f, 0.782f, 0.344f);
+            ImGui::SameLine();
+            if (ImGui::RadioButton("Silver", &matOption, 1))
+                material.albedo = glm::vec3(0.97f, 0.96f, 0.915f);
+            ImGui::SameLine();
+            if (ImGui::RadioButton("Copper", &matOption, 2))
+                material.albedo = glm::vec3(0.955f, 0.637f, 0.538f);
+            if (ImGui::RadioButton("Zinc", &matOption, 3))
+                material.albedo = glm::vec3(0.664f, 0.824f, 0.85f);
+            ImGui::SameLine();
+            if (ImGui::RadioButton("Titanium", &matOption, 4))
+                material.albedo = glm::vec3(0.542f, 0.497f, 0.449f);
+        }
+        //ImGui::SliderFloat("- DirLightFar", &(m_scene->directionalLight().farPlane), 5.0f, 25.0f);
+        ImGui::SliderFloat3("- DirLightVec", glm::value_ptr(m_scene->directionalLight().direction), -10.0f, 10.0f);
+        ImGui::Text("Clustered Lighting: %u point lights", m_lightClusters.lightCount());
+        ImGui::Checkbox("- Light Heatmap", &m_showLightHeatmap);
+        ImGui::Checkbox("Tile Classification", &m_useTileClassification);
+        ImGui::Checkbox("- Show Tile Classes", &m_showTileClasses);
+        ImGui::Checkbox("CPU Frustum Culling", &m_useCpuCulling);
+        if (SceneBVH::hasAVX2()) {
+            bool simd = m_sceneBVH.simd();
+            ImGui::SameLine();
+            if (ImGui::Checkbox("AVX2", &simd))
+                m_sceneBVH.setSIMD(simd);
+        }
+        if (!m_useVisibilityBuffer && m_useCpuCulling) {
+            ImGui::Text("- %u/%zu objects visible, %u BVH nodes tested", m_cullStats.visible,
+                m_scene->objects().size(), m_cullStats.nodesTested);
+        }
+        ImGui::Checkbox("Software Occlusion", &m_softwareOcclusionSettings.enabled);
+        if (!m_useVisibilityBuffer && m_softwareOcclusionSettings.enabled) {
+            const auto& occlusion = m_softwareOcclusion.stats();
+            ImGui::Text("- %u occluders, %u triangles, %u/%u objects rejected", occlusion.occluders,
+                occlusion.triangles, occlusion.rejected, occlusion.tested);
+        }
+        ImGui::Checkbox("Levels of Detail", &m_lodSettings.enabled);
+        ImGui::SliderFloat("- Pixel Error", &m_lodSettings.pixelError, 0.25f, 16.0f);
+        ImGui::SliderFloat("- Hysteresis", &m_lodSettings.hysteresis, 0.0f, 0.9f);
+        ImGui::Checkbox("Impostors", &m_impostorSettings.enabled);
+        ImGui::SliderFloat("- Max Pixels", &m_impostorSettings.maxPixels, 4.0f, 256.0f);
+        if (!m_useVisibilityBuffer && m_impostorSettings.enabled)
+            ImGui::Text("- %u objects drawn as impostors of %u baked models", m_stats.impostors, m_impostors.layerCount());
+        ImGui::Checkbox("Visibility Buffer", &m_useVisibilityBuffer);
+        ImGui::Text("- %u draws, %u of %u triangles in mesh pool at their level of detail", m_meshPool.drawCount(),
+            m_meshPool.lodTriangleCount(), m_meshPool.triangleCount());
+        ImGui::Checkbox("- GPU Culling", &m_useGpuCulling);
         ImGui::SameLine();
-        if (ImGui::RadioButton("Silver", &matOption, 1))
-            m_albedo = glm::vec3(0.97f, 0.96f, 0.915f);
+        ImGui::Checkbox("Hi-Z Occlusion", &m_useOcclusionCulling);
         ImGui::SameLine();
-        if (ImGui::RadioButton("Copper", &matOption, 2))
-            m_albedo = glm::vec3(0.955f, 0.637f, 0.538f);
-        if (ImGui::RadioButton("Zinc", &matOption, 3))
-            m_albedo = glm::vec3(0.664f, 0.824f, 0.85f);
+        ImGui::Checkbox("Clusters", &m_useClusterCulling);
+        if (m_useVisibilityBuffer && m_useGpuCulling) {
+            // Reading the counts back waits for this frame's culling, only done for the GUI
+            const char* items = m_cullingClusters ? "clusters" : "draws";
+            ImGui::Text("- %u early + %u late of %u %s%s", m_gpuCulling.drawnCount(CULL_EARLY),
+                m_gpuCulling.drawnCount(CULL_LATE), m_gpuCulling.itemCount(), items,
+                m_gpuCulling.hasDrawCount() ? "" : " (no draw count)");
+            ImGui::Text("- %u early + %u late triangles", m_gpuCulling.drawnTriangles(CULL_EARLY),
+                m_gpuCulling.drawnTriangles(CULL_LATE));
+        }
+        ImGui::Checkbox("Checkerboard Shading", &m_checkerboardSettings.enabled);
+        ImGui::SliderFloat("- Depth Sensitivity", &m_checkerboardSettings.depthSensitivity, 1.0f, 200.0f);
+        ImGui::SliderFloat("- Normal Power", &m_checkerboardSettings.normalPower, 1.0f, 64.0f);
+        ImGui::SliderFloat("- Reprojection", &m_checkerboardSettings.historyWeight, 0.0f, 0.9f);
+        ImGui::Checkbox("Temporal AA", &m_taaSettings.enabled);
+        ImGui::SliderFloat("- History Weight", &m_taaSettings.historyWeight, 0.5f, 0.98f);
+        ImGui::SliderInt("- Jitter Samples", &m_taaSettings.jitterSamples, 1, 16);
+        ImGui::Checkbox("Dynamic Resolution", &m_dynamicResSettings.enabled);
+        ImGui::Text("- %.0f%% (%dx%d), last GPU frame %.2f ms", m_dynamicRes.scale() * 100.0f, m_renderWidth,
+            m_renderHeight, m_dynamicRes.lastGpuMs());
+        ImGui::SliderFloat("- Target ms", &m_dynamicResSettings.targetMs, 4.0f, 33.3f);
+        ImGui::SliderFloat("- Min Scale", &m_dynamicResSettings.minScale, 0.5f, 1.0f);
+        ImGui::Checkbox("GPU Profiler", &m_showGpuProfiler);
+        if (ImGui::Button("Export Startup Trace"))
+            Profiler::exportTrace("startup_trace.json", 0, 0);
         ImGui::SameLine();
-        if (ImGui::RadioButton("Titanium", &matOption, 4))
-            m_albedo = glm::vec3(0.542f, 0.497f, 0.449f);
-        //ImGui::SliderFloat("- DirLightFar", &(m_scene->directionalLight().farPlane), 5.0f, 25.0f);
-        ImGui::SliderFloat3("- DirLightVec", glm::value_ptr(m_scene->directionalLight().direction), -10.0f, 10.0f);
+        if (ImGui::Button("Capture Frame Trace") && !Profiler::capturing())
+            Profiler::captureFrames(m_traceCaptureFrames, "frame_trace.json");
+        ImGui::SliderInt("- Frames", &m_traceCaptureFrames, 1, 600);
+
+        if (ImGui::CollapsingHeader("Memory")) {
+            const float MB = 1024.0f * 1024.0f;
+            const ImVec4 overColor(1.0f, 0.35f, 0.35f, 1.0f);
+            const ResourceManager& resources = ResourceManager::instance();
+            ImGui::Checkbox("Enforce Budgets", &m_memoryBudgetSettings.enabled);
+            // Budgets of 0 are unbounded
+            for (int category = 0; category < (int)ResourceCategory::Count; category++) {
+                const ResourceStats& stats = resources.stats((ResourceCategory)category);
+                const char* name = ResourceManager::categoryName((ResourceCategory)category);
+                bool over = MemoryBudget::overBudget((ResourceCategory)category, m_memoryBudgetSettings);
+                if (over)
+                    ImGui::PushStyleColor(ImGuiCol_Text, overColor);
+                bool open = ImGui::TreeNode(name, "%-14s %5u %8.2f MB", name, stats.live, stats.bytes / MB);
+                if (over)
+                    ImGui::PopStyleColor();
+                if (open) {
+                    ImGui::PushID(category);
+                    ImGui::SliderFloat("Budget MB", &m_memoryBudgetSettings.categoryMB[category], 0.0f, 4096.0f);
+                    ImGui::PopID();
+                    for (const auto& resource : resources.resources((ResourceCategory)category)) {
+                        ImGui::Text("%8.2f MB %s %u %s", resource.bytes / MB,
+                            ResourceManager::typeName(resource.type), resource.id, resource.name.c_str());
+                    }
+                    ImGui::TreePop();
+                }
+            }
+            if (MemoryBudget::overBudget(ResourceCategory::Count, m_memoryBudgetSettings))
+                ImGui::TextColored(overColor, "Total %8.2f MB", resources.totalBytes() / MB);
+            else
+                ImGui::Text("Total %8.2f MB", resources.totalBytes() / MB);
+            ImGui::SliderFloat("- Total Budget MB", &m_memoryBudgetSettings.totalMB, 0.0f, 16384.0f);
+
+            const MemoryBudgetStats& budget = m_memoryBudget.stats();
+            ImGui::Text("Mesh CPU copies %8.2f MB", budget.meshCpuBytes / MB);
+            ImGui::SliderFloat("- Mesh CPU Budget MB", &m_memoryBudgetSettings.meshCpuMB, 0.0f, 4096.0f);
+            ImGui::SliderInt("- Idle Frames", (int*)&m_memoryBudgetSettings.idleFrames, 1, 3600);
+            ImGui::SliderInt("- Max Downscale", (int*)&m_memoryBudgetSettings.maxDownscale, 0, 4);
+            ImGui::SliderInt("- Textures Per Frame", (int*)&m_memoryBudgetSettings.texturesPerFrame, 1, 16);
+            ImGui::Text("%u meshes released, %u environment sources released", budget.meshesReleased,
+                budget.sourcesReleased);
+            ImGui::Text("%u textures downscaled, %u evicted, %u restored", budget.texturesDownscaled,
+                budget.texturesEvicted, budget.texturesRestored);
+
+            if (ImGui::TreeNode("Objects")) {
+                for (int type = 0; type < (int)ResourceType::Count; type++) {
+                    const ResourceStats& stats = resources.stats((ResourceType)type);
+                    ImGui::Text("%-13s %5u live %8.2f MB, %3u pending %6.2f MB",
+                        ResourceManager::typeName((ResourceType)type), stats.live, stats.bytes / MB,
+                        stats.pending, stats.pendingBytes / MB);
+                }
+                ImGui::TreePop();
+            }
+        }
+        if (ImGui::CollapsingHeader("Stress Scene")) {
+            ImGui::Text("%zu objects, %zu models, %zu materials", m_scene->objects().size(),
+                m_scene->models().size(), m_scene->materials().size());
+            const AssetStats& assets = AssetRegistry::instance().stats();
+            ImGui::Text("%u meshes, %u textures loaded, %u + %u requests shared", assets.meshes,
+                assets.textures, assets.meshReuses, assets.textureReuses);
+            MeshOptimizeStats optimized = m_scene->optimizeStats();
+            if (optimized.before.triangles > 0) {
+                ImGui::Text("Imported: %u -> %u vertices", optimized.before.vertices, optimized.after.vertices);
+                ImGui::Text("- ACMR %.3f -> %.3f, overdraw %.2f -> %.2f", optimized.before.acmr,
+                    optimized.after.acmr, optimized.before.overdraw, optimized.after.overdraw);
+            }
+            ImGui::SliderInt("- Objects", (int*)&m_stressSettings.objectCount, 1, 20000);
+            int distribution = (int)m_stressSettings.distribution;
+            if (ImGui::Combo("- Distribution", &distribution, "Grid\0Uniform\0Clustered\0"))
+                m_stressSettings.distribution = (Distribution)distribution;
+            ImGui::SliderFloat("- Extent", &m_stressSettings.extent, 1.0f, 100.0f);
+            ImGui::SliderFloat("- Instance Ratio", &m_stressSettings.instanceRatio, 0.0f, 1.0f);
+            ImGui::SliderInt("- Lights", (int*)&m_stressSettings.lightCount, 0, 4096);
+            ImGui::SliderFloat("- Light Radius", &m_stressSettings.lightRadius, 0.5f, 50.0f);
+            ImGui::SliderInt("- Materials", (int*)&m_stressSettings.materialCount, 1, 256);
+            ImGui::InputInt("- Seed", (int*)&m_stressSettings.seed);
+            if (ImGui::Button("Generate")) {
+                SceneGenerator::generate(*m_scene, m_stressSettings);
+                sceneChanged();
+            }
+            ImGui::SameLine();
+            if (ImGui::Button("Default Scene")) {
+                m_scene->loadDefault();
+                sceneChanged();
+            }
+        }
 
         ImGui::End();
     }
 
+    if (m_showGpuProfiler)
+        m_gpuProfiler.drawGUI();
+
     ImGui::Render();
     ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 }
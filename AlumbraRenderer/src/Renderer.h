@@ -1,9 +1,39 @@
 #pragma once
 
 #include "Scene.h"
+#include "SceneGenerator.h"
 #include "Texture.h"
 #include "FreeCamera.h"
 #include "Framebuffer.h"
+#include "Bloom.h"
+#include "CheckerboardShading.h"
+#include "DynamicResolution.h"
+#include "TemporalAA.h"
+#include "GpuCulling.h"
+#include "GpuProfiler.h"
+#include "SceneBVH.h"
+#include "SoftwareOcclusion.h"
+#include "JobSystem.h"
+#include "LodSelector.h"
+#include "Impostors.h"
+#include "Profiler.h"
+#include "LightClusters.h"
+#include "TileClassifier.h"
+#include "mesh/MeshPool.h"
+#include "MemoryBudget.h"
+
+// Work submitted by the last beginDraw, shown in the GUI and reported by benchmarks
+struct RenderStats {
+    unsigned int drawCalls = 0;
+    unsigned int dispatches = 0;
+    unsigned long long triangles = 0;
+    // Objects rejected by the CPU frustum culling of the GBuffer pass
+    unsigned int culledObjects = 0;
+    // Objects inside the frustum rejected by the software occlusion culling
+    unsigned int occludedObjects = 0;
+    // Visible objects drawn as impostors instead of meshes
+    unsigned int impostors = 0;
+};
 
 /**
  * Class that is responsible for rendering our scene
@@ -15,16 +45,52 @@ public:
 
     void beginDraw();
     void drawGUI();
+    void sceneChanged();
+
+    inline const RenderStats& stats() const { return m_stats; }
+    inline const GpuProfiler& gpuProfiler() const { return m_gpuProfiler; }
+    inline void setGUIEnabled(bool enabled) { m_guiEnabled = enabled; }
+    inline void setVisibilityBuffer(bool enabled) { m_useVisibilityBuffer = enabled; }
+    // Only applies to the visibility buffer path, which draws from the mesh pool
+    inline void setGpuCulling(bool enabled, bool occlusion) { m_useGpuCulling = enabled; m_useOcclusionCulling = occlusion; }
+    // Culls and draws meshlets instead of whole draws when GPU culling is on
+    inline void setClusterCulling(bool enabled) { m_useClusterCulling = enabled; }
+    // Only applies to the GBuffer path, which draws objects one by one
+    inline void setCpuCulling(bool enabled) { m_useCpuCulling = enabled; }
+    void setSoftwareOcclusion(const SoftwareOcclusionSettings& settings);
+    // Levels of detail are picked for the camera view, both geometry paths draw them
+    inline void setLod(const LodSettings& settings) { m_lodSettings = settings; }
+    // Only applies to the GBuffer path, rebakes when the number of baked models changes
+    void setImpostors(const ImpostorSettings& settings);
+    inline void setDynamicResolution(const DynamicResolutionSettings& settings) { m_dynamicResSettings = settings; }
+    inline void setTemporalAA(const TemporalAASettings& settings) { m_taaSettings = settings; }
+    inline void setCheckerboard(const CheckerboardSettings& settings) { m_checkerboardSettings = settings; }
+    inline void setMemoryBudget(const MemoryBudgetSettings& settings) { m_memoryBudgetSettings = settings; }
+    // Per-axis fraction of the window resolution the last frame was rendered at
+    inline float renderScale() const { return m_dynamicRes.scale(); }
 
 private:
     const unsigned int SHADOW_WIDTH = 1024, SHADOW_HEIGHT = 1024;
+    // Only the first few point lights get a cubemap shadow map, matches pointDepthMaps in pbr_shading.frag
+    static constexpr size_t MAX_SHADOWED_POINT_LIGHTS = 4;
+    const float NEAR_PLANE = 0.1f, FAR_PLANE = 100.0f;
+    // Alpha is never read after lighting, so HDR targets use the packed 32 bit float format.
+    // Switch to GL_RGBA16F if a pass ever needs HDR alpha or negative values
+    static constexpr GLenum HDR_FORMAT = GL_R11F_G11F_B10F;
 
     Scene* m_scene;
     Shader m_pbrLightingShader, m_gBufferShader, m_cubemapCaptureShader, m_cubemapConvolveShader,
         m_cubemapPrefilterShader, m_brdfPrecomputeShader, m_skyboxShader, m_postProcessShader,
-        m_directDepthShader, m_pointDepthShader, m_blurShader;
-
-    Framebuffer m_mainBuffer, m_gBuffer, m_directDepthBuffer, m_captureBuffer, m_pingBuffer, m_pongBuffer;
+        m_directDepthShader, m_pointDepthShader, m_bloomDownsampleShader, m_bloomUpsampleShader,
+        m_lightCullShader, m_tileClassifyShader, m_simpleTileShader, m_complexTileShader, m_visibilityShader,
+        m_visibilityResolveShader, m_taaResolveShader, m_checkerReconstructShader, m_drawCullShader,
+        m_clusterCullShader, m_hiZBuildShader, m_impostorShader;
+
+    Framebuffer m_mainBuffer, m_gBuffer, m_visibilityBuffer, m_directDepthBuffer, m_captureBuffer;
+    // The main buffer alternates between two scene color textures so checkerboard shading can
+    // read last frame's lighting
+    GLuint m_sceneColors[2];
+    int m_sceneColorIndex = 0;
     GLuint m_screenQuadVAO;
     
     // For shadows
@@ -34,18 +100,82 @@ private:
     std::vector<GLuint> m_pointDepthMaps;
 
     GLuint m_brdfLUT;
+    // Scene colors, GBuffer, shadow maps and the BRDF table, owned for the memory accounting
+    std::vector<GpuResource> m_renderTargets;
+
+    LightClusters m_lightClusters;
+    TileClassifier m_tileClassifier;
+    MeshPool m_meshPool;
+    GpuCulling m_gpuCulling;
+    SceneBVH m_sceneBVH;
+    std::vector<unsigned int> m_visibleObjects;
+    BVHQueryStats m_cullStats;
+    // World bounds of every object, kept up to date with the BVH
+    std::vector<AABB> m_objectBounds;
+    JobSystem m_jobs;
+    SoftwareOcclusion m_softwareOcclusion;
+    // Simplified occluder geometry per model, empty for models no occluder object uses
+    std::vector<OccluderMesh> m_occluderMeshes;
+    std::vector<OccluderInstance> m_occluderInstances;
+    LodSelector m_lodSelector;
+    Impostors m_impostors;
+    std::vector<ImpostorInstance> m_impostorInstances;
+    Bloom m_bloom;
+    TemporalAA m_temporalAA;
+    CheckerboardShading m_checkerboard;
+    GpuProfiler m_gpuProfiler;
+    DynamicResolution m_dynamicRes;
+    MemoryBudget m_memoryBudget;
+    RenderStats m_stats;
+    // Size of the region of every screen sized target rendered this frame
+    int m_renderWidth = 0, m_renderHeight = 0;
+    // Unjittered camera and object matrices of this and the last frame, for motion vectors
+    glm::mat4 m_currViewProjection = glm::mat4(1.0f), m_prevViewProjection = glm::mat4(1.0f);
+    glm::mat4 m_prevSkyViewProjection = glm::mat4(1.0f);
+    std::vector<glm::mat4> m_objectMatrices, m_prevObjectMatrices;
+    glm::vec2 m_prevJitter = glm::vec2(0.0f);
+    glm::ivec2 m_prevRenderSize = glm::ivec2(1);
 
     // Settings
     // TODO: Add to Camera
     float m_exposure = 1.0f;
-    // TODO: Material class
-    glm::vec3 m_albedo = glm::vec3(1.0f, 0.782f, 0.344f);
-    float m_roughness = 0.0f;
-    float m_metallic = 1.0f;
+    bool m_useBloom = true;
+    BloomSettings m_bloomSettings;
+    bool m_showLightHeatmap = false;
+    bool m_useTileClassification = true;
+    bool m_showTileClasses = false;
+    bool m_useVisibilityBuffer = false;
+    bool m_useCpuCulling = true;
+    bool m_useGpuCulling = true;
+    bool m_useOcclusionCulling = true;
+    bool m_useClusterCulling = true;
+    // What the GPU culling buffers were last sized for
+    bool m_cullingClusters = false;
+    bool m_showGpuProfiler = false;
+    int m_traceCaptureFrames = 60;
+    bool m_guiEnabled = true;
+    SoftwareOcclusionSettings m_softwareOcclusionSettings;
+    LodSettings m_lodSettings;
+    ImpostorSettings m_impostorSettings;
+    StressSceneSettings m_stressSettings;
+    DynamicResolutionSettings m_dynamicResSettings;
+    TemporalAASettings m_taaSettings;
+    CheckerboardSettings m_checkerboardSettings;
+    MemoryBudgetSettings m_memoryBudgetSettings;
 
     void setupShaders();
     void setupFramebuffers();
+    GLuint trackRenderTarget(GLuint texture, const std::string& name);
     void setupUniforms();
+    void buildSceneBVH();
+    void updateSceneBVH();
+    void buildOccluders();
+    void bakeImpostors();
+    void resetGpuCulling();
+    void geometryPass(const glm::mat4& viewM, const glm::mat4& projectionM);
+    void visibilityPass(const glm::mat4& viewM, const glm::mat4& projectionM);
+    void setLightingUniforms(const Shader& shader, const glm::mat4& viewM, const glm::mat4& projectionM,
+        const glm::mat4& lightSpaceMatrix, float farPlane);
 };
 
 void messageCallback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message,
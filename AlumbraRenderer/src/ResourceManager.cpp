@@ -0,0 +1,321 @@
+#include "pch.h"
+#include "ResourceManager.h"
+
+#include <algorithm>
+
+ResourceManager& ResourceManager::instance()
+{
+    static ResourceManager manager;
+    return manager;
+}
+
+ResourceHandle ResourceManager::adopt(ResourceType type, ResourceCategory category, GLuint id, size_t bytes,
+    const std::string& name)
+{
+    if (id == 0)
+        return {};
+    unsigned int index;
+    if (!m_freeSlots.empty()) {
+        index = m_freeSlots.back();
+        m_freeSlots.pop_back();
+    }
+    else {
+        index = (unsigned int)m_slots.size();
+        m_slots.emplace_back();
+    }
+    Slot& slot = m_slots[index];
+    slot.id = id;
+    slot.type = type;
+    slot.category = category;
+    slot.bytes = bytes;
+    slot.name = name;
+    slot.live = true;
+
+    for (ResourceStats* stats : { &m_stats[(int)type], &m_categoryStats[(int)category] }) {
+        stats->live++;
+        stats->bytes += bytes;
+        stats->created++;
+    }
+    return { index, slot.generation };
+}
+
+ResourceHandle ResourceManager::createBuffer(ResourceCategory category, GLsizeiptr size, const void* data,
+    GLbitfield flags, const std::string& name)
+{
+    GLuint id;
+    glCreateBuffers(1, &id);
+    glNamedBufferStorage(id, size, data, flags);
+    return adopt(ResourceType::Buffer, category, id, size, name);
+}
+
+ResourceHandle ResourceManager::createTexture(ResourceCategory category, GLenum target, const std::string& name)
+{
+    GLuint id;
+    glCreateTextures(target, 1, &id);
+    return adopt(ResourceType::Texture, category, id, 0, name);
+}
+
+ResourceHandle ResourceManager::createVertexArray(ResourceCategory category, const std::string& name)
+{
+    GLuint id;
+    glCreateVertexArrays(1, &id);
+    return adopt(ResourceType::VertexArray, category, id, 0, name);
+}
+
+ResourceHandle ResourceManager::createFramebuffer(ResourceCategory category, const std::string& name)
+{
+    GLuint id;
+    glCreateFramebuffers(1, &id);
+    return adopt(ResourceType::Framebuffer, category, id, 0, name);
+}
+
+ResourceHandle ResourceManager::createRenderbuffer(ResourceCategory category, const std::string& name)
+{
+    GLuint id;
+    glCreateRenderbuffers(1, &id);
+    return adopt(ResourceType::Renderbuffer, category, id, 0, name);
+}
+
+GLuint ResourceManager::get(ResourceHandle handle) const
+{
+    const Slot* found = slot(handle);
+    return found ? found->id : 0;
+}
+
+size_t ResourceManager::bytes(ResourceHandle handle) const
+{
+    const Slot* found = slot(handle);
+    return found ? found->bytes : 0;
+}
+
+void ResourceManager::setBytes(ResourceHandle handle, size_t bytes)
+{
+    Slot* found = const_cast<Slot*>(slot(handle));
+    if (!found)
+        return;
+    for (ResourceStats* stats : { &m_stats[(int)found->type], &m_categoryStats[(int)found->category] })
+        stats->bytes = stats->bytes - found->bytes + bytes;
+    found->bytes = bytes;
+}
+
+void ResourceManager::measureTexture(ResourceHandle handle)
+{
+    GLuint id = get(handle);
+    if (id == 0)
+        return;
+    GLint target = 0, levels = 0;
+    glGetTextureParameteriv(id, GL_TEXTURE_TARGET, &target);
+    glGetTextureParameteriv(id, GL_TEXTURE_IMMUTABLE_LEVELS, &levels);
+    size_t bytes = 0;
+    for (GLint level = 0; level < std::max(levels, 1); level++) {
+        GLint width = 0, height = 0, depth = 0, format = 0;
+        glGetTextureLevelParameteriv(id, level, GL_TEXTURE_WIDTH, &width);
+        glGetTextureLevelParameteriv(id, level, GL_TEXTURE_HEIGHT, &height);
+        glGetTextureLevelParameteriv(id, level, GL_TEXTURE_DEPTH, &depth);
+        glGetTextureLevelParameteriv(id, level, GL_TEXTURE_INTERNAL_FORMAT, &format);
+        // Some drivers report the six faces of a cube map as its depth, others a depth of one
+        int faces = target == GL_TEXTURE_CUBE_MAP && depth <= 1 ? 6 : 1;
+        bytes += (size_t)width * height * std::max(depth, 1) * faces * texelBytes(format);
+    }
+    setBytes(handle, bytes);
+}
+
+void ResourceManager::release(ResourceHandle& handle)
+{
+    Slot* found = const_cast<Slot*>(slot(handle));
+    handle = {};
+    if (!found)
+        return;
+    for (ResourceStats* stats : { &m_stats[(int)found->type], &m_categoryStats[(int)found->category] }) {
+        stats->live--;
+        stats->bytes -= found->bytes;
+        stats->pending++;
+        stats->pendingBytes += found->bytes;
+    }
+    m_releases.push_back({ found->type, found->category, found->id, found->bytes });
+
+    found->live = false;
+    found->id = 0;
+    found->name.clear();
+    if (++found->generation == 0)
+        found->generation = 1;
+    m_freeSlots.push_back((unsigned int)(found - m_slots.data()));
+}
+
+void ResourceManager::endFrame()
+{
+    m_frame++;
+    if (!m_releases.empty()) {
+        FrameReleases frame;
+        frame.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        frame.releases = std::move(m_releases);
+        m_releases.clear();
+        m_fencedReleases.push_back(std::move(frame));
+    }
+    // Fences signal in submission order, the first unsignaled one ends the scan
+    while (!m_fencedReleases.empty()) {
+        FrameReleases& frame = m_fencedReleases.front();
+        GLenum status = glClientWaitSync(frame.fence, 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+            break;
+        for (const auto& release : frame.releases)
+            destroy(release);
+        glDeleteSync(frame.fence);
+        m_fencedReleases.pop_front();
+    }
+}
+
+void ResourceManager::shutdown()
+{
+    glFinish();
+    for (auto& frame : m_fencedReleases) {
+        for (const auto& release : frame.releases)
+            destroy(release);
+        glDeleteSync(frame.fence);
+    }
+    m_fencedReleases.clear();
+    for (const auto& release : m_releases)
+        destroy(release);
+    m_releases.clear();
+
+    unsigned int leaked = 0;
+    for (const auto& slot : m_slots) {
+        if (!slot.live)
+            continue;
+        std::cout << "Leaked " << categoryName(slot.category) << " " << typeName(slot.type) << " " << slot.id << " \"" << slot.name << "\", "
+            << slot.bytes / 1024 << " KB" << std::endl;
+        leaked++;
+    }
+    for (int type = 0; type < (int)ResourceType::Count; type++) {
+        const ResourceStats& stats = m_stats[type];
+        std::cout << typeName((ResourceType)type) << ": " << stats.created << " created, " << stats.deleted
+            << " deleted, " << stats.live << " alive" << std::endl;
+    }
+    if (leaked == 0)
+        std::cout << "No GPU resources leaked" << std::endl;
+}
+
+size_t ResourceManager::totalBytes() const
+{
+    size_t bytes = 0;
+    for (const auto& stats : m_categoryStats)
+        bytes += stats.bytes;
+    return bytes;
+}
+
+std::vector<ResourceInfo> ResourceManager::resources(ResourceCategory category) const
+{
+    std::vector<ResourceInfo> result;
+    for (const auto& slot : m_slots) {
+        if (slot.live && slot.category == category)
+            result.push_back({ slot.type, slot.id, slot.bytes, slot.name });
+    }
+    std::sort(result.begin(), result.end(),
+        [](const ResourceInfo& a, const ResourceInfo& b) { return a.bytes > b.bytes; });
+    return result;
+}
+
+const char* ResourceManager::typeName(ResourceType type)
+{
+    switch (type) {
+    case ResourceType::Buffer:       return "Buffer";
+    case ResourceType::Texture:      return "Texture";
+    case ResourceType::VertexArray:  return "Vertex Array";
+    case ResourceType::Framebuffer:  return "Framebuffer";
+    case ResourceType::Renderbuffer: return "Renderbuffer";
+    case ResourceType::Program:      return "Program";
+    default:                         return "Unknown";
+    }
+}
+
+const char* ResourceManager::categoryName(ResourceCategory category)
+{
+    switch (category) {
+    case ResourceCategory::Environment:  return "Environment";
+    case ResourceCategory::RenderTarget: return "Render Targets";
+    case ResourceCategory::Texture:      return "Textures";
+    case ResourceCategory::Mesh:         return "Meshes";
+    case ResourceCategory::Shader:       return "Shaders";
+    case ResourceCategory::Other:        return "Other";
+    default:                             return "Unknown";
+    }
+}
+
+unsigned int ResourceManager::texelBytes(GLenum internalFormat)
+{
+    switch (internalFormat) {
+    case GL_R8:
+        return 1;
+    case GL_RG8:
+    case GL_R16:
+    case GL_R16F:
+        return 2;
+    // Three channel formats are padded to four by every current driver
+    case GL_RGB8:
+    case GL_SRGB8:
+    case GL_RGBA8:
+    case GL_SRGB8_ALPHA8:
+    case GL_RG16:
+    case GL_RG16F:
+    case GL_R11F_G11F_B10F:
+    case GL_RGB10_A2:
+    case GL_R32F:
+    case GL_R32UI:
+    case GL_DEPTH_COMPONENT24:
+    case GL_DEPTH_COMPONENT32F:
+    case GL_DEPTH24_STENCIL8:
+        return 4;
+    case GL_RGB16F:
+    case GL_RGBA16F:
+    case GL_RGBA16:
+    case GL_RG32F:
+        return 8;
+    case GL_RGB32F:
+    case GL_RGBA32F:
+        return 16;
+    default:
+        return 0;
+    }
+}
+
+const ResourceManager::Slot* ResourceManager::slot(ResourceHandle handle) const
+{
+    if (!handle || handle.index >= m_slots.size())
+        return nullptr;
+    const Slot& found = m_slots[handle.index];
+    return found.live && found.generation == handle.generation ? &found : nullptr;
+}
+
+void ResourceManager::destroy(const PendingRelease& release)
+{
+    switch (release.type) {
+    case ResourceType::Buffer:       glDeleteBuffers(1, &release.id); break;
+    case ResourceType::Texture:      glDeleteTextures(1, &release.id); break;
+    case ResourceType::VertexArray:  glDeleteVertexArrays(1, &release.id); break;
+    case ResourceType::Framebuffer:  glDeleteFramebuffers(1, &release.id); break;
+    case ResourceType::Renderbuffer: glDeleteRenderbuffers(1, &release.id); break;
+    case ResourceType::Program:      glDeleteProgram(release.id); break;
+    default: break;
+    }
+    for (ResourceStats* stats : { &m_stats[(int)release.type], &m_categoryStats[(int)release.category] }) {
+        stats->pending--;
+        stats->pendingBytes -= release.bytes;
+        stats->deleted++;
+    }
+}
+
+GpuResource& GpuResource::operator=(GpuResource&& other) noexcept
+{
+    if (this != &other) {
+        reset();
+        m_handle = other.m_handle;
+        other.m_handle = {};
+    }
+    return *this;
+}
+
+void GpuResource::reset()
+{
+    if (m_handle)
+        ResourceManager::instance().release(m_handle);
+}
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <deque>
+
+enum class ResourceType {
+    Buffer,
+    Texture,
+    VertexArray,
+    Framebuffer,
+    Renderbuffer,
+    Program,
+    Count
+};
+
+/* What an object is used for, budgets and the memory panel are kept per category */
+enum class ResourceCategory {
+    // Equirectangular source, environment, irradiance and prefiltered maps
+    Environment,
+    // GBuffer, scene color, shadow maps and the other screen or fixed size targets
+    RenderTarget,
+    // Material textures loaded from files
+    Texture,
+    // Vertex and index buffers with their vertex arrays
+    Mesh,
+    Shader,
+    Other,
+    Count
+};
+
+/* Slot of a GL object in the ResourceManager plus the generation the slot had when the handle
+    was made. Once the object is released the slot's generation moves on, so a stale handle
+    resolves to 0 instead of to whatever object reuses the slot */
+struct ResourceHandle {
+    unsigned int index = 0;
+    // 0 is never handed out, a default handle is null
+    unsigned int generation = 0;
+
+    explicit operator bool() const { return generation != 0; }
+};
+
+struct ResourceStats {
+    unsigned int live = 0;
+    size_t bytes = 0;
+    // Released, waiting for the GPU to finish the frames that could still use them
+    unsigned int pending = 0;
+    size_t pendingBytes = 0;
+    unsigned long long created = 0;
+    unsigned long long deleted = 0;
+};
+
+/* One live object, for listing what a category is made of */
+struct ResourceInfo {
+    ResourceType type;
+    GLuint id;
+    size_t bytes;
+    std::string name;
+};
+
+/**
+ * Owns GL objects on behalf of the renderer's wrappers through generational handles. Releasing
+ * a handle does not delete the object right away: it is queued with a fence inserted after the
+ * frame it was released in, and deleted once that fence signals, so no frame still in flight
+ * can sample a deleted texture or fetch from a deleted buffer and the driver never has to stall
+ * on it. Live and pending counts and bytes are kept per object type, and whatever is still
+ * alive at shutdown is reported as a leak with the name it was created under. Bytes are also
+ * summed per purpose category, which is what MemoryBudget compares against its budgets.
+ */
+class ResourceManager {
+public:
+    static ResourceManager& instance();
+
+    /* Takes ownership of an object created by the caller, bytes are its GPU memory if known */
+    ResourceHandle adopt(ResourceType type, ResourceCategory category, GLuint id, size_t bytes,
+        const std::string& name);
+    ResourceHandle createBuffer(ResourceCategory category, GLsizeiptr size, const void* data, GLbitfield flags,
+        const std::string& name);
+    ResourceHandle createTexture(ResourceCategory category, GLenum target, const std::string& name);
+    ResourceHandle createVertexArray(ResourceCategory category, const std::string& name);
+    ResourceHandle createFramebuffer(ResourceCategory category, const std::string& name);
+    ResourceHandle createRenderbuffer(ResourceCategory category, const std::string& name);
+
+    /* Object of a handle, 0 once it was released */
+    GLuint get(ResourceHandle handle) const;
+    /* Recorded size of a handle's object, 0 once it was released */
+    size_t bytes(ResourceHandle handle) const;
+    /* Replaces the recorded size, for textures and renderbuffers once their storage is allocated */
+    void setBytes(ResourceHandle handle, size_t bytes);
+    /* Sizes a texture from its levels' dimensions and internal formats */
+    void measureTexture(ResourceHandle handle);
+    /* Queues the object for deletion after the GPU finishes the current frame, nulls the handle */
+    void release(ResourceHandle& handle);
+
+    /* Fences the frame just submitted and deletes every object whose fence signaled */
+    void endFrame();
+    /* Waits for the GPU, deletes everything queued and reports objects still alive */
+    void shutdown();
+
+    inline const ResourceStats& stats(ResourceType type) const { return m_stats[(int)type]; }
+    inline const ResourceStats& stats(ResourceCategory category) const { return m_categoryStats[(int)category]; }
+    // Bytes of every live object
+    size_t totalBytes() const;
+    /* Live objects of a category, largest first */
+    std::vector<ResourceInfo> resources(ResourceCategory category) const;
+    // Frames ended so far, the clock textures are marked used against
+    inline unsigned long long frame() const { return m_frame; }
+
+    static const char* typeName(ResourceType type);
+    static const char* categoryName(ResourceCategory category);
+    /* Bytes per texel of an internal format, 0 for compressed or unknown formats */
+    static unsigned int texelBytes(GLenum internalFormat);
+
+private:
+    struct Slot {
+        GLuint id = 0;
+        ResourceType type = ResourceType::Buffer;
+        ResourceCategory category = ResourceCategory::Other;
+        size_t bytes = 0;
+        std::string name;
+        unsigned int generation = 1;
+        bool live = false;
+    };
+    struct PendingRelease {
+        ResourceType type;
+        ResourceCategory category;
+        GLuint id;
+        size_t bytes;
+    };
+    struct FrameReleases {
+        GLsync fence = nullptr;
+        std::vector<PendingRelease> releases;
+    };
+
+    std::vector<Slot> m_slots;
+    std::vector<unsigned int> m_freeSlots;
+    // Released during the frame being recorded, fenced by endFrame
+    std::vector<PendingRelease> m_releases;
+    std::deque<FrameReleases> m_fencedReleases;
+    ResourceStats m_stats[(int)ResourceType::Count];
+    ResourceStats m_categoryStats[(int)ResourceCategory::Count];
+    unsigned long long m_frame = 0;
+
+    ResourceManager() = default;
+    const Slot* slot(ResourceHandle handle) const;
+    void destroy(const PendingRelease& release);
+};
+
+/* Move only owner of a handle, releases it when destroyed */
+class GpuResource {
+public:
+    GpuResource() = default;
+    explicit GpuResource(ResourceHandle handle) : m_handle(handle) {}
+    GpuResource(const GpuResource&) = delete;
+    GpuResource& operator=(const GpuResource&) = delete;
+    GpuResource(GpuResource&& other) noexcept : m_handle(other.m_handle) { other.m_handle = {}; }
+    GpuResource& operator=(GpuResource&& other) noexcept;
+    ~GpuResource() { reset(); }
+
+    void reset();
+    inline GLuint id() const { return ResourceManager::instance().get(m_handle); }
+    inline ResourceHandle handle() const { return m_handle; }
+    explicit operator bool() const { return (bool)m_handle; }
+
+private:
+    ResourceHandle m_handle;
+};
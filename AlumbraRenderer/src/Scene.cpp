@@ -5,6 +5,30 @@ Scene::Scene()
     : m_cubemap(Cubemap())
     , m_dLight(DirectionalLight{ glm::vec3(2.0f, -4.0f, 1.0f), glm::vec3(1.0f, 1.0f, 1.0f), 1.0f, 7.5 })
 {
+    loadDefault();
+
+    // Setting up cubemap
+    /*std::vector<std::string> faces
+    {
+        "res/cubemaps/quattro/px.png",
+        "res/cubemaps/quattro/nx.png",
+        "res/cubemaps/quattro/py.png",
+        "res/cubemaps/quattro/ny.png",
+        "res/cubemaps/quattro/pz.png",
+        "res/cubemaps/quattro/nz.png"
+    };
+    m_cubemap.loadMap(faces);*/
+    m_cubemap.loadHDRMap("res/cubemaps/quattro_canti_8k.hdr");
+}
+
+Scene::~Scene() {
+    clear();
+}
+
+/* The small showcase scene, replaced by SceneGenerator for stress tests */
+void Scene::loadDefault()
+{
+    clear();
     // Setting up models and their transforms
     //m_models.push_back(new Model("res/models/nanosuit/nanosuit.obj"));
     //m_transforms.push_back(Transform{ glm::vec3(0.0f), glm::vec3(0.2f), glm::vec3(0.0f, -0.5f, 0.0f) });
@@ -19,7 +43,9 @@ Scene::Scene()
     //m_models.push_back(new Model(Quad("res/textures/metal.png")));
     //m_transforms.push_back(Transform{ glm::vec3(0.0f), glm::vec3(2.0f, 1.0f, 2.0f), glm::vec3(0.0f, 0.4f, 0.0f) });
 
-    m_models.push_back(new Model(Sphere()));
+    unsigned int sphere = addModel(new Model(Sphere()));
+    unsigned int gold = addMaterial(glm::vec3(1.0f, 0.782f, 0.344f), 1.0f, 0.0f);
+    addObject(sphere, gold, Transform());
 
     // Setting up point lights
     m_pLights = {
@@ -36,23 +62,51 @@ Scene::Scene()
             glm::vec4(1.0, 1.0, 1.0, 1.0),
             10.0f, 300.0, glm::vec2(0.0f)}
     };
-
-    // Setting up cubemap
-    /*std::vector<std::string> faces
-    {
-        "res/cubemaps/quattro/px.png",
-        "res/cubemaps/quattro/nx.png",
-        "res/cubemaps/quattro/py.png",
-        "res/cubemaps/quattro/ny.png",
-        "res/cubemaps/quattro/pz.png",
-        "res/cubemaps/quattro/nz.png"
-    };
-    m_cubemap.loadMap(faces);*/
-    m_cubemap.loadHDRMap("res/cubemaps/quattro_canti_8k.hdr");
 }
 
-Scene::~Scene() {
+/* Removes every model, material, object and point light, keeps the environment */
+void Scene::clear()
+{
     for (auto& model : m_models)
         delete model;
     m_models.clear();
+    m_materials.clear();
+    m_objects.clear();
+    m_pLights.clear();
+}
+
+unsigned int Scene::addModel(Model* model)
+{
+    m_models.push_back(model);
+    return m_models.size() - 1;
+}
+
+unsigned int Scene::addMaterial(const glm::vec3& albedo, float metallic, float roughness)
+{
+    m_materials.push_back(Material{ albedo, metallic, roughness, { 0.0f, 0.0f, 0.0f } });
+    return m_materials.size() - 1;
+}
+
+void Scene::addObject(unsigned int model, unsigned int material, const Transform& transform, bool occluder)
+{
+    m_objects.push_back(SceneObject{ model, material, transform, occluder });
+}
+
+MeshOptimizeStats Scene::optimizeStats() const
+{
+    MeshOptimizeStats total;
+    for (const Model* model : m_models) {
+        MeshOptimizer::accumulate(total.before, model->optimizeStats().before);
+        MeshOptimizer::accumulate(total.after, model->optimizeStats().after);
+    }
+    return total;
+}
+
+glm::mat4 Transform::matrix() const
+{
+    glm::mat4 model = glm::translate(glm::mat4(1.0f), translate);
+    model = glm::rotate(model, glm::radians(rotate.y), glm::vec3(0.0f, 1.0f, 0.0f));
+    model = glm::rotate(model, glm::radians(rotate.x), glm::vec3(1.0f, 0.0f, 0.0f));
+    model = glm::rotate(model, glm::radians(rotate.z), glm::vec3(0.0f, 0.0f, 1.0f));
+    return glm::scale(model, scale);
 }
@@ -21,9 +21,30 @@ struct PointLight {
 };
 
 struct Transform {
+    // Euler angles in degrees, applied as Y, X then Z
     glm::vec3 rotate    = glm::vec3(0.0f);
-    glm::vec3 scale     = glm::vec3(0.0f);
+    glm::vec3 scale     = glm::vec3(1.0f);
     glm::vec3 translate = glm::vec3(0.0f);
+
+    glm::mat4 matrix() const;
+};
+
+// std430 layout, must match Material in shaders/mesh_pool.glsl
+struct Material {
+    glm::vec3 albedo;
+    float metallic;
+    float roughness;
+    float padding[3];
+};
+
+// One placement of a model asset, many objects can share a model
+struct SceneObject {
+    unsigned int model;
+    unsigned int material;
+    Transform transform;
+    // Rasterized by the software occlusion culling to hide objects behind it, meant for large
+    // closed objects like walls and buildings
+    bool occluder = false;
 };
 
 /**
@@ -35,16 +56,28 @@ public:
     Scene();
     ~Scene();
 
+    void loadDefault();
+    void clear();
+    /* Takes ownership of the model, returns its index for addObject */
+    unsigned int addModel(Model* model);
+    unsigned int addMaterial(const glm::vec3& albedo, float metallic, float roughness);
+    void addObject(unsigned int model, unsigned int material, const Transform& transform, bool occluder = false);
+
     inline DirectionalLight& directionalLight() { return m_dLight; }
     inline std::vector<PointLight>& pointLights() { return m_pLights; }
     inline std::vector<Model*>& models() { return m_models; }
-    inline std::vector<Transform>& transforms() { return m_transforms; }
+    inline std::vector<Material>& materials() { return m_materials; }
+    inline std::vector<SceneObject>& objects() { return m_objects; }
     inline Cubemap& cubemap() { return m_cubemap; }
+    // Import optimization of every loaded model summed up, empty when only shapes are loaded
+    MeshOptimizeStats optimizeStats() const;
 private:
     FreeCamera m_camera;
     Cubemap m_cubemap;
     DirectionalLight m_dLight;
     std::vector<PointLight> m_pLights;
+    // Unique model assets, objects reference them by index
     std::vector<Model*> m_models;
-    std::vector<Transform> m_transforms;
+    std::vector<Material> m_materials;
+    std::vector<SceneObject> m_objects;
 };
@@ -0,0 +1,392 @@
+#include "pch.h"
+#include "SceneBVH.h"
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define BVH_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// MSVC accepts AVX2 intrinsics anywhere, GCC and Clang need them enabled per function
+#if defined(BVH_X86) && (defined(__GNUC__) || defined(__clang__))
+#define AVX2_TARGET __attribute__((target("avx2")))
+#else
+#define AVX2_TARGET
+#endif
+
+SceneBVH::SceneBVH()
+{
+    m_useSIMD = hasAVX2();
+}
+
+SceneBVH::~SceneBVH()
+{
+}
+
+bool SceneBVH::hasAVX2()
+{
+#if defined(BVH_X86) && defined(_MSC_VER)
+    static const bool supported = [] {
+        int info[4];
+        __cpuid(info, 1);
+        // The OS also has to save the YMM registers
+        bool osxsave = (info[2] & (1 << 27)) != 0, avx = (info[2] & (1 << 28)) != 0;
+        if (!osxsave || !avx || (_xgetbv(0) & 6) != 6)
+            return false;
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+    }();
+    return supported;
+#elif defined(BVH_X86)
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
+
+void SceneBVH::clear()
+{
+    m_nodes.clear();
+    m_minX.clear();
+    m_minY.clear();
+    m_minZ.clear();
+    m_maxX.clear();
+    m_maxY.clear();
+    m_maxZ.clear();
+    m_freeNodes.clear();
+    m_objectLeaves.clear();
+    m_root = NULL_NODE;
+}
+
+void SceneBVH::build(const std::vector<AABB>& objectBounds)
+{
+    clear();
+    m_objectLeaves.reserve(objectBounds.size());
+    for (unsigned int i = 0; i < objectBounds.size(); i++) {
+        int leaf = allocateNode();
+        m_nodes[leaf] = { NULL_NODE, NULL_NODE, NULL_NODE, (int)i };
+        setNodeBounds(leaf, fatten(objectBounds[i]));
+        insertLeaf(leaf);
+        m_objectLeaves.push_back(leaf);
+    }
+}
+
+bool SceneBVH::update(unsigned int object, const AABB& bounds)
+{
+    int leaf = m_objectLeaves[object];
+    AABB fat = nodeBounds(leaf);
+    if (fat.contains(bounds))
+        return false;
+
+    // Small moves keep the leaf where it is and only refit its ancestors, large ones would
+    // leave it in a poor spot of the tree so it is reinserted
+    AABB newFat = fatten(bounds);
+    if (glm::length(newFat.center() - fat.center()) > glm::length(fat.extents())) {
+        removeLeaf(leaf);
+        setNodeBounds(leaf, newFat);
+        insertLeaf(leaf);
+    }
+    else {
+        setNodeBounds(leaf, newFat);
+        refitAncestors(m_nodes[leaf].parent);
+    }
+    return true;
+}
+
+BVHQueryStats SceneBVH::query(const Frustum& frustum, std::vector<unsigned int>& visible) const
+{
+    return m_useSIMD ? queryAVX2(frustum, visible) : queryScalar(frustum, visible);
+}
+
+BVHQueryStats SceneBVH::queryScalar(const Frustum& frustum, std::vector<unsigned int>& visible) const
+{
+    BVHQueryStats stats;
+    if (m_root == NULL_NODE)
+        return stats;
+
+    // Nodes fully inside the frustum are collected and expanded once traversal is done
+    std::vector<int> stack, inside;
+    stack.reserve(64);
+    stack.push_back(m_root);
+    while (!stack.empty()) {
+        int node = stack.back();
+        stack.pop_back();
+        stats.nodesTested++;
+
+        // Positive vertex behind a plane means outside, negative vertex behind means straddling
+        bool outside = false, contained = true;
+        for (const auto& plane : frustum.planes) {
+            float px = plane.x >= 0.0f ? m_maxX[node] : m_minX[node];
+            float py = plane.y >= 0.0f ? m_maxY[node] : m_minY[node];
+            float pz = plane.z >= 0.0f ? m_maxZ[node] : m_minZ[node];
+            if (plane.x * px + plane.y * py + plane.z * pz + plane.w < 0.0f) {
+                outside = true;
+                break;
+            }
+            float nx = plane.x >= 0.0f ? m_minX[node] : m_maxX[node];
+            float ny = plane.y >= 0.0f ? m_minY[node] : m_maxY[node];
+            float nz = plane.z >= 0.0f ? m_minZ[node] : m_maxZ[node];
+            if (plane.x * nx + plane.y * ny + plane.z * nz + plane.w < 0.0f)
+                contained = false;
+        }
+        if (outside)
+            continue;
+        if (contained) {
+            inside.push_back(node);
+        }
+        else if (isLeaf(node)) {
+            visible.push_back(m_nodes[node].object);
+            stats.visible++;
+        }
+        else {
+            stack.push_back(m_nodes[node].left);
+            stack.push_back(m_nodes[node].right);
+        }
+    }
+    appendSubtrees(inside, visible, stats);
+    return stats;
+}
+
+/* Pops up to eight nodes from the traversal stack at a time and classifies them together */
+AVX2_TARGET BVHQueryStats SceneBVH::queryAVX2(const Frustum& frustum, std::vector<unsigned int>& visible) const
+{
+#ifdef BVH_X86
+    BVHQueryStats stats;
+    if (m_root == NULL_NODE)
+        return stats;
+
+    __m256 planeX[6], planeY[6], planeZ[6], planeW[6];
+    bool positiveX[6], positiveY[6], positiveZ[6];
+    for (int i = 0; i < 6; i++) {
+        const glm::vec4& plane = frustum.planes[i];
+        planeX[i] = _mm256_set1_ps(plane.x);
+        planeY[i] = _mm256_set1_ps(plane.y);
+        planeZ[i] = _mm256_set1_ps(plane.z);
+        planeW[i] = _mm256_set1_ps(plane.w);
+        positiveX[i] = plane.x >= 0.0f;
+        positiveY[i] = plane.y >= 0.0f;
+        positiveZ[i] = plane.z >= 0.0f;
+    }
+    const __m256 zero = _mm256_setzero_ps();
+
+    // Nodes fully inside the frustum are collected and expanded once traversal is done
+    std::vector<int> stack, inside;
+    stack.reserve(64);
+    stack.push_back(m_root);
+    alignas(32) int batch[8];
+    while (!stack.empty()) {
+        int count = (int)std::min<size_t>(8, stack.size());
+        for (int i = 0; i < 8; i++)
+            batch[i] = stack[stack.size() - 1 - (i < count ? i : 0)];
+        stack.resize(stack.size() - count);
+        stats.nodesTested += count;
+
+        __m256i indices = _mm256_load_si256((const __m256i*)batch);
+        __m256 minX = _mm256_i32gather_ps(m_minX.data(), indices, 4);
+        __m256 minY = _mm256_i32gather_ps(m_minY.data(), indices, 4);
+        __m256 minZ = _mm256_i32gather_ps(m_minZ.data(), indices, 4);
+        __m256 maxX = _mm256_i32gather_ps(m_maxX.data(), indices, 4);
+        __m256 maxY = _mm256_i32gather_ps(m_maxY.data(), indices, 4);
+        __m256 maxZ = _mm256_i32gather_ps(m_maxZ.data(), indices, 4);
+
+        __m256 outside = zero, straddling = zero;
+        for (int i = 0; i < 6; i++) {
+            __m256 px = positiveX[i] ? maxX : minX, nx = positiveX[i] ? minX : maxX;
+            __m256 py = positiveY[i] ? maxY : minY, ny = positiveY[i] ? minY : maxY;
+            __m256 pz = positiveZ[i] ? maxZ : minZ, nz = positiveZ[i] ? minZ : maxZ;
+            __m256 positive = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(planeX[i], px), _mm256_mul_ps(planeY[i], py)),
+                _mm256_add_ps(_mm256_mul_ps(planeZ[i], pz), planeW[i]));
+            __m256 negative = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(planeX[i], nx), _mm256_mul_ps(planeY[i], ny)),
+                _mm256_add_ps(_mm256_mul_ps(planeZ[i], nz), planeW[i]));
+            outside = _mm256_or_ps(outside, _mm256_cmp_ps(positive, zero, _CMP_LT_OQ));
+            straddling = _mm256_or_ps(straddling, _mm256_cmp_ps(negative, zero, _CMP_LT_OQ));
+        }
+        int outsideMask = _mm256_movemask_ps(outside), straddlingMask = _mm256_movemask_ps(straddling);
+
+        for (int i = 0; i < count; i++) {
+            if (outsideMask & (1 << i))
+                continue;
+            int node = batch[i];
+            if (!(straddlingMask & (1 << i))) {
+                inside.push_back(node);
+            }
+            else if (isLeaf(node)) {
+                visible.push_back(m_nodes[node].object);
+                stats.visible++;
+            }
+            else {
+                stack.push_back(m_nodes[node].left);
+                stack.push_back(m_nodes[node].right);
+            }
+        }
+    }
+    appendSubtrees(inside, visible, stats);
+    return stats;
+#else
+    return queryScalar(frustum, visible);
+#endif
+}
+
+/* Appends every object below the given nodes, using the node list as the traversal stack */
+void SceneBVH::appendSubtrees(std::vector<int>& stack, std::vector<unsigned int>& visible, BVHQueryStats& stats) const
+{
+    while (!stack.empty()) {
+        int current = stack.back();
+        stack.pop_back();
+        if (isLeaf(current)) {
+            visible.push_back(m_nodes[current].object);
+            stats.visible++;
+        }
+        else {
+            stack.push_back(m_nodes[current].left);
+            stack.push_back(m_nodes[current].right);
+        }
+    }
+}
+
+int SceneBVH::allocateNode()
+{
+    if (!m_freeNodes.empty()) {
+        int node = m_freeNodes.back();
+        m_freeNodes.pop_back();
+        return node;
+    }
+    m_nodes.push_back({ NULL_NODE, NULL_NODE, NULL_NODE, -1 });
+    m_minX.push_back(0.0f);
+    m_minY.push_back(0.0f);
+    m_minZ.push_back(0.0f);
+    m_maxX.push_back(0.0f);
+    m_maxY.push_back(0.0f);
+    m_maxZ.push_back(0.0f);
+    return (int)m_nodes.size() - 1;
+}
+
+void SceneBVH::freeNode(int node)
+{
+    m_nodes[node] = { NULL_NODE, NULL_NODE, NULL_NODE, -1 };
+    m_freeNodes.push_back(node);
+}
+
+AABB SceneBVH::nodeBounds(int node) const
+{
+    AABB bounds;
+    bounds.min = glm::vec3(m_minX[node], m_minY[node], m_minZ[node]);
+    bounds.max = glm::vec3(m_maxX[node], m_maxY[node], m_maxZ[node]);
+    return bounds;
+}
+
+void SceneBVH::setNodeBounds(int node, const AABB& bounds)
+{
+    m_minX[node] = bounds.min.x;
+    m_minY[node] = bounds.min.y;
+    m_minZ[node] = bounds.min.z;
+    m_maxX[node] = bounds.max.x;
+    m_maxY[node] = bounds.max.y;
+    m_maxZ[node] = bounds.max.z;
+}
+
+/* Objects without geometry become a point at the origin so they never poison parent bounds */
+AABB SceneBVH::fatten(const AABB& bounds)
+{
+    AABB fat;
+    if (bounds.empty()) {
+        fat.min = fat.max = glm::vec3(0.0f);
+        return fat;
+    }
+    glm::vec3 margin = glm::max(FAT_MARGIN * (bounds.max - bounds.min), glm::vec3(MIN_FAT_MARGIN));
+    fat.min = bounds.min - margin;
+    fat.max = bounds.max + margin;
+    return fat;
+}
+
+/* Walks down towards the child whose bounds grow the least, stopping early when pairing the
+    leaf with the current node is cheaper than descending further */
+void SceneBVH::insertLeaf(int leaf)
+{
+    if (m_root == NULL_NODE) {
+        m_root = leaf;
+        m_nodes[leaf].parent = NULL_NODE;
+        return;
+    }
+
+    AABB leafBounds = nodeBounds(leaf);
+    int sibling = m_root;
+    while (!isLeaf(sibling)) {
+        AABB bounds = nodeBounds(sibling);
+        float combinedArea = AABB::merge(bounds, leafBounds).surfaceArea();
+        // Cost of a new parent here, and the minimum cost every ancestor pays for the descent
+        float cost = 2.0f * combinedArea;
+        float inheritedCost = 2.0f * (combinedArea - bounds.surfaceArea());
+
+        auto descendCost = [&](int child) {
+            AABB childBounds = nodeBounds(child);
+            float area = AABB::merge(childBounds, leafBounds).surfaceArea();
+            return isLeaf(child) ? area + inheritedCost : area - childBounds.surfaceArea() + inheritedCost;
+        };
+        int left = m_nodes[sibling].left, right = m_nodes[sibling].right;
+        float leftCost = descendCost(left), rightCost = descendCost(right);
+        if (cost < leftCost && cost < rightCost)
+            break;
+        sibling = leftCost < rightCost ? left : right;
+    }
+
+    int oldParent = m_nodes[sibling].parent;
+    int newParent = allocateNode();
+    m_nodes[newParent] = { oldParent, sibling, leaf, -1 };
+    setNodeBounds(newParent, AABB::merge(leafBounds, nodeBounds(sibling)));
+    if (oldParent == NULL_NODE) {
+        m_root = newParent;
+    }
+    else if (m_nodes[oldParent].left == sibling) {
+        m_nodes[oldParent].left = newParent;
+    }
+    else {
+        m_nodes[oldParent].right = newParent;
+    }
+    m_nodes[sibling].parent = newParent;
+    m_nodes[leaf].parent = newParent;
+    refitAncestors(oldParent);
+}
+
+/* Unlinks a leaf, its parent is freed and replaced by the leaf's sibling */
+void SceneBVH::removeLeaf(int leaf)
+{
+    if (leaf == m_root) {
+        m_root = NULL_NODE;
+        return;
+    }
+
+    int parent = m_nodes[leaf].parent;
+    int grandParent = m_nodes[parent].parent;
+    int sibling = m_nodes[parent].left == leaf ? m_nodes[parent].right : m_nodes[parent].left;
+    if (grandParent == NULL_NODE) {
+        m_root = sibling;
+        m_nodes[sibling].parent = NULL_NODE;
+    }
+    else {
+        if (m_nodes[grandParent].left == parent)
+            m_nodes[grandParent].left = sibling;
+        else
+            m_nodes[grandParent].right = sibling;
+        m_nodes[sibling].parent = grandParent;
+    }
+    freeNode(parent);
+    m_nodes[leaf].parent = NULL_NODE;
+    refitAncestors(grandParent);
+}
+
+/* Recomputes bounds towards the root, stopping once a node's bounds come out unchanged since
+    nothing above it can change either */
+void SceneBVH::refitAncestors(int node)
+{
+    while (node != NULL_NODE) {
+        AABB bounds = AABB::merge(nodeBounds(m_nodes[node].left), nodeBounds(m_nodes[node].right));
+        AABB old = nodeBounds(node);
+        if (bounds.min == old.min && bounds.max == old.max)
+            return;
+        setNodeBounds(node, bounds);
+        node = m_nodes[node].parent;
+    }
+}
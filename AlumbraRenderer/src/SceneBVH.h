@@ -0,0 +1,72 @@
+#pragma once
+
+#include "Bounds.h"
+
+// Work done by the last frustum query
+struct BVHQueryStats {
+    unsigned int nodesTested = 0;
+    unsigned int visible = 0;
+};
+
+/**
+ * Dynamic AABB tree over scene objects. Leaves store the object bounds fattened by a margin so
+ * small movements do not touch the tree at all, objects that leave their fat box get their leaf
+ * refit in place and are only reinserted (with a surface area heuristic descent) once they moved
+ * further than their own size. Node bounds are mirrored in structure of arrays form so frustum
+ * queries can test eight nodes at once with AVX2 gathers, nodes fully inside the frustum accept
+ * their whole subtree without further tests.
+ */
+class SceneBVH {
+public:
+    SceneBVH();
+    ~SceneBVH();
+
+    /* Rebuilds the tree with one leaf per object, objects are identified by their index */
+    void build(const std::vector<AABB>& objectBounds);
+    void clear();
+    /* Moves an object to its new world bounds, returns true if the tree had to change */
+    bool update(unsigned int object, const AABB& bounds);
+
+    /* Appends the objects whose bounds intersect the frustum, using AVX2 when enabled */
+    BVHQueryStats query(const Frustum& frustum, std::vector<unsigned int>& visible) const;
+    BVHQueryStats queryScalar(const Frustum& frustum, std::vector<unsigned int>& visible) const;
+    BVHQueryStats queryAVX2(const Frustum& frustum, std::vector<unsigned int>& visible) const;
+
+    inline void setSIMD(bool enabled) { m_useSIMD = enabled && hasAVX2(); }
+    inline bool simd() const { return m_useSIMD; }
+    inline size_t objectCount() const { return m_objectLeaves.size(); }
+    inline size_t nodeCount() const { return m_nodes.size() - m_freeNodes.size(); }
+    static bool hasAVX2();
+
+private:
+    static constexpr int NULL_NODE = -1;
+    // Fat leaf margin as a fraction of the object size, plus a minimum in world units
+    static constexpr float FAT_MARGIN = 0.1f, MIN_FAT_MARGIN = 0.05f;
+
+    // Leaves have no children and reference an object, inner nodes always have two children
+    struct Node {
+        int parent;
+        int left;
+        int right;
+        int object;
+    };
+
+    std::vector<Node> m_nodes;
+    // Node bounds, structure of arrays so eight nodes can be gathered at once
+    std::vector<float> m_minX, m_minY, m_minZ, m_maxX, m_maxY, m_maxZ;
+    std::vector<int> m_freeNodes;
+    std::vector<int> m_objectLeaves;
+    int m_root = NULL_NODE;
+    bool m_useSIMD = false;
+
+    inline bool isLeaf(int node) const { return m_nodes[node].left == NULL_NODE; }
+    int allocateNode();
+    void freeNode(int node);
+    AABB nodeBounds(int node) const;
+    void setNodeBounds(int node, const AABB& bounds);
+    static AABB fatten(const AABB& bounds);
+    void insertLeaf(int leaf);
+    void removeLeaf(int leaf);
+    void refitAncestors(int node);
+    void appendSubtrees(std::vector<int>& stack, std::vector<unsigned int>& visible, BVHQueryStats& stats) const;
+};
@@ -0,0 +1,164 @@
+#include "pch.h"
+#include "SceneGenerator.h"
+#include "Profiler.h"
+#include "mesh/MeshSimplifier.h"
+
+#include <random>
+
+namespace {
+
+/* std::mt19937 output is specified exactly, unlike the std distributions, so the conversions
+    to floats are done here to keep scenes identical across standard libraries. Draws are
+    sequenced explicitly since function argument evaluation order is unspecified */
+class Random {
+public:
+    Random(unsigned int seed) : m_engine(seed) {}
+
+    // Uniform in [0, 1)
+    inline float next() { return (m_engine() >> 8) * (1.0f / 16777216.0f); }
+    inline float range(float lo, float hi) { return lo + (hi - lo) * next(); }
+    inline unsigned int index(unsigned int count) { return (unsigned int)(next() * count) % count; }
+    inline glm::vec3 vec3(float lo, float hi)
+    {
+        glm::vec3 value;
+        value.x = range(lo, hi);
+        value.y = range(lo, hi);
+        value.z = range(lo, hi);
+        return value;
+    }
+    inline glm::vec3 inBox(float extent) { return vec3(-extent, extent); }
+    // Roughly normal, sum of three uniforms scaled to the given deviation
+    inline glm::vec3 around(const glm::vec3& center, float deviation)
+    {
+        glm::vec3 offset(0.0f);
+        for (int i = 0; i < 3; i++)
+            offset += vec3(-1.0f, 1.0f);
+        return center + offset * deviation;
+    }
+
+private:
+    std::mt19937 m_engine;
+};
+
+enum ShapeKind {
+    SHAPE_SPHERE,
+    SHAPE_CUBE,
+    SHAPE_QUAD,
+    SHAPE_COUNT
+};
+
+/* Builds the i-th unique shape, spheres cycle through tessellation levels so unique assets
+    also differ in triangle count. Unique models with the same shape share one mesh through
+    the asset registry, which builds the LODs of each sphere level once */
+Model* makeShape(unsigned int i)
+{
+    AssetRegistry& registry = AssetRegistry::instance();
+    switch (i % SHAPE_COUNT) {
+    case SHAPE_SPHERE: {
+        int level = (i / SHAPE_COUNT) % 4;
+        auto buildLods = [](MeshData& data) { MeshSimplifier::buildLods(data); };
+        return new Model(registry.mesh(Sphere::generate(16 << level, 8 << level, 0.5f), {}, buildLods));
+    }
+    case SHAPE_CUBE:
+        return new Model(registry.mesh(Cube::generate()));
+    default:
+        return new Model(registry.mesh(Quad::generate()));
+    }
+}
+
+glm::vec3 objectPosition(const StressSceneSettings& settings, unsigned int i,
+    const std::vector<glm::vec3>& clusterCenters, Random& random)
+{
+    switch (settings.distribution) {
+    case Distribution::Grid: {
+        unsigned int side = (unsigned int)std::ceil(std::cbrt((double)settings.objectCount));
+        float spacing = 2.0f * settings.extent / side;
+        glm::vec3 cell(i % side, (i / side) % side, i / (side * side));
+        return (cell + 0.5f) * spacing - settings.extent;
+    }
+    case Distribution::Clustered:
+        return random.around(clusterCenters[random.index(clusterCenters.size())], settings.extent * 0.05f);
+    default:
+        return random.inBox(settings.extent);
+    }
+}
+
+}
+
+/* Replaces the scene's models, materials, objects and point lights */
+void SceneGenerator::generate(Scene& scene, const StressSceneSettings& settings)
+{
+    PROFILE_FUNCTION();
+    Random random(settings.seed);
+    scene.clear();
+
+    // Assets: every object past the unique count reuses a random earlier model
+    unsigned int objectCount = std::max(settings.objectCount, 1u);
+    unsigned int uniqueCount = (unsigned int)std::round(objectCount * (1.0f - glm::clamp(settings.instanceRatio, 0.0f, 1.0f)));
+    uniqueCount = glm::clamp(uniqueCount, 1u, objectCount);
+    // The model file takes the first unique slot so the first object always places it
+    std::vector<ShapeKind> modelShapes;
+    if (!settings.modelPath.empty()) {
+        scene.addModel(new Model(settings.modelPath));
+        modelShapes.push_back(SHAPE_COUNT);
+    }
+    for (unsigned int i = 0; modelShapes.size() < uniqueCount; i++) {
+        scene.addModel(makeShape(i));
+        modelShapes.push_back((ShapeKind)(i % SHAPE_COUNT));
+    }
+
+    for (unsigned int i = 0; i < std::max(settings.materialCount, 1u); i++) {
+        glm::vec3 albedo = random.vec3(0.2f, 1.0f);
+        float metallic = random.next() < 0.5f ? 1.0f : 0.0f;
+        float roughness = random.range(0.05f, 1.0f);
+        scene.addMaterial(albedo, metallic, roughness);
+    }
+
+    std::vector<glm::vec3> clusterCenters;
+    for (unsigned int i = 0; i < std::max(objectCount / 64, 1u); i++)
+        clusterCenters.push_back(random.inBox(settings.extent));
+
+    const auto& models = scene.models();
+    for (unsigned int i = 0; i < objectCount; i++) {
+        unsigned int model = i < models.size() ? i : random.index(models.size());
+        Transform transform;
+        transform.translate = objectPosition(settings, i, clusterCenters, random);
+        transform.rotate.x = random.range(0.0f, 360.0f);
+        transform.rotate.y = random.range(0.0f, 360.0f);
+        transform.scale = glm::vec3(random.range(0.5f, 1.5f));
+        // The quad is a 10x10 floor, bring it to the size of the other shapes
+        if (modelShapes[model] == SHAPE_QUAD)
+            transform.scale *= 0.1f;
+        unsigned int material = random.index(scene.materials().size());
+        // Cubes are closed and only twelve triangles, which makes them the occluders
+        scene.addObject(model, material, transform, modelShapes[model] == SHAPE_CUBE);
+    }
+
+    auto& lights = scene.pointLights();
+    for (unsigned int i = 0; i < settings.lightCount; i++) {
+        glm::vec3 position = random.inBox(settings.extent);
+        glm::vec3 color = random.vec3(0.3f, 1.0f);
+        lights.push_back(PointLight{ glm::vec4(position, 0.0f), glm::vec4(color, 1.0f), 10.0f,
+            settings.lightRadius, glm::vec2(0.0f) });
+    }
+}
+
+const char* SceneGenerator::distributionName(Distribution distribution)
+{
+    switch (distribution) {
+    case Distribution::Grid: return "grid";
+    case Distribution::Clustered: return "clustered";
+    default: return "uniform";
+    }
+}
+
+bool SceneGenerator::parseDistribution(const std::string& name, Distribution& distribution)
+{
+    for (auto candidate : { Distribution::Grid, Distribution::Uniform, Distribution::Clustered }) {
+        if (name == distributionName(candidate)) {
+            distribution = candidate;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "Scene.h"
+
+enum class Distribution {
+    Grid,
+    Uniform,
+    Clustered
+};
+
+struct StressSceneSettings {
+    unsigned int objectCount = 1000;
+    Distribution distribution = Distribution::Uniform;
+    // Objects and lights are placed inside [-extent, extent] on every axis
+    float extent = 30.0f;
+    // Fraction of objects that reuse another object's model, 0 gives every object its own mesh
+    float instanceRatio = 0.9f;
+    unsigned int lightCount = 64;
+    float lightRadius = 10.0f;
+    unsigned int materialCount = 16;
+    // Optional model file, it takes one of the unique model slots so at least one object uses it
+    std::string modelPath;
+    unsigned int seed = 1;
+};
+
+/**
+ * Fills a scene with configurable numbers of objects, lights and materials for scaling tests.
+ * Objects are built from the Sphere, Cube and Quad shapes (spheres at varying tessellation)
+ * plus an optional loaded model. The same settings and seed always produce the same scene,
+ * on any platform, so results from different runs and machines can be compared.
+ */
+class SceneGenerator {
+public:
+    static void generate(Scene& scene, const StressSceneSettings& settings);
+
+    static const char* distributionName(Distribution distribution);
+    static bool parseDistribution(const std::string& name, Distribution& distribution);
+};
@@ -1,7 +1,8 @@
 #include "pch.h"
 #include "Shader.h"
+#include "Profiler.h"
 
-void Shader::graphicsShaders(const std::vector<std::string>& shaderFiles)
+void Shader::graphicsShaders(const std::vector<std::string>& shaderFiles, const std::vector<std::string>& defines)
 {
     std::vector<TypedShader> typedShaders;
     for (const auto& shaderFileName : shaderFiles) {
@@ -28,26 +29,29 @@ void Shader::graphicsShaders(const std::vector<std::string>& shaderFiles)
         typedShaders.push_back(make_pair(shaderType, shaderFileName));
     }
 
-    compileProgram(typedShaders);
+    compileProgram(typedShaders, defines);
 }
 
-void Shader::compileProgram(const std::vector<TypedShader>& shaders)
+void Shader::computeShader(const std::string& shaderFile, const std::vector<std::string>& defines)
 {
+    compileProgram({ make_pair(GL_COMPUTE_SHADER, shaderFile) }, defines);
+}
+
+/* Compiles and links the given stages. Each define is inserted as "#define <define>" right
+    after the #version line, which allows building specialized variants of one source file */
+void Shader::compileProgram(const std::vector<TypedShader>& shaders, const std::vector<std::string>& defines)
+{
+    PROFILE_SCOPE("Shader Compile");
     ID = glCreateProgram();
     for (const auto& shader : shaders) {
         // Read in the shader source
-        std::string shaderCode;
-        std::ifstream shaderFile;
-        shaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-        try {
-            shaderFile.open(shader.second);
-            std::stringstream shaderStream;
-            shaderStream << shaderFile.rdbuf();
-            shaderFile.close();
-            shaderCode = shaderStream.str();
-        }
-        catch (std::ifstream::failure e) {
-            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ\n";
+        std::string shaderCode = readShaderFile(shader.second);
+        if (!defines.empty()) {
+            std::string defineBlock;
+            for (const auto& define : defines)
+                defineBlock += "#define " + define + "\n";
+            auto versionEnd = shaderCode.rfind("#version", 0) == 0 ? shaderCode.find('\n') + 1 : 0;
+            shaderCode.insert(versionEnd, defineBlock);
         }
 
         // Compile shader source and attach to program
@@ -63,6 +67,50 @@ void Shader::compileProgram(const std::vector<TypedShader>& shaders)
     // Finally link the program
     glLinkProgram(ID);
     checkCompileErrors(ID, "PROGRAM");
+
+    // Recompiling releases the previous program of this shader
+    ResourceHandle program = ResourceManager::instance().adopt(ResourceType::Program, ResourceCategory::Shader, ID, 0,
+        shaders.empty() ? "" : shaders.front().second);
+    m_program = std::make_shared<GpuResource>(program);
+    m_uniformLocationCache.clear();
+}
+
+/* Reads a shader file, replacing any #include "file" lines with the contents of that file.
+    Included paths are relative to the including file's directory */
+std::string Shader::readShaderFile(const std::string& path)
+{
+    std::string shaderCode;
+    std::ifstream shaderFile;
+    shaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+    try {
+        shaderFile.open(path);
+        std::stringstream shaderStream;
+        shaderStream << shaderFile.rdbuf();
+        shaderFile.close();
+        shaderCode = shaderStream.str();
+    }
+    catch (std::ifstream::failure e) {
+        std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ: " << path << "\n";
+        return shaderCode;
+    }
+
+    auto dirEnd = path.find_last_of('/');
+    std::string directory = dirEnd == std::string::npos ? "" : path.substr(0, dirEnd + 1);
+
+    std::stringstream source(shaderCode);
+    std::string line, result;
+    while (std::getline(source, line)) {
+        if (line.rfind("#include", 0) == 0) {
+            auto first = line.find('"');
+            auto last = line.find_last_of('"');
+            if (first != std::string::npos && last > first) {
+                result += readShaderFile(directory + line.substr(first + 1, last - first - 1));
+                continue;
+            }
+        }
+        result += line + '\n';
+    }
+    return result;
 }
 
 // activate the shader
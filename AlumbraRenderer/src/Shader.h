@@ -1,5 +1,7 @@
 #pragma once
 
+#include "ResourceManager.h"
+
 #include <unordered_map>
 
 using TypedShader = std::pair<GLenum, std::string>;
@@ -11,8 +13,10 @@ public:
 
     Shader() = default;
 
-    void graphicsShaders(const std::vector<std::string>& shaderFiles);
-    void compileProgram(const std::vector<TypedShader>& shaders);
+    void graphicsShaders(const std::vector<std::string>& shaderFiles,
+        const std::vector<std::string>& defines = {});
+    void computeShader(const std::string& shaderFile, const std::vector<std::string>& defines = {});
+    void compileProgram(const std::vector<TypedShader>& shaders, const std::vector<std::string>& defines = {});
 
     void use() const;
     unsigned int getUniformLocation(const std::string& name) const;
@@ -31,6 +35,9 @@ public:
     void setMat4(const std::string& name, const glm::mat4& mat) const;
 
 private:
+    // Shaders are passed around by value, the program is released once no copy is left
+    std::shared_ptr<GpuResource> m_program;
     mutable std::unordered_map<std::string, unsigned int> m_uniformLocationCache;
     void checkCompileErrors(GLuint shader, std::string type);
+    std::string readShaderFile(const std::string& path);
 };
\ No newline at end of file
@@ -0,0 +1,385 @@
+#include "pch.h"
+#include "SoftwareOcclusion.h"
+#include "Profiler.h"
+#include "mesh/Model.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+// SSE2 is part of x86-64, other targets take the scalar loops
+#if defined(_M_X64) || defined(__x86_64__)
+#define OCCLUSION_SSE 1
+#include <emmintrin.h>
+#endif
+
+// Objects tested per job
+static constexpr unsigned int TEST_BATCH = 64;
+// Slack on the nearest depth of tested bounds, so bounds flush with an occluder's surface are
+// not hidden by the rounding of its interpolated depth
+static constexpr float DEPTH_BIAS = 1e-5f;
+
+/* Snaps vertices to a resolution^3 grid over the bounds, each cell becomes the average of its
+    vertices and triangles that collapse are dropped */
+static OccluderMesh clusterVertices(const OccluderMesh& mesh, const AABB& bounds, int resolution)
+{
+    glm::vec3 cellScale = (float)resolution / glm::max(bounds.max - bounds.min, glm::vec3(1e-6f));
+    std::unordered_map<unsigned int, unsigned int> cellVertices;
+    std::vector<unsigned int> remap(mesh.positions.size());
+    std::vector<glm::vec3> sums;
+    std::vector<float> counts;
+    for (size_t i = 0; i < mesh.positions.size(); i++) {
+        glm::ivec3 cell = glm::clamp(glm::ivec3((mesh.positions[i] - bounds.min) * cellScale), 0, resolution - 1);
+        unsigned int key = (cell.z * resolution + cell.y) * resolution + cell.x;
+        auto inserted = cellVertices.emplace(key, (unsigned int)sums.size());
+        if (inserted.second) {
+            sums.push_back(glm::vec3(0.0f));
+            counts.push_back(0.0f);
+        }
+        unsigned int vertex = inserted.first->second;
+        sums[vertex] += mesh.positions[i];
+        counts[vertex] += 1.0f;
+        remap[i] = vertex;
+    }
+
+    OccluderMesh clustered;
+    for (size_t i = 0; i < sums.size(); i++)
+        clustered.positions.push_back(sums[i] / counts[i]);
+    for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+        unsigned int a = remap[mesh.indices[i]], b = remap[mesh.indices[i + 1]], c = remap[mesh.indices[i + 2]];
+        if (a == b || b == c || c == a)
+            continue;
+        clustered.indices.insert(clustered.indices.end(), { a, b, c });
+    }
+    return clustered;
+}
+
+SoftwareOcclusion::SoftwareOcclusion()
+{
+}
+
+SoftwareOcclusion::~SoftwareOcclusion()
+{
+}
+
+void SoftwareOcclusion::setup(int width, int height)
+{
+    m_tilesX = std::max((width + TILE_SIZE - 1) / TILE_SIZE, 1);
+    m_tilesY = std::max((height + TILE_SIZE - 1) / TILE_SIZE, 1);
+    m_width = m_tilesX * TILE_SIZE;
+    m_height = m_tilesY * TILE_SIZE;
+    m_blocksX = m_width / BLOCK_SIZE;
+    m_depth.assign(m_width * m_height, 1.0f);
+    m_blockDepth.assign(m_blocksX * (m_height / BLOCK_SIZE), 1.0f);
+}
+
+void SoftwareOcclusion::render(JobSystem& jobs, const glm::mat4& viewProjection,
+    const std::vector<OccluderInstance>& occluders)
+{
+    PROFILE_FUNCTION();
+    m_viewProjection = viewProjection;
+    m_stats = OcclusionStats();
+    m_stats.occluders = (unsigned int)occluders.size();
+    m_occluderObjects.clear();
+    for (const auto& occluder : occluders)
+        m_occluderObjects.push_back(occluder.object);
+
+    // A couple of setup jobs per thread balances occluders of different sizes
+    unsigned int tileCount = m_tilesX * m_tilesY;
+    m_binCount = std::min((unsigned int)occluders.size(), jobs.threadCount() * 2);
+    if (m_bins.size() < m_binCount)
+        m_bins.resize(m_binCount);
+    jobs.parallelFor(m_binCount, [&](unsigned int i) {
+        TriangleBin& bin = m_bins[i];
+        bin.triangles.clear();
+        bin.tiles.resize(tileCount);
+        for (auto& tile : bin.tiles)
+            tile.clear();
+        size_t first = occluders.size() * i / m_binCount, last = occluders.size() * (i + 1) / m_binCount;
+        setupTriangles(bin, occluders.data() + first, occluders.data() + last);
+    });
+    for (unsigned int i = 0; i < m_binCount; i++)
+        m_stats.triangles += (unsigned int)m_bins[i].triangles.size();
+
+    jobs.parallelFor(tileCount, [this](unsigned int tile) { rasterizeTile(tile); });
+}
+
+void SoftwareOcclusion::filter(JobSystem& jobs, std::vector<unsigned int>& objects, const std::vector<AABB>& worldBounds)
+{
+    PROFILE_FUNCTION();
+    m_stats.tested = (unsigned int)objects.size();
+    m_stats.rejected = 0;
+    if (m_stats.triangles == 0)
+        return;
+
+    m_objectOccluder.assign(worldBounds.size(), 0);
+    for (unsigned int object : m_occluderObjects) {
+        if (object < worldBounds.size())
+            m_objectOccluder[object] = 1;
+    }
+    m_objectVisible.resize(objects.size());
+    unsigned int batches = ((unsigned int)objects.size() + TEST_BATCH - 1) / TEST_BATCH;
+    jobs.parallelFor(batches, [&](unsigned int batch) {
+        size_t last = std::min(objects.size(), (size_t)(batch + 1) * TEST_BATCH);
+        for (size_t i = batch * TEST_BATCH; i < last; i++)
+            m_objectVisible[i] = m_objectOccluder[objects[i]] || boundsVisible(worldBounds[objects[i]]);
+    });
+
+    size_t kept = 0;
+    for (size_t i = 0; i < objects.size(); i++) {
+        if (m_objectVisible[i])
+            objects[kept++] = objects[i];
+    }
+    m_stats.rejected = (unsigned int)(objects.size() - kept);
+    objects.resize(kept);
+}
+
+OccluderMesh SoftwareOcclusion::buildOccluder(const Model& model, unsigned int triangleBudget)
+{
+    // The finest level of detail that fits the budget, else the coarsest one is clustered
+    unsigned int lodCount = 1;
+    for (const auto& part : model.meshes())
+        lodCount = std::max(lodCount, part->lodCount());
+    std::vector<unsigned int> lods(model.meshes().size(), 0);
+    for (unsigned int lod = 0; lod < lodCount; lod++) {
+        std::fill(lods.begin(), lods.end(), lod);
+        if (model.triangleCount(lods.data()) <= triangleBudget)
+            break;
+    }
+
+    OccluderMesh mesh;
+    for (unsigned int i = 0; i < model.meshes().size(); i++) {
+        model.meshes()[i]->requireCpuData();
+        const Mesh& part = *model.meshes()[i];
+        const MeshLod& range = part.m_lods[std::min(lods[i], part.lodCount() - 1)];
+        unsigned int base = (unsigned int)mesh.positions.size();
+        mesh.positions.insert(mesh.positions.end(), part.m_positions.begin(), part.m_positions.end());
+        for (unsigned int j = range.firstIndex; j < range.firstIndex + range.indexCount; j++)
+            mesh.indices.push_back(base + (part.m_indices.empty() ? j : part.m_indices[j]));
+    }
+    if (mesh.indices.size() / 3 <= triangleBudget)
+        return mesh;
+
+    // Coarsen the grid until the result fits, clustering can move the surface slightly so
+    // occluders should stay well inside the objects they stand for
+    AABB bounds = AABB::fromPoints(mesh.positions);
+    OccluderMesh clustered;
+    for (int resolution = 64; resolution >= 2; resolution /= 2) {
+        clustered = clusterVertices(mesh, bounds, resolution);
+        if (clustered.indices.size() / 3 <= triangleBudget)
+            break;
+    }
+    return clustered;
+}
+
+void SoftwareOcclusion::setupTriangles(TriangleBin& bin, const OccluderInstance* first, const OccluderInstance* last)
+{
+    PROFILE_SCOPE("Occluder Setup");
+    for (const OccluderInstance* occluder = first; occluder != last; occluder++) {
+        glm::mat4 modelViewProjection = m_viewProjection * occluder->model;
+        const auto& positions = occluder->mesh->positions;
+        bin.clipPositions.resize(positions.size());
+        for (size_t i = 0; i < positions.size(); i++)
+            bin.clipPositions[i] = modelViewProjection * glm::vec4(positions[i], 1.0f);
+
+        const auto& indices = occluder->mesh->indices;
+        for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+            const glm::vec4& a = bin.clipPositions[indices[i]];
+            const glm::vec4& b = bin.clipPositions[indices[i + 1]];
+            const glm::vec4& c = bin.clipPositions[indices[i + 2]];
+            // All three vertices outside the same side plane
+            if ((a.x > a.w && b.x > b.w && c.x > c.w) || (a.x < -a.w && b.x < -b.w && c.x < -c.w)
+                || (a.y > a.w && b.y > b.w && c.y > c.w) || (a.y < -a.w && b.y < -b.w && c.y < -c.w))
+                continue;
+
+            // Distance to the near plane, triangles crossing it are clipped into one or two
+            float distances[3] = { a.z + a.w, b.z + b.w, c.z + c.w };
+            if (distances[0] >= 0.0f && distances[1] >= 0.0f && distances[2] >= 0.0f) {
+                binTriangle(bin, a, b, c);
+                continue;
+            }
+            if (distances[0] < 0.0f && distances[1] < 0.0f && distances[2] < 0.0f)
+                continue;
+            const glm::vec4 vertices[3] = { a, b, c };
+            glm::vec4 polygon[4];
+            int count = 0;
+            for (int j = 0; j < 3; j++) {
+                int k = (j + 1) % 3;
+                if (distances[j] >= 0.0f)
+                    polygon[count++] = vertices[j];
+                if ((distances[j] >= 0.0f) != (distances[k] >= 0.0f))
+                    polygon[count++] = glm::mix(vertices[j], vertices[k], distances[j] / (distances[j] - distances[k]));
+            }
+            for (int j = 1; j + 1 < count; j++)
+                binTriangle(bin, polygon[0], polygon[j], polygon[j + 1]);
+        }
+    }
+}
+
+/* Projects to pixels, drops back facing triangles and lists the rest in every tile their
+    bounding rectangle touches */
+void SoftwareOcclusion::binTriangle(TriangleBin& bin, const glm::vec4& a, const glm::vec4& b, const glm::vec4& c)
+{
+    ScreenTriangle triangle;
+    const glm::vec4* clip[3] = { &a, &b, &c };
+    for (int i = 0; i < 3; i++) {
+        glm::vec3 ndc = glm::vec3(*clip[i]) / clip[i]->w;
+        triangle.v[i] = glm::vec3((ndc.x * 0.5f + 0.5f) * m_width, (ndc.y * 0.5f + 0.5f) * m_height, ndc.z * 0.5f + 0.5f);
+    }
+    const glm::vec3& v0 = triangle.v[0];
+    const glm::vec3& v1 = triangle.v[1];
+    const glm::vec3& v2 = triangle.v[2];
+    float area = (v1.x - v0.x) * (v2.y - v0.y) - (v2.x - v0.x) * (v1.y - v0.y);
+    // Also rejects degenerate and NaN triangles
+    if (!(area > 0.0f))
+        return;
+
+    float minX = std::min({ v0.x, v1.x, v2.x }), maxX = std::max({ v0.x, v1.x, v2.x });
+    float minY = std::min({ v0.y, v1.y, v2.y }), maxY = std::max({ v0.y, v1.y, v2.y });
+    if (maxX < 0.0f || maxY < 0.0f || minX >= m_width || minY >= m_height)
+        return;
+    int tileX0 = (int)std::max(minX, 0.0f) / TILE_SIZE, tileX1 = (int)std::min(maxX, m_width - 1.0f) / TILE_SIZE;
+    int tileY0 = (int)std::max(minY, 0.0f) / TILE_SIZE, tileY1 = (int)std::min(maxY, m_height - 1.0f) / TILE_SIZE;
+
+    unsigned int index = (unsigned int)bin.triangles.size();
+    bin.triangles.push_back(triangle);
+    for (int y = tileY0; y <= tileY1; y++) {
+        for (int x = tileX0; x <= tileX1; x++)
+            bin.tiles[y * m_tilesX + x].push_back(index);
+    }
+}
+
+void SoftwareOcclusion::rasterizeTile(int tile)
+{
+    PROFILE_SCOPE("Occluder Tile");
+    int x0 = (tile % m_tilesX) * TILE_SIZE, y0 = (tile / m_tilesX) * TILE_SIZE;
+    int x1 = x0 + TILE_SIZE, y1 = y0 + TILE_SIZE;
+    for (int y = y0; y < y1; y++)
+        std::fill_n(m_depth.begin() + y * m_width + x0, TILE_SIZE, 1.0f);
+
+    for (unsigned int i = 0; i < m_binCount; i++) {
+        const TriangleBin& bin = m_bins[i];
+        for (unsigned int index : bin.tiles[tile])
+            rasterizeTriangle(bin.triangles[index], x0, y0, x1, y1);
+    }
+
+    for (int blockY = y0; blockY < y1; blockY += BLOCK_SIZE) {
+        for (int blockX = x0; blockX < x1; blockX += BLOCK_SIZE) {
+            float farthest = 0.0f;
+            for (int y = blockY; y < blockY + BLOCK_SIZE; y++) {
+                for (int x = blockX; x < blockX + BLOCK_SIZE; x++)
+                    farthest = std::max(farthest, m_depth[y * m_width + x]);
+            }
+            m_blockDepth[(blockY / BLOCK_SIZE) * m_blocksX + blockX / BLOCK_SIZE] = farthest;
+        }
+    }
+}
+
+/* Half space rasterization of the triangle's pixels inside the tile [x0, x1) x [y0, y1), depth
+    is interpolated linearly in screen space where z/w is affine. The depth plane is evaluated
+    relative to the first vertex, an absolute constant term loses most of the depth's precision
+    to cancellation */
+void SoftwareOcclusion::rasterizeTriangle(const ScreenTriangle& triangle, int x0, int y0, int x1, int y1)
+{
+    const glm::vec3& v0 = triangle.v[0];
+    const glm::vec3& v1 = triangle.v[1];
+    const glm::vec3& v2 = triangle.v[2];
+    float invArea = 1.0f / ((v1.x - v0.x) * (v2.y - v0.y) - (v2.x - v0.x) * (v1.y - v0.y));
+
+    // Edge functions a * x + b * y + c, positive inside, edge i is opposite vertex i
+    float a0 = v1.y - v2.y, b0 = v2.x - v1.x, c0 = v1.x * v2.y - v2.x * v1.y;
+    float a1 = v2.y - v0.y, b1 = v0.x - v2.x, c1 = v2.x * v0.y - v0.x * v2.y;
+    float a2 = v0.y - v1.y, b2 = v1.x - v0.x, c2 = v0.x * v1.y - v1.x * v0.y;
+    float za = (a0 * v0.z + a1 * v1.z + a2 * v2.z) * invArea;
+    float zb = (b0 * v0.z + b1 * v1.z + b2 * v2.z) * invArea;
+
+    // Pixel rectangle, starting on a multiple of four so rows are processed in whole groups
+    float minX = std::min({ v0.x, v1.x, v2.x }), maxX = std::max({ v0.x, v1.x, v2.x });
+    float minY = std::min({ v0.y, v1.y, v2.y }), maxY = std::max({ v0.y, v1.y, v2.y });
+    int startX = (int)glm::clamp(minX, (float)x0, (float)(x1 - 1)) & ~3;
+    int endX = (int)glm::clamp(maxX, (float)x0, (float)(x1 - 1));
+    int startY = (int)glm::clamp(minY, (float)y0, (float)(y1 - 1));
+    int endY = (int)glm::clamp(maxY, (float)y0, (float)(y1 - 1));
+
+#ifdef OCCLUSION_SSE
+    const __m128 laneOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+    const __m128 edgeA0 = _mm_set1_ps(a0), edgeA1 = _mm_set1_ps(a1), edgeA2 = _mm_set1_ps(a2);
+    const __m128 depthA = _mm_set1_ps(za), originX = _mm_set1_ps(v0.x), zero = _mm_setzero_ps();
+    for (int y = startY; y <= endY; y++) {
+        float py = y + 0.5f;
+        __m128 row0 = _mm_set1_ps(b0 * py + c0), row1 = _mm_set1_ps(b1 * py + c1), row2 = _mm_set1_ps(b2 * py + c2);
+        __m128 rowDepth = _mm_set1_ps(v0.z + zb * (py - v0.y));
+        float* depthRow = m_depth.data() + y * m_width;
+        for (int x = startX; x <= endX; x += 4) {
+            __m128 px = _mm_add_ps(_mm_set1_ps((float)x), laneOffsets);
+            __m128 e0 = _mm_add_ps(_mm_mul_ps(edgeA0, px), row0);
+            __m128 e1 = _mm_add_ps(_mm_mul_ps(edgeA1, px), row1);
+            __m128 e2 = _mm_add_ps(_mm_mul_ps(edgeA2, px), row2);
+            __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)), _mm_cmpge_ps(e2, zero));
+            if (_mm_movemask_ps(inside) == 0)
+                continue;
+            __m128 z = _mm_add_ps(_mm_mul_ps(depthA, _mm_sub_ps(px, originX)), rowDepth);
+            __m128 depth = _mm_loadu_ps(depthRow + x);
+            __m128 closer = _mm_min_ps(depth, z);
+            _mm_storeu_ps(depthRow + x, _mm_or_ps(_mm_and_ps(inside, closer), _mm_andnot_ps(inside, depth)));
+        }
+    }
+#else
+    for (int y = startY; y <= endY; y++) {
+        float py = y + 0.5f;
+        float* depthRow = m_depth.data() + y * m_width;
+        for (int x = startX; x <= endX; x++) {
+            float px = x + 0.5f;
+            if (a0 * px + b0 * py + c0 < 0.0f || a1 * px + b1 * py + c1 < 0.0f || a2 * px + b2 * py + c2 < 0.0f)
+                continue;
+            depthRow[x] = std::min(depthRow[x], v0.z + za * (px - v0.x) + zb * (py - v0.y));
+        }
+    }
+#endif
+}
+
+/* Hidden when every pixel the projected bounds cover already holds something closer than the
+    nearest point of the bounds */
+bool SoftwareOcclusion::boundsVisible(const AABB& bounds) const
+{
+    // Corners are the transformed center plus or minus the transformed half axes
+    glm::vec3 extents = bounds.extents();
+    glm::vec4 center = m_viewProjection * glm::vec4(bounds.center(), 1.0f);
+    glm::vec4 axisX = m_viewProjection[0] * extents.x, axisY = m_viewProjection[1] * extents.y,
+        axisZ = m_viewProjection[2] * extents.z;
+    glm::vec3 minNdc(std::numeric_limits<float>::max()), maxNdc(-std::numeric_limits<float>::max());
+    for (int i = 0; i < 8; i++) {
+        glm::vec4 clip = center + ((i & 1) ? axisX : -axisX) + ((i & 2) ? axisY : -axisY) + ((i & 4) ? axisZ : -axisZ);
+        // Crossing the near plane, the bounds could cover the whole screen
+        if (clip.w <= 0.0f || clip.z < -clip.w)
+            return true;
+        glm::vec3 ndc = glm::vec3(clip) / clip.w;
+        minNdc = glm::min(minNdc, ndc);
+        maxNdc = glm::max(maxNdc, ndc);
+    }
+    // Off screen objects are left to frustum culling
+    if (maxNdc.x < -1.0f || maxNdc.y < -1.0f || minNdc.x > 1.0f || minNdc.y > 1.0f)
+        return true;
+
+    int x0 = (int)glm::clamp((minNdc.x * 0.5f + 0.5f) * m_width, 0.0f, m_width - 1.0f);
+    int x1 = (int)glm::clamp((maxNdc.x * 0.5f + 0.5f) * m_width, 0.0f, m_width - 1.0f);
+    int y0 = (int)glm::clamp((minNdc.y * 0.5f + 0.5f) * m_height, 0.0f, m_height - 1.0f);
+    int y1 = (int)glm::clamp((maxNdc.y * 0.5f + 0.5f) * m_height, 0.0f, m_height - 1.0f);
+    float nearest = minNdc.z * 0.5f + 0.5f - DEPTH_BIAS;
+
+    for (int blockY = y0 / BLOCK_SIZE; blockY <= y1 / BLOCK_SIZE; blockY++) {
+        for (int blockX = x0 / BLOCK_SIZE; blockX <= x1 / BLOCK_SIZE; blockX++) {
+            // Everything in the block is closer
+            if (m_blockDepth[blockY * m_blocksX + blockX] < nearest)
+                continue;
+            int startX = std::max(x0, blockX * BLOCK_SIZE), endX = std::min(x1, blockX * BLOCK_SIZE + BLOCK_SIZE - 1);
+            int startY = std::max(y0, blockY * BLOCK_SIZE), endY = std::min(y1, blockY * BLOCK_SIZE + BLOCK_SIZE - 1);
+            for (int y = startY; y <= endY; y++) {
+                for (int x = startX; x <= endX; x++) {
+                    if (m_depth[y * m_width + x] >= nearest)
+                        return true;
+                }
+            }
+        }
+    }
+    return false;
+}
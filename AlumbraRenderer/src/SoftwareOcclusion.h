@@ -0,0 +1,102 @@
+#pragma once
+
+#include "Bounds.h"
+#include "JobSystem.h"
+
+class Model;
+
+struct SoftwareOcclusionSettings {
+    bool enabled = true;
+    // Depth buffer resolution, rounded up to whole tiles
+    int width = 256;
+    int height = 128;
+    // Occluder models with more triangles use a coarser level of detail or vertex clustering
+    unsigned int triangleBudget = 256;
+};
+
+/* Position only geometry rasterized into the occlusion depth buffer */
+struct OccluderMesh {
+    std::vector<glm::vec3> positions;
+    std::vector<unsigned int> indices;
+};
+
+struct OccluderInstance {
+    const OccluderMesh* mesh;
+    glm::mat4 model;
+    // Object index of the occluder in the bounds given to filter, which never tests it
+    unsigned int object = ~0u;
+};
+
+// Work done and objects rejected by the last frame
+struct OcclusionStats {
+    unsigned int occluders = 0;
+    // Triangles left after near clipping and back face culling
+    unsigned int triangles = 0;
+    unsigned int tested = 0;
+    unsigned int rejected = 0;
+};
+
+/**
+ * CPU occlusion culling without GPU readback latency. Occluder triangles are transformed,
+ * near clipped and back face culled in parallel jobs that each bin their triangles into the
+ * screen tiles they touch, then every tile is cleared and rasterized by its own job, four
+ * pixels at a time with SSE, into a small depth buffer. Each tile also stores the farthest
+ * depth of its 8x8 blocks, so testing an object's bounds usually only needs a few block
+ * reads before falling back to pixels.
+ */
+class SoftwareOcclusion {
+public:
+    static constexpr int TILE_SIZE = 32;
+    static constexpr int BLOCK_SIZE = 8;
+
+    SoftwareOcclusion();
+    ~SoftwareOcclusion();
+
+    void setup(int width, int height);
+    /* Clears the depth buffer and rasterizes the occluders seen through viewProjection */
+    void render(JobSystem& jobs, const glm::mat4& viewProjection, const std::vector<OccluderInstance>& occluders);
+    /* Removes the objects whose world bounds are hidden by the occluders, keeping the order.
+        Occluders are always kept, their own triangles would hide their bounds */
+    void filter(JobSystem& jobs, std::vector<unsigned int>& objects, const std::vector<AABB>& worldBounds);
+
+    /* Merges the meshes of a model at the finest level of detail within the budget, simplified
+        by vertex clustering when even the coarsest one is over it */
+    static OccluderMesh buildOccluder(const Model& model, unsigned int triangleBudget);
+
+    inline const OcclusionStats& stats() const { return m_stats; }
+    inline int width() const { return m_width; }
+    inline int height() const { return m_height; }
+    // Row major, bottom row first, 0 at the near and 1 at the far plane
+    inline const std::vector<float>& depth() const { return m_depth; }
+
+private:
+    // x and y in pixels, z in [0, 1], counter clockwise
+    struct ScreenTriangle {
+        glm::vec3 v[3];
+    };
+    // Output of one setup job, triangle indices are listed per tile
+    struct TriangleBin {
+        std::vector<ScreenTriangle> triangles;
+        std::vector<std::vector<unsigned int>> tiles;
+        std::vector<glm::vec4> clipPositions;
+    };
+
+    int m_width = 0, m_height = 0;
+    int m_tilesX = 0, m_tilesY = 0, m_blocksX = 0;
+    std::vector<float> m_depth;
+    // Farthest depth of every block
+    std::vector<float> m_blockDepth;
+    std::vector<TriangleBin> m_bins;
+    unsigned int m_binCount = 0;
+    glm::mat4 m_viewProjection = glm::mat4(1.0f);
+    std::vector<unsigned char> m_objectVisible;
+    std::vector<unsigned int> m_occluderObjects;
+    std::vector<unsigned char> m_objectOccluder;
+    OcclusionStats m_stats;
+
+    void setupTriangles(TriangleBin& bin, const OccluderInstance* first, const OccluderInstance* last);
+    void binTriangle(TriangleBin& bin, const glm::vec4& a, const glm::vec4& b, const glm::vec4& c);
+    void rasterizeTile(int tile);
+    void rasterizeTriangle(const ScreenTriangle& triangle, int x0, int y0, int x1, int y1);
+    bool boundsVisible(const AABB& bounds) const;
+};
@@ -0,0 +1,79 @@
+#include "pch.h"
+#include "TemporalAA.h"
+
+TemporalAA::TemporalAA()
+{
+    glCreateFramebuffers(1, &m_framebufferID);
+}
+
+TemporalAA::~TemporalAA() {}
+
+/* Allocates the two output resolution history textures that are written in turns */
+void TemporalAA::setup(int width, int height, GLenum format)
+{
+    ResourceManager& resources = ResourceManager::instance();
+    for (auto& history : m_history) {
+        history = GpuResource(resources.createTexture(ResourceCategory::RenderTarget, GL_TEXTURE_2D, "TAA History"));
+        GLuint texture = history.id();
+        glTextureStorage2D(texture, 1, format, width, height);
+        glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTextureParameteri(texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTextureParameteri(texture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        resources.measureTexture(history.handle());
+    }
+    m_size = glm::ivec2(width, height);
+    m_historyValid = false;
+}
+
+glm::vec2 TemporalAA::nextJitter(const TemporalAASettings& settings)
+{
+    if (!settings.enabled)
+        return glm::vec2(0.0f);
+    // Halton indices start at 1, index 0 would always be the pixel corner
+    unsigned int index = m_jitterIndex++ % std::max(settings.jitterSamples, 1) + 1;
+    return glm::vec2(halton(index, 2), halton(index, 3)) - 0.5f;
+}
+
+/* Resolves the current frame into the next history texture and returns it. The scene is
+    read from the renderSize corner of its texture, the output always covers the full
+    history. Expects a screen quad VAO to be bound and the shader's samplers to be set to units
+    0-3 in argument order followed by the history, leaves the TAA framebuffer bound */
+GLuint TemporalAA::resolve(const Shader& resolveShader, GLuint sceneTexture, GLuint velocityTexture,
+    GLuint depthTexture, glm::ivec2 renderSize, glm::vec2 jitter, const glm::mat4& skyReprojection,
+    const TemporalAASettings& settings)
+{
+    int previous = m_current;
+    m_current = 1 - m_current;
+    glNamedFramebufferTexture(m_framebufferID, GL_COLOR_ATTACHMENT0, m_history[m_current].id(), 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_framebufferID);
+    glViewport(0, 0, m_size.x, m_size.y);
+
+    resolveShader.use();
+    resolveShader.setVec2("renderSize", glm::vec2(renderSize));
+    resolveShader.setVec2("outputSize", glm::vec2(m_size));
+    resolveShader.setVec2("jitter", jitter);
+    resolveShader.setMat4("skyReprojection", skyReprojection);
+    resolveShader.setFloat("historyWeight", m_historyValid ? settings.historyWeight : 0.0f);
+    glBindTextureUnit(0, sceneTexture);
+    glBindTextureUnit(1, velocityTexture);
+    glBindTextureUnit(2, depthTexture);
+    glBindTextureUnit(3, m_history[previous].id());
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+
+    m_historyValid = true;
+    return m_history[m_current].id();
+}
+
+/* Radical inverse of index in the given base */
+float TemporalAA::halton(unsigned int index, unsigned int base)
+{
+    float result = 0.0f;
+    float fraction = 1.0f;
+    while (index > 0) {
+        fraction /= base;
+        result += fraction * (index % base);
+        index /= base;
+    }
+    return result;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "Shader.h"
+
+struct TemporalAASettings {
+    bool enabled = false;
+    // Weight of the reprojected history, higher is smoother but reacts slower
+    float historyWeight = 0.9f;
+    // Length of the Halton jitter sequence
+    int jitterSamples = 8;
+};
+
+/**
+ * Temporal anti-aliasing and upsampling. The projection is offset by a sub-pixel Halton
+ * jitter every frame, and the resolve pass reprojects an output resolution history with
+ * the G-buffer velocity, clips it to the current frame's YCoCg neighborhood and blends in
+ * the new samples. The current frame can be rendered below the output resolution, the
+ * history accumulates the jittered samples back up to full resolution.
+ */
+class TemporalAA {
+public:
+    TemporalAA();
+    ~TemporalAA();
+
+    void setup(int width, int height, GLenum format = GL_RGBA16F);
+    /* Jitter for the next frame in render pixels, both components in [-0.5, 0.5] */
+    glm::vec2 nextJitter(const TemporalAASettings& settings);
+    GLuint resolve(const Shader& resolveShader, GLuint sceneTexture, GLuint velocityTexture, GLuint depthTexture,
+        glm::ivec2 renderSize, glm::vec2 jitter, const glm::mat4& skyReprojection,
+        const TemporalAASettings& settings);
+
+    // Drops the history, e.g. after a scene change or a camera cut
+    inline void invalidateHistory() { m_historyValid = false; }
+
+private:
+    GLuint m_framebufferID;
+    GpuResource m_history[2];
+    int m_current = 0;
+    glm::ivec2 m_size = glm::ivec2(0);
+    bool m_historyValid = false;
+    unsigned int m_jitterIndex = 0;
+
+    static float halton(unsigned int index, unsigned int base);
+};
@@ -25,11 +25,52 @@ GLuint TextureLoader::emptyTexture(GLenum format, GLsizei width, GLsizei height,
 }
 
 GLuint TextureLoader::fileTexture(const std::string& path)
+{
+    std::vector<unsigned char> bytes;
+    if (!readFile(path, bytes)) {
+        m_path = path;
+        std::cout << "Texture failed to load at path: " << path << std::endl;
+        return m_textureID;
+    }
+    return memoryTexture(bytes.data(), bytes.size(), path);
+}
+
+/* 2x2 box filter over 8 bit channels, an odd last row or column is dropped */
+static std::vector<unsigned char> halveImage(const unsigned char* pixels, int& width, int& height, int channels)
+{
+    int halfWidth = width / 2, halfHeight = height / 2;
+    std::vector<unsigned char> result((size_t)halfWidth * halfHeight * channels);
+    for (int y = 0; y < halfHeight; y++) {
+        const unsigned char* row0 = pixels + (size_t)(2 * y) * width * channels;
+        const unsigned char* row1 = row0 + (size_t)width * channels;
+        unsigned char* out = result.data() + (size_t)y * halfWidth * channels;
+        for (int x = 0; x < halfWidth; x++) {
+            for (int c = 0; c < channels; c++) {
+                int sum = row0[2 * x * channels + c] + row0[(2 * x + 1) * channels + c]
+                    + row1[2 * x * channels + c] + row1[(2 * x + 1) * channels + c];
+                out[x * channels + c] = (unsigned char)((sum + 2) / 4);
+            }
+        }
+    }
+    width = halfWidth;
+    height = halfHeight;
+    return result;
+}
+
+GLuint TextureLoader::memoryTexture(const unsigned char* bytes, size_t size, const std::string& path,
+    unsigned int downscale)
 {
     m_path = path;
     int width, height, nrComponents;
-    unsigned char* data = stbi_load(path.c_str(), &width, &height, &nrComponents, 0);
+    unsigned char* data = stbi_load_from_memory(bytes, (int)size, &width, &height, &nrComponents, 0);
     if (data) {
+        const unsigned char* pixels = data;
+        std::vector<unsigned char> halved;
+        for (unsigned int i = 0; i < downscale && width > 1 && height > 1; i++) {
+            halved = halveImage(pixels, width, height, nrComponents);
+            pixels = halved.data();
+        }
+
         GLenum internalFormat, format;
         if (nrComponents == 1) {
             format = GL_RED;
@@ -47,7 +88,10 @@ GLuint TextureLoader::fileTexture(const std::string& path)
             std::cout << "Texture Error: Unsupported image format\n";
 
         glTextureStorage2D(m_textureID, 1, internalFormat, width, height);
-        glTextureSubImage2D(m_textureID, 0, 0, 0, width, height, format, GL_UNSIGNED_BYTE, data);
+        // Rows are tightly packed, halved or odd width RGB images are not 4 byte aligned
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTextureSubImage2D(m_textureID, 0, 0, 0, width, height, format, GL_UNSIGNED_BYTE, pixels);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
         glGenerateTextureMipmap(m_textureID);
 
         stbi_image_free(data);
@@ -62,4 +106,13 @@ GLuint TextureLoader::fileTexture(const std::string& path)
 void TextureLoader::bind(int index)
 {
     glBindTextureUnit(index, m_textureID);
-}
\ No newline at end of file
+}
+bool TextureLoader::readFile(const std::string& path, std::vector<unsigned char>& bytes)
+{
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file)
+        return false;
+    bytes.resize((size_t)file.tellg());
+    file.seekg(0);
+    return (bool)file.read(reinterpret_cast<char*>(bytes.data()), bytes.size());
+}
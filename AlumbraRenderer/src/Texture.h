@@ -1,5 +1,7 @@
 #pragma once
 
+#include "ResourceManager.h"
+
 struct TextureOptions {
     GLint minFilter;
     GLint magFilter;
@@ -11,6 +13,20 @@ struct TextureOptions {
         wrapS(GL_CLAMP_TO_EDGE), wrapT(GL_CLAMP_TO_EDGE), wrapR(GL_CLAMP_TO_EDGE) {}
 };
 
+/* GL texture shared through AssetRegistry handles, released with the last handle. MemoryBudget
+    may stream it at a fraction of its resolution or evict it, id is 0 while it is evicted */
+struct TextureAsset {
+    GLuint id = 0;
+    // Canonical path of the file it was loaded from
+    std::string path;
+    TextureOptions options;
+    GpuResource resource;
+    // Times the file's resolution was halved for the current upload
+    unsigned int downscale = 0;
+    // ResourceManager frame of the last draw binding it
+    unsigned long long lastUsedFrame = 0;
+};
+
 class TextureLoader {
 public:
     TextureLoader();
@@ -18,10 +34,16 @@ public:
     void createNew(GLenum target, const TextureOptions& texOps);
     GLuint emptyTexture(GLenum format, GLsizei width, GLsizei height, GLsizei levels = 1);
     GLuint fileTexture(const std::string& path);
+    /* Decodes an image file already read into memory, halving its resolution downscale times.
+        path is only kept for reference */
+    GLuint memoryTexture(const unsigned char* bytes, size_t size, const std::string& path,
+        unsigned int downscale = 0);
     void bind(int index);
     inline GLuint textureID() const { return m_textureID; }
     inline const std::string& path() { return m_path; }
 
+    static bool readFile(const std::string& path, std::vector<unsigned char>& bytes);
+
 private:
     GLuint m_textureID;
     std::string m_path;
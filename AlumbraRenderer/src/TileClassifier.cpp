@@ -0,0 +1,80 @@
+#include "pch.h"
+#include "TileClassifier.h"
+
+struct DrawArraysIndirectCommand {
+    GLuint count;
+    GLuint instanceCount;
+    GLuint first;
+    GLuint baseInstance;
+};
+
+TileClassifier::TileClassifier() {}
+
+TileClassifier::~TileClassifier() {}
+
+void TileClassifier::setup(int width, int height)
+{
+    m_width = width;
+    m_height = height;
+    m_tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+    m_tilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+    m_maxTiles = m_tilesX * m_tilesY;
+
+    // One list per class, each big enough to hold every tile
+    ResourceManager& resources = ResourceManager::instance();
+    m_tileListSSBO = GpuResource(resources.createBuffer(ResourceCategory::Other,
+        sizeof(GLuint) * m_maxTiles * TILE_CLASS_COUNT, nullptr, 0, "Tile Lists"));
+
+    m_commandBuffer = GpuResource(resources.createBuffer(ResourceCategory::Other,
+        sizeof(DrawArraysIndirectCommand) * TILE_CLASS_COUNT, nullptr, GL_DYNAMIC_STORAGE_BIT, "Tile Commands"));
+}
+
+/* Restricts classification to the top left corner of the G-buffer when rendering below the
+    resolution passed to setup */
+void TileClassifier::setRenderSize(int width, int height)
+{
+    m_width = width;
+    m_height = height;
+    m_tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+    m_tilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+}
+
+/* Fills the per-class tile lists and instance counts from the current G-buffer. Expects the
+    light clusters to be bound and culled for this frame */
+void TileClassifier::classify(const Shader& classifyShader, GLuint depthTexture, float zNear, float zFar)
+{
+    // Every tile is drawn as one instanced 6 vertex quad
+    DrawArraysIndirectCommand commands[TILE_CLASS_COUNT];
+    for (auto& command : commands)
+        command = { 6, 0, 0, 0 };
+    glNamedBufferSubData(m_commandBuffer.id(), 0, sizeof(commands), commands);
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 7, m_tileListSSBO.id());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 8, m_commandBuffer.id());
+
+    classifyShader.use();
+    classifyShader.setSampler("gDepth", 0);
+    classifyShader.setVec2("screenSize", glm::vec2(m_width, m_height));
+    classifyShader.setFloat("zNear", zNear);
+    classifyShader.setFloat("zFar", zFar);
+    classifyShader.setInt("tilesX", m_tilesX);
+    classifyShader.setInt("maxTiles", m_maxTiles);
+    glBindTextureUnit(0, depthTexture);
+
+    glDispatchCompute(m_tilesX, m_tilesY, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+}
+
+/* Draws every tile of the given class with the shader, which must use pbr_tile.vert */
+void TileClassifier::drawTiles(TileClass tileClass, const Shader& shader) const
+{
+    shader.setInt("tileListOffset", tileClass * m_maxTiles);
+    shader.setInt("tilesX", m_tilesX);
+    shader.setVec2("tileSize", glm::vec2(TILE_SIZE));
+    shader.setVec2("screenSize", glm::vec2(m_width, m_height));
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 7, m_tileListSSBO.id());
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandBuffer.id());
+    glDrawArraysIndirect(GL_TRIANGLES, (const void*)(tileClass * sizeof(DrawArraysIndirectCommand)));
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
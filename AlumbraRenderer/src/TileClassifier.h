@@ -0,0 +1,37 @@
+#pragma once
+
+#include "Shader.h"
+
+enum TileClass {
+    TILE_SKY = 0,
+    TILE_SIMPLE,
+    TILE_COMPLEX,
+    TILE_CLASS_COUNT
+};
+
+/**
+ * Classifies screen tiles from the G-buffer into sky, simple and complex with a compute
+ * pass. Each class gets its own tile list and indirect draw, so the lighting pass can skip
+ * sky tiles and run a cheaper shader variant on simple ones.
+ */
+class TileClassifier {
+public:
+    // Must match TILE_SIZE in shaders/tile_classify.comp
+    static constexpr int TILE_SIZE = 16;
+
+    TileClassifier();
+    ~TileClassifier();
+
+    void setup(int width, int height);
+    void setRenderSize(int width, int height);
+    void classify(const Shader& classifyShader, GLuint depthTexture, float zNear, float zFar);
+    void drawTiles(TileClass tileClass, const Shader& shader) const;
+
+private:
+    GpuResource m_tileListSSBO;
+    GpuResource m_commandBuffer;
+    int m_width = 0, m_height = 0;
+    int m_tilesX = 0, m_tilesY = 0;
+    // Tile count of the full allocation, the lists are laid out with this stride
+    int m_maxTiles = 0;
+};
@@ -1,43 +1,78 @@
 #include "pch.h"
 #include "Window.h"
 
+#ifdef ALUMBRA_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+#include <cstring>
+
 float lastX, lastY;
 bool firstMouse = true;
 
 int Window::s_width, Window::s_height;
 bool Window::s_cursorHidden;
+bool Window::s_recordingPath;
+bool Window::s_surfaceless;
 
-Window::Window(const char* title, int width, int height)
+Window::Window(const char* title, int width, int height, bool visible, int contextAPI)
 {
     m_title = title;
+    m_visible = visible;
+    m_contextAPI = contextAPI;
     s_width = width;
     s_height = height;
-    s_cursorHidden = true;
+    s_cursorHidden = visible;
+    s_recordingPath = false;
 
     lastX = (float)s_width / 2.0f;
     lastY = (float)s_height / 2.0f;
 
+    // A surfaceless context has no window to take input or show the GUI
+    if (surfaceless()) {
+        m_valid = initSurfaceless() && initGL();
+        return;
+    }
     if (!initGLFW()) {
         glfwTerminate();
+        return;
     }
     if (!initGL()) {
         glfwDestroyWindow(m_window);
         glfwTerminate();
+        return;
     }
+    m_valid = true;
     initImGUI();
 }
 
 Window::~Window()
 {
-    ImGui_ImplGlfw_Shutdown();
-    ImGui_ImplOpenGL3_Shutdown();
-    ImGui::DestroyContext();
+    if (surfaceless()) {
+        destroySurfaceless();
+        return;
+    }
+    if (m_valid) {
+        ImGui_ImplGlfw_Shutdown();
+        ImGui_ImplOpenGL3_Shutdown();
+        ImGui::DestroyContext();
 
-    glfwDestroyWindow(m_window);
+        glfwDestroyWindow(m_window);
+    }
     glfwTerminate();
 
 }
 
+void* Window::procAddress(const char* name)
+{
+#ifdef ALUMBRA_EGL
+    if (s_surfaceless)
+        return (void*)eglGetProcAddress(name);
+#endif
+    return (void*)glfwGetProcAddress(name);
+}
+
 bool Window::initGLFW()
 {
     // glfw: initialize and configure
@@ -46,6 +81,8 @@ bool Window::initGLFW()
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, m_visible ? GLFW_TRUE : GLFW_FALSE);
+    glfwWindowHint(GLFW_CONTEXT_CREATION_API, m_contextAPI);
 
     // glfw window creation
     // --------------------
@@ -65,18 +102,96 @@ bool Window::initGLFW()
     glfwSetKeyCallback(m_window, keyCallback);
 
     // tell GLFW to capture our mouse
-    glfwSetInputMode(m_window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+    if (m_visible)
+        glfwSetInputMode(m_window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+    return true;
+}
+
+/* Creates an OpenGL 4.5 core context on Mesa's surfaceless platform, which needs neither a
+    display server nor a GPU under llvmpipe. The context renders into a pbuffer of the window
+    size, which stands in for the default framebuffer the renderer presents to */
+bool Window::initSurfaceless()
+{
+#ifdef ALUMBRA_EGL
+    const char* extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    auto getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (extensions == nullptr || std::strstr(extensions, "EGL_MESA_platform_surfaceless") == nullptr
+        || getPlatformDisplay == nullptr) {
+        std::cout << "Failed to create surfaceless context: EGL_MESA_platform_surfaceless unsupported" << std::endl;
+        return false;
+    }
+    EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr)) {
+        std::cout << "Failed to initialize surfaceless EGL display" << std::endl;
+        return false;
+    }
+    m_eglDisplay = display;
+
+    const EGLint configAttribs[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_ALPHA_SIZE, 8,
+        EGL_DEPTH_SIZE, 24, EGL_STENCIL_SIZE, 8,
+        EGL_NONE
+    };
+    EGLConfig config;
+    EGLint configCount = 0;
+    if (!eglBindAPI(EGL_OPENGL_API) || !eglChooseConfig(display, configAttribs, &config, 1, &configCount)
+        || configCount == 0) {
+        std::cout << "Failed to find an EGL config for OpenGL pbuffers" << std::endl;
+        destroySurfaceless();
+        return false;
+    }
+
+    const EGLint surfaceAttribs[] = { EGL_WIDTH, s_width, EGL_HEIGHT, s_height, EGL_NONE };
+    const EGLint contextAttribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 4, EGL_CONTEXT_MINOR_VERSION, 5,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    m_eglSurface = eglCreatePbufferSurface(display, config, surfaceAttribs);
+    m_eglContext = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttribs);
+    if (m_eglSurface == EGL_NO_SURFACE || m_eglContext == EGL_NO_CONTEXT
+        || !eglMakeCurrent(display, m_eglSurface, m_eglSurface, m_eglContext)) {
+        std::cout << "Failed to create surfaceless OpenGL 4.5 context" << std::endl;
+        destroySurfaceless();
+        return false;
+    }
+    eglSwapInterval(display, 0);
+    s_surfaceless = true;
+    return true;
+#else
+    std::cout << "Failed to create surfaceless context: built without EGL" << std::endl;
+    return false;
+#endif
+}
+
+void Window::destroySurfaceless()
+{
+#ifdef ALUMBRA_EGL
+    if (m_eglDisplay == nullptr)
+        return;
+    eglMakeCurrent(m_eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (m_eglContext != EGL_NO_CONTEXT)
+        eglDestroyContext(m_eglDisplay, m_eglContext);
+    if (m_eglSurface != EGL_NO_SURFACE)
+        eglDestroySurface(m_eglDisplay, m_eglSurface);
+    eglTerminate(m_eglDisplay);
+    m_eglDisplay = m_eglSurface = m_eglContext = nullptr;
+    s_surfaceless = false;
+#endif
 }
 
 bool Window::initGL()
 {
     // glad: load all OpenGL function pointers
     // ---------------------------------------
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    if (!gladLoadGLLoader((GLADloadproc)procAddress))
     {
         std::cout << "Failed to initialize GLAD" << std::endl;
         return false;
     }
+    return true;
 }
 
 void Window::initImGUI()
@@ -89,6 +204,12 @@ void Window::initImGUI()
 
 void Window::update()
 {
+#ifdef ALUMBRA_EGL
+    if (surfaceless()) {
+        eglSwapBuffers(m_eglDisplay, m_eglSurface);
+        return;
+    }
+#endif
     // Handle Window updating
     glfwSwapBuffers(m_window);
     glfwPollEvents();
@@ -96,6 +217,8 @@ void Window::update()
 
 bool Window::isClosed()
 {
+    if (surfaceless())
+        return false;
     return glfwWindowShouldClose(m_window);
 }
 
@@ -109,6 +232,8 @@ void Window::clear()
 // ---------------------------------------------------------------------------------------------------------
 void Window::processInput(float deltaTime)
 {
+    if (surfaceless())
+        return;
     if (glfwGetKey(m_window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
         glfwSetWindowShouldClose(m_window, true);
 
@@ -179,4 +304,7 @@ void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods
         GLenum cursorOption = win->cursorHidden() ? GLFW_CURSOR_DISABLED : GLFW_CURSOR_NORMAL;
         glfwSetInputMode(win->windowInstance(), GLFW_CURSOR, cursorOption);
     }
+    if (key == GLFW_KEY_R && action == GLFW_RELEASE) {
+        win->setRecordingPath(!win->recordingPath());
+    }
 }
@@ -7,11 +7,18 @@
 #include "vendor/imgui/imgui_impl_opengl3.h"
 
 /**
- * This class is responsible for handling the application window using GLFW
+ * This class is responsible for handling the application window using GLFW. For offscreen
+ * runs on machines without a display server it can instead create a surfaceless EGL context
+ * rendering into a pbuffer, with no GLFW window, input or GUI behind it
  */
 class Window {
 public:
-    Window(const char* title, int width, int height);
+    // Context API for a surfaceless EGL context, needs EGL_MESA_platform_surfaceless
+    // and a build with ALUMBRA_EGL defined
+    static constexpr int SURFACELESS_CONTEXT_API = -1;
+
+    Window(const char* title, int width, int height, bool visible = true,
+        int contextAPI = GLFW_NATIVE_CONTEXT_API);
     ~Window();
 
     void update();
@@ -21,20 +28,40 @@ public:
     void processInput(float deltaTime);
 
     inline GLFWwindow* windowInstance() { return m_window; }
+    inline bool surfaceless() const { return m_contextAPI == SURFACELESS_CONTEXT_API; }
+    // Whether a current GL context was created and its functions loaded
+    inline bool valid() const { return m_valid; }
+    /* GL function of the current context, for entry points GLAD does not load */
+    static void* procAddress(const char* name);
     static inline int width() { return s_width; }
     static inline void setWidth(int width) { s_width = width; }
     static inline int height() { return s_height; }
     static inline void setHeight(int height) { s_height = height; }
     static inline bool cursorHidden() { return s_cursorHidden; }
     static inline void setCursorHidden(bool mode) { s_cursorHidden = mode; }
+    static inline bool recordingPath() { return s_recordingPath; }
+    static inline void setRecordingPath(bool recording) { s_recordingPath = recording; }
 
 private:
     const char* m_title;
-    GLFWwindow* m_window;
+    GLFWwindow* m_window = nullptr;
+    // Hidden windows are used for offscreen benchmarking, the context API picks
+    // native, EGL or OSMesa context creation or a surfaceless EGL context
+    bool m_visible;
+    int m_contextAPI;
+    bool m_valid = false;
+    // EGLDisplay, EGLSurface and EGLContext of a surfaceless context
+    void* m_eglDisplay = nullptr;
+    void* m_eglSurface = nullptr;
+    void* m_eglContext = nullptr;
+    static bool s_surfaceless;
     static int s_width, s_height;
     static bool s_cursorHidden;
+    static bool s_recordingPath;
 
     bool initGLFW();
+    bool initSurfaceless();
+    void destroySurfaceless();
     bool initGL();
     void initImGUI();
 
@@ -1,6 +1,7 @@
 #include "../pch.h"
 #include "Mesh.h"
-#include "../Buffers.h"
+#include "../AssetRegistry.h"
+#include "../Profiler.h"
 
 // Default Constructor
 Mesh::Mesh() {}
@@ -21,8 +22,28 @@ Mesh::Mesh(std::vector<glm::vec3>& positions, std::vector<glm::vec3>& normals,
     setupMesh();
 }
 
-/* Render the mesh */
-void Mesh::draw(Shader shader)
+/* Uploads generated or extracted data, missing tangent streams are zero filled and get a
+    frame around the normal when packed */
+Mesh::Mesh(const MeshData& data, const std::vector<MeshTexture>& textures)
+{
+    m_positions = data.positions;
+    m_normals = data.normals;
+    m_texCoords = data.texCoords;
+    m_tangents = data.tangents;
+    m_bitangents = data.bitangents;
+    m_indices = data.indices;
+    m_lods = data.lods;
+    m_textures = textures;
+    if (m_tangents.size() != m_positions.size())
+        m_tangents.assign(m_positions.size(), glm::vec3(0.0f));
+    if (m_bitangents.size() != m_positions.size())
+        m_bitangents.assign(m_positions.size(), glm::vec3(0.0f));
+
+    setupMesh();
+}
+
+/* Render one level of detail of the mesh, clamped to the coarsest one */
+void Mesh::draw(Shader shader, unsigned int lod)
 {
     // bind appropriate textures
 
@@ -36,16 +57,19 @@ void Mesh::draw(Shader shader)
 
         // now set the sampler to the correct texture unit
         shader.setSampler(("material." + name), i);
-        // bind proper texture unit after binding
-        glBindTextureUnit(i, m_textures[i].id);
+        // bind proper texture unit after binding, registry textures may have to be streamed back in
+        const MeshTexture& texture = m_textures[i];
+        glBindTextureUnit(i, texture.asset ? AssetRegistry::instance().useTexture(*texture.asset) : texture.id);
     }
     // draw mesh
-    glBindVertexArray(m_meshVAO);
-    if (m_indices.size() > 0) {
-        glDrawElements(GL_TRIANGLES, m_indices.size(), GL_UNSIGNED_INT, 0);
+    glBindVertexArray(m_vertexArray.id());
+    const MeshLod& range = m_lods[std::min(lod, lodCount() - 1)];
+    if (m_indexCount > 0) {
+        glDrawElements(GL_TRIANGLES, range.indexCount, m_indexFormat.type,
+            (void*)((size_t)m_indexFormat.size * range.firstIndex));
     }
     else {
-        glDrawArrays(GL_TRIANGLES, 0, m_positions.size());
+        glDrawArrays(GL_TRIANGLES, range.firstIndex, range.indexCount);
     }
 
     glBindTextureUnit(1, 0);
@@ -55,17 +79,112 @@ void Mesh::draw(Shader shader)
 /* Initializes all the buffer objects/arrays */
 void Mesh::setupMesh()
 {
-    auto bufferSize = sizeof(unsigned int) * m_indices.size()
-        + sizeof(m_positions[0]) * (m_positions.size() + m_normals.size() + m_tangents.size() + m_bitangents.size())
-        + sizeof(m_texCoords[0]) * m_texCoords.size();
-    DataBuffer buffer(bufferSize, m_positions.size(), 5, m_indices.size());
-    buffer.addIndices(m_indices.data());
-    buffer.addVec3s(m_positions.data());
-    buffer.addVec3s(m_normals.data());
-    buffer.addVec2s(m_texCoords.data());
-    buffer.addVec3s(m_tangents.data());
-    buffer.addVec3s(m_bitangents.data());
-    VertexArray vao;
-    vao.loadBuffer(buffer, 2);
-    m_meshVAO = vao.vertexArrayID();
+    m_bounds = AABB::fromPoints(m_positions);
+    if (m_lods.empty() || m_indices.empty())
+        m_lods = { { 0, (unsigned int)(m_indices.empty() ? m_positions.size() : m_indices.size()), 0.0f } };
+
+    // Meshlets never straddle two levels, so culling a cluster is also selecting its level
+    if (m_indices.empty()) {
+        m_meshlets = Meshlets::build(m_positions, m_indices);
+    }
+    else {
+        m_meshlets.clear();
+        for (unsigned int lod = 0; lod < m_lods.size(); lod++) {
+            auto first = m_indices.begin() + m_lods[lod].firstIndex;
+            std::vector<unsigned int> levelIndices(first, first + m_lods[lod].indexCount);
+            std::vector<Meshlet> levelMeshlets = Meshlets::build(m_positions, levelIndices);
+            std::copy(levelIndices.begin(), levelIndices.end(), first);
+            for (auto& meshlet : levelMeshlets) {
+                meshlet.firstIndex += m_lods[lod].firstIndex;
+                meshlet.lod = lod;
+                m_meshlets.push_back(meshlet);
+            }
+        }
+    }
+
+    // Interleaved and quantized, the bitangent is rebuilt in the vertex shader from the sign
+    // packed with the tangent
+    VertexStreams streams;
+    streams.positions = m_positions.data();
+    streams.normals = m_normals.size() == m_positions.size() ? m_normals.data() : nullptr;
+    streams.texCoords = m_texCoords.size() == m_positions.size() ? m_texCoords.data() : nullptr;
+    streams.tangents = m_tangents.size() == m_positions.size() ? m_tangents.data() : nullptr;
+    streams.bitangents = m_bitangents.size() == m_positions.size() ? m_bitangents.data() : nullptr;
+    VertexUpload upload = MeshVertexFormat::upload(streams, m_positions.size(), m_indices);
+    ResourceManager& resources = ResourceManager::instance();
+    m_vertexArray = GpuResource(resources.adopt(ResourceType::VertexArray, ResourceCategory::Mesh,
+        upload.vertexArrayID, 0, "Mesh"));
+    m_buffer = GpuResource(resources.adopt(ResourceType::Buffer, ResourceCategory::Mesh,
+        upload.bufferID, upload.size, "Mesh"));
+    m_indexFormat = upload.indexFormat;
+    m_gpuSize = upload.size;
+    m_vertexCount = m_positions.size();
+    m_indexCount = m_indices.size();
+    m_vertexOffset = upload.vertexOffset;
+    m_cpuResident = true;
+}
+
+size_t Mesh::cpuSize() const
+{
+    return m_positions.capacity() * sizeof(glm::vec3) + m_normals.capacity() * sizeof(glm::vec3)
+        + m_texCoords.capacity() * sizeof(glm::vec2) + m_tangents.capacity() * sizeof(glm::vec3)
+        + m_bitangents.capacity() * sizeof(glm::vec3) + m_indices.capacity() * sizeof(unsigned int);
+}
+
+/* Frees the streams, bounds, levels and meshlets stay since culling and draws read them every frame */
+void Mesh::releaseCpuData()
+{
+    if (!m_cpuResident || !m_buffer)
+        return;
+    std::vector<glm::vec3>().swap(m_positions);
+    std::vector<glm::vec3>().swap(m_normals);
+    std::vector<glm::vec2>().swap(m_texCoords);
+    std::vector<glm::vec3>().swap(m_tangents);
+    std::vector<glm::vec3>().swap(m_bitangents);
+    std::vector<unsigned int>().swap(m_indices);
+    m_cpuResident = false;
+}
+
+/* Decodes the streams from the interleaved buffer. Positions and indices come back exact,
+    normals, tangents and texture coordinates at the precision they were quantized to */
+void Mesh::requireCpuData()
+{
+    if (m_cpuResident)
+        return;
+    PROFILE_SCOPE("Mesh Readback");
+    static_assert(MeshVertexFormat::STRIDE == 24, "readback expects the attribute order of MeshVertexFormat");
+    std::vector<unsigned char> data(m_gpuSize);
+    glGetNamedBufferSubData(m_buffer.id(), 0, m_gpuSize, data.data());
+
+    m_indices.resize(m_indexCount);
+    for (size_t i = 0; i < m_indexCount; i++) {
+        if (m_indexFormat.type == GL_UNSIGNED_SHORT) {
+            GLushort index;
+            std::memcpy(&index, data.data() + i * sizeof(GLushort), sizeof(GLushort));
+            m_indices[i] = index;
+        }
+        else {
+            std::memcpy(&m_indices[i], data.data() + i * sizeof(GLuint), sizeof(GLuint));
+        }
+    }
+
+    m_positions.resize(m_vertexCount);
+    m_normals.resize(m_vertexCount);
+    m_texCoords.resize(m_vertexCount);
+    m_tangents.resize(m_vertexCount);
+    m_bitangents.resize(m_vertexCount);
+    for (size_t v = 0; v < m_vertexCount; v++) {
+        const unsigned char* vertex = data.data() + m_vertexOffset + v * MeshVertexFormat::STRIDE;
+        GLuint normal, texCoord, tangent;
+        std::memcpy(&m_positions[v], vertex, sizeof(glm::vec3));
+        std::memcpy(&normal, vertex + 12, sizeof(GLuint));
+        std::memcpy(&texCoord, vertex + 16, sizeof(GLuint));
+        std::memcpy(&tangent, vertex + 20, sizeof(GLuint));
+        m_normals[v] = quantize::octDecode(glm::unpackSnorm2x16(normal));
+        m_texCoords[v] = glm::unpackHalf2x16(texCoord);
+        glm::vec4 frame = glm::unpackSnorm3x10_1x2(tangent);
+        m_tangents[v] = glm::vec3(frame);
+        m_bitangents[v] = glm::cross(m_normals[v], m_tangents[v]) * frame.w;
+    }
+    m_cpuResident = true;
 }
@@ -1,6 +1,11 @@
 #pragma once
 
 #include "../Shader.h"
+#include "../Bounds.h"
+#include "../Buffers.h"
+#include "../Texture.h"
+#include "../ResourceManager.h"
+#include "Meshlets.h"
 
 struct Vertex {
     glm::vec3 Position;
@@ -8,14 +13,40 @@ struct Vertex {
     glm::vec2 TexCoords;
 };
 
+/* Index range of one level of detail, coarser levels reuse the vertices of the first */
+struct MeshLod {
+    unsigned int firstIndex = 0;
+    unsigned int indexCount = 0;
+    // Distance in object space units this level strays from the full detail surface, summed
+    // over the levels it was simplified through
+    float error = 0.0f;
+};
+
+/* CPU side vertex streams of a mesh, filled without touching GL so loaders and generators
+    can be run (and benchmarked) without a context */
+struct MeshData {
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> normals;
+    std::vector<glm::vec2> texCoords;
+    std::vector<glm::vec3> tangents;
+    std::vector<glm::vec3> bitangents;
+    std::vector<unsigned int> indices;
+    // Empty when indices holds a single level
+    std::vector<MeshLod> lods;
+};
+
 struct MeshTexture {
     GLuint id;
     std::string type;
     std::string path;
+    // Keeps a registry texture alive while any mesh samples it, empty for textures owned elsewhere
+    std::shared_ptr<TextureAsset> asset = nullptr;
 };
 
 class Mesh {
 public:
+    static constexpr unsigned int MAX_LODS = 4;
+
     /* Mesh data */
     std::vector<glm::vec3> m_positions;
     std::vector<glm::vec3> m_normals;
@@ -24,16 +55,45 @@ public:
     std::vector<glm::vec3> m_bitangents;
     std::vector<unsigned int> m_indices;
     std::vector<MeshTexture> m_textures;
+    // Built when the mesh is uploaded, m_indices is reordered to keep each one contiguous
+    std::vector<Meshlet> m_meshlets;
+    // Finest first, setupMesh leaves at least one level covering the whole mesh
+    std::vector<MeshLod> m_lods;
     /* Functions */
     Mesh();
     Mesh(std::vector<glm::vec3>& positions, std::vector<glm::vec3>& normals,
         std::vector<glm::vec2>& texCoords, std::vector<glm::vec3>& tangents,
         std::vector<glm::vec3>& bitangents, std::vector<unsigned int>& indices,
         std::vector<MeshTexture>& textures);
-    void draw(Shader shader);
+    Mesh(const MeshData& data, const std::vector<MeshTexture>& textures = {});
+    void draw(Shader shader, unsigned int lod = 0);
+
+    // Object space bounds of the positions, computed when the mesh is uploaded
+    inline const AABB& bounds() const { return m_bounds; }
+    inline unsigned int lodCount() const { return (unsigned int)m_lods.size(); }
+    // Bytes of vertex and index data uploaded for the mesh
+    inline size_t gpuSize() const { return m_gpuSize; }
+
+    /* CPU copies of the streams are kept after upload for the pool and occluder builds.
+        MemoryBudget drops them when meshes go over their CPU budget, and whoever reads the
+        streams calls requireCpuData first to read them back from the GPU buffer */
+    inline bool cpuResident() const { return m_cpuResident; }
+    // Bytes held by the vertex streams and indices
+    size_t cpuSize() const;
+    void releaseCpuData();
+    void requireCpuData();
 protected:
     /* Render data */
-    unsigned int m_meshVAO;
+    // Owned through the ResourceManager, which also makes meshes move only
+    GpuResource m_vertexArray;
+    GpuResource m_buffer;
+    IndexFormat m_indexFormat;
+    size_t m_gpuSize = 0;
+    size_t m_vertexCount = 0;
+    size_t m_indexCount = 0;
+    size_t m_vertexOffset = 0;
+    bool m_cpuResident = true;
+    AABB m_bounds;
 
     /* Functions */
     void setupMesh();
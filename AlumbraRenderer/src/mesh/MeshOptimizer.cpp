@@ -0,0 +1,408 @@
+#include "../pch.h"
+#include "MeshOptimizer.h"
+#include "../Bounds.h"
+#include "../Profiler.h"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <unordered_map>
+
+// Triangles using each vertex, as offsets into one flat list
+struct TriangleAdjacency {
+    std::vector<unsigned int> offsets;
+    std::vector<unsigned int> triangles;
+
+    TriangleAdjacency(const std::vector<unsigned int>& indices, unsigned int vertexCount)
+        : offsets(vertexCount + 1, 0), triangles(indices.size())
+    {
+        for (unsigned int index : indices)
+            offsets[index + 1]++;
+        for (unsigned int v = 0; v < vertexCount; v++)
+            offsets[v + 1] += offsets[v];
+        std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+        for (unsigned int i = 0; i < indices.size(); i++)
+            triangles[fill[indices[i]]++] = i / 3;
+    }
+    inline unsigned int valence(unsigned int v) const { return offsets[v + 1] - offsets[v]; }
+};
+
+/* Simulates a FIFO cache with timestamps, a vertex is cached while fewer than CACHE_SIZE misses
+    happened since its own. Returns the misses of one triangle */
+static unsigned int updateCache(const unsigned int* triangle, std::vector<unsigned int>& timestamps,
+    unsigned int& time)
+{
+    unsigned int misses = 0;
+    for (int k = 0; k < 3; k++) {
+        if (time - timestamps[triangle[k]] > MeshOptimizer::CACHE_SIZE) {
+            timestamps[triangle[k]] = time++;
+            misses++;
+        }
+    }
+    return misses;
+}
+
+void MeshOptimizer::optimize(MeshData& data, float overdrawThreshold)
+{
+    PROFILE_FUNCTION();
+    weldVertices(data);
+    optimizeVertexCache(data.indices, (unsigned int)data.positions.size());
+    optimizeOverdraw(data.indices, data.positions, overdrawThreshold);
+    optimizeVertexFetch(data);
+}
+
+unsigned int MeshOptimizer::weldVertices(MeshData& data)
+{
+    unsigned int vertexCount = (unsigned int)data.positions.size();
+    if (data.indices.empty()) {
+        data.indices.resize(vertexCount - vertexCount % 3);
+        std::iota(data.indices.begin(), data.indices.end(), 0u);
+    }
+    // Streams that are missing or of the wrong size are not per vertex and are left alone
+    bool normals = data.normals.size() == vertexCount;
+    bool texCoords = data.texCoords.size() == vertexCount;
+    bool tangents = data.tangents.size() == vertexCount && data.bitangents.size() == vertexCount;
+
+    auto hashBytes = [](size_t hash, const void* bytes, size_t size) {
+        const unsigned char* p = (const unsigned char*)bytes;
+        for (size_t i = 0; i < size; i++)
+            hash = (hash ^ p[i]) * 1099511628211ull;
+        return hash;
+    };
+    auto hashVertex = [&](unsigned int v) {
+        size_t hash = hashBytes(14695981039346656037ull, &data.positions[v], sizeof(glm::vec3));
+        if (normals)
+            hash = hashBytes(hash, &data.normals[v], sizeof(glm::vec3));
+        if (texCoords)
+            hash = hashBytes(hash, &data.texCoords[v], sizeof(glm::vec2));
+        if (tangents) {
+            hash = hashBytes(hash, &data.tangents[v], sizeof(glm::vec3));
+            hash = hashBytes(hash, &data.bitangents[v], sizeof(glm::vec3));
+        }
+        return hash;
+    };
+    auto equalVertex = [&](unsigned int a, unsigned int b) {
+        return std::memcmp(&data.positions[a], &data.positions[b], sizeof(glm::vec3)) == 0
+            && (!normals || std::memcmp(&data.normals[a], &data.normals[b], sizeof(glm::vec3)) == 0)
+            && (!texCoords || std::memcmp(&data.texCoords[a], &data.texCoords[b], sizeof(glm::vec2)) == 0)
+            && (!tangents || (std::memcmp(&data.tangents[a], &data.tangents[b], sizeof(glm::vec3)) == 0
+                && std::memcmp(&data.bitangents[a], &data.bitangents[b], sizeof(glm::vec3)) == 0));
+    };
+
+    // Keyed by the first vertex seen with each set of attributes
+    std::unordered_map<unsigned int, unsigned int, decltype(hashVertex), decltype(equalVertex)>
+        unique(vertexCount, hashVertex, equalVertex);
+    std::vector<unsigned int> remap(vertexCount);
+    std::vector<unsigned int> kept;
+    kept.reserve(vertexCount);
+    for (unsigned int v = 0; v < vertexCount; v++) {
+        auto inserted = unique.emplace(v, (unsigned int)kept.size());
+        if (inserted.second)
+            kept.push_back(v);
+        remap[v] = inserted.first->second;
+    }
+    if (kept.size() == vertexCount)
+        return 0;
+
+    for (auto& index : data.indices)
+        index = remap[index];
+    auto compact = [&](auto& stream) {
+        for (unsigned int i = 0; i < kept.size(); i++)
+            stream[i] = stream[kept[i]];
+        stream.resize(kept.size());
+    };
+    compact(data.positions);
+    if (normals)
+        compact(data.normals);
+    if (texCoords)
+        compact(data.texCoords);
+    if (tangents) {
+        compact(data.tangents);
+        compact(data.bitangents);
+    }
+    return vertexCount - (unsigned int)kept.size();
+}
+
+/* Tipsify (Sander et al. 2007): fans out every unemitted triangle around the current vertex,
+    then moves on to the vertex among the ones just emitted that will still be in the cache
+    once its remaining triangles are emitted, preferring the oldest. Without one it goes back
+    to recently used vertices with triangles left, then to any vertex in input order */
+void MeshOptimizer::optimizeVertexCache(std::vector<unsigned int>& indices, unsigned int vertexCount)
+{
+    unsigned int triangleCount = (unsigned int)indices.size() / 3;
+    if (triangleCount == 0)
+        return;
+    TriangleAdjacency adjacency(indices, vertexCount);
+    std::vector<unsigned int> live(vertexCount);
+    for (unsigned int v = 0; v < vertexCount; v++)
+        live[v] = adjacency.valence(v);
+    std::vector<unsigned int> timestamps(vertexCount, 0);
+    std::vector<unsigned char> emitted(triangleCount, 0);
+    std::vector<unsigned int> deadEnd, candidates, result;
+    result.reserve(indices.size());
+    unsigned int time = CACHE_SIZE + 1;
+    unsigned int cursor = 0;
+
+    int fanning = (int)indices[0];
+    while (fanning >= 0) {
+        candidates.clear();
+        for (unsigned int a = adjacency.offsets[fanning]; a < adjacency.offsets[fanning + 1]; a++) {
+            unsigned int t = adjacency.triangles[a];
+            if (emitted[t])
+                continue;
+            emitted[t] = 1;
+            for (int k = 0; k < 3; k++) {
+                unsigned int v = indices[t * 3 + k];
+                result.push_back(v);
+                deadEnd.push_back(v);
+                candidates.push_back(v);
+                live[v]--;
+                if (time - timestamps[v] > CACHE_SIZE)
+                    timestamps[v] = time++;
+            }
+        }
+
+        fanning = -1;
+        int bestPriority = -1;
+        for (unsigned int v : candidates) {
+            if (live[v] == 0)
+                continue;
+            // Fanning v costs at most 2 misses per remaining triangle, it only counts as cached
+            // if it survives them
+            int priority = 0;
+            if (time - timestamps[v] + 2 * live[v] <= CACHE_SIZE)
+                priority = (int)(time - timestamps[v]);
+            if (priority > bestPriority) {
+                bestPriority = priority;
+                fanning = (int)v;
+            }
+        }
+        while (fanning < 0 && !deadEnd.empty()) {
+            unsigned int v = deadEnd.back();
+            deadEnd.pop_back();
+            if (live[v] > 0)
+                fanning = (int)v;
+        }
+        while (fanning < 0 && cursor < vertexCount) {
+            if (live[cursor] > 0)
+                fanning = (int)cursor;
+            cursor++;
+        }
+    }
+    indices = std::move(result);
+}
+
+/* Sander et al. 2007 as done by meshoptimizer: the cache ordered triangles are cut into clusters
+    wherever a triangle misses on all three vertices, those are split further as long as each
+    piece keeps its misses within the threshold, then clusters facing away from the mesh center
+    are drawn first since they tend to occlude the rest */
+void MeshOptimizer::optimizeOverdraw(std::vector<unsigned int>& indices, const std::vector<glm::vec3>& positions,
+    float threshold)
+{
+    unsigned int triangleCount = (unsigned int)indices.size() / 3;
+    if (triangleCount < 2)
+        return;
+    std::vector<unsigned int> timestamps(positions.size(), 0);
+    unsigned int time = CACHE_SIZE + 1;
+
+    std::vector<unsigned int> hardBoundaries;
+    for (unsigned int t = 0; t < triangleCount; t++) {
+        if (updateCache(&indices[t * 3], timestamps, time) == 3 || t == 0)
+            hardBoundaries.push_back(t);
+    }
+
+    std::vector<unsigned int> clusters;
+    for (unsigned int c = 0; c < hardBoundaries.size(); c++) {
+        unsigned int start = hardBoundaries[c];
+        unsigned int end = c + 1 < hardBoundaries.size() ? hardBoundaries[c + 1] : triangleCount;
+        // Resetting the cache between clusters, they may be drawn in any order
+        time += CACHE_SIZE + 1;
+        unsigned int misses = 0;
+        for (unsigned int t = start; t < end; t++)
+            misses += updateCache(&indices[t * 3], timestamps, time);
+        float clusterThreshold = threshold * (float)misses / (float)(end - start);
+
+        clusters.push_back(start);
+        time += CACHE_SIZE + 1;
+        unsigned int runningMisses = 0, runningTriangles = 0;
+        for (unsigned int t = start; t < end; t++) {
+            runningMisses += updateCache(&indices[t * 3], timestamps, time);
+            runningTriangles++;
+            if ((float)runningMisses / (float)runningTriangles <= clusterThreshold && t + 1 < end) {
+                clusters.push_back(t + 1);
+                time += CACHE_SIZE + 1;
+                runningMisses = runningTriangles = 0;
+            }
+        }
+        // The remainder rarely reaches the target and is merged into the piece before it
+        if (runningTriangles > 0 && clusters.back() != start && runningMisses > clusterThreshold * runningTriangles)
+            clusters.pop_back();
+    }
+
+    glm::vec3 meshCentroid(0.0f);
+    for (unsigned int index : indices)
+        meshCentroid += positions[index];
+    meshCentroid /= (float)indices.size();
+
+    std::vector<float> sortKeys(clusters.size());
+    for (unsigned int c = 0; c < clusters.size(); c++) {
+        unsigned int end = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+        glm::vec3 centroid(0.0f), normal(0.0f);
+        float area = 0.0f;
+        for (unsigned int t = clusters[c]; t < end; t++) {
+            const glm::vec3& a = positions[indices[t * 3]];
+            const glm::vec3& b = positions[indices[t * 3 + 1]];
+            const glm::vec3& d = positions[indices[t * 3 + 2]];
+            glm::vec3 cross = glm::cross(b - a, d - a);
+            float triangleArea = glm::length(cross);
+            centroid += (a + b + d) * (triangleArea / 3.0f);
+            normal += cross;
+            area += triangleArea;
+        }
+        centroid = area > 0.0f ? centroid / area : meshCentroid;
+        float length = glm::length(normal);
+        sortKeys[c] = length > 0.0f ? glm::dot(centroid - meshCentroid, normal / length) : 0.0f;
+    }
+
+    std::vector<unsigned int> order(clusters.size());
+    std::iota(order.begin(), order.end(), 0u);
+    std::stable_sort(order.begin(), order.end(), [&](unsigned int a, unsigned int b) { return sortKeys[a] > sortKeys[b]; });
+    std::vector<unsigned int> result;
+    result.reserve(indices.size());
+    for (unsigned int c : order) {
+        unsigned int end = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+        result.insert(result.end(), indices.begin() + clusters[c] * 3, indices.begin() + end * 3);
+    }
+    indices = std::move(result);
+}
+
+void MeshOptimizer::optimizeVertexFetch(MeshData& data)
+{
+    unsigned int vertexCount = (unsigned int)data.positions.size();
+    if (data.indices.empty())
+        return;
+    std::vector<unsigned int> remap(vertexCount, ~0u);
+    std::vector<unsigned int> order;
+    order.reserve(vertexCount);
+    for (auto& index : data.indices) {
+        if (remap[index] == ~0u) {
+            remap[index] = (unsigned int)order.size();
+            order.push_back(index);
+        }
+        index = remap[index];
+    }
+    auto reorder = [&](auto& stream) {
+        if (stream.size() != vertexCount)
+            return;
+        auto source = stream;
+        stream.resize(order.size());
+        for (unsigned int i = 0; i < order.size(); i++)
+            stream[i] = source[order[i]];
+    };
+    reorder(data.positions);
+    reorder(data.normals);
+    reorder(data.texCoords);
+    reorder(data.tangents);
+    reorder(data.bitangents);
+}
+
+MeshStats MeshOptimizer::analyze(const std::vector<glm::vec3>& positions, const std::vector<unsigned int>& indices)
+{
+    std::vector<unsigned int> sequential;
+    if (indices.empty()) {
+        sequential.resize(positions.size() - positions.size() % 3);
+        std::iota(sequential.begin(), sequential.end(), 0u);
+    }
+    const auto& triangles = indices.empty() ? sequential : indices;
+    MeshStats stats;
+    stats.vertices = (unsigned int)positions.size();
+    stats.triangles = (unsigned int)triangles.size() / 3;
+    stats.acmr = analyzeVertexCache(triangles, stats.vertices);
+    stats.overdraw = analyzeOverdraw(positions, triangles);
+    return stats;
+}
+
+void MeshOptimizer::accumulate(MeshStats& total, const MeshStats& stats)
+{
+    unsigned int triangles = total.triangles + stats.triangles;
+    if (triangles > 0) {
+        total.acmr = (total.acmr * total.triangles + stats.acmr * stats.triangles) / triangles;
+        total.overdraw = (total.overdraw * total.triangles + stats.overdraw * stats.triangles) / triangles;
+    }
+    total.vertices += stats.vertices;
+    total.triangles = triangles;
+}
+
+float MeshOptimizer::analyzeVertexCache(const std::vector<unsigned int>& indices, unsigned int vertexCount)
+{
+    unsigned int triangleCount = (unsigned int)indices.size() / 3;
+    if (triangleCount == 0)
+        return 0.0f;
+    std::vector<unsigned int> timestamps(vertexCount, 0);
+    unsigned int time = CACHE_SIZE + 1;
+    unsigned int misses = 0;
+    for (unsigned int t = 0; t < triangleCount; t++)
+        misses += updateCache(&indices[t * 3], timestamps, time);
+    return (float)misses / (float)triangleCount;
+}
+
+/* Rasterizes the mesh in index order with back face culling and a depth test along +-x, +-y and
+    +-z into a small grid each, counting every fragment that passes against the pixels left
+    covered */
+float MeshOptimizer::analyzeOverdraw(const std::vector<glm::vec3>& positions, const std::vector<unsigned int>& indices)
+{
+    if (indices.size() < 3)
+        return 0.0f;
+    AABB bounds = AABB::fromPoints(positions);
+    glm::vec3 size = bounds.max - bounds.min;
+    float scale = std::max(std::max(size.x, size.y), size.z);
+    if (scale <= 0.0f)
+        return 0.0f;
+
+    const int resolution = OVERDRAW_RESOLUTION;
+    std::vector<float> depth(resolution * resolution);
+    unsigned long long shaded = 0, covered = 0;
+    for (int axis = 0; axis < 3; axis++) {
+        for (int side = 0; side < 2; side++) {
+            std::fill(depth.begin(), depth.end(), std::numeric_limits<float>::max());
+            for (unsigned int i = 0; i + 2 < indices.size(); i += 3) {
+                // Cyclic axis permutations keep the handedness, the back view mirrors u
+                glm::vec3 v[3];
+                for (int k = 0; k < 3; k++) {
+                    glm::vec3 p = (positions[indices[i + k]] - bounds.min) / scale;
+                    glm::vec3 view(p[(axis + 1) % 3], p[(axis + 2) % 3], p[axis]);
+                    v[k] = side == 0 ? glm::vec3(view.x, view.y, 1.0f - view.z) : glm::vec3(1.0f - view.x, view.y, view.z);
+                    v[k].x *= resolution;
+                    v[k].y *= resolution;
+                }
+                float area = (v[1].x - v[0].x) * (v[2].y - v[0].y) - (v[2].x - v[0].x) * (v[1].y - v[0].y);
+                if (area <= 0.0f)
+                    continue;
+
+                int x0 = std::max((int)std::floor(std::min({ v[0].x, v[1].x, v[2].x })), 0);
+                int x1 = std::min((int)std::ceil(std::max({ v[0].x, v[1].x, v[2].x })), resolution - 1);
+                int y0 = std::max((int)std::floor(std::min({ v[0].y, v[1].y, v[2].y })), 0);
+                int y1 = std::min((int)std::ceil(std::max({ v[0].y, v[1].y, v[2].y })), resolution - 1);
+                for (int y = y0; y <= y1; y++) {
+                    for (int x = x0; x <= x1; x++) {
+                        glm::vec2 p(x + 0.5f, y + 0.5f);
+                        float w0 = (v[2].x - v[1].x) * (p.y - v[1].y) - (v[2].y - v[1].y) * (p.x - v[1].x);
+                        float w1 = (v[0].x - v[2].x) * (p.y - v[2].y) - (v[0].y - v[2].y) * (p.x - v[2].x);
+                        float w2 = area - w0 - w1;
+                        if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f)
+                            continue;
+                        float z = (w0 * v[0].z + w1 * v[1].z + w2 * v[2].z) / area;
+                        float& stored = depth[y * resolution + x];
+                        if (z < stored) {
+                            stored = z;
+                            shaded++;
+                        }
+                    }
+                }
+            }
+            for (float d : depth)
+                covered += d != std::numeric_limits<float>::max() ? 1 : 0;
+        }
+    }
+    return covered > 0 ? (float)shaded / (float)covered : 0.0f;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "Mesh.h"
+
+// Vertex reuse and overdraw of one vertex and index order
+struct MeshStats {
+    unsigned int vertices = 0;
+    unsigned int triangles = 0;
+    // Post-transform cache misses per triangle with a MeshOptimizer::CACHE_SIZE FIFO, 3 at worst
+    // and around 0.5 for large regular grids
+    float acmr = 0.0f;
+    // Fragments passing the depth test per pixel covered, over six axis aligned views
+    float overdraw = 0.0f;
+};
+
+struct MeshOptimizeStats {
+    MeshStats before;
+    MeshStats after;
+};
+
+/**
+ * Import time optimization of indexed triangle meshes, no GL calls. optimize runs the passes in
+ * the order they depend on each other: identical vertices are welded so triangles can share
+ * them, triangles are reordered for the post-transform vertex cache with Tipsify, the cache
+ * friendly clusters that produces are sorted outside in to cut overdraw, and finally vertices
+ * are renumbered in the order the triangles first use them so fetches stream through memory.
+ */
+class MeshOptimizer {
+public:
+    static constexpr unsigned int CACHE_SIZE = 16;
+    // Grid each view is rasterized at by analyzeOverdraw
+    static constexpr int OVERDRAW_RESOLUTION = 256;
+
+    /* Runs every pass, the overdraw pass may give up to threshold times the cache misses */
+    static void optimize(MeshData& data, float overdrawThreshold = 1.05f);
+
+    /* Merges vertices whose attributes are bitwise identical and indexes unindexed meshes,
+        returns how many vertices were removed */
+    static unsigned int weldVertices(MeshData& data);
+    static void optimizeVertexCache(std::vector<unsigned int>& indices, unsigned int vertexCount);
+    /* Expects indices already in vertex cache order */
+    static void optimizeOverdraw(std::vector<unsigned int>& indices, const std::vector<glm::vec3>& positions,
+        float threshold);
+    /* Renumbers vertices by first use and drops unreferenced ones */
+    static void optimizeVertexFetch(MeshData& data);
+
+    static MeshStats analyze(const std::vector<glm::vec3>& positions, const std::vector<unsigned int>& indices);
+    static float analyzeVertexCache(const std::vector<unsigned int>& indices, unsigned int vertexCount);
+    static float analyzeOverdraw(const std::vector<glm::vec3>& positions, const std::vector<unsigned int>& indices);
+    /* Adds stats to a total, ACMR and overdraw are weighted by triangles */
+    static void accumulate(MeshStats& total, const MeshStats& stats);
+};
@@ -0,0 +1,221 @@
+#include "../pch.h"
+#include "MeshPool.h"
+
+#include <unordered_map>
+
+MeshPool::MeshPool()
+{
+    m_poolVAO = GpuResource(ResourceManager::instance().createVertexArray(ResourceCategory::Mesh, "Mesh Pool VAO"));
+}
+
+MeshPool::~MeshPool() {}
+
+/* Appends every mesh of every model to the pool once, then adds one draw per mesh of each
+    object. Meshes without an index buffer get a sequential one so all draws can be fetched
+    the same way */
+void MeshPool::build(const std::vector<Model*>& models, const std::vector<SceneObject>& objects)
+{
+    std::vector<PoolVertex> vertices;
+    std::vector<GLuint> indices;
+    std::vector<PoolMeshlet> meshlets;
+    m_meshes.clear();
+    m_draws.clear();
+    m_drawObjects.clear();
+    m_triangleCount = 0;
+    m_lodTriangleCount = 0;
+    m_clusterCount = 0;
+    m_hasTransforms = false;
+
+    // Pool mesh of every mesh of each model, meshes shared between models through the asset
+    // registry are only appended once
+    std::vector<std::vector<unsigned int>> modelMeshes(models.size());
+    std::unordered_map<const Mesh*, unsigned int> poolMeshes;
+    for (unsigned int i = 0; i < models.size(); i++) {
+        for (const auto& handle : models[i]->meshes()) {
+            auto pooled = poolMeshes.emplace(handle.get(), (unsigned int)m_meshes.size());
+            modelMeshes[i].push_back(pooled.first->second);
+            if (!pooled.second)
+                continue;
+            handle->requireCpuData();
+            const Mesh& mesh = *handle;
+            PoolMesh poolMesh;
+            poolMesh.firstIndex = indices.size();
+            poolMesh.baseVertex = vertices.size();
+            poolMesh.meshletOffset = meshlets.size();
+            poolMesh.meshletCount = mesh.m_meshlets.size();
+            poolMesh.lodCount = mesh.lodCount();
+            poolMesh.padding[0] = poolMesh.padding[1] = 0;
+            poolMesh.lodFirstIndex = glm::uvec4(0);
+            poolMesh.lodIndexCount = glm::uvec4(0);
+            poolMesh.lodError = glm::vec4(0.0f);
+            for (unsigned int lod = 0; lod < mesh.lodCount(); lod++) {
+                poolMesh.lodFirstIndex[lod] = mesh.m_lods[lod].firstIndex;
+                poolMesh.lodIndexCount[lod] = mesh.m_lods[lod].indexCount;
+                poolMesh.lodError[lod] = mesh.m_lods[lod].error;
+            }
+            glm::vec3 boundsMin(std::numeric_limits<float>::max());
+            glm::vec3 boundsMax(-std::numeric_limits<float>::max());
+            for (const auto& position : mesh.m_positions) {
+                boundsMin = glm::min(boundsMin, position);
+                boundsMax = glm::max(boundsMax, position);
+            }
+            if (mesh.m_positions.empty())
+                boundsMin = boundsMax = glm::vec3(0.0f);
+            poolMesh.boundsMin = glm::vec4(boundsMin, 0.0f);
+            poolMesh.boundsMax = glm::vec4(boundsMax, 0.0f);
+
+            for (unsigned int v = 0; v < mesh.m_positions.size(); v++) {
+                glm::vec2 uv = v < mesh.m_texCoords.size() ? mesh.m_texCoords[v] : glm::vec2(0.0f);
+                glm::vec3 normal = v < mesh.m_normals.size() ? mesh.m_normals[v] : glm::vec3(0.0f, 1.0f, 0.0f);
+                vertices.push_back({ glm::vec4(mesh.m_positions[v], uv.x), glm::vec4(normal, uv.y) });
+            }
+            if (mesh.m_indices.size() > 0) {
+                indices.insert(indices.end(), mesh.m_indices.begin(), mesh.m_indices.end());
+            }
+            else {
+                for (GLuint v = 0; v < mesh.m_positions.size(); v++)
+                    indices.push_back(v);
+            }
+            poolMesh.indexCount = indices.size() - poolMesh.firstIndex;
+            // Sequential indices match the meshlets of unindexed meshes as well
+            for (const auto& meshlet : mesh.m_meshlets) {
+                meshlets.push_back({ meshlet.sphere, meshlet.cone, glm::vec4(meshlet.coneApex, 0.0f),
+                    meshlet.firstIndex, meshlet.triangleCount * 3, meshlet.lod, 0 });
+            }
+            m_meshes.push_back(poolMesh);
+        }
+    }
+
+    std::vector<PoolCluster> clusters;
+    m_draws.reserve(objects.size());
+    for (unsigned int i = 0; i < objects.size(); i++) {
+        const auto& object = objects[i];
+        for (unsigned int meshIndex : modelMeshes[object.model]) {
+            PoolDraw draw;
+            draw.model = glm::mat4(1.0f);
+            draw.prevModel = glm::mat4(1.0f);
+            draw.meshIndex = meshIndex;
+            draw.triangleOffset = m_triangleCount;
+            draw.materialIndex = object.material;
+            draw.lod = 0;
+            m_triangleCount += m_meshes[draw.meshIndex].indexCount / 3;
+            m_lodTriangleCount += m_meshes[draw.meshIndex].lodIndexCount[0] / 3;
+            const auto& poolMesh = m_meshes[draw.meshIndex];
+            for (GLuint k = 0; k < poolMesh.meshletCount; k++)
+                clusters.push_back({ (GLuint)m_draws.size(), poolMesh.meshletOffset + k });
+
+            m_draws.push_back(draw);
+            m_drawObjects.push_back(i);
+        }
+    }
+
+    releaseBuffers();
+    if (m_draws.empty())
+        return;
+
+    ResourceManager& resources = ResourceManager::instance();
+    m_vertexSSBO = GpuResource(resources.createBuffer(ResourceCategory::Mesh, vertices.size() * sizeof(PoolVertex),
+        vertices.data(), 0, "Mesh Pool Vertices"));
+    m_indexSSBO = GpuResource(resources.createBuffer(ResourceCategory::Mesh, indices.size() * sizeof(GLuint),
+        indices.data(), 0, "Mesh Pool Indices"));
+    m_meshSSBO = GpuResource(resources.createBuffer(ResourceCategory::Mesh, m_meshes.size() * sizeof(PoolMesh),
+        m_meshes.data(), 0, "Mesh Pool Meshes"));
+    m_drawSSBO = GpuResource(resources.createBuffer(ResourceCategory::Mesh, m_draws.size() * sizeof(PoolDraw),
+        m_draws.data(), GL_DYNAMIC_STORAGE_BIT, "Mesh Pool Draws"));
+    m_clusterCount = clusters.size();
+    if (!clusters.empty()) {
+        m_meshletSSBO = GpuResource(resources.createBuffer(ResourceCategory::Mesh,
+            meshlets.size() * sizeof(PoolMeshlet), meshlets.data(), 0, "Mesh Pool Meshlets"));
+        m_clusterSSBO = GpuResource(resources.createBuffer(ResourceCategory::Mesh,
+            clusters.size() * sizeof(PoolCluster), clusters.data(), 0, "Mesh Pool Clusters"));
+    }
+    std::vector<GLuint> instanceIndices(std::max(m_draws.size(), clusters.size()));
+    for (GLuint i = 0; i < instanceIndices.size(); i++)
+        instanceIndices[i] = i;
+    m_instanceIndexBuffer = GpuResource(resources.createBuffer(ResourceCategory::Mesh,
+        instanceIndices.size() * sizeof(GLuint), instanceIndices.data(), 0, "Mesh Pool Instance Indices"));
+
+    // The same buffers double as a position-only vertex stream for rasterizing the pool
+    GLuint vao = m_poolVAO.id();
+    glVertexArrayVertexBuffer(vao, 0, m_vertexSSBO.id(), 0, sizeof(PoolVertex));
+    glVertexArrayElementBuffer(vao, m_indexSSBO.id());
+    glEnableVertexArrayAttrib(vao, 0);
+    glVertexArrayAttribFormat(vao, 0, 3, GL_FLOAT, GL_FALSE, 0);
+    glVertexArrayAttribBinding(vao, 0, 0);
+    glVertexArrayVertexBuffer(vao, 1, m_instanceIndexBuffer.id(), 0, sizeof(GLuint));
+    glVertexArrayBindingDivisor(vao, 1, 1);
+    glEnableVertexArrayAttrib(vao, 1);
+    glVertexArrayAttribIFormat(vao, 1, 1, GL_UNSIGNED_INT, 0);
+    glVertexArrayAttribBinding(vao, 1, 1);
+}
+
+/* Sets the level of detail of every draw, clamped to the levels its mesh has */
+void MeshPool::setLods(const std::vector<unsigned int>& drawLods)
+{
+    m_lodTriangleCount = 0;
+    for (unsigned int i = 0; i < m_draws.size() && i < drawLods.size(); i++) {
+        const auto& mesh = m_meshes[m_draws[i].meshIndex];
+        m_draws[i].lod = std::min(drawLods[i], mesh.lodCount - 1);
+        m_lodTriangleCount += mesh.lodIndexCount[m_draws[i].lod] / 3;
+    }
+}
+
+/* Uploads one model matrix per scene object to every draw that came from it, the matrices
+    of the previous call are kept as each draw's prevModel. Call once per frame */
+void MeshPool::updateTransforms(const std::vector<glm::mat4>& objectMatrices)
+{
+    if (m_draws.empty())
+        return;
+    for (unsigned int i = 0; i < m_draws.size(); i++) {
+        const auto& matrix = objectMatrices[m_drawObjects[i]];
+        m_draws[i].prevModel = m_hasTransforms ? m_draws[i].model : matrix;
+        m_draws[i].model = matrix;
+    }
+    m_hasTransforms = true;
+    glNamedBufferSubData(m_drawSSBO.id(), 0, m_draws.size() * sizeof(PoolDraw), m_draws.data());
+}
+
+/* Uploads the scene materials the draws index into, growing the buffer when needed */
+void MeshPool::updateMaterials(const std::vector<Material>& materials)
+{
+    if (materials.empty())
+        return;
+    if (materials.size() > m_materialCapacity) {
+        m_materialCapacity = std::max((unsigned int)materials.size(), m_materialCapacity * 2);
+        m_materialSSBO = GpuResource(ResourceManager::instance().createBuffer(ResourceCategory::Mesh,
+            m_materialCapacity * sizeof(Material), nullptr, GL_DYNAMIC_STORAGE_BIT, "Mesh Pool Materials"));
+    }
+    glNamedBufferSubData(m_materialSSBO.id(), 0, materials.size() * sizeof(Material), materials.data());
+}
+
+/* Rasterizes every draw in the pool at its level of detail. Each draw's index is passed as its
+    base instance, the shader reads it from attribute 1 and fetches the draw from the pool buffers */
+void MeshPool::draw() const
+{
+    bind();
+    glBindVertexArray(m_poolVAO.id());
+    for (unsigned int i = 0; i < m_draws.size(); i++) {
+        const auto& mesh = m_meshes[m_draws[i].meshIndex];
+        GLuint lod = m_draws[i].lod;
+        glDrawElementsInstancedBaseVertexBaseInstance(GL_TRIANGLES, mesh.lodIndexCount[lod], GL_UNSIGNED_INT,
+            (void*)((mesh.firstIndex + mesh.lodFirstIndex[lod]) * sizeof(GLuint)), 1, mesh.baseVertex, i);
+    }
+}
+
+void MeshPool::bind() const
+{
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 9, m_vertexSSBO.id());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 10, m_indexSSBO.id());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 11, m_meshSSBO.id());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 12, m_drawSSBO.id());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 13, m_materialSSBO.id());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 17, m_meshletSSBO.id());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 18, m_clusterSSBO.id());
+}
+
+void MeshPool::releaseBuffers()
+{
+    for (GpuResource* buffer : { &m_vertexSSBO, &m_indexSSBO, &m_meshSSBO, &m_drawSSBO, &m_meshletSSBO,
+        &m_clusterSSBO, &m_instanceIndexBuffer })
+        buffer->reset();
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "../Scene.h"
+
+// std430 layouts, must match shaders/mesh_pool.glsl
+struct PoolVertex {
+    glm::vec4 positionU;
+    glm::vec4 normalV;
+};
+
+struct PoolMesh {
+    GLuint firstIndex;
+    GLuint indexCount;
+    GLuint baseVertex;
+    GLuint meshletOffset;
+    GLuint meshletCount;
+    GLuint lodCount;
+    GLuint padding[2];
+    // Object space bounding box, w unused
+    glm::vec4 boundsMin;
+    glm::vec4 boundsMax;
+    // Index range of each level of detail relative to firstIndex, and its error, see MeshLod
+    glm::uvec4 lodFirstIndex;
+    glm::uvec4 lodIndexCount;
+    glm::vec4 lodError;
+};
+static_assert(Mesh::MAX_LODS == 4, "PoolMesh stores one level of detail per vector component");
+
+struct PoolMeshlet {
+    // Object space bounding sphere and normal cone, see Meshlet
+    glm::vec4 sphere;
+    glm::vec4 cone;
+    glm::vec4 coneApex;
+    // Relative to the mesh's first index
+    GLuint firstIndex;
+    GLuint indexCount;
+    GLuint lod;
+    GLuint padding;
+};
+
+// One meshlet of one draw, the unit the cluster culling pass works on
+struct PoolCluster {
+    GLuint drawIndex;
+    GLuint meshletIndex;
+};
+
+struct PoolDraw {
+    glm::mat4 model;
+    // Last frame's model matrix, for velocity
+    glm::mat4 prevModel;
+    GLuint meshIndex;
+    GLuint triangleOffset;
+    GLuint materialIndex;
+    // Level of detail drawn, set by setLods
+    GLuint lod;
+};
+
+/**
+ * Packs the vertices and indices of every mesh in the scene into one mega buffer that
+ * shaders can fetch from directly. Each model's meshes are stored once, and every scene
+ * object using the model adds a draw per mesh with its own slice of a global triangle ID
+ * range, which is what the visibility buffer stores per pixel. The range covers every level
+ * of detail of the mesh, so a triangle keeps its ID whichever level the draw picks. Meshes
+ * keep the meshlets built at import, and every draw also lists one cluster per meshlet of
+ * every level so it can be culled and drawn in pieces.
+ */
+class MeshPool {
+public:
+    MeshPool();
+    ~MeshPool();
+
+    void build(const std::vector<Model*>& models, const std::vector<SceneObject>& objects);
+    /* One level of detail per draw, uploaded by the next updateTransforms */
+    void setLods(const std::vector<unsigned int>& drawLods);
+    void updateTransforms(const std::vector<glm::mat4>& objectMatrices);
+    void updateMaterials(const std::vector<Material>& materials);
+    /* Expects the drawing shader to be in use */
+    void draw() const;
+    void bind() const;
+
+    inline GLuint vertexArray() const { return m_poolVAO.id(); }
+    inline unsigned int drawCount() const { return m_draws.size(); }
+    inline unsigned int clusterCount() const { return m_clusterCount; }
+    // Size of the triangle ID range, every level of detail of every draw
+    inline unsigned int triangleCount() const { return m_triangleCount; }
+    // Triangles of the levels of detail the draws use
+    inline unsigned int lodTriangleCount() const { return m_lodTriangleCount; }
+
+private:
+    // Tracked under Mesh, every pooled mesh is a second copy of its own buffers
+    GpuResource m_vertexSSBO;
+    GpuResource m_indexSSBO;
+    GpuResource m_meshSSBO;
+    GpuResource m_drawSSBO;
+    GpuResource m_materialSSBO;
+    GpuResource m_meshletSSBO;
+    GpuResource m_clusterSSBO;
+    // Indices 0..n-1 read as an instanced attribute, so a command's base instance selects its
+    // draw or cluster
+    GpuResource m_instanceIndexBuffer;
+    unsigned int m_materialCapacity = 0;
+    GpuResource m_poolVAO;
+
+    std::vector<PoolMesh> m_meshes;
+    std::vector<PoolDraw> m_draws;
+    // Object each draw came from, used to pick its matrix in updateTransforms
+    std::vector<unsigned int> m_drawObjects;
+    unsigned int m_triangleCount = 0;
+    unsigned int m_lodTriangleCount = 0;
+    unsigned int m_clusterCount = 0;
+    // False until the first updateTransforms after a build, prevModel is not known before
+    bool m_hasTransforms = false;
+
+    void releaseBuffers();
+};
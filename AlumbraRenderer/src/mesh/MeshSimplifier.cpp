@@ -0,0 +1,271 @@
+#include "../pch.h"
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+#include "../Profiler.h"
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+
+/* Symmetric 4x4 error quadric of a set of planes, weighted by triangle area so the error
+    divided by the weight is an average squared distance */
+struct Quadric {
+    double a00 = 0, a01 = 0, a02 = 0, a11 = 0, a12 = 0, a22 = 0;
+    double b0 = 0, b1 = 0, b2 = 0, c = 0;
+    double weight = 0;
+
+    static Quadric fromPlane(const glm::dvec3& n, double d, double weight)
+    {
+        Quadric q;
+        q.a00 = n.x * n.x * weight; q.a01 = n.x * n.y * weight; q.a02 = n.x * n.z * weight;
+        q.a11 = n.y * n.y * weight; q.a12 = n.y * n.z * weight; q.a22 = n.z * n.z * weight;
+        q.b0 = n.x * d * weight; q.b1 = n.y * d * weight; q.b2 = n.z * d * weight;
+        q.c = d * d * weight;
+        q.weight = weight;
+        return q;
+    }
+    Quadric& operator+=(const Quadric& o)
+    {
+        a00 += o.a00; a01 += o.a01; a02 += o.a02; a11 += o.a11; a12 += o.a12; a22 += o.a22;
+        b0 += o.b0; b1 += o.b1; b2 += o.b2; c += o.c;
+        weight += o.weight;
+        return *this;
+    }
+    // Average squared distance of p to the planes
+    double error(const glm::vec3& point) const
+    {
+        glm::dvec3 p(point);
+        double e = p.x * (a00 * p.x + 2.0 * (a01 * p.y + a02 * p.z + b0))
+            + p.y * (a11 * p.y + 2.0 * (a12 * p.z + b1))
+            + p.z * (a22 * p.z + 2.0 * b2) + c;
+        return weight > 0.0 ? std::max(e, 0.0) / weight : 0.0;
+    }
+};
+
+struct Collapse {
+    float cost;
+    // Geometric part of the cost, the rest is the normal penalty
+    float error;
+    unsigned int from, to;
+};
+
+void MeshSimplifier::buildLods(MeshData& data, float reduction)
+{
+    PROFILE_FUNCTION();
+    data.lods.clear();
+    if (data.indices.empty())
+        return;
+    data.lods.push_back({ 0, (unsigned int)data.indices.size(), 0.0f });
+
+    std::vector<unsigned int> current(data.indices);
+    float error = 0.0f;
+    while (data.lods.size() < Mesh::MAX_LODS && current.size() / 3 >= MIN_TRIANGLES) {
+        unsigned int target = (unsigned int)(current.size() / 3 * reduction) * 3;
+        float levelError = 0.0f;
+        std::vector<unsigned int> next = simplify(data.positions, data.normals, current, target,
+            std::numeric_limits<float>::max(), &levelError);
+        // Locked borders and seams can stop a mesh from shrinking much, such a level is not
+        // worth its memory
+        if (next.empty() || next.size() > current.size() * 0.8f)
+            break;
+        MeshOptimizer::optimizeVertexCache(next, (unsigned int)data.positions.size());
+        // Each level is measured against the one it was built from, their sum bounds the
+        // distance to the full detail mesh
+        error += levelError;
+        data.lods.push_back({ (unsigned int)data.indices.size(), (unsigned int)next.size(), error });
+        data.indices.insert(data.indices.end(), next.begin(), next.end());
+        current = std::move(next);
+    }
+}
+
+std::vector<unsigned int> MeshSimplifier::simplify(const std::vector<glm::vec3>& positions,
+    const std::vector<glm::vec3>& normals, const std::vector<unsigned int>& indices,
+    unsigned int targetIndexCount, float targetError, float* resultError)
+{
+    unsigned int vertexCount = (unsigned int)positions.size();
+    bool hasNormals = normals.size() == vertexCount;
+    std::vector<unsigned int> result(indices);
+    float maxError = 0.0f;
+
+    // Vertices sharing a position, the first one stands for the group
+    std::vector<unsigned int> positionGroup(vertexCount);
+    std::vector<unsigned int> groupSize(vertexCount, 0);
+    {
+        auto hashPosition = [&](unsigned int v) {
+            unsigned int bits[3];
+            std::memcpy(bits, &positions[v], sizeof(bits));
+            return (size_t)bits[0] * 73856093u ^ (size_t)bits[1] * 19349663u ^ (size_t)bits[2] * 83492791u;
+        };
+        auto equalPosition = [&](unsigned int a, unsigned int b) {
+            return std::memcmp(&positions[a], &positions[b], sizeof(glm::vec3)) == 0;
+        };
+        std::unordered_map<unsigned int, unsigned int, decltype(hashPosition), decltype(equalPosition)>
+            groups(vertexCount, hashPosition, equalPosition);
+        for (unsigned int v = 0; v < vertexCount; v++) {
+            positionGroup[v] = groups.emplace(v, v).first->second;
+            groupSize[positionGroup[v]]++;
+        }
+    }
+
+    // Seams, open borders and non manifold edges are found on positions so that a UV seam
+    // does not count as a border
+    std::vector<unsigned char> locked(vertexCount, 0);
+    for (unsigned int v = 0; v < vertexCount; v++)
+        locked[v] = groupSize[positionGroup[v]] > 1 ? 1 : 0;
+    {
+        std::unordered_map<unsigned long long, unsigned int> edgeUses;
+        edgeUses.reserve(result.size());
+        auto edgeKey = [&](unsigned int a, unsigned int b) {
+            unsigned long long ga = positionGroup[a], gb = positionGroup[b];
+            return ga < gb ? (ga << 32) | gb : (gb << 32) | ga;
+        };
+        for (unsigned int i = 0; i < result.size(); i += 3) {
+            for (int k = 0; k < 3; k++)
+                edgeUses[edgeKey(result[i + k], result[i + (k + 1) % 3])]++;
+        }
+        for (unsigned int i = 0; i < result.size(); i += 3) {
+            for (int k = 0; k < 3; k++) {
+                unsigned int a = result[i + k], b = result[i + (k + 1) % 3];
+                if (edgeUses[edgeKey(a, b)] != 2)
+                    locked[a] = locked[b] = 1;
+            }
+        }
+    }
+
+    std::vector<Quadric> quadrics(vertexCount);
+    for (unsigned int i = 0; i + 2 < result.size(); i += 3) {
+        glm::dvec3 a(positions[result[i]]), b(positions[result[i + 1]]), c(positions[result[i + 2]]);
+        glm::dvec3 normal = glm::cross(b - a, c - a);
+        double length = glm::length(normal);
+        if (length == 0.0)
+            continue;
+        normal /= length;
+        Quadric plane = Quadric::fromPlane(normal, -glm::dot(normal, a), length * 0.5);
+        for (int k = 0; k < 3; k++)
+            quadrics[result[i + k]] += plane;
+    }
+
+    std::vector<unsigned int> adjacencyOffsets, adjacency, remap(vertexCount);
+    std::vector<unsigned char> touched(vertexCount);
+    std::vector<Collapse> collapses;
+    std::vector<unsigned int> ring, shared;
+    float maxCost = targetError < std::numeric_limits<float>::max() ? targetError * targetError : targetError;
+
+    while (result.size() > targetIndexCount) {
+        unsigned int triangleCount = (unsigned int)result.size() / 3;
+        adjacencyOffsets.assign(vertexCount + 1, 0);
+        for (unsigned int index : result)
+            adjacencyOffsets[index + 1]++;
+        for (unsigned int v = 0; v < vertexCount; v++)
+            adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+        adjacency.resize(result.size());
+        std::vector<unsigned int> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+        for (unsigned int i = 0; i < result.size(); i++)
+            adjacency[fill[result[i]]++] = i / 3;
+
+        collapses.clear();
+        for (unsigned int i = 0; i < result.size(); i += 3) {
+            for (int k = 0; k < 3; k++) {
+                unsigned int a = result[i + k], b = result[i + (k + 1) % 3];
+                for (int direction = 0; direction < 2; direction++) {
+                    if (!locked[a]) {
+                        Quadric merged = quadrics[a];
+                        merged += quadrics[b];
+                        float error = (float)merged.error(positions[b]);
+                        float cost = error;
+                        if (hasNormals) {
+                            glm::vec3 edge = positions[a] - positions[b];
+                            glm::vec3 turn = normals[a] - normals[b];
+                            cost += 0.5f * glm::dot(turn, turn) * glm::dot(edge, edge);
+                        }
+                        collapses.push_back({ cost, error, a, b });
+                    }
+                    std::swap(a, b);
+                }
+            }
+        }
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& x, const Collapse& y) { return x.cost < y.cost; });
+
+        // Each collapse removes about two triangles, a collapse locks the one ring of the vertex
+        // it removes so the flip test stays valid for the rest of the pass
+        for (unsigned int v = 0; v < vertexCount; v++)
+            remap[v] = v;
+        std::fill(touched.begin(), touched.end(), 0);
+        unsigned int trianglesToRemove = (triangleCount - targetIndexCount / 3);
+        unsigned int removed = 0;
+        for (const auto& collapse : collapses) {
+            if (removed >= trianglesToRemove || collapse.cost > maxCost)
+                break;
+            unsigned int a = collapse.from, b = collapse.to;
+            if (touched[a] || touched[b])
+                continue;
+
+            // Link condition, a and b may only share the neighbours of the triangles on their
+            // edge or the collapse folds the surface onto itself
+            ring.clear();
+            shared.clear();
+            for (unsigned int j = adjacencyOffsets[b]; j < adjacencyOffsets[b + 1]; j++) {
+                const unsigned int* triangle = &result[adjacency[j] * 3];
+                for (int k = 0; k < 3; k++)
+                    ring.push_back(positionGroup[triangle[k]]);
+            }
+            unsigned int degenerate = 0;
+            for (unsigned int j = adjacencyOffsets[a]; j < adjacencyOffsets[a + 1]; j++) {
+                const unsigned int* triangle = &result[adjacency[j] * 3];
+                if (triangle[0] == b || triangle[1] == b || triangle[2] == b) {
+                    degenerate++;
+                    for (int k = 0; k < 3; k++)
+                        shared.push_back(positionGroup[triangle[k]]);
+                }
+            }
+            bool flips = false;
+            for (unsigned int j = adjacencyOffsets[a]; j < adjacencyOffsets[a + 1] && !flips; j++) {
+                const unsigned int* triangle = &result[adjacency[j] * 3];
+                if (triangle[0] == b || triangle[1] == b || triangle[2] == b)
+                    continue;
+                glm::vec3 p[3], q[3];
+                for (int k = 0; k < 3; k++) {
+                    p[k] = positions[triangle[k]];
+                    q[k] = triangle[k] == a ? positions[b] : p[k];
+                }
+                glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+                glm::vec3 after = glm::cross(q[1] - q[0], q[2] - q[0]);
+                // Also rejects triangles turning by more than about 75 degrees
+                flips = glm::dot(before, after) <= 0.25f * glm::length(before) * glm::length(after);
+                for (int k = 0; k < 3 && !flips; k++) {
+                    unsigned int group = positionGroup[triangle[k]];
+                    flips = std::find(ring.begin(), ring.end(), group) != ring.end()
+                        && std::find(shared.begin(), shared.end(), group) == shared.end();
+                }
+            }
+            if (flips)
+                continue;
+
+            remap[a] = b;
+            quadrics[b] += quadrics[a];
+            maxError = std::max(maxError, collapse.error);
+            removed += degenerate;
+            for (unsigned int j = adjacencyOffsets[a]; j < adjacencyOffsets[a + 1]; j++) {
+                const unsigned int* triangle = &result[adjacency[j] * 3];
+                touched[triangle[0]] = touched[triangle[1]] = touched[triangle[2]] = 1;
+            }
+        }
+        if (removed == 0)
+            break;
+
+        unsigned int kept = 0;
+        for (unsigned int i = 0; i < result.size(); i += 3) {
+            unsigned int a = remap[result[i]], b = remap[result[i + 1]], c = remap[result[i + 2]];
+            if (a == b || b == c || a == c)
+                continue;
+            result[kept++] = a;
+            result[kept++] = b;
+            result[kept++] = c;
+        }
+        result.resize(kept);
+    }
+
+    if (resultError)
+        *resultError = std::sqrt(maxError);
+    return result;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "Mesh.h"
+
+/**
+ * Quadric error metric simplification (Garland and Heckbert 1997) for building LOD chains at
+ * import, no GL calls. Vertices are collapsed onto a neighbour, never moved, so every level
+ * keeps indexing the mesh's original vertices and only needs its own index range. Vertices on
+ * open borders, on attribute seams (shared positions with different normals or UVs) or on non
+ * manifold edges never collapse, which keeps silhouettes and texture layouts intact, and
+ * collapses between vertices with different normals are penalised on top of the quadric error.
+ */
+class MeshSimplifier {
+public:
+    // Meshes below this many triangles are not worth more levels
+    static constexpr unsigned int MIN_TRIANGLES = 64;
+
+    /* Appends up to Mesh::MAX_LODS - 1 coarser levels to data.indices, each with about
+        reduction times the triangles of the one before, and fills data.lods */
+    static void buildLods(MeshData& data, float reduction = 0.5f);
+
+    /* Collapses edges until at most targetIndexCount indices remain or the next collapse would
+        exceed targetError. The error reached, in object space units, is written to resultError */
+    static std::vector<unsigned int> simplify(const std::vector<glm::vec3>& positions,
+        const std::vector<glm::vec3>& normals, const std::vector<unsigned int>& indices,
+        unsigned int targetIndexCount, float targetError, float* resultError = nullptr);
+};
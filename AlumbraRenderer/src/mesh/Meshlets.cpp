@@ -0,0 +1,193 @@
+#include "../pch.h"
+#include "Meshlets.h"
+#include "../Bounds.h"
+
+#include <algorithm>
+
+std::vector<Meshlet> Meshlets::build(const std::vector<glm::vec3>& positions, std::vector<unsigned int>& indices)
+{
+    bool sequential = indices.empty();
+    std::vector<unsigned int> sequentialIndices;
+    if (sequential) {
+        sequentialIndices.resize(positions.size() - positions.size() % 3);
+        for (unsigned int i = 0; i < sequentialIndices.size(); i++)
+            sequentialIndices[i] = i;
+    }
+    const std::vector<unsigned int>& source = sequential ? sequentialIndices : indices;
+    unsigned int triangleCount = (unsigned int)source.size() / 3;
+    unsigned int vertexCount = (unsigned int)positions.size();
+    std::vector<Meshlet> meshlets;
+    if (triangleCount == 0)
+        return meshlets;
+
+    // Triangles using each vertex, as offsets into one flat list
+    std::vector<unsigned int> adjacencyOffsets(vertexCount + 1, 0);
+    for (unsigned int index : source)
+        adjacencyOffsets[index + 1]++;
+    for (unsigned int v = 0; v < vertexCount; v++)
+        adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+    std::vector<unsigned int> adjacency(source.size());
+    std::vector<unsigned int> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+    for (unsigned int t = 0; t < triangleCount; t++) {
+        for (int k = 0; k < 3; k++)
+            adjacency[fill[source[t * 3 + k]]++] = t;
+    }
+
+    std::vector<unsigned char> used(triangleCount, 0);
+    // Meshlet each vertex was last added to, so new vertices can be counted without a set
+    std::vector<unsigned int> vertexMeshlet(vertexCount, ~0u);
+    std::vector<unsigned int> reordered;
+    reordered.reserve(source.size());
+    std::vector<unsigned int> candidates, triangles;
+    unsigned int nextSeed = 0;
+
+    unsigned int meshletTriangles = 0;
+    while (meshletTriangles < triangleCount) {
+        unsigned int id = (unsigned int)meshlets.size();
+        Meshlet meshlet;
+        meshlet.firstIndex = (unsigned int)reordered.size();
+        glm::vec3 vertexSum(0.0f);
+        candidates.clear();
+        triangles.clear();
+
+        while (true) {
+            auto newVertices = [&](unsigned int t) {
+                unsigned int count = 0;
+                for (int k = 0; k < 3; k++)
+                    count += vertexMeshlet[source[t * 3 + k]] != id ? 1 : 0;
+                return count;
+            };
+
+            // Unused neighbour needing the fewest new vertices, ties go to the one closest to the
+            // meshlet's centroid so it grows as a round patch rather than a strip
+            glm::vec3 centroid = meshlet.vertexCount > 0 ? vertexSum / (float)meshlet.vertexCount : glm::vec3(0.0f);
+            unsigned int best = ~0u, bestNew = 4;
+            float bestDistance = 0.0f;
+            unsigned int kept = 0;
+            for (unsigned int t : candidates) {
+                if (used[t])
+                    continue;
+                candidates[kept++] = t;
+                unsigned int count = newVertices(t);
+                if (count > bestNew)
+                    continue;
+                glm::vec3 offset = positions[source[t * 3]] + positions[source[t * 3 + 1]]
+                    + positions[source[t * 3 + 2]] - 3.0f * centroid;
+                float distance = glm::dot(offset, offset);
+                if (count < bestNew || distance < bestDistance) {
+                    best = t;
+                    bestNew = count;
+                    bestDistance = distance;
+                }
+            }
+            candidates.resize(kept);
+
+            // Out of neighbours, a nearly empty meshlet carries on with the next triangle in order,
+            // this is also what groups the triangles of unindexed meshes
+            if (best == ~0u) {
+                if (meshlet.triangleCount >= MAX_TRIANGLES / 2)
+                    break;
+                while (nextSeed < triangleCount && used[nextSeed])
+                    nextSeed++;
+                if (nextSeed == triangleCount)
+                    break;
+                best = nextSeed;
+                bestNew = newVertices(best);
+            }
+            if (meshlet.vertexCount + bestNew > MAX_VERTICES || meshlet.triangleCount == MAX_TRIANGLES)
+                break;
+
+            used[best] = 1;
+            meshlet.vertexCount += bestNew;
+            meshlet.triangleCount++;
+            triangles.push_back(best);
+            for (int k = 0; k < 3; k++) {
+                unsigned int v = source[best * 3 + k];
+                if (vertexMeshlet[v] == id)
+                    continue;
+                vertexMeshlet[v] = id;
+                vertexSum += positions[v];
+                for (unsigned int a = adjacencyOffsets[v]; a < adjacencyOffsets[v + 1]; a++) {
+                    if (!used[adjacency[a]])
+                        candidates.push_back(adjacency[a]);
+                }
+            }
+        }
+        // Within a meshlet triangles keep their input order, which MeshOptimizer may have tuned
+        // for the vertex cache and overdraw
+        std::sort(triangles.begin(), triangles.end());
+        for (unsigned int t : triangles)
+            reordered.insert(reordered.end(), source.begin() + t * 3, source.begin() + t * 3 + 3);
+        computeBounds(meshlet, positions, reordered.data() + meshlet.firstIndex);
+        meshletTriangles += meshlet.triangleCount;
+        meshlets.push_back(meshlet);
+    }
+
+    if (!sequential)
+        indices = std::move(reordered);
+    return meshlets;
+}
+
+bool Meshlets::coneCulled(const Meshlet& meshlet, const glm::vec3& cameraPosition)
+{
+    glm::vec3 direction = meshlet.coneApex - cameraPosition;
+    float length = glm::length(direction);
+    if (length == 0.0f)
+        return false;
+    return glm::dot(direction / length, glm::vec3(meshlet.cone)) >= meshlet.cone.w;
+}
+
+/* Sphere around the center of the vertices' box. The cone axis is the average triangle facing
+    and its cutoff comes from the triangle deviating most from it, the apex is pushed back far
+    enough that every triangle plane lies in front of it */
+void Meshlets::computeBounds(Meshlet& meshlet, const std::vector<glm::vec3>& positions,
+    const unsigned int* indices)
+{
+    unsigned int indexCount = meshlet.triangleCount * 3;
+    AABB box;
+    for (unsigned int i = 0; i < indexCount; i++)
+        box.expand(positions[indices[i]]);
+    glm::vec3 center = box.center();
+    float radius = 0.0f;
+    for (unsigned int i = 0; i < indexCount; i++)
+        radius = std::max(radius, glm::length(positions[indices[i]] - center));
+    meshlet.sphere = glm::vec4(center, radius);
+
+    // Unit normal and first corner of every non degenerate triangle
+    std::vector<glm::vec3> normals, corners;
+    normals.reserve(meshlet.triangleCount);
+    corners.reserve(meshlet.triangleCount);
+    glm::vec3 axis(0.0f);
+    for (unsigned int i = 0; i < indexCount; i += 3) {
+        const glm::vec3& a = positions[indices[i]];
+        glm::vec3 normal = glm::cross(positions[indices[i + 1]] - a, positions[indices[i + 2]] - a);
+        float length = glm::length(normal);
+        // Degenerate triangles are never rasterized and do not constrain the cone
+        if (length == 0.0f)
+            continue;
+        normals.push_back(normal / length);
+        corners.push_back(a);
+        axis += normals.back();
+    }
+    meshlet.cone = glm::vec4(0.0f, 0.0f, 1.0f, 2.0f);
+    meshlet.coneApex = center;
+    float axisLength = glm::length(axis);
+    if (normals.empty() || axisLength == 0.0f)
+        return;
+    axis /= axisLength;
+
+    float minDot = 1.0f;
+    for (const auto& normal : normals)
+        minDot = std::min(minDot, glm::dot(normal, axis));
+    // Wider cones barely cull anything and their apex runs off to infinity
+    if (minDot <= 0.1f) {
+        meshlet.cone = glm::vec4(axis, 2.0f);
+        return;
+    }
+
+    float maxT = 0.0f;
+    for (unsigned int i = 0; i < normals.size(); i++)
+        maxT = std::max(maxT, glm::dot(center - corners[i], normals[i]) / glm::dot(axis, normals[i]));
+    meshlet.coneApex = center - axis * maxT;
+    meshlet.cone = glm::vec4(axis, std::sqrt(1.0f - minDot * minDot));
+}
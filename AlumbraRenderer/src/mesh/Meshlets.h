@@ -0,0 +1,41 @@
+#pragma once
+
+/* A cluster of up to Meshlets::MAX_TRIANGLES triangles referencing at most
+    Meshlets::MAX_VERTICES vertices, small enough to be culled on its own */
+struct Meshlet {
+    // Into the mesh's index list, a meshlet's triangles are contiguous
+    unsigned int firstIndex = 0;
+    unsigned int triangleCount = 0;
+    unsigned int vertexCount = 0;
+    // Level of detail whose index range the meshlet lies in
+    unsigned int lod = 0;
+    // Object space bounding sphere, center in xyz and radius in w
+    glm::vec4 sphere = glm::vec4(0.0f);
+    // Average facing in xyz and the cosine cutoff in w, above 1 when the triangles face too many
+    // ways for the cone to ever cull them
+    glm::vec4 cone = glm::vec4(0.0f, 0.0f, 1.0f, 2.0f);
+    // Seen from anywhere inside the cone behind the apex every triangle faces away
+    glm::vec3 coneApex = glm::vec3(0.0f);
+};
+
+/**
+ * Splits meshes into meshlets at import. Meshlets are grown greedily from a seed triangle by
+ * always adding the unused neighbouring triangle that brings in the fewest new vertices,
+ * which keeps them compact enough for tight bounding spheres and normal cones. Index lists are
+ * reordered in place so every meshlet is a contiguous range that can be drawn on its own.
+ */
+class Meshlets {
+public:
+    static constexpr unsigned int MAX_VERTICES = 64;
+    static constexpr unsigned int MAX_TRIANGLES = 124;
+
+    /* Builds the meshlets of a triangle list and reorders its indices to match. An empty index
+        list stands for sequential indices, its unshared vertices keep the triangles in order */
+    static std::vector<Meshlet> build(const std::vector<glm::vec3>& positions, std::vector<unsigned int>& indices);
+    /* True when the camera sees the back of every triangle in the meshlet */
+    static bool coneCulled(const Meshlet& meshlet, const glm::vec3& cameraPosition);
+
+private:
+    static void computeBounds(Meshlet& meshlet, const std::vector<glm::vec3>& positions,
+        const unsigned int* indices);
+};
@@ -1,29 +1,53 @@
 #include "../pch.h"
 #include "Model.h"
+#include "MeshSimplifier.h"
+#include "../Profiler.h"
 
 #include <stb_image.h>
 
-Model::Model(const Mesh& mesh) {
-    meshes.push_back(mesh);
+Model::Model(Mesh&& mesh) {
+    m_bounds = mesh.bounds();
+    m_meshes.push_back(std::make_shared<Mesh>(std::move(mesh)));
+}
+
+Model::Model(MeshHandle mesh) {
+    m_bounds = mesh->bounds();
+    m_meshes.push_back(std::move(mesh));
 }
 
 Model::Model(const std::string& path) {
     loadModel(path);
 }
 
-/* Draws the model by drawing all its meshes */
-void Model::draw(Shader shader) {
-    for (unsigned int i = 0; i < meshes.size(); i++)
-        meshes[i].draw(shader);
+/* Draws the model by drawing all its meshes, lods holds one level per mesh or is empty for
+    full detail */
+void Model::draw(Shader shader, const unsigned int* lods) {
+    for (unsigned int i = 0; i < m_meshes.size(); i++)
+        m_meshes[i]->draw(shader, lods ? lods[i] : 0);
+}
+
+unsigned int Model::triangleCount(const unsigned int* lods) const
+{
+    unsigned int triangles = 0;
+    for (unsigned int i = 0; i < m_meshes.size(); i++) {
+        const Mesh& mesh = *m_meshes[i];
+        triangles += mesh.m_lods[std::min(lods ? lods[i] : 0u, mesh.lodCount() - 1)].indexCount / 3;
+    }
+    return triangles;
 }
 
 /* Loads a model with supported ASSIMP extensions from file and stores the resulting meshes
     in the meshes vector */
 void Model::loadModel(const std::string& path) {
+    PROFILE_FUNCTION();
     // read the file via ASSIMP
     Assimp::Importer importer;
-    const aiScene* scene = importer.ReadFile(path, 
-        aiProcess_Triangulate | aiProcess_FlipUVs |aiProcess_CalcTangentSpace);
+    const aiScene* scene;
+    {
+        PROFILE_SCOPE("Assimp Import");
+        scene = importer.ReadFile(path,
+            aiProcess_Triangulate | aiProcess_FlipUVs |aiProcess_CalcTangentSpace);
+    }
 
     // check for errors
     if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
@@ -33,6 +57,7 @@ void Model::loadModel(const std::string& path) {
 
     //retrieve the directory path of the filepath
     directory = path.substr(0, path.find_last_of('/'));
+    m_path = AssetRegistry::canonicalPath(path);
 
     // process ASSIMP's root node recursively
     processNode(scene->mRootNode, scene);
@@ -43,8 +68,9 @@ void Model::loadModel(const std::string& path) {
 void Model::processNode(aiNode* node, const aiScene* scene) {
     // process all the node's meshes (if any)
     for (unsigned int i = 0; i < node->mNumMeshes; i++) {
-        aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-        meshes.push_back(processMesh(mesh, scene));
+        unsigned int meshIndex = node->mMeshes[i];
+        m_meshes.push_back(processMesh(scene->mMeshes[meshIndex], scene, meshIndex));
+        m_bounds.expand(m_meshes.back()->bounds());
     }
     // then do the same for each of its children
     for (unsigned int i = 0; i < node->mNumChildren; i++) {
@@ -52,37 +78,58 @@ void Model::processNode(aiNode* node, const aiScene* scene) {
     }
 }
 
-Mesh Model::processMesh(aiMesh* mesh, const aiScene* scene) {
-    // data to fill
-    std::vector<glm::vec3> positions;
-    std::vector<glm::vec3> normals;
-    std::vector<glm::vec2> texCoords;
-    std::vector<glm::vec3> tangents;
-    std::vector<glm::vec3> bitangents;
-    std::vector<unsigned int> indices;
-    std::vector<MeshTexture> textures;
+MeshData Model::extractMeshData(const aiMesh* mesh) {
+    MeshData data;
+    bool hasTangents = mesh->mTangents && mesh->mBitangents;
 
     // walk through each of the mesh's vertices
-    positions.reserve(mesh->mNumVertices);
-    normals.reserve(mesh->mNumVertices);
-    textures.reserve(mesh->mNumVertices);
+    data.positions.reserve(mesh->mNumVertices);
+    data.normals.reserve(mesh->mNumVertices);
+    if (hasTangents) {
+        data.tangents.reserve(mesh->mNumVertices);
+        data.bitangents.reserve(mesh->mNumVertices);
+    }
+    else {
+        // setupMesh always packs tangent streams, zero them for meshes without UVs
+        data.tangents.assign(mesh->mNumVertices, glm::vec3(0.0f));
+        data.bitangents.assign(mesh->mNumVertices, glm::vec3(0.0f));
+    }
+    if (mesh->mTextureCoords[0])
+        data.texCoords.reserve(mesh->mNumVertices);
     for (unsigned int i = 0; i < mesh->mNumVertices; i++) {
-        positions.emplace_back(mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z);
-        normals.emplace_back(mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z);
-        tangents.emplace_back(mesh->mTangents[i].x, mesh->mTangents[i].y, mesh->mTangents[i].z);
-        bitangents.emplace_back(mesh->mBitangents[i].x, mesh->mBitangents[i].y, mesh->mBitangents[i].z);
+        data.positions.emplace_back(mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z);
+        data.normals.emplace_back(mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z);
+        if (hasTangents) {
+            data.tangents.emplace_back(mesh->mTangents[i].x, mesh->mTangents[i].y, mesh->mTangents[i].z);
+            data.bitangents.emplace_back(mesh->mBitangents[i].x, mesh->mBitangents[i].y, mesh->mBitangents[i].z);
+        }
         if (mesh->mTextureCoords[0]) {
-            texCoords.emplace_back(mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y);
+            data.texCoords.emplace_back(mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y);
         }
     }
-    // now walk through each of the mesh's faces and retrieve the corresponding vertex indices
+    // now walk through each of the mesh's faces and retrieve the corresponding vertex indices,
+    // faces are triangles after aiProcess_Triangulate
+    data.indices.reserve(mesh->mNumFaces * 3);
     for (unsigned int i = 0; i < mesh->mNumFaces; i++) {
-        aiFace face = mesh->mFaces[i];
+        const aiFace& face = mesh->mFaces[i];
         // retrieve all indices of the face and store them int the indices vector
-        for (unsigned int j = 0; j < face.mNumIndices; j++) {
-            indices.push_back(face.mIndices[j]);
-        }
+        data.indices.insert(data.indices.end(), face.mIndices, face.mIndices + face.mNumIndices);
     }
+    return data;
+}
+
+/* Meshes are shared through the asset registry, first by the file and index they were
+    loaded from, then by content, only a mesh seen for the first time is optimized and uploaded */
+MeshHandle Model::processMesh(aiMesh* mesh, const aiScene* scene, unsigned int meshIndex) {
+    AssetRegistry& registry = AssetRegistry::instance();
+    std::string key = m_path + "#" + std::to_string(meshIndex);
+    if (MeshHandle shared = registry.findMesh(key))
+        return shared;
+
+    // data to fill
+    MeshData data = extractMeshData(mesh);
+    std::vector<MeshTexture> textures;
+
     // process materials
     if (mesh->mMaterialIndex >= 0) {
         aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
@@ -97,44 +144,43 @@ Mesh Model::processMesh(aiMesh* mesh, const aiScene* scene) {
         textures.insert(textures.end(), normalMaps.begin(), normalMaps.end());
     }
 
-    // return a mesh object created from the extracted mesh data
-    return Mesh(positions, normals, texCoords, tangents, bitangents, indices, textures);
+    bool built = false;
+    MeshHandle result = registry.mesh(std::move(data), textures, [&](MeshData& prepared) {
+        built = true;
+        // ASSIMP is not asked to join identical vertices, the optimizer welds them over every
+        // attribute along with reordering for the vertex cache, overdraw and fetch locality
+        MeshOptimizer::accumulate(m_optimizeStats.before, MeshOptimizer::analyze(prepared.positions, prepared.indices));
+        MeshOptimizer::optimize(prepared);
+        // Coarser levels are appended after the optimized indices and only share its vertices
+        MeshSimplifier::buildLods(prepared);
+    }, key);
+    if (!built)
+        return result;
+
+    // Measured after the meshlet build had its turn at the triangle order
+    const MeshLod& full = result->m_lods[0];
+    std::vector<unsigned int> fullIndices(result->m_indices.begin() + full.firstIndex,
+        result->m_indices.begin() + full.firstIndex + full.indexCount);
+    MeshOptimizer::accumulate(m_optimizeStats.after, MeshOptimizer::analyze(result->m_positions, fullIndices));
+    return result;
 }
 
-/* Checks all material textures of a given type and loads the textures if they're not loaded yet.
-    The required info is returned as a Texture struct */
+/* Gets all material textures of a given type from the asset registry, loading the ones no
+    model has loaded yet. The required info is returned as a Texture struct */
 std::vector<MeshTexture> Model::loadMaterialTextures(aiMaterial* mat,
     aiTextureType type, std::string typeName) {
     std::vector<MeshTexture> textures;
 
+    TextureOptions texOps;
+    texOps.wrapS = GL_REPEAT;
+    texOps.wrapT = GL_REPEAT;
     for (unsigned int i = 0; i < mat->GetTextureCount(type); i++) {
         aiString str;
         mat->GetTexture(type, i, &str);
-        // check if the texture was loaded before and if so, continue to next iteration
-        bool skip = false;
-        for (unsigned int j = 0; j < texturesLoaded.size(); j++) {
-            if (std::strcmp(texturesLoaded[j].path.data(), str.C_Str()) == 0) {
-                textures.push_back(texturesLoaded[j]);
-                skip = true;	// a texture with the same filepath has already been loaded, continue to next
-                break;
-            }
-        }
-
-        TextureLoader tex;
-        TextureOptions texOps;
-        texOps.wrapS = GL_REPEAT;
-        texOps.wrapT = GL_REPEAT;
-        if (!skip) { // if texture hasn't been loaded already, load it
-            MeshTexture texture;
-            std::string filename = std::string(str.C_Str());
-            filename = directory + '/' + filename;
-            tex.createNew(GL_TEXTURE_2D, texOps);
-            texture.id = tex.fileTexture(filename);
-            texture.type = typeName;
-            texture.path = tex.path();
-            textures.push_back(texture);
-            texturesLoaded.push_back(texture); // add to loaded textures
-        }
+        // the registry loads each file once for every model in the scene
+        TextureHandle texture = AssetRegistry::instance().texture(directory + '/' + str.C_Str(), texOps);
+        if (texture)
+            textures.push_back({ texture->id, typeName, texture->path, texture });
     }
     return textures;
 }
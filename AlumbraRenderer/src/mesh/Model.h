@@ -5,27 +5,44 @@
 #include <assimp/postprocess.h>
 
 #include "Mesh.h"
-#include "../Texture.h"
+#include "MeshOptimizer.h"
+#include "../AssetRegistry.h"
 
 class Model {
 public:
     /* Functions */
-    Model(const Mesh& mesh);
+    Model(Mesh&& mesh);
+    /* Model of a single mesh shared through the asset registry */
+    Model(MeshHandle mesh);
     /* Constructor, expects a filepath to a 3D model */
     Model(const std::string& path);
-    void draw(Shader shader);
+    void draw(Shader shader, const unsigned int* lods = nullptr);
+
+    inline const std::vector<MeshHandle>& meshes() const { return m_meshes; }
+    // Triangles drawn with one level per mesh, full detail without lods
+    unsigned int triangleCount(const unsigned int* lods = nullptr) const;
+    // Union of the mesh bounds in model space
+    inline const AABB& bounds() const { return m_bounds; }
+    // Imported meshes summed up as extracted and as uploaded, ACMR and overdraw weighted by
+    // triangles. Meshes shared from the asset registry were measured by the model that built them
+    inline const MeshOptimizeStats& optimizeStats() const { return m_optimizeStats; }
+
+    /* Copies the vertex attributes and face indices of an ASSIMP mesh, no GL calls */
+    static MeshData extractMeshData(const aiMesh* mesh);
 
 private:
     /* Model data */
-    std::vector<Mesh> meshes;
+    // Shared with every other model holding the same content
+    std::vector<MeshHandle> m_meshes;
+    AABB m_bounds;
+    MeshOptimizeStats m_optimizeStats;
+    std::string m_path;
     std::string directory;
-    // stores all the textures loaded so far
-    std::vector<MeshTexture> texturesLoaded;
 
     /* Functions */
     void loadModel(const std::string& path);
     void processNode(aiNode* node, const aiScene* scene);
-    Mesh processMesh(aiMesh* mesh, const aiScene* scene);
+    MeshHandle processMesh(aiMesh* mesh, const aiScene* scene, unsigned int meshIndex);
     std::vector<MeshTexture> loadMaterialTextures(aiMaterial* mat, aiTextureType type,
         std::string typeName);
 };
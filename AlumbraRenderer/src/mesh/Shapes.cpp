@@ -1,5 +1,19 @@
 #include "../pch.h"
 #include "Shapes.h"
+#include "MeshSimplifier.h"
+#include "../AssetRegistry.h"
+
+/* Repeating texture from the asset registry, shared with every other shape and model using the file */
+static MeshTexture loadTexture(const std::string& path, const std::string& type)
+{
+    TextureOptions texOps;
+    texOps.wrapS = GL_REPEAT;
+    texOps.wrapT = GL_REPEAT;
+    TextureHandle texture = AssetRegistry::instance().texture(path, texOps);
+    if (!texture)
+        return { 0, type, path };
+    return { texture->id, type, texture->path, texture };
+}
 
 Cube::Cube(const std::string& diffTexPath, const std::string& specTexPath, const std::string& normTexPath)
 {
@@ -7,28 +21,12 @@ Cube::Cube(const std::string& diffTexPath, const std::string& specTexPath, const
     m_normals = cubeNormals;
     m_texCoords = cubeTexCoords;
 
-    TextureLoader texture;
-    TextureOptions texOps;
-    texOps.wrapS = GL_REPEAT;
-    texOps.wrapT = GL_REPEAT;
-    texture.createNew(GL_TEXTURE_2D, texOps);
-    texture.fileTexture(diffTexPath);
-    m_textures.push_back({ texture.textureID(), "texture_diffuse", texture.path() });
-
-    if (specTexPath != "") {
-        texture.createNew(GL_TEXTURE_2D, texOps);
-        texture.fileTexture(specTexPath);
-        m_textures.push_back({ texture.textureID(), "texture_specular", texture.path() });
-    }
-    else {
-        // Use the same as diffuse texture
-        m_textures.push_back({ texture.textureID(), "texture_specular", texture.path() });
-    }
+    m_textures.push_back(loadTexture(diffTexPath, "texture_diffuse"));
+    // Use the same as diffuse texture without a specular one
+    m_textures.push_back(loadTexture(specTexPath != "" ? specTexPath : diffTexPath, "texture_specular"));
 
     if (normTexPath != "") {
-        texture.createNew(GL_TEXTURE_2D, texOps);
-        texture.fileTexture(normTexPath);
-        m_textures.push_back({ texture.textureID(), "texture_normal", texture.path() });
+        m_textures.push_back(loadTexture(normTexPath, "texture_normal"));
         
         for (auto i = 0ll; i < m_positions.size(); i += 3ll) {
             glm::vec3 edge1 = m_positions[i + 1ll] - m_positions[i];
@@ -64,33 +62,28 @@ Cube::Cube(const std::string& diffTexPath, const std::string& specTexPath, const
 
 Cube::~Cube() {}
 
+/* Untextured unit cube, 36 unindexed vertices */
+MeshData Cube::generate()
+{
+    MeshData data;
+    data.positions = cubePositions;
+    data.normals = cubeNormals;
+    data.texCoords = cubeTexCoords;
+    return data;
+}
+
 Quad::Quad(const std::string& diffTexPath, const std::string& specTexPath, const std::string& normTexPath)
 {
     m_positions = quadPositions;
     m_normals = quadNormals;
     m_texCoords = quadTexCoords;
 
-    TextureLoader texture;
-    TextureOptions texOps;
-    texOps.wrapS = GL_REPEAT;
-    texOps.wrapT = GL_REPEAT;
-    texture.fileTexture(diffTexPath);
-    m_textures.push_back({ texture.textureID(), "texture_diffuse", texture.path() });
-
-    if (specTexPath != "") {
-        texture.createNew(GL_TEXTURE_2D, texOps);
-        texture.fileTexture(specTexPath);
-        m_textures.push_back({ texture.textureID(), "texture_specular", texture.path() });
-    }
-    else {
-        // Use the same as diffuse texture
-        m_textures.push_back({ texture.textureID(), "texture_specular", texture.path() });
-    }
+    m_textures.push_back(loadTexture(diffTexPath, "texture_diffuse"));
+    // Use the same as diffuse texture without a specular one
+    m_textures.push_back(loadTexture(specTexPath != "" ? specTexPath : diffTexPath, "texture_specular"));
 
     if (normTexPath != "") {
-        texture.fileTexture(normTexPath);
-        texture.createNew(GL_TEXTURE_2D, texOps);
-        m_textures.push_back({ texture.textureID(), "texture_normal", texture.path() });
+        m_textures.push_back(loadTexture(normTexPath, "texture_normal"));
     }
     else {
         m_textures.push_back({ 0, "texture_null", "" });
@@ -101,17 +94,30 @@ Quad::Quad(const std::string& diffTexPath, const std::string& specTexPath, const
 
 Quad::~Quad() {}
 
+MeshData Quad::generate()
+{
+    MeshData data;
+    data.positions = quadPositions;
+    data.normals = quadNormals;
+    data.texCoords = quadTexCoords;
+    return data;
+}
+
 /* Credit to http://www.songho.ca/opengl/gl_sphere.html */
-Sphere::Sphere()
+/* Builds a UV sphere with (sectorCount + 1) * (stackCount + 1) vertices */
+MeshData Sphere::generate(int sectorCount, int stackCount, float radius)
 {
-    std::vector<glm::vec3> vertices;
-    std::vector<glm::vec2> texCoords;
-    std::vector<glm::vec3> normals;
-    std::vector<unsigned int> indices;
+    MeshData data;
+    std::vector<glm::vec3>& vertices = data.positions;
+    std::vector<glm::vec2>& texCoords = data.texCoords;
+    std::vector<glm::vec3>& normals = data.normals;
+    std::vector<unsigned int>& indices = data.indices;
 
     const float PI = 3.1415926f;
-    float radius = 1.0f;
-    float sectorCount = 64, stackCount = 32;
+    vertices.reserve((sectorCount + 1) * (stackCount + 1));
+    normals.reserve((sectorCount + 1) * (stackCount + 1));
+    texCoords.reserve((sectorCount + 1) * (stackCount + 1));
+    indices.reserve(sectorCount * (stackCount - 1) * 6);
 
     float x, y, z, xy;                              // vertex position
     float nx, ny, nz, lengthInv = 1.0f / radius;    // vertex normal
@@ -178,29 +184,26 @@ Sphere::Sphere()
         }
     }
 
-    TextureLoader texture;
-    TextureOptions texOps;
-    texOps.wrapS = GL_REPEAT;
-    texOps.wrapT = GL_REPEAT;
+    return data;
+}
 
-    texture.createNew(GL_TEXTURE_2D, texOps);
-    texture.fileTexture("res/textures/rusted_iron/rustediron2_basecolor.png");
-    m_textures.push_back({ texture.textureID(), "texture_albedo", texture.path() });
+Sphere::Sphere()
+{
+    MeshData data = generate(64, 32, 1.0f);
+    MeshSimplifier::buildLods(data);
 
-    // TODO: Figure out how to do tangent space if actual bump mapping is needed
+    m_textures.push_back(loadTexture("res/textures/rusted_iron/rustediron2_basecolor.png", "texture_albedo"));
 
-    texture.createNew(GL_TEXTURE_2D, texOps);
-    texture.fileTexture("res/textures/rusted_iron/rustediron2_metallic.png");
-    m_textures.push_back({ texture.textureID(), "texture_metal", texture.path() });
+    // TODO: Figure out how to do tangent space if actual bump mapping is needed
 
-    texture.createNew(GL_TEXTURE_2D, texOps);
-    texture.fileTexture("res/textures/rusted_iron/rustediron2_roughness.png");
-    m_textures.push_back({ texture.textureID(), "texture_rough", texture.path() });
+    m_textures.push_back(loadTexture("res/textures/rusted_iron/rustediron2_metallic.png", "texture_metal"));
+    m_textures.push_back(loadTexture("res/textures/rusted_iron/rustediron2_roughness.png", "texture_rough"));
 
-    m_positions = vertices;
-    m_normals = normals;
-    m_texCoords = texCoords;
-    m_indices = indices;
+    m_positions = std::move(data.positions);
+    m_normals = std::move(data.normals);
+    m_texCoords = std::move(data.texCoords);
+    m_indices = std::move(data.indices);
+    m_lods = std::move(data.lods);
 
     setupMesh();
 }
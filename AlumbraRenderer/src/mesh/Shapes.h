@@ -6,6 +6,8 @@ class Cube final : public Mesh {
 public:
     Cube(const std::string& diffTexPath, const std::string& specTexPath = "", const std::string& normTexPath = "");
     ~Cube();
+
+    static MeshData generate();
 private:
 };
 
@@ -13,6 +15,8 @@ class Quad final : public Mesh {
 public:
     Quad(const std::string& diffTexPath, const std::string& specTexPath = "", const std::string& normTexPath = "");
     ~Quad();
+
+    static MeshData generate();
 private:
 };
 
@@ -20,6 +24,8 @@ class Sphere final : public Mesh {
 public:
     Sphere();
     ~Sphere();
+
+    static MeshData generate(int sectorCount, int stackCount, float radius = 1.0f);
 };
 
 const std::vector<glm::vec3> cubePositions{
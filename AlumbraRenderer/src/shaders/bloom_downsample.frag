@@ -0,0 +1,82 @@
+#version 450 core
+
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D srcTexture;
+uniform vec2 srcTexelSize;
+// Part of the source holding valid texels, it can be smaller than the texture when the
+// scene is rendered at a reduced resolution
+uniform vec2 srcUVScale;
+uniform vec2 srcUVMax;
+uniform bool prefilter;
+uniform float threshold;
+
+float luminance(vec3 color)
+{
+    return dot(color, vec3(0.2126, 0.7152, 0.0722));
+}
+
+// Karis average, weights each box by inverse luminance so single very bright pixels
+// do not turn into flickering blobs when bright-passing the full scene
+vec3 karisAverage(vec3 boxes[5], float weights[5])
+{
+    vec3 color = vec3(0.0);
+    float totalWeight = 0.0;
+    for (int box = 0; box < 5; box++) {
+        float w = weights[box] / (1.0 + luminance(boxes[box]));
+        color += boxes[box] * w;
+        totalWeight += w;
+    }
+    return color / totalWeight;
+}
+
+vec3 fetch(vec2 uv)
+{
+    return texture(srcTexture, min(uv, srcUVMax)).rgb;
+}
+
+void main()
+{
+    // 13 tap downsample (Jimenez, Next Generation Post Processing in Call of Duty: AW).
+    // Five overlapping 4x4 boxes: the center box weighted 0.5 and the corner boxes 0.125
+    vec2 d = srcTexelSize;
+    vec2 uv = TexCoords * srcUVScale;
+    vec3 a = fetch(uv + vec2(-2.0,  2.0) * d);
+    vec3 b = fetch(uv + vec2( 0.0,  2.0) * d);
+    vec3 c = fetch(uv + vec2( 2.0,  2.0) * d);
+    vec3 e = fetch(uv + vec2(-2.0,  0.0) * d);
+    vec3 f = fetch(uv);
+    vec3 g = fetch(uv + vec2( 2.0,  0.0) * d);
+    vec3 h = fetch(uv + vec2(-2.0, -2.0) * d);
+    vec3 i = fetch(uv + vec2( 0.0, -2.0) * d);
+    vec3 j = fetch(uv + vec2( 2.0, -2.0) * d);
+    vec3 k = fetch(uv + vec2(-1.0,  1.0) * d);
+    vec3 l = fetch(uv + vec2( 1.0,  1.0) * d);
+    vec3 m = fetch(uv + vec2(-1.0, -1.0) * d);
+    vec3 n = fetch(uv + vec2( 1.0, -1.0) * d);
+
+    vec3 color;
+    if (prefilter) {
+        // First mip reads the HDR scene directly, so it also does the bright-pass and
+        // keeps only the part of each pixel above the threshold
+        vec3 boxes[5] = vec3[](
+            (k + l + m + n) * 0.25,
+            (a + b + e + f) * 0.25,
+            (b + c + f + g) * 0.25,
+            (e + f + h + i) * 0.25,
+            (f + g + i + j) * 0.25);
+        float weights[5] = float[](0.5, 0.125, 0.125, 0.125, 0.125);
+        color = karisAverage(boxes, weights);
+        float brightness = luminance(color);
+        color *= max(brightness - threshold, 0.0) / max(brightness, 0.0001);
+    }
+    else {
+        color = f * 0.125;
+        color += (a + c + h + j) * 0.03125;
+        color += (b + e + g + i) * 0.0625;
+        color += (k + l + m + n) * 0.125;
+    }
+    FragColor = vec4(color, 1.0);
+}
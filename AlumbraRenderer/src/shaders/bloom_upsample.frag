@@ -0,0 +1,33 @@
+#version 450 core
+
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D srcTexture;
+uniform vec2 srcTexelSize;
+uniform vec2 srcUVScale;
+uniform vec2 srcUVMax;
+uniform float radius;
+
+vec3 fetch(vec2 uv)
+{
+    return texture(srcTexture, min(uv, srcUVMax)).rgb;
+}
+
+void main()
+{
+    // 3x3 tent filter, the result is additively blended into the larger mip
+    vec2 d = srcTexelSize * radius;
+    vec2 uv = TexCoords * srcUVScale;
+    vec3 color = fetch(uv) * 4.0;
+    color += fetch(uv + vec2(-d.x,  0.0)) * 2.0;
+    color += fetch(uv + vec2( d.x,  0.0)) * 2.0;
+    color += fetch(uv + vec2( 0.0, -d.y)) * 2.0;
+    color += fetch(uv + vec2( 0.0,  d.y)) * 2.0;
+    color += fetch(uv + vec2(-d.x, -d.y));
+    color += fetch(uv + vec2( d.x, -d.y));
+    color += fetch(uv + vec2(-d.x,  d.y));
+    color += fetch(uv + vec2( d.x,  d.y));
+    FragColor = vec4(color / 16.0, 1.0);
+}
@@ -0,0 +1,93 @@
+#version 450 core
+
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+#include "octahedral.glsl"
+
+// Half width lighting, see checkerboard in pbr_shading.frag
+uniform sampler2D checkerTexture;
+uniform sampler2D gDepth;
+uniform sampler2D gNormal;
+uniform sampler2D velocityTexture;
+// Last frame's reconstructed lighting, its rendered region can differ from this frame's
+uniform sampler2D historyTexture;
+uniform vec2 historyUVScale;
+uniform vec2 historyUVMax;
+// Previous minus current projection jitter in render pixels
+uniform vec2 jitterDelta;
+
+uniform int checkerFrame;
+uniform vec2 renderSize;
+uniform float zNear;
+uniform float zFar;
+uniform float depthSensitivity;
+uniform float normalPower;
+uniform float historyWeight;
+
+float linearDepth(float depth)
+{
+    float z = depth * 2.0 - 1.0;
+    return (2.0 * zNear * zFar) / (zFar + zNear - z * (zFar - zNear));
+}
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    float depth = texelFetch(gDepth, pixel, 0).r;
+    // Background pixels are covered by the skybox afterwards
+    if (depth == 1.0)
+        discard;
+
+    bool shaded = ((pixel.x + pixel.y + checkerFrame) & 1) == 0;
+    if (shaded) {
+        FragColor = vec4(texelFetch(checkerTexture, ivec2(pixel.x / 2, pixel.y), 0).rgb, 1.0);
+        return;
+    }
+
+    // All four direct neighbors were shaded this frame, weight them by how likely they lie on
+    // the same surface so edges are not blurred across
+    float z = linearDepth(depth);
+    vec3 N = octDecode(texelFetch(gNormal, pixel, 0).rg * 2.0 - 1.0);
+    const ivec2 offsets[4] = ivec2[4](ivec2(-1, 0), ivec2(1, 0), ivec2(0, -1), ivec2(0, 1));
+    ivec2 maxPixel = ivec2(renderSize) - 1;
+    vec3 fill = vec3(0.0);
+    vec3 average = vec3(0.0);
+    float weightSum = 0.0;
+    vec3 boxMin = vec3(1e10);
+    vec3 boxMax = vec3(-1e10);
+    for (int i = 0; i < 4; i++) {
+        ivec2 neighbor = clamp(pixel + offsets[i], ivec2(0), maxPixel);
+        // Clamping at the border can land on an unshaded pixel, its own row neighbor is shaded
+        if (((neighbor.x + neighbor.y + checkerFrame) & 1) != 0)
+            neighbor.x += neighbor.x > 0 ? -1 : 1;
+        vec3 color = texelFetch(checkerTexture, ivec2(neighbor.x / 2, neighbor.y), 0).rgb;
+        float neighborDepth = texelFetch(gDepth, neighbor, 0).r;
+        vec3 neighborN = octDecode(texelFetch(gNormal, neighbor, 0).rg * 2.0 - 1.0);
+
+        float depthWeight = neighborDepth == 1.0 ? 0.0 :
+            exp(-abs(linearDepth(neighborDepth) - z) / z * depthSensitivity);
+        float normalWeight = pow(max(dot(N, neighborN), 0.0), normalPower);
+        float w = depthWeight * normalWeight;
+        fill += color * w;
+        weightSum += w;
+        average += color;
+        if (w > 0.1) {
+            boxMin = min(boxMin, color);
+            boxMax = max(boxMax, color);
+        }
+    }
+    vec3 color = weightSum > 0.0001 ? fill / weightSum : average * 0.25;
+
+    // Reuse last frame's result for this pixel, clamped to the matching neighbors so
+    // disocclusions and lighting changes fall back to the spatial fill
+    vec2 historyUV = (gl_FragCoord.xy + jitterDelta) / renderSize - texelFetch(velocityTexture, pixel, 0).rg;
+    bool onscreen = all(greaterThanEqual(historyUV, vec2(0.0))) && all(lessThanEqual(historyUV, vec2(1.0)));
+    if (onscreen && historyWeight > 0.0 && weightSum > 0.0001 && boxMin.x <= boxMax.x) {
+        vec3 history = texture(historyTexture, min(historyUV * historyUVScale, historyUVMax)).rgb;
+        history = clamp(history, boxMin, boxMax);
+        color = mix(color, history, historyWeight);
+    }
+    FragColor = vec4(color, 1.0);
+}
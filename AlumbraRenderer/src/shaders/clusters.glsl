@@ -0,0 +1,45 @@
+// Clustered light lists shared by the light culling compute pass and any shading pass.
+// Include with #include "clusters.glsl" and bind LightClusters before drawing.
+
+// Must match LightClusters::CLUSTER_X/Y/Z
+#define CLUSTER_X 16
+#define CLUSTER_Y 9
+#define CLUSTER_Z 24
+
+// Matches struct PointLight in Scene.h
+struct PointLight {
+    vec4 position;
+    vec4 color;
+    float intensity;
+    float radius;
+    vec2 padding;
+};
+
+layout (std430, binding = 3) readonly buffer LightsSSBO
+{
+    PointLight pointLights[];
+};
+
+layout (std430, binding = 4) buffer LightIndicesSSBO
+{
+    uint lightIndices[];
+};
+
+// x = offset into lightIndices, y = light count
+layout (std430, binding = 5) buffer LightGridSSBO
+{
+    uvec2 lightGrid[];
+};
+
+uniform vec2 clusterTileSize;
+uniform float clusterZScale;
+uniform float clusterZBias;
+
+// Finds the cluster of a fragment given its window coordinates and positive view space depth
+uint clusterIndex(vec2 fragCoord, float viewDepth)
+{
+    uint slice = uint(max(log(viewDepth) * clusterZScale + clusterZBias, 0.0));
+    slice = min(slice, uint(CLUSTER_Z - 1));
+    uvec2 tile = min(uvec2(fragCoord / clusterTileSize), uvec2(CLUSTER_X - 1, CLUSTER_Y - 1));
+    return tile.x + tile.y * CLUSTER_X + slice * CLUSTER_X * CLUSTER_Y;
+}
@@ -0,0 +1,132 @@
+// Two phase GPU culling shared by the draw and cluster culling passes, include after
+// mesh_pool.glsl. Items are draws or clusters, each gets a command slot and a visibility flag.
+
+struct DrawElementsIndirectCommand {
+    uint count;
+    uint instanceCount;
+    uint firstIndex;
+    int baseVertex;
+    uint baseInstance;
+};
+
+// One list of commandStride commands per phase
+layout (std430, binding = 14) writeonly buffer CullCommandSSBO
+{
+    DrawElementsIndirectCommand cullCommands[];
+};
+
+// Commands emitted per phase, followed by the triangles they draw per phase
+layout (std430, binding = 15) buffer CullCountSSBO
+{
+    uint cullCounts[];
+};
+
+// Whether each item passed the late test last frame
+layout (std430, binding = 16) buffer CullVisibilitySSBO
+{
+    uint cullVisibility[];
+};
+
+uniform sampler2D hiZ;
+uniform mat4 viewProjection;
+uniform int phase;
+uniform bool occlusion;
+// Compacted lists for glMultiDrawElementsIndirectCount, otherwise every item keeps its slot
+// and culled ones get zero instances
+uniform bool compact;
+uniform int itemCount;
+uniform int commandStride;
+uniform vec2 hiZSize;
+uniform int hiZLevels;
+
+#define PHASE_EARLY 0
+#define PHASE_COUNT 2
+
+// Screen footprint of a box, outside has a bit set for every clip plane all corners are beyond
+struct ProjectedBox {
+    uint outside;
+    bool crossesNear;
+    vec2 ndcMin;
+    vec2 ndcMax;
+    float nearestDepth;
+};
+
+ProjectedBox projectBox(mat4 mvp, vec3 boxMin, vec3 boxMax)
+{
+    ProjectedBox box;
+    box.outside = 0x3Fu;
+    box.crossesNear = false;
+    box.ndcMin = vec2(1.0);
+    box.ndcMax = vec2(-1.0);
+    box.nearestDepth = 1.0;
+    for (int i = 0; i < 8; i++) {
+        vec3 corner = mix(boxMin, boxMax, vec3(i & 1, (i >> 1) & 1, (i >> 2) & 1));
+        vec4 clip = mvp * vec4(corner, 1.0);
+        uint planes = 0u;
+        planes |= clip.x < -clip.w ? 0x01u : 0u;
+        planes |= clip.x >  clip.w ? 0x02u : 0u;
+        planes |= clip.y < -clip.w ? 0x04u : 0u;
+        planes |= clip.y >  clip.w ? 0x08u : 0u;
+        planes |= clip.z < -clip.w ? 0x10u : 0u;
+        planes |= clip.z >  clip.w ? 0x20u : 0u;
+        box.outside &= planes;
+        if (clip.w <= 0.0) {
+            box.crossesNear = true;
+        }
+        else {
+            vec3 ndc = clip.xyz / clip.w;
+            box.ndcMin = min(box.ndcMin, ndc.xy);
+            box.ndcMax = max(box.ndcMax, ndc.xy);
+            box.nearestDepth = min(box.nearestDepth, ndc.z * 0.5 + 0.5);
+        }
+    }
+    return box;
+}
+
+// Conservative test of a screen rectangle against the pyramid, the level is picked so the
+// rectangle spans at most 2x2 texels
+bool occlusionVisible(vec2 uvMin, vec2 uvMax, float nearestDepth)
+{
+    vec2 size = (uvMax - uvMin) * hiZSize;
+    int level = clamp(int(ceil(log2(max(max(size.x, size.y), 1.0)))), 0, hiZLevels - 1);
+    ivec2 levelSize = textureSize(hiZ, level);
+    ivec2 p0 = clamp(ivec2(uvMin * vec2(levelSize)), ivec2(0), levelSize - 1);
+    ivec2 p1 = clamp(ivec2(uvMax * vec2(levelSize)), ivec2(0), levelSize - 1);
+    float farthest = max(
+        max(texelFetch(hiZ, p0, level).r, texelFetch(hiZ, ivec2(p1.x, p0.y), level).r),
+        max(texelFetch(hiZ, ivec2(p0.x, p1.y), level).r, texelFetch(hiZ, p1, level).r));
+    return nearestDepth <= farthest;
+}
+
+// Whether this phase draws the item, visible is the result of every test except occlusion.
+// The late phase records the outcome for next frame's early phase
+bool phaseEmit(uint item, bool visible, ProjectedBox box)
+{
+    if (phase == PHASE_EARLY)
+        return visible && cullVisibility[item] != 0u;
+
+    // Boxes reaching behind the camera cannot be projected and are kept
+    if (visible && occlusion && !box.crossesNear) {
+        vec2 uvMin = clamp(box.ndcMin * 0.5 + 0.5, 0.0, 1.0);
+        vec2 uvMax = clamp(box.ndcMax * 0.5 + 0.5, 0.0, 1.0);
+        visible = occlusionVisible(uvMin, uvMax, max(box.nearestDepth, 0.0));
+    }
+    // Items from the early phase are already in the depth buffer
+    bool emit = visible && cullVisibility[item] == 0u;
+    cullVisibility[item] = visible ? 1u : 0u;
+    return emit;
+}
+
+void writeCommand(uint item, DrawElementsIndirectCommand command, bool emit)
+{
+    command.instanceCount = emit ? 1u : 0u;
+    uint slot = item;
+    if (emit) {
+        uint emitted = atomicAdd(cullCounts[phase], 1u);
+        atomicAdd(cullCounts[PHASE_COUNT + phase], command.count / 3u);
+        if (compact)
+            slot = emitted;
+    }
+    if (!compact || emit)
+        cullCommands[uint(phase * commandStride) + slot] = command;
+}
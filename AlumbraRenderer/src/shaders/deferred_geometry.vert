@@ -1,9 +1,12 @@
 #version 450 core
 layout (location = 0) in vec3 aPos;
-layout (location = 1) in vec3 aNormal;
+// Interleaved MeshVertexFormat, see Buffers.h: octahedral normal and the tangent with the
+// bitangent's handedness in w
+layout (location = 1) in vec2 aNormal;
 layout (location = 2) in vec2 aTexCoords;
-layout (location = 3) in vec3 aTangent;
-layout (location = 4) in vec3 aBitangent;
+layout (location = 3) in vec4 aTangent;
+
+#include "octahedral.glsl"
 
 out VS_OUT {
     vec2 TexCoords;
@@ -31,13 +34,14 @@ void main()
     // If only translations and rotations took place, no need to renormalize
     //float normalMatrix = 1;
 
-    vs_out.Normal = normalMatrix * aNormal;
+    vec3 normal = octDecode(aNormal);
+    vs_out.Normal = normalMatrix * normal;
 
-    vec3 T = normalize(normalMatrix * aTangent);
-    vec3 B =  normalize(normalMatrix * aBitangent);
-    vec3 N = normalize(normalMatrix * aNormal);
+    vec3 T = normalize(normalMatrix * aTangent.xyz);
+    vec3 N = normalize(normalMatrix * normal);
     // Re-orthogonalization for when TS vectors have been averaged
     T = normalize(T - dot(T, N) * N);
+    vec3 B = cross(N, T) * aTangent.w;
 
     vs_out.TBN = (mat3(T, B, N));
 
@@ -0,0 +1,43 @@
+// Shared texture filters for resampling between resolutions
+
+// Catmull-Rom bicubic with 9 bilinear taps instead of 16 point taps, the weights of each
+// middle pair are merged into one filtered fetch (Jimenez, Filmic SMAA). Taps are clamped to
+// [half a texel, uvMax] so texels outside a partially filled texture never bleed in
+vec3 sampleCatmullRom(sampler2D tex, vec2 uv, vec2 uvMax)
+{
+    vec2 texSize = vec2(textureSize(tex, 0));
+    vec2 invTexSize = 1.0 / texSize;
+    vec2 uvMin = 0.5 * invTexSize;
+
+    vec2 samplePos = uv * texSize;
+    vec2 texPos1 = floor(samplePos - 0.5) + 0.5;
+    vec2 f = samplePos - texPos1;
+
+    vec2 w0 = f * (-0.5 + f * (1.0 - 0.5 * f));
+    vec2 w1 = 1.0 + f * f * (-2.5 + 1.5 * f);
+    vec2 w2 = f * (0.5 + f * (2.0 - 1.5 * f));
+    vec2 w3 = f * f * (-0.5 + 0.5 * f);
+
+    vec2 w12 = w1 + w2;
+    vec2 offset12 = w2 / w12;
+
+    vec2 texPos0 = clamp((texPos1 - 1.0) * invTexSize, uvMin, uvMax);
+    vec2 texPos3 = clamp((texPos1 + 2.0) * invTexSize, uvMin, uvMax);
+    vec2 texPos12 = clamp((texPos1 + offset12) * invTexSize, uvMin, uvMax);
+
+    vec3 color = vec3(0.0);
+    color += texture(tex, vec2(texPos0.x,  texPos0.y)).rgb * w0.x * w0.y;
+    color += texture(tex, vec2(texPos12.x, texPos0.y)).rgb * w12.x * w0.y;
+    color += texture(tex, vec2(texPos3.x,  texPos0.y)).rgb * w3.x * w0.y;
+
+    color += texture(tex, vec2(texPos0.x,  texPos12.y)).rgb * w0.x * w12.y;
+    color += texture(tex, vec2(texPos12.x, texPos12.y)).rgb * w12.x * w12.y;
+    color += texture(tex, vec2(texPos3.x,  texPos12.y)).rgb * w3.x * w12.y;
+
+    color += texture(tex, vec2(texPos0.x,  texPos3.y)).rgb * w0.x * w3.y;
+    color += texture(tex, vec2(texPos12.x, texPos3.y)).rgb * w12.x * w3.y;
+    color += texture(tex, vec2(texPos3.x,  texPos3.y)).rgb * w3.x * w3.y;
+
+    // The negative lobes can ring below zero next to very bright HDR pixels
+    return max(color, vec3(0.0));
+}
@@ -0,0 +1,75 @@
+#version 450 core
+
+// Writes the same targets as pbr_geometry.frag so the lighting passes are shared
+layout (location = 0) out vec2 gNormal;
+layout (location = 1) out vec4 gAlbedo;
+layout (location = 2) out vec4 gMetalRoughAO;
+layout (location = 3) out vec2 gVelocity;
+
+in VS_OUT {
+    vec4 ViewUV01;
+    vec4 ViewUV23;
+    flat vec2 Cell;
+    vec3 WorldPos;
+    vec4 CurrClip;
+    vec4 PrevClip;
+    flat vec4 Weights;
+    flat mat3 NormalMatrix;
+    flat vec3 ToCamera;
+    flat float Radius;
+    flat vec3 Albedo;
+    flat vec2 MetalRough;
+    flat uint Layer;
+} fs_in;
+
+// Baked by Impostors::bake, one layer per model
+uniform sampler2DArray albedoAtlas;
+uniform sampler2DArray normalAtlas;
+uniform sampler2DArray depthAtlas;
+uniform mat4 view;
+uniform mat4 projection;
+
+#include "octahedral.glsl"
+
+// Must match Impostors::GRID
+const int GRID = 8;
+
+void main()
+{
+    vec2 uvs[4] = vec2[](fs_in.ViewUV01.xy, fs_in.ViewUV01.zw, fs_in.ViewUV23.xy, fs_in.ViewUV23.zw);
+    vec2 cells[4] = vec2[](fs_in.Cell, fs_in.Cell + vec2(1.0, 0.0), fs_in.Cell + vec2(0.0, 1.0), fs_in.Cell + vec2(1.0, 1.0));
+    vec4 albedo = vec4(0.0);
+    vec3 normal = vec3(0.0);
+    float depth = 0.0;
+    float weightSum = 0.0;
+    for (int i = 0; i < 4; i++) {
+        // Rays missing a view's square would read its neighbour in the atlas
+        if (any(lessThan(uvs[i], vec2(0.0))) || any(greaterThan(uvs[i], vec2(1.0))))
+            continue;
+        vec3 uv = vec3((cells[i] + uvs[i]) / float(GRID), float(fs_in.Layer));
+        vec4 texel = texture(albedoAtlas, uv);
+        // Only covered texels carry a normal and depth
+        float weight = fs_in.Weights[i] * texel.a;
+        albedo += fs_in.Weights[i] * texel;
+        normal += weight * octDecode(texture(normalAtlas, uv).rg * 2.0 - 1.0);
+        depth += weight * texture(depthAtlas, uv).r;
+        weightSum += weight;
+    }
+    if (albedo.a < 0.5)
+        discard;
+    depth /= weightSum;
+
+    // Baked depth runs from the front of the bounding sphere at 0 to its back at 1, move the
+    // quad's point toward the camera by as much so impostors intersect other geometry
+    vec3 worldPos = fs_in.WorldPos + fs_in.ToCamera * fs_in.Radius * (1.0 - 2.0 * depth);
+    vec4 clip = projection * view * vec4(worldPos, 1.0);
+    gl_FragDepth = clip.z / clip.w * 0.5 + 0.5;
+
+    vec3 N = normalize(fs_in.NormalMatrix * normal);
+    gNormal = octEncode(N) * 0.5 + 0.5;
+    // The views were baked with a white material, the instance's albedo tints them
+    gAlbedo = vec4(fs_in.Albedo * albedo.rgb / albedo.a, 1.0);
+    gMetalRoughAO = vec4(fs_in.MetalRough, 1.0, 1.0);
+    // screen space motion since last frame in UV units
+    gVelocity = (fs_in.CurrClip.xy / fs_in.CurrClip.w - fs_in.PrevClip.xy / fs_in.PrevClip.w) * 0.5;
+}
@@ -0,0 +1,123 @@
+#version 450 core
+
+// Matches ImpostorInstance in Impostors.h
+struct ImpostorInstance {
+    mat4 model;
+    mat4 prevModel;
+    vec4 sphere;
+    vec3 albedo;
+    float metallic;
+    float roughness;
+    uint layer;
+    uint padding0;
+    uint padding1;
+};
+
+layout (std430, binding = 19) readonly buffer ImpostorInstanceSSBO
+{
+    ImpostorInstance impostorInstances[];
+};
+
+#include "octahedral.glsl"
+
+// Must match Impostors::GRID
+const int GRID = 8;
+
+out VS_OUT {
+    // Coordinates of this corner inside the four views blended, xy and zw for two views each
+    vec4 ViewUV01;
+    vec4 ViewUV23;
+    // Atlas cell of the first view, the others are the next cells right, up and diagonally
+    flat vec2 Cell;
+    vec3 WorldPos;
+    vec4 CurrClip;
+    vec4 PrevClip;
+    flat vec4 Weights;
+    flat mat3 NormalMatrix;
+    flat vec3 ToCamera;
+    // World space radius of the bounding sphere
+    flat float Radius;
+    flat vec3 Albedo;
+    flat vec2 MetalRough;
+    flat uint Layer;
+} vs_out;
+
+uniform mat4 view;
+uniform mat4 projection;
+// Unjittered matrices of this and the previous frame for the velocity target
+uniform mat4 currViewProjection;
+uniform mat4 prevViewProjection;
+uniform vec3 cameraPosition;
+
+// Same basis the baker's lookAt builds for a camera looking back along direction
+void viewBasis(vec3 direction, out vec3 right, out vec3 up)
+{
+    vec3 reference = abs(direction.y) > 0.999 ? vec3(0.0, 0.0, 1.0) : vec3(0.0, 1.0, 0.0);
+    right = normalize(cross(reference, direction));
+    up = cross(direction, right);
+}
+
+// Where the ray from the camera through a point of the quad crosses the plane a view was baked
+// on, in [0, 1] over the view
+vec2 viewUV(vec3 direction, vec3 camera, vec3 point, float radius)
+{
+    vec3 right, up;
+    viewBasis(direction, right, up);
+    vec3 ray = point - camera;
+    float facing = dot(ray, direction);
+    float t = abs(facing) > 1e-6 ? -dot(camera, direction) / facing : 1.0;
+    vec3 hit = camera + ray * t;
+    vec2 local = vec2(dot(hit, right), dot(hit, up)) / radius;
+    return local * 0.5 + 0.5;
+}
+
+void main()
+{
+    ImpostorInstance instance = impostorInstances[gl_InstanceID];
+    mat3 basis = mat3(instance.model);
+    float scale = max(max(length(basis[0]), length(basis[1])), length(basis[2]));
+    vec3 center = (instance.model * vec4(instance.sphere.xyz, 1.0)).xyz;
+    float radius = instance.sphere.w * scale;
+
+    // Camera facing quad around the world space bounding sphere
+    vec3 toCamera = normalize(cameraPosition - center);
+    vec3 right, up;
+    viewBasis(toCamera, right, up);
+    vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1) * 2.0 - 1.0;
+    vec3 worldPos = center + (right * corner.x + up * corner.y) * radius;
+
+    // The view direction in object space picks the baked views, only the upper hemisphere was
+    // baked so views from below use the horizon ones
+    mat3 toObject = inverse(basis);
+    vec3 direction = toObject * toCamera;
+    direction.y = max(direction.y, 0.0);
+    direction = dot(direction, direction) > 1e-12 ? normalize(direction) : vec3(0.0, 1.0, 0.0);
+    vec2 grid = (hemiOctEncode(direction) * 0.5 + 0.5) * float(GRID - 1);
+    vec2 cell = min(floor(grid), vec2(GRID - 2));
+    vec2 f = grid - cell;
+    vs_out.Weights = vec4((1.0 - f.x) * (1.0 - f.y), f.x * (1.0 - f.y), (1.0 - f.x) * f.y, f.x * f.y);
+
+    // Camera and corner relative to the sphere center in object space
+    vec3 camera = toObject * (cameraPosition - center);
+    vec3 point = toObject * (worldPos - center);
+    vec2 cells[4] = vec2[](cell, cell + vec2(1.0, 0.0), cell + vec2(0.0, 1.0), cell + vec2(1.0, 1.0));
+    vec2 uvs[4];
+    for (int i = 0; i < 4; i++) {
+        vec3 viewDirection = hemiOctDecode(cells[i] / float(GRID - 1) * 2.0 - 1.0);
+        uvs[i] = viewUV(viewDirection, camera, point, instance.sphere.w);
+    }
+    vs_out.ViewUV01 = vec4(uvs[0], uvs[1]);
+    vs_out.ViewUV23 = vec4(uvs[2], uvs[3]);
+    vs_out.Cell = cell;
+
+    vs_out.WorldPos = worldPos;
+    vs_out.NormalMatrix = transpose(toObject);
+    vs_out.ToCamera = toCamera;
+    vs_out.Radius = radius;
+    vs_out.Albedo = instance.albedo;
+    vs_out.MetalRough = vec2(instance.metallic, instance.roughness);
+    vs_out.Layer = instance.layer;
+    vs_out.CurrClip = currViewProjection * vec4(worldPos, 1.0);
+    vs_out.PrevClip = prevViewProjection * instance.prevModel * inverse(instance.model) * vec4(worldPos, 1.0);
+    gl_Position = projection * view * vec4(worldPos, 1.0);
+}
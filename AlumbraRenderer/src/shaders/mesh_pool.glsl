@@ -0,0 +1,107 @@
+// Mesh pool mega buffer, include with #include "mesh_pool.glsl" and bind MeshPool before drawing.
+
+// Matches the structs in mesh/MeshPool.h
+struct PoolVertex {
+    vec4 positionU;
+    vec4 normalV;
+};
+
+struct PoolMesh {
+    uint firstIndex;
+    uint indexCount;
+    uint baseVertex;
+    uint meshletOffset;
+    uint meshletCount;
+    uint lodCount;
+    uint padding0;
+    uint padding1;
+    vec4 boundsMin;
+    vec4 boundsMax;
+    // Relative to firstIndex, one level of detail per component
+    uvec4 lodFirstIndex;
+    uvec4 lodIndexCount;
+    vec4 lodError;
+};
+
+struct PoolDraw {
+    mat4 model;
+    mat4 prevModel;
+    uint meshIndex;
+    uint triangleOffset;
+    uint materialIndex;
+    uint lod;
+};
+
+struct PoolMeshlet {
+    vec4 sphere;
+    vec4 cone;
+    vec4 coneApex;
+    // Relative to the mesh's first index
+    uint firstIndex;
+    uint indexCount;
+    uint lod;
+    uint padding;
+};
+
+struct PoolCluster {
+    uint drawIndex;
+    uint meshletIndex;
+};
+
+// Matches Material in Scene.h
+struct Material {
+    vec3 albedo;
+    float metallic;
+    float roughness;
+};
+
+layout (std430, binding = 9) readonly buffer PoolVertexSSBO
+{
+    PoolVertex poolVertices[];
+};
+
+layout (std430, binding = 10) readonly buffer PoolIndexSSBO
+{
+    uint poolIndices[];
+};
+
+layout (std430, binding = 11) readonly buffer PoolMeshSSBO
+{
+    PoolMesh poolMeshes[];
+};
+
+layout (std430, binding = 12) readonly buffer PoolDrawSSBO
+{
+    PoolDraw poolDraws[];
+};
+
+layout (std430, binding = 13) readonly buffer PoolMaterialSSBO
+{
+    Material poolMaterials[];
+};
+
+layout (std430, binding = 17) readonly buffer PoolMeshletSSBO
+{
+    PoolMeshlet poolMeshlets[];
+};
+
+// One per meshlet of every draw
+layout (std430, binding = 18) readonly buffer PoolClusterSSBO
+{
+    PoolCluster poolClusters[];
+};
+
+// Finds the draw whose triangle ID range contains the global triangle ID
+uint findPoolDraw(uint triangleID)
+{
+    uint low = 0u;
+    uint high = uint(poolDraws.length()) - 1u;
+    while (low < high) {
+        uint mid = (low + high + 1u) / 2u;
+        if (poolDraws[mid].triangleOffset <= triangleID)
+            low = mid;
+        else
+            high = mid - 1u;
+    }
+    return low;
+}
@@ -0,0 +1,37 @@
+// Octahedral normal encoding shared by every pass that writes or reads gNormal.
+// Maps the unit sphere onto the [-1, 1] square, the G-buffer stores it remapped to [0, 1].
+
+vec2 octWrap(vec2 v)
+{
+    return (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+}
+
+vec2 octEncode(vec3 n)
+{
+    n /= (abs(n.x) + abs(n.y) + abs(n.z));
+    n.xy = n.z >= 0.0 ? n.xy : octWrap(n.xy);
+    return n.xy;
+}
+
+vec3 octDecode(vec2 f)
+{
+    vec3 n = vec3(f.x, f.y, 1.0 - abs(f.x) - abs(f.y));
+    float t = clamp(-n.z, 0.0, 1.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+
+// Hemi-octahedral mapping of the upper (y >= 0) hemisphere onto the [-1, 1] square, the
+// layout the impostor views are baked in. Matches hemiOctDecode in Impostors.cpp
+vec2 hemiOctEncode(vec3 d)
+{
+    vec2 p = d.xz / (abs(d.x) + abs(d.y) + abs(d.z));
+    return vec2(p.x + p.y, p.x - p.y);
+}
+
+vec3 hemiOctDecode(vec2 f)
+{
+    vec2 p = vec2(f.x + f.y, f.x - f.y) * 0.5;
+    return normalize(vec3(p.x, 1.0 - abs(p.x) - abs(p.y), p.y));
+}
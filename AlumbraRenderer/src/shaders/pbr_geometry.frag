@@ -1,15 +1,17 @@
 #version 450 core
 
-layout (location = 0) out vec3 gPosition;
-layout (location = 1) out vec3 gNormal;
-layout (location = 2) out vec3 gAlbedo;
-layout (location = 3) out vec3 gMetalRoughAO;
+layout (location = 0) out vec2 gNormal;
+layout (location = 1) out vec4 gAlbedo;
+layout (location = 2) out vec4 gMetalRoughAO;
+layout (location = 3) out vec2 gVelocity;
 
 in VS_OUT {
     vec2 TexCoords;
     vec3 FragPos;
     vec3 Normal;
     mat3 TBN;
+    vec4 CurrClip;
+    vec4 PrevClip;
 } fs_in;
 
 struct Material {
@@ -28,23 +30,29 @@ uniform vec3  albedo;
 uniform float metallic;
 uniform float roughness;
 
+#include "octahedral.glsl"
+
 void main()
 {    
-    // store the fragment position vector in the first gbuffer texture
-    gPosition = fs_in.FragPos;
-    // also store the per-fragment normals into the gbuffer
+    // position is not stored, the lighting pass reconstructs it from depth
+    // store the per-fragment normals octahedral encoded into the gbuffer
+    vec3 N;
     if (useNormalMap) {
         vec3 norm = texture(material.texture_normal, fs_in.TexCoords).rgb;
         norm = norm * 2.0 - 1.0;
-        gNormal = normalize(fs_in.TBN * norm);
+        N = normalize(fs_in.TBN * norm);
     }
     else {
-        gNormal = fs_in.Normal;
+        N = normalize(fs_in.Normal);
     }
+    gNormal = octEncode(N) * 0.5 + 0.5;
     // and the diffuse per-fragment color
-    gAlbedo = vec3(albedo);//texture(material.texture_albedo, fs_in.TexCoords);
+    gAlbedo = vec4(albedo, 1.0);//texture(material.texture_albedo, fs_in.TexCoords);
     // store pbr properties into separate gbuffer texture
     gMetalRoughAO.r = metallic;//texture(material.texture_metal, fs_in.TexCoords).r;
     gMetalRoughAO.g = roughness;//texture(material.texture_rough, fs_in.TexCoords).r;
     gMetalRoughAO.b = 1.0;
+    gMetalRoughAO.a = 1.0;
+    // screen space motion since last frame in UV units
+    gVelocity = (fs_in.CurrClip.xy / fs_in.CurrClip.w - fs_in.PrevClip.xy / fs_in.PrevClip.w) * 0.5;
 }
@@ -1,20 +1,29 @@
 #version 450 core
 layout (location = 0) in vec3 aPos;
-layout (location = 1) in vec3 aNormal;
+// Interleaved MeshVertexFormat, see Buffers.h: octahedral normal and the tangent with the
+// bitangent's handedness in w
+layout (location = 1) in vec2 aNormal;
 layout (location = 2) in vec2 aTexCoords;
-layout (location = 3) in vec3 aTangent;
-layout (location = 4) in vec3 aBitangent;
+layout (location = 3) in vec4 aTangent;
+
+#include "octahedral.glsl"
 
 out VS_OUT {
     vec2 TexCoords;
     vec3 FragPos;
     vec3 Normal;
     mat3 TBN;
+    vec4 CurrClip;
+    vec4 PrevClip;
 } vs_out;
 
 uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
+// Unjittered matrices of this and the previous frame for the velocity target
+uniform mat4 prevModel;
+uniform mat4 currViewProjection;
+uniform mat4 prevViewProjection;
 
 void main()
 {
@@ -24,15 +33,19 @@ void main()
     vs_out.FragPos = worldPos.xyz;
 
     mat3 normalMatrix = transpose(inverse(mat3(model)));
-    vs_out.Normal = normalMatrix * aNormal;
+    vec3 normal = octDecode(aNormal);
+    vs_out.Normal = normalMatrix * normal;
 
-    vec3 T = normalize(normalMatrix * aTangent);
-    vec3 B = normalize(normalMatrix * aBitangent);
-    vec3 N = normalize(normalMatrix * aNormal);
+    vec3 T = normalize(normalMatrix * aTangent.xyz);
+    vec3 N = normalize(normalMatrix * normal);
     // Re-orthogonalization for when TS vectors have been averaged
     T = normalize(T - dot(T, N) * N);
+    vec3 B = cross(N, T) * aTangent.w;
 
     vs_out.TBN = mat3(T, B, N);
 
+    vs_out.CurrClip = currViewProjection * worldPos;
+    vs_out.PrevClip = prevViewProjection * prevModel * vec4(aPos, 1.0);
+
     gl_Position = projection * view * worldPos;
 }
@@ -1,13 +1,15 @@
 #version 450 core
 
 layout (location = 0) out vec4 FragColor;
-layout (location = 1) out vec4 BrightColor;
 
 in vec2 TexCoords;
 
 #define PI 3.14159265359
 #define MAX_REFLECTION_LOD 4.0
-#define MAX_LIGHTS 5
+#define HEATMAP_MAX_LIGHTS 32.0
+
+#include "clusters.glsl"
+#include "octahedral.glsl"
 
 struct DirectionalLight {
     vec3 direction;
@@ -15,17 +17,21 @@ struct DirectionalLight {
     float intensity;
 };
 
-struct PointLight {
-    vec4 position;
-    vec4 color;
-    float radius;
-    float intensity;
-};
-
 uniform vec3 viewPos;
+uniform mat4 view;
+uniform mat4 invViewProjection;
+uniform bool showLightHeatmap;
+uniform bool showTileClasses;
+uniform vec3 tileClassColor;
+
+// Checkerboard shading, the target is half as wide as the rendered region and each pixel
+// shades one of the two pixels it covers, alternating per row and frame
+uniform bool checkerboard;
+uniform int checkerFrame;
+uniform vec2 renderSize;
 
 // GBuffer textures
-uniform sampler2D gPosition;
+uniform sampler2D gDepth;
 uniform sampler2D gNormal;
 uniform sampler2D gAlbedo;
 uniform sampler2D gMetalRoughAO;
@@ -35,13 +41,8 @@ uniform DirectionalLight directLight;
 uniform sampler2D directionalDepthMap;
 uniform mat4 lightSpaceMatrix;
 
-// Punctual lighting
-layout (std140, binding = 2) uniform LightsUBO
-{
-    PointLight pointLights[MAX_LIGHTS];
-};
+// Punctual lighting, lights come from the cluster lists in clusters.glsl
 uniform samplerCube pointDepthMaps[4];
-uniform int numPointLights;
 uniform float farPlane;
 
 // PBR Shading
@@ -56,15 +57,36 @@ float geometrySchlickGGX(float NdotV, float roughness);
 float geometrySmith(float NdotV, float NdotL, float roughness);
 vec3 calcPuncLight(PointLight light, vec3 V, vec3 N, vec3 P, vec3 albedo, vec3 F0, float rough, float metal, int index);
 vec3 calcDirLight(DirectionalLight light, vec3 V, vec3 N, vec3 albedo, vec3 F0, float rough, float metal);
+vec3 reconstructPosition(vec2 uv, float depth);
+vec3 heatmap(float t);
 
 void main()
 {
-    vec3 albedo = texture(gAlbedo, TexCoords).rgb;
-    float metallic = texture(gMetalRoughAO, TexCoords).r;
-    float roughness = texture(gMetalRoughAO, TexCoords).g;
-    vec3 P = texture(gPosition, TexCoords).rgb;
-
-    vec3 N = normalize(texture(gNormal, TexCoords).rgb);
+    // GBuffer texels are fetched by pixel, with dynamic resolution only the lower left part of
+    // each target is filled while TexCoords still span the rendered region
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    vec2 fragCoord = gl_FragCoord.xy;
+    vec2 uv = TexCoords;
+    if (checkerboard) {
+        pixel.x = pixel.x * 2 + ((pixel.y + checkerFrame) & 1);
+        if (pixel.x >= int(renderSize.x))
+            discard;
+        fragCoord = vec2(pixel) + 0.5;
+        uv = fragCoord / renderSize;
+    }
+    vec3 albedo = texelFetch(gAlbedo, pixel, 0).rgb;
+    vec2 metalRough = texelFetch(gMetalRoughAO, pixel, 0).rg;
+    float metallic = metalRough.r;
+    float roughness = metalRough.g;
+    float depth = texelFetch(gDepth, pixel, 0).r;
+#ifndef TILE_SIMPLE
+    // Background pixels are covered by the skybox afterwards
+    if (depth == 1.0)
+        discard;
+#endif
+    vec3 P = reconstructPosition(uv, depth);
+
+    vec3 N = octDecode(texelFetch(gNormal, pixel, 0).rg * 2.0 - 1.0);
     vec3 V = normalize(viewPos - P);
     vec3 R = reflect(-V, N);
 
@@ -72,11 +94,19 @@ void main()
     vec3 F0 = vec3(0.04); 
     F0      = mix(F0, albedo, metallic);
     
-    // calculate per-light outgoing radiance
+    // calculate per-light outgoing radiance, only for the lights binned into this fragment's cluster
     vec3 Lo = calcDirLight(directLight, V, N, albedo, F0, roughness, metallic);
-    for(int i = 0; i < numPointLights; i++) {
-        Lo += calcPuncLight(pointLights[i], V, N, P, albedo, F0, roughness, metallic, i);
+    uint clusterLightCount = 0u;
+#ifndef TILE_SIMPLE
+    // Simple tiles are never reached by point lights, so they skip the cluster lookup entirely
+    float viewDepth = -(view * vec4(P, 1.0)).z;
+    uvec2 lightList = lightGrid[clusterIndex(fragCoord, viewDepth)];
+    clusterLightCount = lightList.y;
+    for (uint i = 0u; i < lightList.y; i++) {
+        uint lightIndex = lightIndices[lightList.x + i];
+        Lo += calcPuncLight(pointLights[lightIndex], V, N, P, albedo, F0, roughness, metallic, int(lightIndex));
     }
+#endif
 
     // IBL Lighting
     vec3 F = fresnelSchlickRoughness(max(dot(N, V), 0.0), F0, roughness);
@@ -94,12 +124,10 @@ void main()
     vec3 color = ambient + Lo;
     
     FragColor = vec4(color, 1.0);
-
-    float brightness = dot(FragColor.rgb, vec3(0.2126, 0.7152, 0.0722));
-    if (brightness > 1.0)
-        BrightColor = vec4(FragColor.rgb, 1.0);
-    else
-        BrightColor = vec4(0.0, 0.0, 0.0, 1.0);
+    if (showLightHeatmap)
+        FragColor.rgb = mix(color, heatmap(float(clusterLightCount) / HEATMAP_MAX_LIGHTS), 0.75);
+    if (showTileClasses)
+        FragColor.rgb = mix(FragColor.rgb, tileClassColor, 0.3);
 }
 
 vec3 calcPuncLight(PointLight light, vec3 V, vec3 N, vec3 P, vec3 albedo, vec3 F0, float rough, float metal, int index)
@@ -160,6 +188,21 @@ vec3 calcDirLight(DirectionalLight light, vec3 V, vec3 N, vec3 albedo, vec3 F0,
     return radianceOut;
 }
 
+// World space position from the depth buffer and the inverse view-projection matrix
+vec3 reconstructPosition(vec2 uv, float depth)
+{
+    vec4 ndc = vec4(uv * 2.0 - 1.0, depth * 2.0 - 1.0, 1.0);
+    vec4 world = invViewProjection * ndc;
+    return world.xyz / world.w;
+}
+
+// Blue -> green -> red ramp used to visualize the number of lights per cluster
+vec3 heatmap(float t)
+{
+    t = clamp(t, 0.0, 1.0);
+    return clamp(vec3(2.0 * t - 1.0, 1.0 - abs(2.0 * t - 1.0), 1.0 - 2.0 * t), 0.0, 1.0);
+}
+
 // Unmodified Schlick approximation of Fresnel reflectance, interpolating between the characteristic
 // specular color F0 and white, resulting in the whiter reflections at glancing angles
 vec3 fresnelSchlick(float cosTheta, vec3 F0)
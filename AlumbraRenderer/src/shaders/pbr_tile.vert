@@ -0,0 +1,29 @@
+#version 450 core
+
+// Expands one instanced quad per classified tile, no vertex attributes are needed
+
+layout (std430, binding = 7) readonly buffer TileListSSBO
+{
+    uint tileList[];
+};
+
+out vec2 TexCoords;
+
+uniform int tileListOffset;
+uniform int tilesX;
+uniform vec2 tileSize;
+uniform vec2 screenSize;
+
+const vec2 corners[6] = vec2[6](
+    vec2(0.0, 1.0), vec2(0.0, 0.0), vec2(1.0, 0.0),
+    vec2(0.0, 1.0), vec2(1.0, 0.0), vec2(1.0, 1.0)
+);
+
+void main()
+{
+    uint tile = tileList[tileListOffset + gl_InstanceID];
+    vec2 origin = vec2(tile % uint(tilesX), tile / uint(tilesX)) * tileSize;
+    vec2 pixel = min(origin + corners[gl_VertexID] * tileSize, screenSize);
+    TexCoords = pixel / screenSize;
+    gl_Position = vec4(TexCoords * 2.0 - 1.0, 0.0, 1.0);
+}
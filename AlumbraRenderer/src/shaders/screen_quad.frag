@@ -6,15 +6,54 @@ in vec2 TexCoords;
 uniform sampler2D sceneTexture;
 uniform sampler2D bloomTexture;
 uniform bool bloom;
+uniform float bloomIntensity;
+uniform float bloomRadius;
 uniform float exposure;
 
+// Part of the scene and bloom textures that was rendered this frame, below 1 when rendering
+// at a reduced resolution, the scene is then upscaled with a bicubic filter
+uniform vec2 sceneUVScale;
+uniform vec2 bloomUVScale;
+
+#include "filtering.glsl"
+
+vec3 sampleScene(vec2 uv);
+vec3 upsampleBloom(vec2 uv);
+
 void main()
 {
-    vec3 hdrColor = texture(sceneTexture, TexCoords).rgb;
-    vec3 bloomColor = texture(bloomTexture, TexCoords).rgb;
+    vec3 hdrColor = sampleScene(TexCoords * sceneUVScale);
     if (bloom) {
-        hdrColor += bloomColor;
+        hdrColor += upsampleBloom(TexCoords * bloomUVScale) * bloomIntensity;
     }
     vec3 result = vec3(1.0) - exp(-hdrColor * exposure);
     FragColor = vec4(result, 1.0);
 }
+
+// Bicubic upscale when the scene was rendered below the window resolution
+vec3 sampleScene(vec2 uv)
+{
+    if (sceneUVScale == vec2(1.0))
+        return texture(sceneTexture, uv).rgb;
+    vec2 uvMax = sceneUVScale - 0.5 / vec2(textureSize(sceneTexture, 0));
+    return sampleCatmullRom(sceneTexture, uv, uvMax);
+}
+
+// Last step of the bloom upsample chain, the half resolution bloom is tent filtered up to
+// full resolution here so the composite does not need its own render target
+vec3 upsampleBloom(vec2 uv)
+{
+    vec2 texSize = vec2(textureSize(bloomTexture, 0));
+    vec2 uvMax = bloomUVScale - 0.5 / texSize;
+    vec2 d = bloomRadius / texSize;
+    vec3 color = texture(bloomTexture, min(uv, uvMax)).rgb * 4.0;
+    color += texture(bloomTexture, min(uv + vec2(-d.x,  0.0), uvMax)).rgb * 2.0;
+    color += texture(bloomTexture, min(uv + vec2( d.x,  0.0), uvMax)).rgb * 2.0;
+    color += texture(bloomTexture, min(uv + vec2( 0.0, -d.y), uvMax)).rgb * 2.0;
+    color += texture(bloomTexture, min(uv + vec2( 0.0,  d.y), uvMax)).rgb * 2.0;
+    color += texture(bloomTexture, min(uv + vec2(-d.x, -d.y), uvMax)).rgb;
+    color += texture(bloomTexture, min(uv + vec2( d.x, -d.y), uvMax)).rgb;
+    color += texture(bloomTexture, min(uv + vec2(-d.x,  d.y), uvMax)).rgb;
+    color += texture(bloomTexture, min(uv + vec2( d.x,  d.y), uvMax)).rgb;
+    return color / 16.0;
+}
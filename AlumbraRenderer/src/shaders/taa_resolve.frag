@@ -0,0 +1,121 @@
+#version 450 core
+
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D sceneTexture;
+uniform sampler2D velocityTexture;
+uniform sampler2D depthTexture;
+uniform sampler2D historyTexture;
+// Rendered region of the scene, velocity and depth textures, can be below the output size
+uniform vec2 renderSize;
+uniform vec2 outputSize;
+// Projection offset of the current frame in render pixels
+uniform vec2 jitter;
+// Maps the current NDC to the previous NDC for sky pixels, which have no velocity written
+uniform mat4 skyReprojection;
+uniform float historyWeight;
+
+#include "filtering.glsl"
+
+vec3 rgbToYCoCg(vec3 c)
+{
+    return vec3(
+        0.25 * c.r + 0.5 * c.g + 0.25 * c.b,
+        0.5 * c.r - 0.5 * c.b,
+        -0.25 * c.r + 0.5 * c.g - 0.25 * c.b);
+}
+
+vec3 yCoCgToRgb(vec3 c)
+{
+    return vec3(c.x + c.y - c.z, c.x + c.z, c.x - c.y - c.z);
+}
+
+// Moves the history towards the neighborhood center until it lies inside the box, unlike a
+// per-channel clamp this keeps its hue
+vec3 clipAABB(vec3 boxMin, vec3 boxMax, vec3 history)
+{
+    vec3 center = 0.5 * (boxMax + boxMin);
+    vec3 extents = 0.5 * (boxMax - boxMin) + 0.0001;
+    vec3 offset = history - center;
+    vec3 ts = abs(offset / extents);
+    float t = max(ts.x, max(ts.y, ts.z));
+    return t > 1.0 ? center + offset / t : history;
+}
+
+void main()
+{
+    // Output pixel center in unjittered render pixel space. Render texel t holds the scene
+    // at t + 0.5 - jitter since the projection shifted everything by jitter
+    vec2 renderPos = TexCoords * renderSize;
+    ivec2 center = ivec2(floor(renderPos + jitter));
+    ivec2 maxTexel = ivec2(renderSize) - 1;
+
+    vec3 colorSum = vec3(0.0);
+    float weightSum = 0.0;
+    vec3 m1 = vec3(0.0);
+    vec3 m2 = vec3(0.0);
+    vec3 boxMin = vec3(1e10);
+    vec3 boxMax = vec3(-1e10);
+    float closestDepth = 1.0;
+    ivec2 closestTexel = clamp(center, ivec2(0), maxTexel);
+    float nearestDist = 2.0;
+    for (int y = -1; y <= 1; y++) {
+        for (int x = -1; x <= 1; x++) {
+            ivec2 texel = clamp(center + ivec2(x, y), ivec2(0), maxTexel);
+            vec3 color = rgbToYCoCg(texelFetch(sceneTexture, texel, 0).rgb);
+            // Gaussian fit of a Blackman-Harris window over the jittered sample distance
+            vec2 d = vec2(texel) + 0.5 - jitter - renderPos;
+            float dist2 = dot(d, d);
+            float w = exp(-2.29 * dist2);
+            colorSum += color * w;
+            weightSum += w;
+            nearestDist = min(nearestDist, dist2);
+
+            m1 += color;
+            m2 += color * color;
+            boxMin = min(boxMin, color);
+            boxMax = max(boxMax, color);
+
+            // Velocity of the closest surface, so edges are reprojected with the foreground
+            float depth = texelFetch(depthTexture, texel, 0).r;
+            if (depth < closestDepth) {
+                closestDepth = depth;
+                closestTexel = texel;
+            }
+        }
+    }
+    vec3 current = colorSum / weightSum;
+
+    vec2 velocity;
+    if (closestDepth == 1.0) {
+        vec4 prev = skyReprojection * vec4(TexCoords * 2.0 - 1.0, 1.0, 1.0);
+        velocity = TexCoords - (prev.xy / prev.w * 0.5 + 0.5);
+    }
+    else {
+        velocity = texelFetch(velocityTexture, closestTexel, 0).rg;
+    }
+    vec2 historyUV = TexCoords - velocity;
+
+    // Variance clipping (Salvi), tightened by the min/max box of the same neighborhood
+    vec3 mean = m1 / 9.0;
+    vec3 sigma = sqrt(max(m2 / 9.0 - mean * mean, 0.0));
+    vec3 clipMin = max(boxMin, mean - sigma);
+    vec3 clipMax = min(boxMax, mean + sigma);
+
+    // Samples far from this output pixel are trusted less, which matters when upsampling
+    float confidence = exp(-2.29 * nearestDist);
+    bool offscreen = any(lessThan(historyUV, vec2(0.0))) || any(greaterThan(historyUV, vec2(1.0)));
+    vec3 result = current;
+    if (!offscreen && historyWeight > 0.0) {
+        vec3 history = sampleCatmullRom(historyTexture, historyUV, 1.0 - 0.5 / outputSize);
+        history = clipAABB(clipMin, clipMax, rgbToYCoCg(history));
+
+        // Luminance weighted blend (Karis), keeps single bright samples from flickering
+        float currentWeight = (1.0 - historyWeight) * confidence / (1.0 + current.x);
+        float historyBlend = historyWeight / (1.0 + history.x);
+        result = (current * currentWeight + history * historyBlend) / (currentWeight + historyBlend);
+    }
+    FragColor = vec4(max(yCoCgToRgb(result), vec3(0.0)), 1.0);
+}
@@ -0,0 +1,11 @@
+#version 450 core
+
+// Global triangle ID + 1, so 0 is left for pixels that no geometry covers
+layout (location = 0) out uint visibilityID;
+
+flat in uint triangleOffset;
+
+void main()
+{
+    visibilityID = triangleOffset + uint(gl_PrimitiveID) + 1u;
+}
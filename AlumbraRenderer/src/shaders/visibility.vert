@@ -0,0 +1,29 @@
+#version 450 core
+layout (location = 0) in vec3 aPos;
+// Index into poolDraws or poolClusters, an instanced attribute offset by each command's base instance
+layout (location = 1) in uint aInstance;
+
+#include "mesh_pool.glsl"
+
+flat out uint triangleOffset;
+
+uniform mat4 viewProjection;
+// Commands draw single clusters, gl_PrimitiveID then counts from the meshlet's first triangle
+// instead of the first triangle of the draw's level of detail
+uniform bool clusters;
+
+void main()
+{
+    uint drawIndex = aInstance;
+    uint firstTriangle = 0u;
+    if (clusters) {
+        PoolCluster cluster = poolClusters[aInstance];
+        drawIndex = cluster.drawIndex;
+        firstTriangle = poolMeshlets[cluster.meshletIndex].firstIndex / 3u;
+    }
+    PoolDraw draw = poolDraws[drawIndex];
+    if (!clusters)
+        firstTriangle = poolMeshes[draw.meshIndex].lodFirstIndex[draw.lod] / 3u;
+    triangleOffset = draw.triangleOffset + firstTriangle;
+    gl_Position = viewProjection * draw.model * vec4(aPos, 1.0);
+}
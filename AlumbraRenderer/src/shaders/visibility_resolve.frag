@@ -0,0 +1,68 @@
+#version 450 core
+
+// Writes the same targets as pbr_geometry.frag so the lighting passes are shared
+layout (location = 0) out vec2 gNormal;
+layout (location = 1) out vec4 gAlbedo;
+layout (location = 2) out vec4 gMetalRoughAO;
+layout (location = 3) out vec2 gVelocity;
+
+#include "mesh_pool.glsl"
+#include "octahedral.glsl"
+
+uniform usampler2D visibilityBuffer;
+uniform mat4 viewProjection;
+// Unjittered matrices of this and the previous frame for the velocity target
+uniform mat4 currViewProjection;
+uniform mat4 prevViewProjection;
+uniform vec2 screenSize;
+
+void main()
+{
+    uint id = texelFetch(visibilityBuffer, ivec2(gl_FragCoord.xy), 0).r;
+    if (id == 0u)
+        discard;
+    uint triangleID = id - 1u;
+
+    PoolDraw draw = poolDraws[findPoolDraw(triangleID)];
+    PoolMesh mesh = poolMeshes[draw.meshIndex];
+    uint first = mesh.firstIndex + (triangleID - draw.triangleOffset) * 3u;
+    PoolVertex v0 = poolVertices[poolIndices[first]      + mesh.baseVertex];
+    PoolVertex v1 = poolVertices[poolIndices[first + 1u] + mesh.baseVertex];
+    PoolVertex v2 = poolVertices[poolIndices[first + 2u] + mesh.baseVertex];
+
+    // Re-project the triangle and solve for this pixel's screen space barycentrics
+    mat4 mvp = viewProjection * draw.model;
+    vec4 c0 = mvp * vec4(v0.positionU.xyz, 1.0);
+    vec4 c1 = mvp * vec4(v1.positionU.xyz, 1.0);
+    vec4 c2 = mvp * vec4(v2.positionU.xyz, 1.0);
+    vec3 invW = 1.0 / vec3(c0.w, c1.w, c2.w);
+    vec2 p0 = c0.xy * invW.x;
+    vec2 p1 = c1.xy * invW.y;
+    vec2 p2 = c2.xy * invW.z;
+    vec2 p = gl_FragCoord.xy / screenSize * 2.0 - 1.0;
+
+    vec2 e1 = p1 - p0;
+    vec2 e2 = p2 - p0;
+    vec2 ep = p - p0;
+    float area = e1.x * e2.y - e2.x * e1.y;
+    float b1 = (ep.x * e2.y - e2.x * ep.y) / area;
+    float b2 = (e1.x * ep.y - ep.x * e1.y) / area;
+    vec3 bary = vec3(1.0 - b1 - b2, b1, b2);
+    // Perspective correct interpolation weights
+    bary *= invW;
+    bary /= bary.x + bary.y + bary.z;
+
+    vec3 normal = bary.x * v0.normalV.xyz + bary.y * v1.normalV.xyz + bary.z * v2.normalV.xyz;
+    mat3 normalMatrix = transpose(inverse(mat3(draw.model)));
+    vec3 N = normalize(normalMatrix * normal);
+
+    gNormal = octEncode(N) * 0.5 + 0.5;
+    Material material = poolMaterials[draw.materialIndex];
+    gAlbedo = vec4(material.albedo, 1.0);
+    gMetalRoughAO = vec4(material.metallic, material.roughness, 1.0, 1.0);
+
+    vec3 position = bary.x * v0.positionU.xyz + bary.y * v1.positionU.xyz + bary.z * v2.positionU.xyz;
+    vec4 currClip = currViewProjection * draw.model * vec4(position, 1.0);
+    vec4 prevClip = prevViewProjection * draw.prevModel * vec4(position, 1.0);
+    gVelocity = (currClip.xy / currClip.w - prevClip.xy / prevClip.w) * 0.5;
+}
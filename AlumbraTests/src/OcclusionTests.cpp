@@ -0,0 +1,104 @@
+#include "pch.h"
+#include "SoftwareOcclusion.h"
+#include "mesh/Shapes.h"
+
+/*
+ * Checks of the software occlusion culling that run without a GL context. Each check prints
+ * what failed, the exit code is the number of failed checks.
+ */
+
+static int s_failures = 0;
+
+static void check(bool condition, const std::string& message)
+{
+    if (!condition) {
+        std::cout << "FAILED: " << message << std::endl;
+        s_failures++;
+    }
+}
+
+struct OcclusionFixture {
+    JobSystem jobs;
+    SoftwareOcclusion occlusion;
+    OccluderMesh cube;
+    AABB cubeBounds;
+    glm::mat4 viewProjection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+
+    // Single threaded, the checks are about the results and not the scheduling
+    OcclusionFixture() : jobs(0)
+    {
+        MeshData data = Cube::generate();
+        cube.positions = data.positions;
+        for (unsigned int i = 0; i < data.positions.size(); i++)
+            cube.indices.push_back(i);
+        cubeBounds = AABB::fromPoints(cube.positions);
+        occlusion.setup(256, 128);
+    }
+
+    /* Renders the occluders and returns the objects of the bounds that survive the filter */
+    std::vector<unsigned int> visible(const std::vector<OccluderInstance>& occluders, const std::vector<AABB>& bounds)
+    {
+        occlusion.render(jobs, viewProjection, occluders);
+        std::vector<unsigned int> objects;
+        for (unsigned int i = 0; i < bounds.size(); i++)
+            objects.push_back(i);
+        occlusion.filter(jobs, objects, bounds);
+        return objects;
+    }
+};
+
+static std::string position(const glm::vec3& p)
+{
+    return "(" + std::to_string(p.x) + ", " + std::to_string(p.y) + ", " + std::to_string(p.z) + ")";
+}
+
+/* A cube alone in view is its own only occluder, its bounds must not be hidden by its own depth */
+static void loneOccluderStaysVisible(OcclusionFixture& fixture)
+{
+    for (float z = -30.0f; z <= -3.0f; z += 0.25f) {
+        for (float x = -6.0f; x <= 6.0f; x += 0.1f) {
+            glm::vec3 p(x, 0.0f, z);
+            glm::mat4 model = glm::scale(glm::translate(glm::mat4(1.0f), p), glm::vec3(0.5f));
+            auto objects = fixture.visible({ { &fixture.cube, model, 0 } },
+                { fixture.cubeBounds.transformed(model) });
+            check(objects.size() == 1, "lone occluder at " + position(p) + " was culled");
+        }
+    }
+}
+
+/* An object that is not an occluder but whose bounds are flush with an occluder's faces */
+static void flushObjectStaysVisible(OcclusionFixture& fixture)
+{
+    for (float z = -60.0f; z <= -3.0f; z += 0.5f) {
+        for (float x = -6.0f; x <= 6.0f; x += 0.2f) {
+            glm::vec3 p(x, 1.0f, z);
+            glm::mat4 model = glm::scale(glm::translate(glm::mat4(1.0f), p), glm::vec3(0.5f, 0.25f, 1.0f));
+            AABB bounds = fixture.cubeBounds.transformed(model);
+            auto objects = fixture.visible({ { &fixture.cube, model, 0 } }, { bounds, bounds });
+            check(objects.size() == 2, "object flush with an occluder at " + position(p) + " was culled");
+        }
+    }
+}
+
+/* Objects entirely behind a wall are still culled, and the wall is not */
+static void hiddenObjectIsCulled(OcclusionFixture& fixture)
+{
+    glm::mat4 wall = glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -10.0f)),
+        glm::vec3(20.0f, 20.0f, 0.5f));
+    glm::mat4 behind = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -20.0f));
+    glm::mat4 front = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -5.0f));
+    auto objects = fixture.visible({ { &fixture.cube, wall, 0 } },
+        { fixture.cubeBounds.transformed(wall), fixture.cubeBounds.transformed(behind),
+        fixture.cubeBounds.transformed(front) });
+    check(objects == std::vector<unsigned int>({ 0, 2 }), "only the object behind the wall should be culled");
+}
+
+int main()
+{
+    OcclusionFixture fixture;
+    loneOccluderStaysVisible(fixture);
+    flushObjectStaysVisible(fixture);
+    hiddenObjectIsCulled(fixture);
+    std::cout << (s_failures == 0 ? "All occlusion checks passed" : "Occlusion checks failed") << std::endl;
+    return s_failures;
+}